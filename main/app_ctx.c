@@ -0,0 +1,497 @@
+#include "app_ctx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+// 配置
+#define APP_CTX_MAX_TASKS               8
+#define APP_CTX_TASK_STOP_TIMEOUT_MS    500     // 销毁时等待任务退出的最长时间
+
+typedef enum {
+    APP_RES_TIMER,
+    APP_RES_ANIM,
+    APP_RES_OBJ,
+    APP_RES_EVENT,
+    APP_RES_TASK,
+} app_res_type_t;
+
+// 后台任务记录（任务和LVGL任务共用，状态变化在g_task_lock中进行）
+typedef struct {
+    bool in_use;
+    app_task_fn_t fn;
+    void* arg;
+    TaskHandle_t handle;
+    SemaphoreHandle_t done;     // 任务函数返回后给出
+    volatile bool stop;         // 请求退出
+    bool finished;
+    bool detached;              // 等待超时，任务结束后自行释放记录
+    char name[16];
+} app_task_rec_t;
+
+typedef struct app_ctx_res_t {
+    app_res_type_t type;
+    union {
+        lv_timer_t* timer;
+        struct {
+            void* var;
+            lv_anim_exec_xcb_t exec_cb;
+        } anim;
+        lv_obj_t* obj;
+        struct {
+            hal_event_type_t type;
+            hal_event_cb_t cb;
+            void* user_data;
+        } event;
+        app_task_rec_t* task;
+    };
+    struct app_ctx_res_t* next;
+} app_ctx_res_t;
+
+// 应用上下文（第一次创建资源时分配，销毁应用时释放）
+struct app_ctx_t {
+    app_ctx_res_t* resources;
+    bool paused;
+};
+
+static app_task_rec_t g_tasks[APP_CTX_MAX_TASKS];
+static portMUX_TYPE g_task_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* -------------------------------------------------------------------------- */
+/*                                  Records                                   */
+/* -------------------------------------------------------------------------- */
+
+static app_ctx_t* get_ctx(app_t* app) {
+    if (!app) {
+        return NULL;
+    }
+    if (!app->ctx) {
+        app->ctx = (app_ctx_t*)calloc(1, sizeof(app_ctx_t));
+        if (!app->ctx) {
+            printf("Failed to allocate app context for %s\n", app->name);
+        }
+    }
+    return app->ctx;
+}
+
+static app_ctx_res_t* add_res(app_t* app, app_res_type_t type) {
+    app_ctx_t* ctx = get_ctx(app);
+    if (!ctx) {
+        return NULL;
+    }
+    app_ctx_res_t* res = (app_ctx_res_t*)calloc(1, sizeof(app_ctx_res_t));
+    if (!res) {
+        printf("Failed to allocate app resource for %s\n", app->name);
+        return NULL;
+    }
+    res->type = type;
+    res->next = ctx->resources;
+    ctx->resources = res;
+    return res;
+}
+
+// 从链表中取下第一个满足条件的记录（不释放）
+typedef bool (*res_match_t)(const app_ctx_res_t* res, const void* key);
+
+static app_ctx_res_t* take_res(app_t* app, app_res_type_t type, res_match_t match, const void* key) {
+    if (!app || !app->ctx) {
+        return NULL;
+    }
+    for (app_ctx_res_t** link = &app->ctx->resources; *link; link = &(*link)->next) {
+        app_ctx_res_t* res = *link;
+        if (res->type == type && match(res, key)) {
+            *link = res->next;
+            res->next = NULL;
+            return res;
+        }
+    }
+    return NULL;
+}
+
+// 去掉已经自行结束的动画的记录，避免反复创建时记录越积越多
+// （定时器不会自行删除，见app_ctx_timer_create）
+static void prune_finished(app_t* app) {
+    if (!app || !app->ctx) {
+        return;
+    }
+    app_ctx_res_t** link = &app->ctx->resources;
+    while (*link) {
+        app_ctx_res_t* res = *link;
+        if (res->type == APP_RES_ANIM && !lv_anim_get(res->anim.var, res->anim.exec_cb)) {
+            *link = res->next;
+            free(res);
+        } else {
+            link = &res->next;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               Timers and anims                             */
+/* -------------------------------------------------------------------------- */
+
+lv_timer_t* app_ctx_timer_create(app_t* app, lv_timer_cb_t cb, uint32_t period, void* user_data) {
+    prune_finished(app);
+    app_ctx_res_t* res = add_res(app, APP_RES_TIMER);
+    if (!res) {
+        return NULL;
+    }
+
+    res->timer = lv_timer_create(cb, period, user_data);
+    if (!res->timer) {
+        app->ctx->resources = res->next;
+        free(res);
+        return NULL;
+    }
+    // 带重复次数的定时器执行完后只暂停不删除：记录中的指针在删除前一直有效，
+    // 不会因为LVGL复用已释放定时器的内存而误删别人的定时器
+    lv_timer_set_auto_delete(res->timer, false);
+    if (app->ctx->paused) {
+        lv_timer_pause(res->timer);
+    }
+    return res->timer;
+}
+
+static bool match_timer(const app_ctx_res_t* res, const void* key) {
+    return res->timer == (const lv_timer_t*)key;
+}
+
+void app_ctx_timer_delete(app_t* app, lv_timer_t* timer) {
+    app_ctx_res_t* res = take_res(app, APP_RES_TIMER, match_timer, timer);
+    if (!res) {
+        return;
+    }
+    lv_timer_delete(res->timer);
+    free(res);
+}
+
+static bool match_anim(const app_ctx_res_t* res, const void* key) {
+    const lv_anim_t* anim = (const lv_anim_t*)key;
+    return res->anim.var == anim->var && res->anim.exec_cb == anim->exec_cb;
+}
+
+lv_anim_t* app_ctx_anim_start(app_t* app, const lv_anim_t* anim) {
+    if (!app || !anim) {
+        return NULL;
+    }
+    prune_finished(app);
+
+    // 同一个var和exec_cb只记一次（lv_anim_start会替换正在运行的同名动画）
+    app_ctx_res_t* res = take_res(app, APP_RES_ANIM, match_anim, anim);
+    if (res) {
+        res->next = app->ctx->resources;
+        app->ctx->resources = res;
+    } else {
+        res = add_res(app, APP_RES_ANIM);
+        if (!res) {
+            return NULL;
+        }
+        res->anim.var = anim->var;
+        res->anim.exec_cb = anim->exec_cb;
+    }
+    return lv_anim_start(anim);
+}
+
+static bool match_obj(const app_ctx_res_t* res, const void* key) {
+    return res->obj == (const lv_obj_t*)key;
+}
+
+// 对象按时删除后去掉记录
+static void delayed_obj_delete_cb(lv_event_t* e) {
+    app_t* app = (app_t*)lv_event_get_user_data(e);
+    free(take_res(app, APP_RES_OBJ, match_obj, lv_event_get_target(e)));
+}
+
+void app_ctx_obj_delete_delayed(app_t* app, lv_obj_t* obj, uint32_t delay_ms) {
+    if (!obj) {
+        return;
+    }
+    app_ctx_res_t* res = add_res(app, APP_RES_OBJ);
+    if (res) {
+        res->obj = obj;
+        lv_obj_add_event_cb(obj, delayed_obj_delete_cb, LV_EVENT_DELETE, app);
+    }
+    lv_obj_delete_delayed(obj, delay_ms);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 HAL events                                 */
+/* -------------------------------------------------------------------------- */
+
+typedef struct {
+    hal_event_type_t type;
+    hal_event_cb_t cb;
+    void* user_data;
+} event_key_t;
+
+static bool match_event(const app_ctx_res_t* res, const void* key) {
+    const event_key_t* k = (const event_key_t*)key;
+    return res->event.type == k->type && res->event.cb == k->cb && res->event.user_data == k->user_data;
+}
+
+bool app_ctx_subscribe(app_t* app, hal_event_type_t type, hal_event_cb_t cb, void* user_data) {
+    if (!cb) {
+        return false;
+    }
+    event_key_t key = { type, cb, user_data };
+    app_ctx_res_t* res = take_res(app, APP_RES_EVENT, match_event, &key);
+    if (res) {
+        // 已经订阅过，放回原处
+        res->next = app->ctx->resources;
+        app->ctx->resources = res;
+        return true;
+    }
+
+    res = add_res(app, APP_RES_EVENT);
+    if (!res) {
+        return false;
+    }
+    res->event.type = type;
+    res->event.cb = cb;
+    res->event.user_data = user_data;
+    if (!hal_event_subscribe(type, cb, user_data)) {
+        free(take_res(app, APP_RES_EVENT, match_event, &key));
+        return false;
+    }
+    return true;
+}
+
+void app_ctx_unsubscribe(app_t* app, hal_event_type_t type, hal_event_cb_t cb, void* user_data) {
+    event_key_t key = { type, cb, user_data };
+    app_ctx_res_t* res = take_res(app, APP_RES_EVENT, match_event, &key);
+    if (!res) {
+        return;
+    }
+    hal_event_unsubscribe(type, cb, user_data);
+    free(res);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Tasks                                    */
+/* -------------------------------------------------------------------------- */
+
+static void app_task_entry(void* param) {
+    app_task_rec_t* rec = (app_task_rec_t*)param;
+    rec->handle = xTaskGetCurrentTaskHandle();
+
+    rec->fn(rec->arg);
+
+    portENTER_CRITICAL(&g_task_lock);
+    rec->finished = true;
+    bool detached = rec->detached;
+    if (detached) {
+        rec->in_use = false;
+    }
+    portEXIT_CRITICAL(&g_task_lock);
+
+    if (detached) {
+        printf("Detached app task %s finished\n", rec->name);
+    } else {
+        xSemaphoreGive(rec->done);
+    }
+    vTaskDelete(NULL);
+}
+
+// 请求任务退出并等待；返回后记录不再属于应用
+static void stop_task(app_task_rec_t* rec) {
+    rec->stop = true;
+    if (xSemaphoreTake(rec->done, pdMS_TO_TICKS(APP_CTX_TASK_STOP_TIMEOUT_MS)) != pdTRUE) {
+        portENTER_CRITICAL(&g_task_lock);
+        bool finished = rec->finished;
+        if (!finished) {
+            rec->detached = true;
+        }
+        portEXIT_CRITICAL(&g_task_lock);
+
+        if (!finished) {
+            printf("App task %s did not stop within %d ms, detached\n", rec->name, APP_CTX_TASK_STOP_TIMEOUT_MS);
+            vSemaphoreDelete(rec->done);
+            rec->done = NULL;
+            return;
+        }
+        // 刚好结束，信号马上给出
+        xSemaphoreTake(rec->done, portMAX_DELAY);
+    }
+
+    vSemaphoreDelete(rec->done);
+    portENTER_CRITICAL(&g_task_lock);
+    memset(rec, 0, sizeof(app_task_rec_t));
+    portEXIT_CRITICAL(&g_task_lock);
+}
+
+static bool match_finished_task(const app_ctx_res_t* res, const void* key) {
+    (void)key;
+    return res->task->finished;
+}
+
+bool app_ctx_task_create(app_t* app, app_task_fn_t fn, const char* name,
+                         uint32_t stack_size, uint32_t priority, void* arg) {
+    if (!app || !fn) {
+        return false;
+    }
+
+    // 回收已经结束的任务
+    app_ctx_res_t* done;
+    while ((done = take_res(app, APP_RES_TASK, match_finished_task, NULL)) != NULL) {
+        stop_task(done->task);
+        free(done);
+    }
+
+    app_task_rec_t* rec = NULL;
+    portENTER_CRITICAL(&g_task_lock);
+    for (int i = 0; i < APP_CTX_MAX_TASKS; i++) {
+        if (!g_tasks[i].in_use) {
+            rec = &g_tasks[i];
+            memset(rec, 0, sizeof(app_task_rec_t));
+            rec->in_use = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&g_task_lock);
+    if (!rec) {
+        printf("App task table full, cannot start %s\n", name ? name : "task");
+        return false;
+    }
+
+    app_ctx_res_t* res = add_res(app, APP_RES_TASK);
+    rec->done = res ? xSemaphoreCreateBinary() : NULL;
+    if (!rec->done) {
+        if (res) {
+            app->ctx->resources = res->next;
+            free(res);
+        }
+        rec->in_use = false;
+        return false;
+    }
+    rec->fn = fn;
+    rec->arg = arg;
+    strncpy(rec->name, name ? name : "app_task", sizeof(rec->name) - 1);
+    res->task = rec;
+
+    if (xTaskCreate(app_task_entry, rec->name, stack_size, rec, (UBaseType_t)priority, NULL) != pdPASS) {
+        printf("Failed to create app task %s\n", rec->name);
+        app->ctx->resources = res->next;
+        free(res);
+        vSemaphoreDelete(rec->done);
+        memset(rec, 0, sizeof(app_task_rec_t));
+        return false;
+    }
+    return true;
+}
+
+bool app_ctx_task_should_stop(void) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < APP_CTX_MAX_TASKS; i++) {
+        if (g_tasks[i].in_use && g_tasks[i].handle == self) {
+            return g_tasks[i].stop;
+        }
+    }
+    return false;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Lifecycle                                  */
+/* -------------------------------------------------------------------------- */
+
+void app_ctx_get_stats(app_t* app, app_ctx_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(app_ctx_stats_t));
+    if (!app || !app->ctx) {
+        return;
+    }
+    prune_finished(app);
+    for (app_ctx_res_t* res = app->ctx->resources; res; res = res->next) {
+        switch (res->type) {
+            case APP_RES_TIMER: stats->timers++; break;
+            case APP_RES_ANIM:  stats->anims++; break;
+            case APP_RES_OBJ:   stats->objects++; break;
+            case APP_RES_EVENT: stats->events++; break;
+            case APP_RES_TASK:  stats->tasks++; break;
+        }
+    }
+}
+
+void app_ctx_pause(app_t* app) {
+    if (!app || !app->ctx || app->ctx->paused) {
+        return;
+    }
+    app->ctx->paused = true;
+
+    for (app_ctx_res_t* res = app->ctx->resources; res; res = res->next) {
+        if (res->type == APP_RES_TIMER) {
+            lv_timer_pause(res->timer);
+        }
+    }
+}
+
+void app_ctx_resume(app_t* app) {
+    if (!app || !app->ctx || !app->ctx->paused) {
+        return;
+    }
+    app->ctx->paused = false;
+    prune_finished(app);
+
+    for (app_ctx_res_t* res = app->ctx->resources; res; res = res->next) {
+        if (res->type == APP_RES_TIMER) {
+            lv_timer_resume(res->timer);
+            lv_timer_ready(res->timer);
+        }
+    }
+}
+
+void app_ctx_release(app_t* app) {
+    if (!app || !app->ctx) {
+        return;
+    }
+
+    // 先摘下整个链表：删除对象时的DELETE回调找不到记录，不会修改正在遍历的链表
+    app_ctx_t* ctx = app->ctx;
+    app->ctx = NULL;
+
+    app_ctx_stats_t released = {0};
+    app_ctx_res_t* res = ctx->resources;
+    while (res) {
+        app_ctx_res_t* next = res->next;
+        switch (res->type) {
+            case APP_RES_TIMER:
+                lv_timer_delete(res->timer);
+                released.timers++;
+                break;
+            case APP_RES_ANIM:
+                if (lv_anim_delete(res->anim.var, res->anim.exec_cb)) {
+                    released.anims++;
+                }
+                break;
+            case APP_RES_OBJ:
+                if (lv_obj_is_valid(res->obj)) {
+                    lv_obj_delete(res->obj);
+                    released.objects++;
+                }
+                break;
+            case APP_RES_EVENT:
+                hal_event_unsubscribe(res->event.type, res->event.cb, res->event.user_data);
+                released.events++;
+                break;
+            case APP_RES_TASK:
+                if (!res->task->finished) {
+                    released.tasks++;
+                }
+                stop_task(res->task);
+                break;
+        }
+        free(res);
+        res = next;
+    }
+    free(ctx);
+
+    if (released.timers || released.anims || released.objects || released.events || released.tasks) {
+        printf("App %s context released: %lu timers, %lu anims, %lu objects, %lu events, %lu tasks\n",
+               app->name, (unsigned long)released.timers, (unsigned long)released.anims,
+               (unsigned long)released.objects, (unsigned long)released.events,
+               (unsigned long)released.tasks);
+    }
+}
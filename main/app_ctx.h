@@ -0,0 +1,100 @@
+#ifndef APP_CTX_H
+#define APP_CTX_H
+
+#include "app_manager.h"
+#include "hal_event.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 应用上下文：通过这里创建的定时器、动画、延迟删除、后台任务和HAL事件订阅
+ * 记在应用名下，由app_manager统一管理，应用不需要在destroy_cb中逐个清理：
+ *
+ *   挂起  定时器暂停；HAL事件订阅和后台任务继续（挂起的应用仍需跟踪播放等状态）
+ *   恢复  定时器恢复并立即执行一次
+ *   销毁  在destroy_cb之前全部释放：删除定时器和动画、删除延迟删除的对象、
+ *         取消订阅、请求任务退出并等待
+ *
+ * 除app_ctx_task_should_stop外只能在LVGL任务中调用。
+ */
+
+// 后台任务函数：返回即结束，耗时的循环中应检查app_ctx_task_should_stop()
+typedef void (*app_task_fn_t)(void* arg);
+
+// 应用上下文持有的资源数
+typedef struct {
+    uint32_t timers;
+    uint32_t anims;
+    uint32_t objects;       // 等待延迟删除的对象
+    uint32_t events;        // HAL事件订阅
+    uint32_t tasks;
+} app_ctx_stats_t;
+
+/**
+ * @brief 创建属于应用的LVGL定时器
+ *
+ * 提前删除必须用app_ctx_timer_delete，不能直接lv_timer_delete。
+ * 设置了重复次数的定时器执行完后暂停，直到删除或随应用释放。
+ */
+lv_timer_t* app_ctx_timer_create(app_t* app, lv_timer_cb_t cb, uint32_t period, void* user_data);
+
+/**
+ * @brief 删除属于应用的定时器（可以在定时器自己的回调中调用）
+ *
+ * 定时器不属于应用或已随应用释放时不做任何事。
+ */
+void app_ctx_timer_delete(app_t* app, lv_timer_t* timer);
+
+/**
+ * @brief 启动属于应用的动画（按var和exec_cb识别，和lv_anim_delete相同）
+ */
+lv_anim_t* app_ctx_anim_start(app_t* app, const lv_anim_t* anim);
+
+/**
+ * @brief 延迟删除对象（应用容器之外的提示等）；应用先销毁时立即删除
+ */
+void app_ctx_obj_delete_delayed(app_t* app, lv_obj_t* obj, uint32_t delay_ms);
+
+/**
+ * @brief 订阅属于应用的HAL事件
+ */
+bool app_ctx_subscribe(app_t* app, hal_event_type_t type, hal_event_cb_t cb, void* user_data);
+
+/**
+ * @brief 提前取消订阅
+ */
+void app_ctx_unsubscribe(app_t* app, hal_event_type_t type, hal_event_cb_t cb, void* user_data);
+
+/**
+ * @brief 创建属于应用的后台任务
+ *
+ * 任务不能操作LVGL对象；应用挂起时继续运行，销毁时请求退出并等待，
+ * 超时仍未退出的任务脱离应用，结束后自行释放。
+ */
+bool app_ctx_task_create(app_t* app, app_task_fn_t fn, const char* name,
+                         uint32_t stack_size, uint32_t priority, void* arg);
+
+/**
+ * @brief 在应用的后台任务中调用：应用正在销毁，任务应尽快返回
+ */
+bool app_ctx_task_should_stop(void);
+
+/**
+ * @brief 获取应用当前持有的资源数
+ */
+void app_ctx_get_stats(app_t* app, app_ctx_stats_t* stats);
+
+// 以下由app_manager调用
+void app_ctx_pause(app_t* app);
+void app_ctx_resume(app_t* app);
+void app_ctx_release(app_t* app);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APP_CTX_H
@@ -1,47 +1,79 @@
-#include "app_file_manager.h"
 #include "app_manager.h"
+#include "app_ctx.h"
 #include "hal_sdcard.h"
 #include "menu_utils.h"
+#include "file_listing.h"
+#include "file_ops.h"
+#include "dir_size.h"
+#include "text_viewer.h"
+#include "file_index.h"
+#include "file_grep.h"
+#include "archive.h"
+#include "dup_finder.h"
+#include "file_types.h"
+#include "fs_watch.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <dirent.h>
-#include <sys/stat.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_heap_caps.h>
+#include <esp_timer.h>
 
 // 声明自定义字体
 LV_FONT_DECLARE(simhei_32);
 
-// 文件项类型
-typedef enum {
-    FILE_TYPE_DIRECTORY,
-    FILE_TYPE_FILE,
-    FILE_TYPE_PARENT
-} file_type_t;
-
-// 文件项结构
-typedef struct {
-    char name[256];           // 文件名（支持长文件名）
-    char full_path[512];      // 完整路径
-    file_type_t type;         // 文件类型
-    size_t size;              // 文件大小（字节）
-    uint32_t modified_time;   // 修改时间
-    bool is_selected;         // 是否被选中
-} file_item_t;
-
 // 文件管理器状态
 typedef struct {
+    app_t* app;                  // 定时器属于应用上下文，挂起时暂停，销毁时释放
     lv_obj_t* menu;              // 主菜单容器
     lv_obj_t* path_label;        // 路径显示标签
     lv_obj_t* file_list;         // 文件列表容器
     lv_obj_t* status_bar;        // 状态栏
     lv_obj_t* action_buttons;    // 操作按钮容器
+    lv_obj_t* confirm_box;       // 删除确认对话框
     
-    file_item_t* files;          // 文件列表
-    uint32_t file_count;         // 文件数量
+    file_listing_t* listing;     // 当前目录列表
     uint32_t selected_count;     // 选中文件数量
+    int32_t restore_scroll_y;    // 待恢复的滚动位置
+    
+    file_listing_t* clipboard;   // 复制/剪切的条目（dir_path为源目录）
+    bool clipboard_is_move;      // 剪切标志
+    lv_timer_t* progress_timer;  // 文件操作进度刷新定时器
+    
+    lv_obj_t* storage_panel;     // 存储空间分析面板
+    lv_obj_t* storage_list;      // 子目录占用列表
+    lv_obj_t* storage_summary;   // 当前目录汇总
+    lv_timer_t* storage_timer;   // 面板刷新定时器
+    uint32_t storage_generation; // 面板显示的统计结果版本
+    bool storage_dups;           // 面板显示的是查重进度和结果
+    file_listing_t* dup_results; // 重复文件（名称为完整路径，modified_time为组号）
+    
+    text_viewer_t* text_viewer;  // 打开的文本查看器
+    
+    lv_obj_t* search_panel;      // 全局搜索面板
+    lv_obj_t* search_input;      // 搜索输入框
+    lv_obj_t* search_list;       // 搜索结果列表
+    lv_obj_t* search_status;     // 结果数量和耗时
+    lv_timer_t* search_timer;    // 索引更新后刷新结果
+    uint32_t search_generation;  // 结果对应的索引版本
+    file_listing_t* search_results; // 搜索结果（名称为完整路径）
+    bool search_content;         // 显示的是内容搜索结果（size为偏移，modified_time为行号）
+    bool search_content_pending; // 等上一次内容搜索的任务退出后再开始
+    
+    lv_obj_t* archive_panel;     // 压缩包浏览面板
+    lv_obj_t* archive_list;      // 条目列表
+    lv_obj_t* archive_status;    // 条目数量/解压进度
+    lv_obj_t* archive_button;    // 解压/取消按钮文字
+    lv_timer_t* archive_timer;   // 解压进度刷新定时器
+    archive_t* archive;          // 打开的压缩包目录
+    uint8_t* archive_selected;   // 每个条目的选中标志
+    uint32_t archive_selected_count;
+    
+    lv_timer_t* watch_timer;     // 检测SD卡插拔和当前目录的变化
+    uint32_t sd_generation;      // 当前列表对应的SD卡挂载版本
+    char watched_path[512];      // 后台监视外部修改的目录
     
     char current_path[512];      // 当前路径
     char root_path[512];         // 根路径
@@ -62,14 +94,30 @@ static void update_path_display(void);
 static void update_status_bar(void);
 static void create_action_buttons(void);
 static void file_item_event_cb(lv_event_t* e);
+static void file_item_long_press_cb(lv_event_t* e);
+static void text_viewer_closed_cb(void* user_data);
+static void status_bar_event_cb(lv_event_t* e);
+static void delete_confirm_event_cb(lv_event_t* e);
+static void progress_timer_cb(lv_timer_t* timer);
+static void reload_current_directory(void);
+static file_listing_t* collect_selection(void);
+static void clear_selection(void);
+static void start_progress_timer(void);
+static void show_delete_confirm(void);
+static void show_storage_panel(void);
+static void close_storage_panel(void);
+static void show_search_panel(void);
+static void close_search_panel(void);
+static void show_archive_panel(const char* path);
+static void close_archive_panel(void);
+static void navigate_to(const char* path);
+static void watch_timer_cb(lv_timer_t* timer);
 static void action_button_event_cb(lv_event_t* e);
 static void* safe_malloc(size_t size);
 static void safe_free(void* ptr);
 static void cleanup_file_list(void);
-static bool is_hidden_file(const char* name);
-static char* get_file_extension(const char* filename);
 static const char* get_file_icon(const char* filename, file_type_t type);
-static void format_file_size(size_t size, char* buffer, size_t buffer_size);
+static void format_file_size(uint64_t size, char* buffer, size_t buffer_size);
 
 // 安全的内存分配函数
 static void* safe_malloc(size_t size) {
@@ -102,27 +150,19 @@ static void safe_free(void* ptr) {
     }
 }
 
-// 清理文件列表
+// 清理文件列表（归还缓存并记录滚动位置，返回时可立即恢复）
 static void cleanup_file_list(void) {
-    if (g_file_manager_state && g_file_manager_state->files) {
-        safe_free(g_file_manager_state->files);
-        g_file_manager_state->files = NULL;
-        g_file_manager_state->file_count = 0;
+    if (g_file_manager_state && g_file_manager_state->listing) {
+        int32_t scroll_y = 0;
+        if (g_file_manager_state->file_list) {
+            scroll_y = lv_obj_get_scroll_y(g_file_manager_state->file_list);
+        }
+        file_listing_cache_release(g_file_manager_state->listing, scroll_y);
+        g_file_manager_state->listing = NULL;
         g_file_manager_state->selected_count = 0;
     }
 }
 
-// 检查是否为隐藏文件
-static bool is_hidden_file(const char* name) {
-    return name[0] == '.';
-}
-
-// 获取文件扩展名
-static char* get_file_extension(const char* filename) {
-    char* ext = strrchr(filename, '.');
-    return ext ? ext + 1 : NULL;
-}
-
 // 获取文件图标
 static const char* get_file_icon(const char* filename, file_type_t type) {
     if (type == FILE_TYPE_DIRECTORY) {
@@ -130,45 +170,16 @@ static const char* get_file_icon(const char* filename, file_type_t type) {
     } else if (type == FILE_TYPE_PARENT) {
         return LV_SYMBOL_UP;
     }
-    
-    // 根据文件扩展名返回不同图标
-    char* ext = get_file_extension(filename);
-    if (!ext) {
-        return LV_SYMBOL_FILE;
-    }
-    
-    // 转换为小写进行比较
-    char ext_lower[16];
-    strncpy(ext_lower, ext, sizeof(ext_lower) - 1);
-    ext_lower[sizeof(ext_lower) - 1] = '\0';
-    for (int i = 0; ext_lower[i]; i++) {
-        if (ext_lower[i] >= 'A' && ext_lower[i] <= 'Z') {
-            ext_lower[i] = ext_lower[i] - 'A' + 'a';
-        }
-    }
-    
-    // 根据扩展名返回图标
-    if (strcmp(ext_lower, "mp3") == 0 || strcmp(ext_lower, "wav") == 0) {
-        return LV_SYMBOL_AUDIO;
-    } else if (strcmp(ext_lower, "jpg") == 0 || strcmp(ext_lower, "png") == 0 || 
-               strcmp(ext_lower, "bmp") == 0 || strcmp(ext_lower, "gif") == 0) {
-        return LV_SYMBOL_IMAGE;
-    } else if (strcmp(ext_lower, "txt") == 0 || strcmp(ext_lower, "log") == 0) {
-        return LV_SYMBOL_EDIT;
-    } else if (strcmp(ext_lower, "pdf") == 0) {
-        return LV_SYMBOL_DOWNLOAD;
-    } else {
-        return LV_SYMBOL_FILE;
-    }
+    return file_types_lookup(filename)->icon;
 }
 
 // 格式化文件大小
-static void format_file_size(size_t size, char* buffer, size_t buffer_size) {
+static void format_file_size(uint64_t size, char* buffer, size_t buffer_size) {
     if (size < 1024) {
-        snprintf(buffer, buffer_size, "%zu B", size);
+        snprintf(buffer, buffer_size, "%u B", (unsigned)size);
     } else if (size < 1024 * 1024) {
         snprintf(buffer, buffer_size, "%.1f KB", (float)size / 1024);
-    } else if (size < 1024 * 1024 * 1024) {
+    } else if (size < 1024ULL * 1024 * 1024) {
         snprintf(buffer, buffer_size, "%.1f MB", (float)size / (1024 * 1024));
     } else {
         snprintf(buffer, buffer_size, "%.1f GB", (float)size / (1024 * 1024 * 1024));
@@ -202,116 +213,40 @@ static void scan_directory(const char* path) {
     
     g_file_manager_state->is_scanning = true;
     
-    // 打开目录
-    DIR* dir = opendir(path);
-    if (!dir) {
-        printf("Failed to open directory: %s\n", path);
-        g_file_manager_state->is_scanning = false;
-        return;
-    }
+    // 优先使用缓存（目录未修改时无需重新遍历）；如果不是根目录，添加".."项
+    bool add_parent = strcmp(path, g_file_manager_state->root_path) != 0;
+    g_file_manager_state->listing = file_listing_cache_acquire(path, add_parent,
+                                                               &g_file_manager_state->restore_scroll_y);
     
-    // 第一次扫描：计算文件数量
-    struct dirent* entry;
-    uint32_t file_count = 0;
+    g_file_manager_state->is_scanning = false;
     
-    while ((entry = readdir(dir)) != NULL) {
-        // 跳过隐藏文件
-        if (is_hidden_file(entry->d_name)) {
-            continue;
+    // 后台监视当前目录，发现外部修改时刷新
+    if (strcmp(g_file_manager_state->watched_path, path) != 0) {
+        if (g_file_manager_state->watched_path[0] != '\0') {
+            fs_watch_remove_dir(g_file_manager_state->watched_path);
         }
-        file_count++;
-    }
-    
-    // 如果不是根目录，需要为".."项预留空间
-    if (strcmp(path, g_file_manager_state->root_path) != 0) {
-        file_count++;
+        strcpy(g_file_manager_state->watched_path, path);
+        fs_watch_add_dir(path);
     }
     
-    // 分配内存
-    g_file_manager_state->files = (file_item_t*)safe_malloc(file_count * sizeof(file_item_t));
-    if (!g_file_manager_state->files) {
-        printf("Failed to allocate memory for file list (count: %lu)\n", (unsigned long)file_count);
-        closedir(dir);
-        g_file_manager_state->is_scanning = false;
+    if (!g_file_manager_state->listing) {
+        printf("Failed to scan directory: %s\n", path);
         return;
     }
     
-    // 初始化内存
-    memset(g_file_manager_state->files, 0, file_count * sizeof(file_item_t));
-    
-    // 重新扫描目录，填充文件信息
-    rewinddir(dir);
-    g_file_manager_state->file_count = 0;
-    
-    // 如果不是根目录，添加".."项
-    if (strcmp(path, g_file_manager_state->root_path) != 0) {
-        file_item_t* parent_file = &g_file_manager_state->files[g_file_manager_state->file_count];
-        strcpy(parent_file->name, "..");
-        parent_file->type = FILE_TYPE_PARENT;
-        parent_file->size = 0;
-        parent_file->modified_time = 0;
-        parent_file->is_selected = false;
-        g_file_manager_state->file_count++;
-    }
-    
-    while ((entry = readdir(dir)) != NULL) {
-        // 跳过隐藏文件
-        if (is_hidden_file(entry->d_name)) {
-            continue;
-        }
-        
-        // 检查数组边界
-        if (g_file_manager_state->file_count >= file_count) {
-            printf("File count exceeded allocated space: %lu >= %lu\n", 
-                   (unsigned long)g_file_manager_state->file_count, (unsigned long)file_count);
-            break;
-        }
-        
-        file_item_t* file = &g_file_manager_state->files[g_file_manager_state->file_count];
-        if (!file) {
-            printf("Invalid file item pointer at index %lu\n", (unsigned long)g_file_manager_state->file_count);
-            break;
-        }
-        
-        // 设置文件名
-        strncpy(file->name, entry->d_name, sizeof(file->name) - 1);
-        file->name[sizeof(file->name) - 1] = '\0';
-        
-        // 设置完整路径
-        int full_path_len = snprintf(file->full_path, sizeof(file->full_path), "%s/%s", path, entry->d_name);
-        if (full_path_len >= sizeof(file->full_path)) {
-            printf("Full path too long: %s/%s\n", path, entry->d_name);
-            continue;
-        }
-        
-        // 设置文件类型
-        if (entry->d_type == DT_DIR) {
-            file->type = FILE_TYPE_DIRECTORY;
-        } else {
-            file->type = FILE_TYPE_FILE;
-        }
-        
-        // 获取文件信息
-        struct stat st;
-        if (stat(file->full_path, &st) == 0) {
-            file->size = st.st_size;
-            file->modified_time = st.st_mtime;
-        } else {
-            file->size = 0;
-            file->modified_time = 0;
-        }
-        
-        file->is_selected = false;
-        g_file_manager_state->file_count++;
-    }
-    
-    closedir(dir);
-    g_file_manager_state->is_scanning = false;
-    
-    printf("Scanned %lu files in directory\n", (unsigned long)g_file_manager_state->file_count);
+    printf("Scanned %lu files in directory (%zu bytes)\n",
+           (unsigned long)g_file_manager_state->listing->count,
+           file_listing_memory_usage(g_file_manager_state->listing));
     app_manager_log_memory_usage("After directory scan");
 }
 
+// 设置文件项选中样式
+static void set_item_selected_style(lv_obj_t* item, bool selected) {
+    lv_obj_set_style_bg_color(item, lv_color_hex(0xBBDEFB), 0);
+    lv_obj_set_style_bg_opa(item, selected ? LV_OPA_COVER : LV_OPA_TRANSP, 0);
+    lv_obj_set_style_radius(item, 8, 0);
+}
+
 // 创建文件列表UI
 static void create_file_list_ui(void) {
     if (!g_file_manager_state || !g_file_manager_state->file_list) {
@@ -319,7 +254,8 @@ static void create_file_list_ui(void) {
         return;
     }
     
-    if (!g_file_manager_state->files) {
+    file_listing_t* listing = g_file_manager_state->listing;
+    if (!listing) {
         printf("No file list available for UI creation\n");
         return;
     }
@@ -333,18 +269,11 @@ static void create_file_list_ui(void) {
     lv_obj_set_flex_align(g_file_manager_state->file_list, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER);
     lv_obj_set_style_pad_gap(g_file_manager_state->file_list, 8, 0);
     
-    // 创建文件项
-    for (uint32_t i = 0; i < g_file_manager_state->file_count; i++) {
-        if (i >= g_file_manager_state->file_count) {
-            printf("File index out of bounds: %lu >= %lu\n", (unsigned long)i, (unsigned long)g_file_manager_state->file_count);
-            break;
-        }
-        
-        file_item_t* file = &g_file_manager_state->files[i];
-        if (!file) {
-            printf("Invalid file item at index %lu\n", (unsigned long)i);
-            continue;
-        }
+    // 创建文件项（单独统计类型识别耗时）
+    int64_t classify_us = 0;
+    for (uint32_t i = 0; i < listing->count; i++) {
+        const file_entry_t* file = &listing->entries[i];
+        const char* name = file_listing_name(listing, i);
         
         // 创建文件项容器
         lv_obj_t* item_container = lv_obj_create(g_file_manager_state->file_list);
@@ -367,14 +296,17 @@ static void create_file_list_ui(void) {
         
         // 创建图标
         lv_obj_t* icon = lv_label_create(item_container);
-        lv_label_set_text(icon, get_file_icon(file->name, file->type));
+        int64_t classify_start = esp_timer_get_time();
+        const char* icon_text = get_file_icon(name, (file_type_t)file->type);
+        classify_us += esp_timer_get_time() - classify_start;
+        lv_label_set_text(icon, icon_text);
         lv_obj_set_style_text_color(icon, lv_color_hex(0x2196F3), 0);
         lv_obj_set_style_text_font(icon, &lv_font_montserrat_20, 0);
         lv_obj_align(icon, LV_ALIGN_LEFT_MID, 8, 0);
         
         // 创建文件名标签
         lv_obj_t* name_label = lv_label_create(item_container);
-        lv_label_set_text(name_label, file->name);
+        lv_label_set_text(name_label, name);
         lv_obj_set_style_text_color(name_label, lv_color_hex(0x333333), 0);
         lv_obj_set_style_text_font(name_label, &simhei_32, 0);
         lv_obj_align_to(name_label, icon, LV_ALIGN_OUT_RIGHT_MID, 12, 0);
@@ -385,7 +317,17 @@ static void create_file_list_ui(void) {
         if (file->type == FILE_TYPE_PARENT) {
             snprintf(info_text, sizeof(info_text), "返回上级");
         } else if (file->type == FILE_TYPE_DIRECTORY) {
-            snprintf(info_text, sizeof(info_text), "目录");
+            // 显示后台统计的目录大小（只读缓存，不访问SD卡）
+            char dir_path[512];
+            dir_size_info_t dir_info;
+            if (file_listing_full_path(listing, i, dir_path, sizeof(dir_path)) &&
+                dir_size_get(dir_path, &dir_info)) {
+                char size_text[32];
+                format_file_size(dir_info.total_bytes, size_text, sizeof(size_text));
+                snprintf(info_text, sizeof(info_text), "目录 %s", size_text);
+            } else {
+                snprintf(info_text, sizeof(info_text), "目录");
+            }
         } else {
             format_file_size(file->size, info_text, sizeof(info_text));
         }
@@ -394,8 +336,25 @@ static void create_file_list_ui(void) {
         lv_obj_set_style_text_font(info_label, &lv_font_montserrat_14, 0);
         lv_obj_align(info_label, LV_ALIGN_RIGHT_MID, -8, 0);
         
-        // 添加点击事件
-        lv_obj_add_event_cb(item_container, file_item_event_cb, LV_EVENT_CLICKED, file);
+        // 多选状态
+        if (file->flags & FILE_ENTRY_FLAG_SELECTED) {
+            set_item_selected_style(item_container, true);
+        }
+        
+        // 添加点击事件（短按打开，长按多选）
+        lv_obj_add_event_cb(item_container, file_item_event_cb, LV_EVENT_SHORT_CLICKED, (void*)(uintptr_t)i);
+        lv_obj_add_event_cb(item_container, file_item_long_press_cb, LV_EVENT_LONG_PRESSED, (void*)(uintptr_t)i);
+    }
+    if (listing->count > 0) {
+        printf("Classified %lu entries in %lld us (%lld ns/entry)\n", (unsigned long)listing->count,
+               (long long)classify_us, (long long)(classify_us * 1000 / listing->count));
+    }
+    
+    // 恢复上次离开该目录时的滚动位置
+    if (g_file_manager_state->restore_scroll_y > 0) {
+        lv_obj_update_layout(g_file_manager_state->file_list);
+        lv_obj_scroll_to_y(g_file_manager_state->file_list, g_file_manager_state->restore_scroll_y, LV_ANIM_OFF);
+        g_file_manager_state->restore_scroll_y = 0;
     }
 }
 
@@ -414,11 +373,24 @@ static void update_status_bar(void) {
         return;
     }
     
+    // 文件操作进行中时由进度定时器更新
+    if (file_ops_is_busy()) {
+        return;
+    }
+    
     char status_text[128];
-    snprintf(status_text, sizeof(status_text), 
-             "文件: %lu | 选中: %lu", 
-             (unsigned long)g_file_manager_state->file_count,
-             (unsigned long)g_file_manager_state->selected_count);
+    if (g_file_manager_state->clipboard) {
+        snprintf(status_text, sizeof(status_text), 
+                 "文件: %lu | 选中: %lu | 剪贴板: %lu", 
+                 (unsigned long)(g_file_manager_state->listing ? g_file_manager_state->listing->count : 0),
+                 (unsigned long)g_file_manager_state->selected_count,
+                 (unsigned long)g_file_manager_state->clipboard->count);
+    } else {
+        snprintf(status_text, sizeof(status_text), 
+                 "文件: %lu | 选中: %lu", 
+                 (unsigned long)(g_file_manager_state->listing ? g_file_manager_state->listing->count : 0),
+                 (unsigned long)g_file_manager_state->selected_count);
+    }
     
     lv_label_set_text(g_file_manager_state->status_bar, status_text);
 }
@@ -438,10 +410,10 @@ static void create_action_buttons(void) {
     lv_obj_set_flex_align(g_file_manager_state->action_buttons, LV_FLEX_ALIGN_SPACE_EVENLY, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
     
     // 创建按钮
-    const char* button_texts[] = {"复制", "删除", "重命名", "新建文件夹"};
-    const char* button_icons[] = {LV_SYMBOL_COPY, LV_SYMBOL_TRASH, LV_SYMBOL_EDIT, LV_SYMBOL_DIRECTORY};
+    const char* button_texts[] = {"复制", "剪切", "粘贴", "删除", "重命名", "新建文件夹", "存储", "搜索"};
+    const char* button_icons[] = {LV_SYMBOL_COPY, LV_SYMBOL_CUT, LV_SYMBOL_PASTE, LV_SYMBOL_TRASH, LV_SYMBOL_EDIT, LV_SYMBOL_DIRECTORY, LV_SYMBOL_SD_CARD, LV_SYMBOL_EYE_OPEN};
     
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < 8; i++) {
         lv_obj_t* button = lv_btn_create(g_file_manager_state->action_buttons);
         lv_obj_set_size(button, 80, 40);
         
@@ -469,18 +441,28 @@ static void file_item_event_cb(lv_event_t* e) {
         return;
     }
     
-    file_item_t* file = (file_item_t*)lv_event_get_user_data(e);
-    if (!file) {
-        printf("Invalid file data in file_item_event_cb\n");
+    uint32_t index = (uint32_t)(uintptr_t)lv_event_get_user_data(e);
+    
+    if (!g_file_manager_state || !g_file_manager_state->listing) {
+        printf("Invalid file manager state in file_item_event_cb\n");
         return;
     }
     
-    if (!g_file_manager_state) {
-        printf("Invalid file manager state in file_item_event_cb\n");
+    file_listing_t* listing = g_file_manager_state->listing;
+    if (index >= listing->count) {
+        printf("Invalid file index in file_item_event_cb: %lu\n", (unsigned long)index);
         return;
     }
     
-    printf("File clicked: %s\n", file->name);
+    const file_entry_t* file = &listing->entries[index];
+    const char* name = file_listing_name(listing, index);
+    printf("File clicked: %s\n", name);
+    
+    // 多选模式下短按切换选中状态
+    if (g_file_manager_state->selected_count > 0 && file->type != FILE_TYPE_PARENT) {
+        file_item_long_press_cb(e);
+        return;
+    }
     
     if (file->type == FILE_TYPE_PARENT) {
         // 返回上一级目录 - 使用安全的路径处理
@@ -510,11 +492,10 @@ static void file_item_event_cb(lv_event_t* e) {
             }
         }
     } else if (file->type == FILE_TYPE_DIRECTORY) {
-        // 进入目录 - 使用安全的路径构建
+        // 进入目录 - 按需构建完整路径
         char new_path[512];
-        int path_len = snprintf(new_path, sizeof(new_path), "%s/%s", g_file_manager_state->current_path, file->name);
-        if (path_len >= sizeof(new_path)) {
-            printf("Path too long: %s/%s\n", g_file_manager_state->current_path, file->name);
+        if (!file_listing_full_path(listing, index, new_path, sizeof(new_path))) {
+            printf("Path too long: %s/%s\n", listing->dir_path, name);
             return;
         }
         
@@ -536,149 +517,1546 @@ static void file_item_event_cb(lv_event_t* e) {
             printf("Failed to access directory: %s\n", new_path);
         }
     } else {
-        // 文件操作（这里可以添加文件预览等功能）
-        printf("File selected: %s (size: %zu bytes)\n", file->name, file->size);
+        // 按文件头确认类型后交给对应的处理模块
+        char file_path[512];
+        if (!file_listing_full_path(listing, index, file_path, sizeof(file_path))) {
+            return;
+        }
+        const file_type_info_t* file_type = file_types_sniff(file_path, file->size, file->modified_time);
+
+        if (file_type->handler == FILE_HANDLER_ARCHIVE && !g_file_manager_state->archive_panel) {
+            // 压缩包：只读取目录，按需解压
+            show_archive_panel(file_path);
+        } else if (file_type->handler == FILE_HANDLER_TEXT_VIEWER && !g_file_manager_state->text_viewer) {
+            // 文本文件：分页查看器（只读取可见部分）
+            g_file_manager_state->text_viewer = text_viewer_open(g_file_manager_state->app, g_file_manager_state->menu,
+                                                                 file_path, text_viewer_closed_cb, NULL);
+        } else {
+            printf("File selected: %s (%s, size: %lu bytes, handler: %s)\n", name, file_type->name,
+                   (unsigned long)file->size, file_type->handler_app ? file_type->handler_app : "none");
+        }
     }
 }
 
-// 操作按钮点击事件
-static void action_button_event_cb(lv_event_t* e) {
-    int button_id = (int)(intptr_t)lv_event_get_user_data(e);
-    
-    printf("Action button clicked: %d\n", button_id);
-    
-    // 这里可以添加具体的文件操作实现
-    switch (button_id) {
-        case 0: // 复制
-            printf("Copy action\n");
-            break;
-        case 1: // 删除
-            printf("Delete action\n");
-            break;
-        case 2: // 重命名
-            printf("Rename action\n");
-            break;
-        case 3: // 新建文件夹
-            printf("New folder action\n");
-            break;
+// 文本查看器关闭
+static void text_viewer_closed_cb(void* user_data) {
+    (void)user_data;
+    if (g_file_manager_state) {
+        g_file_manager_state->text_viewer = NULL;
     }
 }
 
-// 文件管理器App创建
-static void file_manager_create(app_t* app) {
-    if (!app || !app->container) {
+// 文件项长按事件：切换多选状态
+static void file_item_long_press_cb(lv_event_t* e) {
+    uint32_t index = (uint32_t)(uintptr_t)lv_event_get_user_data(e);
+    
+    if (!g_file_manager_state || !g_file_manager_state->listing) {
         return;
     }
     
-    printf("Creating file manager app\n");
-    app_manager_log_memory_usage("Before file manager creation");
-    
-    // 分配状态结构
-    g_file_manager_state = (file_manager_state_t*)safe_malloc(sizeof(file_manager_state_t));
-    if (!g_file_manager_state) {
-        printf("Failed to allocate file manager state\n");
+    file_listing_t* listing = g_file_manager_state->listing;
+    if (index >= listing->count || listing->entries[index].type == FILE_TYPE_PARENT) {
         return;
     }
     
-    memset(g_file_manager_state, 0, sizeof(file_manager_state_t));
+    file_entry_t* file = &listing->entries[index];
+    file->flags ^= FILE_ENTRY_FLAG_SELECTED;
     
-    // 设置初始路径
-    const char* mount_point = hal_sdcard_get_mount_point();
-    if (mount_point) {
-        strncpy(g_file_manager_state->current_path, mount_point, sizeof(g_file_manager_state->current_path) - 1);
-        strncpy(g_file_manager_state->root_path, mount_point, sizeof(g_file_manager_state->root_path) - 1);
-    } else {
-        strcpy(g_file_manager_state->current_path, "/sdcard");
-        strcpy(g_file_manager_state->root_path, "/sdcard");
+    bool selected = (file->flags & FILE_ENTRY_FLAG_SELECTED) != 0;
+    if (selected) {
+        g_file_manager_state->selected_count++;
+    } else if (g_file_manager_state->selected_count > 0) {
+        g_file_manager_state->selected_count--;
     }
     
-    // 创建主容器
-    g_file_manager_state->menu = lv_obj_create(app->container);
-    lv_obj_set_size(g_file_manager_state->menu, LV_PCT(100), LV_PCT(100));
-    lv_obj_set_pos(g_file_manager_state->menu, 0, 0);
-    lv_obj_set_style_pad_all(g_file_manager_state->menu, 16, 0);
+    set_item_selected_style(lv_event_get_current_target_obj(e), selected);
+    update_status_bar();
+}
+
+// 收集选中条目（dir_path为当前目录）
+static file_listing_t* collect_selection(void) {
+    file_listing_t* listing = g_file_manager_state->listing;
+    if (!listing || g_file_manager_state->selected_count == 0) {
+        return NULL;
+    }
     
-    // 创建路径显示
-    g_file_manager_state->path_label = lv_label_create(g_file_manager_state->menu);
-    lv_label_set_text(g_file_manager_state->path_label, g_file_manager_state->current_path);
-    lv_obj_set_style_text_color(g_file_manager_state->path_label, lv_color_hex(0x2196F3), 0);
-    lv_obj_set_style_text_font(g_file_manager_state->path_label, &simhei_32, 0);
-    lv_obj_align(g_file_manager_state->path_label, LV_ALIGN_TOP_LEFT, 0, 0);
+    file_listing_t* selection = file_listing_create(listing->dir_path);
+    if (!selection) {
+        return NULL;
+    }
     
-    // 创建状态栏
-    g_file_manager_state->status_bar = lv_label_create(g_file_manager_state->menu);
-    lv_label_set_text(g_file_manager_state->status_bar, "文件: 0 | 选中: 0");
-    lv_obj_set_style_text_color(g_file_manager_state->status_bar, lv_color_hex(0x666666), 0);
-    lv_obj_set_style_text_font(g_file_manager_state->status_bar, &simhei_32, 0);
-    lv_obj_align_to(g_file_manager_state->status_bar, g_file_manager_state->path_label, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 8);
+    for (uint32_t i = 0; i < listing->count; i++) {
+        const file_entry_t* file = &listing->entries[i];
+        if (!(file->flags & FILE_ENTRY_FLAG_SELECTED)) {
+            continue;
+        }
+        if (!file_listing_add(selection, file_listing_name(listing, i), (file_type_t)file->type,
+                              file->size, file->modified_time)) {
+            file_listing_free(selection);
+            return NULL;
+        }
+    }
     
-    // 创建文件列表容器
-    g_file_manager_state->file_list = lv_obj_create(g_file_manager_state->menu);
-    lv_obj_set_size(g_file_manager_state->file_list, LV_PCT(100), LV_PCT(70));
-    lv_obj_align_to(g_file_manager_state->file_list, g_file_manager_state->status_bar, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 8);
-    lv_obj_set_style_bg_opa(g_file_manager_state->file_list, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_border_width(g_file_manager_state->file_list, 0, 0);
-    lv_obj_set_style_pad_all(g_file_manager_state->file_list, 8, 0);
+    return selection;
+}
+
+// 清除选中状态（文件项与列表条目一一对应）
+static void clear_selection(void) {
+    file_listing_t* listing = g_file_manager_state->listing;
+    if (!listing) {
+        return;
+    }
     
-    // 创建操作按钮容器
-    g_file_manager_state->action_buttons = lv_obj_create(g_file_manager_state->menu);
-    lv_obj_set_size(g_file_manager_state->action_buttons, LV_PCT(100), 60);
-    lv_obj_align_to(g_file_manager_state->action_buttons, g_file_manager_state->file_list, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 8);
-    lv_obj_set_style_bg_opa(g_file_manager_state->action_buttons, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_border_width(g_file_manager_state->action_buttons, 0, 0);
-    lv_obj_set_style_pad_all(g_file_manager_state->action_buttons, 8, 0);
+    for (uint32_t i = 0; i < listing->count; i++) {
+        if (listing->entries[i].flags & FILE_ENTRY_FLAG_SELECTED) {
+            listing->entries[i].flags &= ~FILE_ENTRY_FLAG_SELECTED;
+            lv_obj_t* item = lv_obj_get_child(g_file_manager_state->file_list, (int32_t)i);
+            if (item) {
+                set_item_selected_style(item, false);
+            }
+        }
+    }
+    
+    g_file_manager_state->selected_count = 0;
+    update_status_bar();
+}
+
+// 丢弃当前列表并重新扫描（保持滚动位置）
+static void reload_current_directory(void) {
+    int32_t scroll_y = lv_obj_get_scroll_y(g_file_manager_state->file_list);
+    
+    if (g_file_manager_state->listing) {
+        file_listing_free(g_file_manager_state->listing);
+        g_file_manager_state->listing = NULL;
+        g_file_manager_state->selected_count = 0;
+    }
+    file_listing_cache_invalidate(g_file_manager_state->current_path);
     
-    // 扫描目录并创建UI
     scan_directory(g_file_manager_state->current_path);
+    g_file_manager_state->restore_scroll_y = scroll_y;
     create_file_list_ui();
-    update_path_display();
     update_status_bar();
-    create_action_buttons();
+}
+
+// 文件操作进度刷新
+static void progress_timer_cb(lv_timer_t* timer) {
+    if (!g_file_manager_state) {
+        return;
+    }
     
-    g_file_manager_state->is_initialized = true;
+    file_op_progress_t progress;
+    if (!file_ops_get_progress(&progress)) {
+        return;
+    }
     
-    app->user_data = g_file_manager_state;
+    const char* op_name = progress.type == FILE_OP_COPY ? "复制" :
+                          progress.type == FILE_OP_MOVE ? "移动" : "删除";
+    char status_text[192];
     
-    printf("File manager app created successfully\n");
-    app_manager_log_memory_usage("After file manager creation");
+    if (progress.state == FILE_OP_STATE_RUNNING) {
+        if (progress.bytes_total > 0) {
+            snprintf(status_text, sizeof(status_text), "%s中 %lu/%lu | %u%% | %.1f MB/s (点击取消)",
+                     op_name,
+                     (unsigned long)progress.files_done, (unsigned long)progress.files_total,
+                     (unsigned)(progress.bytes_done * 100 / progress.bytes_total),
+                     progress.mb_per_sec);
+        } else {
+            snprintf(status_text, sizeof(status_text), "%s中 %lu/%lu (点击取消)",
+                     op_name, (unsigned long)progress.files_done, (unsigned long)progress.files_total);
+        }
+        lv_label_set_text(g_file_manager_state->status_bar, status_text);
+        return;
+    }
+    
+    // 操作结束：停止刷新（修改过的目录已由file_ops报告给fs_watch，
+    // 列表缓存、目录大小和文件索引据此失效）
+    app_ctx_timer_delete(g_file_manager_state->app, g_file_manager_state->progress_timer);
+    g_file_manager_state->progress_timer = NULL;
+    
+    reload_current_directory();
+    
+    if (progress.state == FILE_OP_STATE_DONE) {
+        snprintf(status_text, sizeof(status_text), "%s完成: %lu 个文件 | %.1f MB/s",
+                 op_name, (unsigned long)progress.files_done, progress.mb_per_sec);
+    } else if (progress.state == FILE_OP_STATE_CANCELLED) {
+        snprintf(status_text, sizeof(status_text), "%s已取消", op_name);
+    } else {
+        snprintf(status_text, sizeof(status_text), "%s失败: %s", op_name, progress.error);
+    }
+    lv_label_set_text(g_file_manager_state->status_bar, status_text);
 }
 
-// 文件管理器App销毁
-static void file_manager_destroy(app_t* app) {
-    if (!app) {
+static void start_progress_timer(void) {
+    if (!g_file_manager_state->progress_timer) {
+        g_file_manager_state->progress_timer = app_ctx_timer_create(g_file_manager_state->app, progress_timer_cb, 200, NULL);
+    }
+    lv_timer_ready(g_file_manager_state->progress_timer);
+}
+
+// 状态栏点击：取消进行中的文件操作
+static void status_bar_event_cb(lv_event_t* e) {
+    (void)e;
+    file_ops_cancel();
+}
+
+// 删除确认对话框按钮
+static void delete_confirm_event_cb(lv_event_t* e) {
+    bool confirmed = (bool)(intptr_t)lv_event_get_user_data(e);
+    
+    if (!g_file_manager_state) {
         return;
     }
     
-    printf("Destroying file manager app\n");
-    app_manager_log_memory_usage("Before file manager destruction");
+    if (g_file_manager_state->confirm_box) {
+        lv_msgbox_close(g_file_manager_state->confirm_box);
+        g_file_manager_state->confirm_box = NULL;
+    }
     
-    if (g_file_manager_state) {
-        // 清理文件列表
-        cleanup_file_list();
-        
-        // 重置状态
-        g_file_manager_state->is_initialized = false;
-        g_file_manager_state->is_scanning = false;
-        
-        // 等待LVGL任务完成
-        lv_refr_now(NULL);
-        vTaskDelay(pdMS_TO_TICKS(20));
-        
-        // 释放状态结构
-        safe_free(g_file_manager_state);
-        g_file_manager_state = NULL;
+    if (!confirmed || file_ops_is_busy()) {
+        return;
     }
     
-    if (app) {
-        app->user_data = NULL;
+    file_listing_t* selection = collect_selection();
+    if (!selection) {
+        return;
     }
     
-    printf("File manager app destroyed\n");
-    app_manager_log_memory_usage("After file manager destruction");
+    if (file_ops_start(FILE_OP_DELETE, selection, NULL)) {
+        clear_selection();
+        start_progress_timer();
+    }
+    file_listing_free(selection);
+}
+
+static void show_delete_confirm(void) {
+    if (g_file_manager_state->selected_count == 0 || g_file_manager_state->confirm_box) {
+        printf("No files selected\n");
+        return;
+    }
+    
+    char text[64];
+    snprintf(text, sizeof(text), "删除选中的 %lu 项？", (unsigned long)g_file_manager_state->selected_count);
+    
+    lv_obj_t* mbox = lv_msgbox_create(NULL);
+    lv_obj_set_style_text_font(mbox, &simhei_32, 0);
+    lv_msgbox_add_title(mbox, "删除");
+    lv_msgbox_add_text(mbox, text);
+    
+    lv_obj_t* delete_btn = lv_msgbox_add_footer_button(mbox, "删除");
+    lv_obj_set_style_bg_color(delete_btn, lv_color_hex(0xF44336), 0);
+    lv_obj_add_event_cb(delete_btn, delete_confirm_event_cb, LV_EVENT_CLICKED, (void*)(intptr_t)true);
+    
+    lv_obj_t* cancel_btn = lv_msgbox_add_footer_button(mbox, "取消");
+    lv_obj_add_event_cb(cancel_btn, delete_confirm_event_cb, LV_EVENT_CLICKED, (void*)(intptr_t)false);
+    
+    g_file_manager_state->confirm_box = mbox;
+}
+
+// 存储空间分析行
+typedef struct {
+    uint32_t index;           // 列表索引，UINT32_MAX表示当前目录中的文件
+    uint64_t bytes;
+    bool pending;
+} storage_row_t;
+
+// 按占用降序
+static int storage_row_compare(const void* a, const void* b) {
+    uint64_t bytes_a = ((const storage_row_t*)a)->bytes;
+    uint64_t bytes_b = ((const storage_row_t*)b)->bytes;
+    return (bytes_a < bytes_b) - (bytes_a > bytes_b);
+}
+
+static void add_storage_row(const char* name, uint64_t bytes, uint64_t total, bool pending) {
+    lv_obj_t* row = lv_obj_create(g_file_manager_state->storage_list);
+    lv_obj_set_size(row, LV_PCT(100), 80);
+    lv_obj_set_style_bg_opa(row, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(row, 0, 0);
+    lv_obj_set_style_pad_all(row, 4, 0);
+    lv_obj_clear_flag(row, LV_OBJ_FLAG_SCROLLABLE);
+    
+    lv_obj_t* name_label = lv_label_create(row);
+    lv_label_set_text(name_label, name);
+    lv_label_set_long_mode(name_label, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(name_label, LV_PCT(65));
+    lv_obj_set_style_text_color(name_label, lv_color_hex(0x333333), 0);
+    lv_obj_set_style_text_font(name_label, &simhei_32, 0);
+    lv_obj_align(name_label, LV_ALIGN_TOP_LEFT, 0, 0);
+    
+    char size_text[48];
+    if (pending) {
+        snprintf(size_text, sizeof(size_text), "计算中");
+    } else {
+        format_file_size(bytes, size_text, sizeof(size_text));
+    }
+    lv_obj_t* size_label = lv_label_create(row);
+    lv_label_set_text(size_label, size_text);
+    lv_obj_set_style_text_color(size_label, lv_color_hex(0x666666), 0);
+    lv_obj_set_style_text_font(size_label, &simhei_32, 0);
+    lv_obj_align(size_label, LV_ALIGN_TOP_RIGHT, 0, 0);
+    
+    lv_obj_t* bar = lv_bar_create(row);
+    lv_obj_set_size(bar, LV_PCT(100), 10);
+    lv_bar_set_range(bar, 0, 1000);
+    lv_bar_set_value(bar, total > 0 ? (int32_t)(bytes * 1000 / total) : 0, LV_ANIM_OFF);
+    lv_obj_align(bar, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+}
+
+// 刷新存储空间面板（只读取缓存结果，不访问SD卡）
+static void refresh_storage_panel(void) {
+    if (!g_file_manager_state || !g_file_manager_state->storage_panel) {
+        return;
+    }
+    
+    g_file_manager_state->storage_generation = dir_size_get_generation();
+    lv_obj_clean(g_file_manager_state->storage_list);
+    
+    char summary[256];
+    int len = 0;
+    uint64_t card_total = 0, card_free = 0;
+    if (hal_sdcard_get_usage(&card_total, &card_free)) {
+        char used_text[32], total_text[32];
+        format_file_size(card_total - card_free, used_text, sizeof(used_text));
+        format_file_size(card_total, total_text, sizeof(total_text));
+        len += snprintf(summary + len, sizeof(summary) - len, "SD卡已用 %s / 共 %s\n", used_text, total_text);
+    }
+    
+    dir_size_info_t current;
+    bool have_current = dir_size_get(g_file_manager_state->current_path, &current);
+    if (have_current && current.pending && !dir_size_is_busy()) {
+        // 整个目录树被标记失效后不会自动统计，查看时按需重新统计
+        dir_size_request(g_file_manager_state->current_path, false);
+    }
+    if (have_current) {
+        char total_text[32];
+        format_file_size(current.total_bytes, total_text, sizeof(total_text));
+        snprintf(summary + len, sizeof(summary) - len, "当前目录 %s | %lu 个文件 | %lu 个目录%s",
+                 total_text, (unsigned long)current.total_files, (unsigned long)current.total_dirs,
+                 (current.pending || dir_size_is_busy()) ? " | 统计中..." : "");
+    } else {
+        snprintf(summary + len, sizeof(summary) - len, "正在统计当前目录...");
+    }
+    lv_label_set_text(g_file_manager_state->storage_summary, summary);
+    
+    file_listing_t* listing = g_file_manager_state->listing;
+    if (!listing) {
+        return;
+    }
+    
+    storage_row_t* rows = safe_malloc((listing->count + 1) * sizeof(storage_row_t));
+    if (!rows) {
+        return;
+    }
+    
+    uint32_t row_count = 0;
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < listing->count; i++) {
+        if (listing->entries[i].type != FILE_TYPE_DIRECTORY) {
+            continue;
+        }
+        
+        char dir_path[512];
+        dir_size_info_t info;
+        storage_row_t* row = &rows[row_count++];
+        row->index = i;
+        row->bytes = 0;
+        row->pending = true;
+        if (file_listing_full_path(listing, i, dir_path, sizeof(dir_path)) && dir_size_get(dir_path, &info)) {
+            row->bytes = info.total_bytes;
+            row->pending = info.pending;
+        }
+        sum += row->bytes;
+    }
+    if (have_current && current.own_bytes > 0) {
+        rows[row_count++] = (storage_row_t){ .index = UINT32_MAX, .bytes = current.own_bytes, .pending = false };
+        sum += current.own_bytes;
+    }
+    
+    qsort(rows, row_count, sizeof(storage_row_t), storage_row_compare);
+    
+    uint64_t total = (have_current && current.total_bytes > sum) ? current.total_bytes : sum;
+    for (uint32_t i = 0; i < row_count; i++) {
+        const char* name = rows[i].index == UINT32_MAX ? "(当前目录中的文件)" :
+                           file_listing_name(listing, rows[i].index);
+        add_storage_row(name, rows[i].bytes, total, rows[i].pending);
+    }
+    
+    safe_free(rows);
+}
+
+#define DUP_MIN_SIZE    4096        // 忽略小文件
+#define DUP_MAX_ROWS    200
+
+// 重复文件点击：跳转到所在目录
+static void dup_row_event_cb(lv_event_t* e) {
+    uint32_t index = (uint32_t)(uintptr_t)lv_event_get_user_data(e);
+    file_listing_t* results = g_file_manager_state ? g_file_manager_state->dup_results : NULL;
+    if (!results || index >= results->count) {
+        return;
+    }
+    
+    char path[512];
+    strncpy(path, file_listing_name(results, index), sizeof(path) - 1);
+    path[sizeof(path) - 1] = '\0';
+    char* last_slash = strrchr(path, '/');
+    if (last_slash && last_slash != path) {
+        *last_slash = '\0';
+    }
+    
+    close_storage_panel();
+    navigate_to(path);
+}
+
+static void add_dup_row(const char* text, uint32_t index, bool header) {
+    lv_obj_t* item = lv_obj_create(g_file_manager_state->storage_list);
+    lv_obj_set_size(item, LV_PCT(100), LV_SIZE_CONTENT);
+    lv_obj_set_style_bg_opa(item, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(item, 0, 0);
+    lv_obj_set_style_pad_all(item, 4, 0);
+    lv_obj_clear_flag(item, LV_OBJ_FLAG_SCROLLABLE);
+    if (!header) {
+        lv_obj_add_flag(item, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_add_event_cb(item, dup_row_event_cb, LV_EVENT_CLICKED, (void*)(uintptr_t)index);
+    }
+    
+    lv_obj_t* label = lv_label_create(item);
+    lv_label_set_text(label, text);
+    lv_label_set_long_mode(label, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(label, LV_PCT(100));
+    lv_obj_set_style_text_color(label, lv_color_hex(header ? 0x2196F3 : 0x333333), 0);
+    lv_obj_set_style_text_font(label, &simhei_32, 0);
+}
+
+// 显示查重结果：每组一行标题，下面列出各个副本
+static void show_dup_results(void) {
+    lv_obj_clean(g_file_manager_state->storage_list);
+    
+    file_listing_t* results = g_file_manager_state->dup_results;
+    if (!results) {
+        return;
+    }
+    
+    size_t root_len = strlen(g_file_manager_state->current_path);
+    uint32_t rows = 0;
+    for (uint32_t i = 0; i < results->count && rows < DUP_MAX_ROWS; i++) {
+        const file_entry_t* entry = &results->entries[i];
+        if (i == 0 || entry->modified_time != results->entries[i - 1].modified_time) {
+            uint32_t copies = 1;
+            while (i + copies < results->count && results->entries[i + copies].modified_time == entry->modified_time) {
+                copies++;
+            }
+            char size_text[32], header[96];
+            format_file_size(entry->size, size_text, sizeof(size_text));
+            snprintf(header, sizeof(header), "%s x %lu", size_text, (unsigned long)copies);
+            add_dup_row(header, i, true);
+            rows++;
+        }
+        
+        // 显示相对当前目录的路径
+        const char* path = file_listing_name(results, i);
+        add_dup_row(strlen(path) > root_len ? path + root_len + 1 : path, i, false);
+        rows++;
+    }
+}
+
+// 查重进度刷新；完成后取走结果
+static void refresh_dup_panel(void) {
+    dup_finder_progress_t progress;
+    if (!dup_finder_get_progress(&progress)) {
+        return;
+    }
+    
+    char read_text[32], total_text[32];
+    format_file_size(progress.bytes_read, read_text, sizeof(read_text));
+    format_file_size(progress.bytes_total, total_text, sizeof(total_text));
+    
+    if (progress.state == DUP_FINDER_STATE_RUNNING) {
+        const char* stage = progress.stage == DUP_FINDER_STAGE_SCAN ? "遍历" :
+                            progress.stage == DUP_FINDER_STAGE_PARTIAL ? "比较首尾" : "比较全文";
+        lv_label_set_text_fmt(g_file_manager_state->storage_summary, "查重中（%s）%lu 个文件\n已读 %s / 共 %s (点击查重取消)",
+                              stage, (unsigned long)progress.files_scanned, read_text, total_text);
+        return;
+    }
+    
+    if (!g_file_manager_state->dup_results) {
+        g_file_manager_state->dup_results = dup_finder_take_results();
+        show_dup_results();
+    }
+    
+    if (progress.state == DUP_FINDER_STATE_DONE) {
+        char wasted_text[32];
+        format_file_size(progress.wasted_bytes, wasted_text, sizeof(wasted_text));
+        lv_label_set_text_fmt(g_file_manager_state->storage_summary, "重复 %lu 组 | 可释放 %s\n已读 %s / 共 %s | 缓存 %lu 个文件",
+                              (unsigned long)progress.groups, wasted_text, read_text, total_text,
+                              (unsigned long)progress.cache_hits);
+    } else if (progress.state == DUP_FINDER_STATE_CANCELLED) {
+        lv_label_set_text(g_file_manager_state->storage_summary, "查重已取消");
+    } else {
+        lv_label_set_text_fmt(g_file_manager_state->storage_summary, "查重失败: %s", progress.error);
+    }
+}
+
+// 在当前目录下查重；查找中再次点击取消
+static void dup_button_event_cb(lv_event_t* e) {
+    (void)e;
+    if (dup_finder_is_busy()) {
+        dup_finder_cancel();
+        return;
+    }
+    
+    if (g_file_manager_state->dup_results) {
+        file_listing_free(g_file_manager_state->dup_results);
+        g_file_manager_state->dup_results = NULL;
+    }
+    if (dup_finder_start(g_file_manager_state->current_path, DUP_MIN_SIZE)) {
+        g_file_manager_state->storage_dups = true;
+        lv_obj_clean(g_file_manager_state->storage_list);
+        refresh_dup_panel();
+    }
+}
+
+// 后台统计结果变化时刷新面板
+static void storage_timer_cb(lv_timer_t* timer) {
+    if (!g_file_manager_state) {
+        return;
+    }
+    if (g_file_manager_state->storage_dups) {
+        if (dup_finder_is_busy() || !g_file_manager_state->dup_results) {
+            refresh_dup_panel();
+        }
+    } else if (g_file_manager_state->storage_generation != dir_size_get_generation()) {
+        refresh_storage_panel();
+    }
+}
+
+static void storage_close_event_cb(lv_event_t* e) {
+    (void)e;
+    close_storage_panel();
+}
+
+static void close_storage_panel(void) {
+    if (!g_file_manager_state || !g_file_manager_state->storage_panel) {
+        return;
+    }
+    
+    if (g_file_manager_state->storage_timer) {
+        app_ctx_timer_delete(g_file_manager_state->app, g_file_manager_state->storage_timer);
+        g_file_manager_state->storage_timer = NULL;
+    }
+    
+    dup_finder_cancel();
+    if (g_file_manager_state->dup_results) {
+        file_listing_free(g_file_manager_state->dup_results);
+        g_file_manager_state->dup_results = NULL;
+    }
+    g_file_manager_state->storage_dups = false;
+    
+    // 可能在面板内按钮的事件回调中调用，延迟删除
+    lv_obj_delete_async(g_file_manager_state->storage_panel);
+    g_file_manager_state->storage_panel = NULL;
+    g_file_manager_state->storage_list = NULL;
+    g_file_manager_state->storage_summary = NULL;
+    
+    // 刷新列表中的目录大小
+    g_file_manager_state->restore_scroll_y = lv_obj_get_scroll_y(g_file_manager_state->file_list);
+    create_file_list_ui();
+}
+
+// 显示存储空间分析面板：立即显示缓存结果，后台更新后自动刷新
+static void show_storage_panel(void) {
+    if (g_file_manager_state->storage_panel) {
+        return;
+    }
+    
+    // 当前目录的有效缓存会被复用，只统计缺失或失效的部分
+    dir_size_request(g_file_manager_state->current_path, false);
+    
+    lv_obj_t* panel = lv_obj_create(g_file_manager_state->menu);
+    lv_obj_set_size(panel, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_pos(panel, 0, 0);
+    lv_obj_set_style_bg_color(panel, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_bg_opa(panel, LV_OPA_COVER, 0);
+    lv_obj_set_style_pad_all(panel, 16, 0);
+    lv_obj_clear_flag(panel, LV_OBJ_FLAG_SCROLLABLE);
+    g_file_manager_state->storage_panel = panel;
+    
+    lv_obj_t* title = lv_label_create(panel);
+    lv_label_set_text(title, "存储空间");
+    lv_obj_set_style_text_color(title, lv_color_hex(0x2196F3), 0);
+    lv_obj_set_style_text_font(title, &simhei_32, 0);
+    lv_obj_align(title, LV_ALIGN_TOP_LEFT, 0, 0);
+    
+    lv_obj_t* close_btn = lv_btn_create(panel);
+    lv_obj_set_size(close_btn, 100, 48);
+    lv_obj_set_style_bg_color(close_btn, lv_color_hex(0x2196F3), 0);
+    lv_obj_set_style_radius(close_btn, 8, 0);
+    lv_obj_align(close_btn, LV_ALIGN_TOP_RIGHT, 0, 0);
+    lv_obj_add_event_cb(close_btn, storage_close_event_cb, LV_EVENT_CLICKED, NULL);
+    
+    lv_obj_t* close_label = lv_label_create(close_btn);
+    lv_label_set_text(close_label, "关闭");
+    lv_obj_set_style_text_color(close_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(close_label, &simhei_32, 0);
+    lv_obj_center(close_label);
+    
+    // 在当前目录下查找重复文件
+    lv_obj_t* dup_btn = lv_btn_create(panel);
+    lv_obj_set_size(dup_btn, 100, 48);
+    lv_obj_set_style_bg_color(dup_btn, lv_color_hex(0x2196F3), 0);
+    lv_obj_set_style_radius(dup_btn, 8, 0);
+    lv_obj_align_to(dup_btn, close_btn, LV_ALIGN_OUT_LEFT_MID, -8, 0);
+    lv_obj_add_event_cb(dup_btn, dup_button_event_cb, LV_EVENT_CLICKED, NULL);
+    
+    lv_obj_t* dup_label = lv_label_create(dup_btn);
+    lv_label_set_text(dup_label, "查重");
+    lv_obj_set_style_text_color(dup_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(dup_label, &simhei_32, 0);
+    lv_obj_center(dup_label);
+    
+    g_file_manager_state->storage_summary = lv_label_create(panel);
+    lv_obj_set_width(g_file_manager_state->storage_summary, LV_PCT(100));
+    lv_obj_set_style_text_color(g_file_manager_state->storage_summary, lv_color_hex(0x666666), 0);
+    lv_obj_set_style_text_font(g_file_manager_state->storage_summary, &simhei_32, 0);
+    lv_obj_align(g_file_manager_state->storage_summary, LV_ALIGN_TOP_LEFT, 0, 64);
+    
+    g_file_manager_state->storage_list = lv_obj_create(panel);
+    lv_obj_set_size(g_file_manager_state->storage_list, LV_PCT(100), LV_PCT(78));
+    lv_obj_align(g_file_manager_state->storage_list, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_set_style_bg_opa(g_file_manager_state->storage_list, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(g_file_manager_state->storage_list, 0, 0);
+    lv_obj_set_style_pad_all(g_file_manager_state->storage_list, 0, 0);
+    lv_obj_set_layout(g_file_manager_state->storage_list, LV_LAYOUT_FLEX);
+    lv_obj_set_flex_flow(g_file_manager_state->storage_list, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_style_pad_gap(g_file_manager_state->storage_list, 8, 0);
+    
+    refresh_storage_panel();
+    g_file_manager_state->storage_timer = app_ctx_timer_create(g_file_manager_state->app, storage_timer_cb, 500, NULL);
+}
+
+// SD卡插拔后缓存的列表和打开的压缩包都已失效，回到根目录重新扫描；
+// 当前目录被其他App或外部修改时重新读取
+static void watch_timer_cb(lv_timer_t* timer) {
+    (void)timer;
+    if (!g_file_manager_state) {
+        return;
+    }
+    
+    uint32_t generation = hal_sdcard_get_generation();
+    if (generation == g_file_manager_state->sd_generation) {
+        // 文件操作和解压结束时由各自的进度定时器刷新；有选中项或对话框时不打断用户
+        file_listing_t* listing = g_file_manager_state->listing;
+        if (listing && !file_ops_is_busy() && !archive_extract_is_busy() &&
+            g_file_manager_state->selected_count == 0 && !g_file_manager_state->confirm_box &&
+            listing->generation != fs_watch_get_generation(g_file_manager_state->current_path)) {
+            printf("Directory changed: %s\n", g_file_manager_state->current_path);
+            reload_current_directory();
+        }
+        return;
+    }
+    g_file_manager_state->sd_generation = generation;
+    printf("SD card %s, reloading file manager\n", hal_sdcard_is_mounted() ? "mounted" : "removed");
+    
+    if (g_file_manager_state->archive_panel) {
+        close_archive_panel();
+    }
+    clear_selection();
+    file_listing_cache_clear();
+    navigate_to(g_file_manager_state->root_path);
+}
+
+// 跳转到指定目录
+static void navigate_to(const char* path) {
+    if (strlen(path) >= sizeof(g_file_manager_state->current_path)) {
+        return;
+    }
+    
+    strcpy(g_file_manager_state->current_path, path);
+    scan_directory(g_file_manager_state->current_path);
+    create_file_list_ui();
+    update_path_display();
+    update_status_bar();
+}
+
+#define SEARCH_MAX_RESULTS 100
+
+// 索引查询结果：以完整路径保存到结果列表
+static bool search_result_cb(const char* dir_path, const char* name, bool is_dir, uint32_t size, void* user_data) {
+    file_listing_t* results = (file_listing_t*)user_data;
+    char full_path[512];
+    int len = snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, name);
+    if (len < 0 || (size_t)len >= sizeof(full_path)) {
+        return true;
+    }
+    return file_listing_add(results, full_path, is_dir ? FILE_TYPE_DIRECTORY : FILE_TYPE_FILE, size, 0);
+}
+
+// 搜索结果点击：内容匹配在查看器中定位，文件名匹配跳转到所在目录
+static void search_result_event_cb(lv_event_t* e) {
+    uint32_t index = (uint32_t)(uintptr_t)lv_event_get_user_data(e);
+    file_listing_t* results = g_file_manager_state ? g_file_manager_state->search_results : NULL;
+    if (!results || index >= results->count) {
+        return;
+    }
+    
+    char path[512];
+    strncpy(path, file_listing_name(results, index), sizeof(path) - 1);
+    path[sizeof(path) - 1] = '\0';
+    
+    if (g_file_manager_state->search_content) {
+        uint32_t offset = results->entries[index].size;
+        close_search_panel();
+        if (!g_file_manager_state->text_viewer) {
+            g_file_manager_state->text_viewer = text_viewer_open(g_file_manager_state->app, g_file_manager_state->menu,
+                                                                 path, text_viewer_closed_cb, NULL);
+            text_viewer_goto_offset(g_file_manager_state->text_viewer, offset);
+        }
+        return;
+    }
+    
+    if (results->entries[index].type != FILE_TYPE_DIRECTORY) {
+        char* last_slash = strrchr(path, '/');
+        if (last_slash && last_slash != path) {
+            *last_slash = '\0';
+        }
+    }
+    
+    close_search_panel();
+    navigate_to(path);
+}
+
+static void add_search_row(uint32_t index, const char* text) {
+    lv_obj_t* item = lv_obj_create(g_file_manager_state->search_list);
+    lv_obj_set_size(item, LV_PCT(100), LV_SIZE_CONTENT);
+    lv_obj_set_style_bg_opa(item, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(item, 0, 0);
+    lv_obj_set_style_pad_all(item, 4, 0);
+    lv_obj_clear_flag(item, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(item, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(item, search_result_event_cb, LV_EVENT_CLICKED, (void*)(uintptr_t)index);
+    
+    lv_obj_t* label = lv_label_create(item);
+    lv_label_set_text(label, text);
+    lv_label_set_long_mode(label, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(label, LV_PCT(100));
+    lv_obj_set_style_text_color(label, lv_color_hex(0x333333), 0);
+    lv_obj_set_style_text_font(label, &simhei_32, 0);
+}
+
+// 执行文件名搜索（只查询内存中的索引，不访问SD卡）
+static void run_search(void) {
+    if (!g_file_manager_state || !g_file_manager_state->search_panel) {
+        return;
+    }
+    
+    file_grep_cancel();
+    g_file_manager_state->search_content = false;
+    g_file_manager_state->search_content_pending = false;
+    lv_obj_clean(g_file_manager_state->search_list);
+    if (g_file_manager_state->search_results) {
+        file_listing_free(g_file_manager_state->search_results);
+        g_file_manager_state->search_results = NULL;
+    }
+    
+    const char* query = lv_textarea_get_text(g_file_manager_state->search_input);
+    file_index_stats_t stats;
+    file_index_get_stats(&stats);
+    g_file_manager_state->search_generation = stats.generation;
+    
+    if (!stats.ready) {
+        lv_label_set_text(g_file_manager_state->search_status, "正在建立文件索引...");
+        return;
+    }
+    if (query[0] == '\0') {
+        lv_label_set_text_fmt(g_file_manager_state->search_status, "已索引 %lu 个文件%s",
+                              (unsigned long)stats.entry_count, stats.building ? " | 更新中..." : "");
+        return;
+    }
+    
+    file_listing_t* results = file_listing_create("");
+    if (!results) {
+        return;
+    }
+    int count = file_index_query(query, FILE_INDEX_MATCH_SUBSTRING, SEARCH_MAX_RESULTS, search_result_cb, results);
+    file_index_get_stats(&stats);
+    g_file_manager_state->search_results = results;
+    
+    lv_label_set_text_fmt(g_file_manager_state->search_status, "%s%d 个结果 | %lu us%s",
+                          count >= SEARCH_MAX_RESULTS ? "前 " : "", count < 0 ? 0 : count,
+                          (unsigned long)stats.last_query_us, stats.building ? " | 索引更新中..." : "");
+    
+    for (uint32_t i = 0; i < results->count; i++) {
+        char text[560];
+        snprintf(text, sizeof(text), "%s %s",
+                 results->entries[i].type == FILE_TYPE_DIRECTORY ? LV_SYMBOL_DIRECTORY : LV_SYMBOL_FILE,
+                 file_listing_name(results, i) + strlen(g_file_manager_state->root_path));
+        add_search_row(i, text);
+    }
+}
+
+// 启动内容搜索任务（上一次的任务已退出）
+static void launch_content_search(void) {
+    const char* query = lv_textarea_get_text(g_file_manager_state->search_input);
+    g_file_manager_state->search_content_pending = false;
+    if (query[0] == '\0' || !g_file_manager_state->search_results ||
+        !file_grep_start(g_file_manager_state->current_path, query, true)) {
+        lv_label_set_text(g_file_manager_state->search_status, "无法开始内容搜索");
+        return;
+    }
+    lv_label_set_text(g_file_manager_state->search_status, "正在搜索文件内容...");
+}
+
+// 在当前目录下搜索文件内容，匹配由定时器逐批取回
+static void start_content_search(void) {
+    const char* query = lv_textarea_get_text(g_file_manager_state->search_input);
+    if (query[0] == '\0') {
+        return;
+    }
+    
+    lv_obj_clean(g_file_manager_state->search_list);
+    if (g_file_manager_state->search_results) {
+        file_listing_free(g_file_manager_state->search_results);
+    }
+    g_file_manager_state->search_results = file_listing_create("");
+    g_file_manager_state->search_content = true;
+    
+    // 上一次搜索的任务还在运行时不在界面线程中等待，由定时器在它退出后启动
+    file_grep_cancel();
+    if (file_grep_is_busy()) {
+        g_file_manager_state->search_content_pending = true;
+        lv_label_set_text(g_file_manager_state->search_status, "正在停止上一次搜索...");
+        return;
+    }
+    launch_content_search();
+}
+
+// 取回内容搜索的新匹配并更新进度
+static void poll_content_search(void) {
+    file_listing_t* results = g_file_manager_state->search_results;
+    file_grep_match_t matches[8];
+    uint32_t count;
+    
+    while (results && results->count < SEARCH_MAX_RESULTS &&
+           (count = file_grep_fetch_matches(matches, 8)) > 0) {
+        for (uint32_t i = 0; i < count && results->count < SEARCH_MAX_RESULTS; i++) {
+            if (!file_listing_add(results, matches[i].path, FILE_TYPE_FILE, matches[i].offset, matches[i].line)) {
+                break;
+            }
+            char text[420];
+            snprintf(text, sizeof(text), "%s:%lu  %s",
+                     matches[i].path + strlen(g_file_manager_state->root_path),
+                     (unsigned long)matches[i].line, matches[i].context);
+            add_search_row(results->count - 1, text);
+        }
+    }
+    
+    // 只显示前SEARCH_MAX_RESULTS条，够了就停止读取
+    bool limited = results && results->count >= SEARCH_MAX_RESULTS;
+    if (limited) {
+        file_grep_cancel();
+    }
+    
+    file_grep_progress_t progress;
+    if (!file_grep_get_progress(&progress)) {
+        return;
+    }
+    char size_text[32];
+    format_file_size(progress.bytes_scanned, size_text, sizeof(size_text));
+    
+    if (progress.state == FILE_GREP_STATE_RUNNING) {
+        lv_label_set_text_fmt(g_file_manager_state->search_status, "搜索中 %lu 个文件 | %s | %.1f MB/s | %s",
+                              (unsigned long)progress.files_scanned, size_text, progress.mb_per_sec, progress.current);
+    } else if (progress.state == FILE_GREP_STATE_FAILED) {
+        lv_label_set_text_fmt(g_file_manager_state->search_status, "内容搜索失败: %s", progress.error);
+    } else {
+        lv_label_set_text_fmt(g_file_manager_state->search_status, "%s%lu 个匹配 | %lu 个文件 | %s | %.1f MB/s%s",
+                              (limited || progress.truncated) ? "前 " : "",
+                              (unsigned long)(results ? results->count : 0),
+                              (unsigned long)progress.files_scanned, size_text, progress.mb_per_sec,
+                              (progress.state == FILE_GREP_STATE_CANCELLED && !limited) ? " | 已取消" : "");
+    }
+}
+
+static void search_input_event_cb(lv_event_t* e) {
+    if (lv_event_get_code(e) == LV_EVENT_READY) {
+        start_content_search();
+    } else {
+        run_search();
+    }
+}
+
+static void content_search_event_cb(lv_event_t* e) {
+    (void)e;
+    start_content_search();
+}
+
+// 内容搜索时取回匹配；文件名搜索时在后台索引更新后刷新结果
+static void search_timer_cb(lv_timer_t* timer) {
+    if (!g_file_manager_state) {
+        return;
+    }
+    
+    if (g_file_manager_state->search_content_pending) {
+        if (!file_grep_is_busy()) {
+            launch_content_search();
+        }
+        return;
+    }
+    if (g_file_manager_state->search_content) {
+        poll_content_search();
+        return;
+    }
+    
+    file_index_stats_t stats;
+    file_index_get_stats(&stats);
+    if (g_file_manager_state->search_generation != stats.generation) {
+        run_search();
+    }
+}
+
+static void search_close_event_cb(lv_event_t* e) {
+    (void)e;
+    close_search_panel();
+}
+
+static void close_search_panel(void) {
+    if (!g_file_manager_state || !g_file_manager_state->search_panel) {
+        return;
+    }
+    
+    if (g_file_manager_state->search_timer) {
+        app_ctx_timer_delete(g_file_manager_state->app, g_file_manager_state->search_timer);
+        g_file_manager_state->search_timer = NULL;
+    }
+    file_grep_cancel();
+    g_file_manager_state->search_content_pending = false;
+    
+    // 可能在面板内的事件回调中调用，延迟删除
+    lv_obj_delete_async(g_file_manager_state->search_panel);
+    g_file_manager_state->search_panel = NULL;
+    g_file_manager_state->search_input = NULL;
+    g_file_manager_state->search_list = NULL;
+    g_file_manager_state->search_status = NULL;
+    
+    if (g_file_manager_state->search_results) {
+        file_listing_free(g_file_manager_state->search_results);
+        g_file_manager_state->search_results = NULL;
+    }
+}
+
+// 显示全局搜索面板：输入时即时查询整张SD卡的文件名索引
+static void show_search_panel(void) {
+    if (g_file_manager_state->search_panel) {
+        return;
+    }
+    
+    lv_obj_t* panel = lv_obj_create(g_file_manager_state->menu);
+    lv_obj_set_size(panel, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_pos(panel, 0, 0);
+    lv_obj_set_style_bg_color(panel, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_bg_opa(panel, LV_OPA_COVER, 0);
+    lv_obj_set_style_pad_all(panel, 16, 0);
+    lv_obj_clear_flag(panel, LV_OBJ_FLAG_SCROLLABLE);
+    g_file_manager_state->search_panel = panel;
+    
+    lv_obj_t* close_btn = lv_btn_create(panel);
+    lv_obj_set_size(close_btn, 100, 48);
+    lv_obj_set_style_bg_color(close_btn, lv_color_hex(0x2196F3), 0);
+    lv_obj_set_style_radius(close_btn, 8, 0);
+    lv_obj_align(close_btn, LV_ALIGN_TOP_RIGHT, 0, 0);
+    lv_obj_add_event_cb(close_btn, search_close_event_cb, LV_EVENT_CLICKED, NULL);
+    
+    lv_obj_t* close_label = lv_label_create(close_btn);
+    lv_label_set_text(close_label, "关闭");
+    lv_obj_set_style_text_color(close_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(close_label, &simhei_32, 0);
+    lv_obj_center(close_label);
+    
+    // 在当前目录下搜索文件内容
+    lv_obj_t* content_btn = lv_btn_create(panel);
+    lv_obj_set_size(content_btn, 140, 48);
+    lv_obj_set_style_bg_color(content_btn, lv_color_hex(0x2196F3), 0);
+    lv_obj_set_style_radius(content_btn, 8, 0);
+    lv_obj_align_to(content_btn, close_btn, LV_ALIGN_OUT_LEFT_MID, -8, 0);
+    lv_obj_add_event_cb(content_btn, content_search_event_cb, LV_EVENT_CLICKED, NULL);
+    
+    lv_obj_t* content_label = lv_label_create(content_btn);
+    lv_label_set_text(content_label, "搜内容");
+    lv_obj_set_style_text_color(content_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(content_label, &simhei_32, 0);
+    lv_obj_center(content_label);
+    
+    g_file_manager_state->search_input = lv_textarea_create(panel);
+    lv_textarea_set_one_line(g_file_manager_state->search_input, true);
+    lv_textarea_set_max_length(g_file_manager_state->search_input, 64);
+    lv_textarea_set_placeholder_text(g_file_manager_state->search_input, "搜索文件名");
+    lv_obj_set_width(g_file_manager_state->search_input, LV_PCT(65));
+    lv_obj_set_style_text_font(g_file_manager_state->search_input, &simhei_32, 0);
+    lv_obj_align(g_file_manager_state->search_input, LV_ALIGN_TOP_LEFT, 0, 0);
+    lv_obj_add_event_cb(g_file_manager_state->search_input, search_input_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    lv_obj_add_event_cb(g_file_manager_state->search_input, search_input_event_cb, LV_EVENT_READY, NULL);
+    
+    g_file_manager_state->search_status = lv_label_create(panel);
+    lv_obj_set_style_text_color(g_file_manager_state->search_status, lv_color_hex(0x666666), 0);
+    lv_obj_set_style_text_font(g_file_manager_state->search_status, &simhei_32, 0);
+    lv_obj_align(g_file_manager_state->search_status, LV_ALIGN_TOP_LEFT, 0, 64);
+    
+    g_file_manager_state->search_list = lv_obj_create(panel);
+    lv_obj_set_size(g_file_manager_state->search_list, LV_PCT(100), LV_PCT(40));
+    lv_obj_align(g_file_manager_state->search_list, LV_ALIGN_TOP_LEFT, 0, 110);
+    lv_obj_set_style_bg_opa(g_file_manager_state->search_list, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(g_file_manager_state->search_list, 0, 0);
+    lv_obj_set_style_pad_all(g_file_manager_state->search_list, 0, 0);
+    lv_obj_set_layout(g_file_manager_state->search_list, LV_LAYOUT_FLEX);
+    lv_obj_set_flex_flow(g_file_manager_state->search_list, LV_FLEX_FLOW_COLUMN);
+    
+    lv_obj_t* keyboard = lv_keyboard_create(panel);
+    lv_keyboard_set_textarea(keyboard, g_file_manager_state->search_input);
+    lv_obj_set_size(keyboard, LV_PCT(100), LV_PCT(40));
+    lv_obj_align(keyboard, LV_ALIGN_BOTTOM_MID, 0, 0);
+    
+    run_search();
+    g_file_manager_state->search_timer = app_ctx_timer_create(g_file_manager_state->app, search_timer_cb, 200, NULL);
+}
+
+#define ARCHIVE_MAX_ROWS 500
+
+static void update_archive_status(void) {
+    archive_t* archive = g_file_manager_state->archive;
+    char size_text[32];
+    format_file_size(archive->total_size, size_text, sizeof(size_text));
+    if (g_file_manager_state->archive_selected_count > 0) {
+        lv_label_set_text_fmt(g_file_manager_state->archive_status, "%lu 个条目 | %s | 已选 %lu",
+                              (unsigned long)archive->count, size_text,
+                              (unsigned long)g_file_manager_state->archive_selected_count);
+    } else {
+        lv_label_set_text_fmt(g_file_manager_state->archive_status, "%lu 个条目 | %s%s",
+                              (unsigned long)archive->count, size_text,
+                              archive->count > ARCHIVE_MAX_ROWS ? " | 仅显示前500项" : "");
+    }
+}
+
+// 条目点击：切换选中状态
+static void archive_row_event_cb(lv_event_t* e) {
+    uint32_t index = (uint32_t)(uintptr_t)lv_event_get_user_data(e);
+    if (!g_file_manager_state || !g_file_manager_state->archive || archive_extract_is_busy()) {
+        return;
+    }
+    
+    bool selected = !g_file_manager_state->archive_selected[index];
+    g_file_manager_state->archive_selected[index] = selected;
+    g_file_manager_state->archive_selected_count += selected ? 1 : -1;
+    set_item_selected_style(lv_event_get_current_target_obj(e), selected);
+    update_archive_status();
+}
+
+static void add_archive_row(uint32_t index) {
+    const archive_entry_t* entry = &g_file_manager_state->archive->entries[index];
+    
+    lv_obj_t* item = lv_obj_create(g_file_manager_state->archive_list);
+    lv_obj_set_size(item, LV_PCT(100), LV_SIZE_CONTENT);
+    lv_obj_set_style_bg_opa(item, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(item, 0, 0);
+    lv_obj_set_style_pad_all(item, 4, 0);
+    lv_obj_clear_flag(item, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(item, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(item, archive_row_event_cb, LV_EVENT_CLICKED, (void*)(uintptr_t)index);
+    
+    lv_obj_t* name_label = lv_label_create(item);
+    lv_label_set_text_fmt(name_label, "%s %s", entry->is_dir ? LV_SYMBOL_DIRECTORY : LV_SYMBOL_FILE,
+                          archive_entry_name(g_file_manager_state->archive, index));
+    lv_label_set_long_mode(name_label, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(name_label, LV_PCT(75));
+    lv_obj_set_style_text_color(name_label, lv_color_hex(entry->method == ARCHIVE_METHOD_UNSUPPORTED ? 0x999999 : 0x333333), 0);
+    lv_obj_set_style_text_font(name_label, &simhei_32, 0);
+    lv_obj_align(name_label, LV_ALIGN_LEFT_MID, 0, 0);
+    
+    if (!entry->is_dir) {
+        char size_text[32];
+        if (entry->method == ARCHIVE_METHOD_UNSUPPORTED) {
+            snprintf(size_text, sizeof(size_text), "不支持");
+        } else {
+            format_file_size(entry->size, size_text, sizeof(size_text));
+        }
+        lv_obj_t* size_label = lv_label_create(item);
+        lv_label_set_text(size_label, size_text);
+        lv_obj_set_style_text_color(size_label, lv_color_hex(0x666666), 0);
+        lv_obj_set_style_text_font(size_label, &simhei_32, 0);
+        lv_obj_align(size_label, LV_ALIGN_RIGHT_MID, 0, 0);
+    }
+}
+
+// 解压进度刷新；结束后刷新当前目录
+static void archive_timer_cb(lv_timer_t* timer) {
+    if (!g_file_manager_state || !g_file_manager_state->archive_panel) {
+        return;
+    }
+    
+    archive_progress_t progress;
+    if (!archive_extract_get_progress(&progress)) {
+        return;
+    }
+    
+    if (progress.state == ARCHIVE_STATE_RUNNING) {
+        lv_label_set_text_fmt(g_file_manager_state->archive_status, "解压中 %lu/%lu | %u%% | %.1f MB/s",
+                              (unsigned long)progress.files_done, (unsigned long)progress.files_total,
+                              progress.bytes_total > 0 ? (unsigned)(progress.bytes_done * 100 / progress.bytes_total) : 0,
+                              progress.mb_per_sec);
+        return;
+    }
+    
+    app_ctx_timer_delete(g_file_manager_state->app, g_file_manager_state->archive_timer);
+    g_file_manager_state->archive_timer = NULL;
+    lv_label_set_text(g_file_manager_state->archive_button, "解压");
+    
+    // 解压目录位于当前目录下（修改已由解压引擎报告给fs_watch）
+    reload_current_directory();
+    
+    if (progress.state == ARCHIVE_STATE_DONE) {
+        lv_label_set_text_fmt(g_file_manager_state->archive_status, "解压完成: %lu 个条目%s | %.1f MB/s",
+                              (unsigned long)progress.files_done,
+                              progress.files_skipped > 0 ? "（部分跳过）" : "", progress.mb_per_sec);
+    } else if (progress.state == ARCHIVE_STATE_CANCELLED) {
+        lv_label_set_text(g_file_manager_state->archive_status, "解压已取消");
+    } else {
+        lv_label_set_text_fmt(g_file_manager_state->archive_status, "解压失败: %s", progress.error);
+    }
+}
+
+// 解压选中条目（未选中时解压全部）到当前目录下与压缩包同名的文件夹；解压中再次点击取消
+static void archive_extract_event_cb(lv_event_t* e) {
+    (void)e;
+    archive_t* archive = g_file_manager_state->archive;
+    if (archive_extract_is_busy()) {
+        archive_extract_cancel();
+        return;
+    }
+    if (file_ops_is_busy()) {
+        printf("File operation in progress\n");
+        return;
+    }
+    
+    char dest_dir[512];
+    const char* name = strrchr(archive->path, '/');
+    name = name ? name + 1 : archive->path;
+    const char* ext = strrchr(name, '.');
+    int len = snprintf(dest_dir, sizeof(dest_dir), "%s/%.*s", g_file_manager_state->current_path,
+                       (int)(ext ? ext - name : (int)strlen(name)), name);
+    if (len < 0 || (size_t)len >= sizeof(dest_dir)) {
+        return;
+    }
+    
+    uint32_t* indices = NULL;
+    uint32_t count = 0;
+    if (g_file_manager_state->archive_selected_count > 0) {
+        indices = safe_malloc(g_file_manager_state->archive_selected_count * sizeof(uint32_t));
+        if (!indices) {
+            return;
+        }
+        for (uint32_t i = 0; i < archive->count; i++) {
+            if (g_file_manager_state->archive_selected[i]) {
+                indices[count++] = i;
+            }
+        }
+    }
+    
+    if (archive_extract_start(archive, indices, count, dest_dir)) {
+        lv_label_set_text(g_file_manager_state->archive_button, "取消");
+        g_file_manager_state->archive_timer = app_ctx_timer_create(g_file_manager_state->app, archive_timer_cb, 200, NULL);
+        lv_timer_ready(g_file_manager_state->archive_timer);
+    }
+    safe_free(indices);
+}
+
+static void archive_close_event_cb(lv_event_t* e) {
+    (void)e;
+    close_archive_panel();
+}
+
+// 关闭面板时取消未完成的解压（未完成的文件会被删除）
+static void close_archive_panel(void) {
+    if (!g_file_manager_state || !g_file_manager_state->archive_panel) {
+        return;
+    }
+    
+    if (archive_extract_is_busy()) {
+        archive_extract_cancel();
+    }
+    if (g_file_manager_state->archive_timer) {
+        app_ctx_timer_delete(g_file_manager_state->app, g_file_manager_state->archive_timer);
+        g_file_manager_state->archive_timer = NULL;
+    }
+    
+    // 可能在面板内按钮的事件回调中调用，延迟删除
+    lv_obj_delete_async(g_file_manager_state->archive_panel);
+    g_file_manager_state->archive_panel = NULL;
+    g_file_manager_state->archive_list = NULL;
+    g_file_manager_state->archive_status = NULL;
+    g_file_manager_state->archive_button = NULL;
+    
+    archive_close(g_file_manager_state->archive);
+    g_file_manager_state->archive = NULL;
+    safe_free(g_file_manager_state->archive_selected);
+    g_file_manager_state->archive_selected = NULL;
+    g_file_manager_state->archive_selected_count = 0;
+}
+
+// 显示压缩包面板：只读取目录（ZIP中央目录/TAR条目头），不解压数据
+static void show_archive_panel(const char* path) {
+    archive_t* archive = archive_open(path);
+    if (!archive) {
+        lv_label_set_text(g_file_manager_state->status_bar, "无法读取压缩包");
+        return;
+    }
+    
+    g_file_manager_state->archive_selected = safe_malloc(archive->count > 0 ? archive->count : 1);
+    if (!g_file_manager_state->archive_selected) {
+        archive_close(archive);
+        return;
+    }
+    memset(g_file_manager_state->archive_selected, 0, archive->count > 0 ? archive->count : 1);
+    g_file_manager_state->archive = archive;
+    g_file_manager_state->archive_selected_count = 0;
+    
+    lv_obj_t* panel = lv_obj_create(g_file_manager_state->menu);
+    lv_obj_set_size(panel, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_pos(panel, 0, 0);
+    lv_obj_set_style_bg_color(panel, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_bg_opa(panel, LV_OPA_COVER, 0);
+    lv_obj_set_style_pad_all(panel, 16, 0);
+    lv_obj_clear_flag(panel, LV_OBJ_FLAG_SCROLLABLE);
+    g_file_manager_state->archive_panel = panel;
+    
+    const char* name = strrchr(path, '/');
+    lv_obj_t* title = lv_label_create(panel);
+    lv_label_set_text(title, name ? name + 1 : path);
+    lv_label_set_long_mode(title, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(title, LV_PCT(60));
+    lv_obj_set_style_text_color(title, lv_color_hex(0x2196F3), 0);
+    lv_obj_set_style_text_font(title, &simhei_32, 0);
+    lv_obj_align(title, LV_ALIGN_TOP_LEFT, 0, 0);
+    
+    lv_obj_t* close_btn = lv_btn_create(panel);
+    lv_obj_set_size(close_btn, 100, 48);
+    lv_obj_set_style_bg_color(close_btn, lv_color_hex(0x2196F3), 0);
+    lv_obj_set_style_radius(close_btn, 8, 0);
+    lv_obj_align(close_btn, LV_ALIGN_TOP_RIGHT, 0, 0);
+    lv_obj_add_event_cb(close_btn, archive_close_event_cb, LV_EVENT_CLICKED, NULL);
+    
+    lv_obj_t* close_label = lv_label_create(close_btn);
+    lv_label_set_text(close_label, "关闭");
+    lv_obj_set_style_text_color(close_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(close_label, &simhei_32, 0);
+    lv_obj_center(close_label);
+    
+    lv_obj_t* extract_btn = lv_btn_create(panel);
+    lv_obj_set_size(extract_btn, 100, 48);
+    lv_obj_set_style_bg_color(extract_btn, lv_color_hex(0x2196F3), 0);
+    lv_obj_set_style_radius(extract_btn, 8, 0);
+    lv_obj_align_to(extract_btn, close_btn, LV_ALIGN_OUT_LEFT_MID, -8, 0);
+    lv_obj_add_event_cb(extract_btn, archive_extract_event_cb, LV_EVENT_CLICKED, NULL);
+    
+    g_file_manager_state->archive_button = lv_label_create(extract_btn);
+    lv_label_set_text(g_file_manager_state->archive_button, "解压");
+    lv_obj_set_style_text_color(g_file_manager_state->archive_button, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(g_file_manager_state->archive_button, &simhei_32, 0);
+    lv_obj_center(g_file_manager_state->archive_button);
+    
+    g_file_manager_state->archive_status = lv_label_create(panel);
+    lv_obj_set_width(g_file_manager_state->archive_status, LV_PCT(100));
+    lv_obj_set_style_text_color(g_file_manager_state->archive_status, lv_color_hex(0x666666), 0);
+    lv_obj_set_style_text_font(g_file_manager_state->archive_status, &simhei_32, 0);
+    lv_obj_align(g_file_manager_state->archive_status, LV_ALIGN_TOP_LEFT, 0, 64);
+    
+    g_file_manager_state->archive_list = lv_obj_create(panel);
+    lv_obj_set_size(g_file_manager_state->archive_list, LV_PCT(100), LV_PCT(78));
+    lv_obj_align(g_file_manager_state->archive_list, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_set_style_bg_opa(g_file_manager_state->archive_list, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(g_file_manager_state->archive_list, 0, 0);
+    lv_obj_set_style_pad_all(g_file_manager_state->archive_list, 0, 0);
+    lv_obj_set_layout(g_file_manager_state->archive_list, LV_LAYOUT_FLEX);
+    lv_obj_set_flex_flow(g_file_manager_state->archive_list, LV_FLEX_FLOW_COLUMN);
+    
+    uint32_t rows = archive->count < ARCHIVE_MAX_ROWS ? archive->count : ARCHIVE_MAX_ROWS;
+    for (uint32_t i = 0; i < rows; i++) {
+        add_archive_row(i);
+    }
+    update_archive_status();
+}
+
+// 操作按钮点击事件
+static void action_button_event_cb(lv_event_t* e) {
+    int button_id = (int)(intptr_t)lv_event_get_user_data(e);
+    
+    printf("Action button clicked: %d\n", button_id);
+    
+    if (!g_file_manager_state) {
+        return;
+    }
+    
+    if (file_ops_is_busy() && button_id <= 3) {
+        printf("File operation in progress\n");
+        return;
+    }
+    
+    switch (button_id) {
+        case 0: // 复制
+        case 1: // 剪切
+        {
+            file_listing_t* selection = collect_selection();
+            if (!selection) {
+                printf("No files selected\n");
+                break;
+            }
+            
+            if (g_file_manager_state->clipboard) {
+                file_listing_free(g_file_manager_state->clipboard);
+            }
+            g_file_manager_state->clipboard = selection;
+            g_file_manager_state->clipboard_is_move = (button_id == 1);
+            printf("%s %lu items to clipboard\n", button_id == 1 ? "Cut" : "Copied",
+                   (unsigned long)selection->count);
+            
+            clear_selection();
+            break;
+        }
+        case 2: // 粘贴
+        {
+            file_listing_t* clipboard = g_file_manager_state->clipboard;
+            if (!clipboard) {
+                printf("Clipboard is empty\n");
+                break;
+            }
+            
+            file_op_type_t type = g_file_manager_state->clipboard_is_move ? FILE_OP_MOVE : FILE_OP_COPY;
+            if (file_ops_start(type, clipboard, g_file_manager_state->current_path)) {
+                // 剪切的条目只能粘贴一次
+                if (type == FILE_OP_MOVE) {
+                    file_listing_free(clipboard);
+                    g_file_manager_state->clipboard = NULL;
+                }
+                start_progress_timer();
+            }
+            break;
+        }
+        case 3: // 删除
+            show_delete_confirm();
+            break;
+        case 4: // 重命名
+            printf("Rename action\n");
+            break;
+        case 5: // 新建文件夹
+            printf("New folder action\n");
+            break;
+        case 6: // 存储空间
+            show_storage_panel();
+            break;
+        case 7: // 搜索
+            show_search_panel();
+            break;
+    }
+}
+
+// 文件管理器App创建
+static void file_manager_create(app_t* app) {
+    if (!app || !app->container) {
+        return;
+    }
+    
+    printf("Creating file manager app\n");
+    app_manager_log_memory_usage("Before file manager creation");
+    
+    // 分配状态结构
+    g_file_manager_state = (file_manager_state_t*)safe_malloc(sizeof(file_manager_state_t));
+    if (!g_file_manager_state) {
+        printf("Failed to allocate file manager state\n");
+        return;
+    }
+    
+    memset(g_file_manager_state, 0, sizeof(file_manager_state_t));
+    g_file_manager_state->app = app;
+    
+    // 设置初始路径
+    const char* mount_point = hal_sdcard_get_mount_point();
+    if (mount_point) {
+        strncpy(g_file_manager_state->current_path, mount_point, sizeof(g_file_manager_state->current_path) - 1);
+        strncpy(g_file_manager_state->root_path, mount_point, sizeof(g_file_manager_state->root_path) - 1);
+    } else {
+        strcpy(g_file_manager_state->current_path, "/sdcard");
+        strcpy(g_file_manager_state->root_path, "/sdcard");
+    }
+    
+    // 创建主容器
+    g_file_manager_state->menu = lv_obj_create(app->container);
+    lv_obj_set_size(g_file_manager_state->menu, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_pos(g_file_manager_state->menu, 0, 0);
+    lv_obj_set_style_pad_all(g_file_manager_state->menu, 16, 0);
+    
+    // 创建路径显示
+    g_file_manager_state->path_label = lv_label_create(g_file_manager_state->menu);
+    lv_label_set_text(g_file_manager_state->path_label, g_file_manager_state->current_path);
+    lv_obj_set_style_text_color(g_file_manager_state->path_label, lv_color_hex(0x2196F3), 0);
+    lv_obj_set_style_text_font(g_file_manager_state->path_label, &simhei_32, 0);
+    lv_obj_align(g_file_manager_state->path_label, LV_ALIGN_TOP_LEFT, 0, 0);
+    
+    // 创建状态栏
+    g_file_manager_state->status_bar = lv_label_create(g_file_manager_state->menu);
+    lv_label_set_text(g_file_manager_state->status_bar, "文件: 0 | 选中: 0");
+    lv_obj_set_style_text_color(g_file_manager_state->status_bar, lv_color_hex(0x666666), 0);
+    lv_obj_set_style_text_font(g_file_manager_state->status_bar, &simhei_32, 0);
+    lv_obj_align_to(g_file_manager_state->status_bar, g_file_manager_state->path_label, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 8);
+    lv_obj_add_flag(g_file_manager_state->status_bar, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(g_file_manager_state->status_bar, status_bar_event_cb, LV_EVENT_CLICKED, NULL);
+    
+    // 创建文件列表容器
+    g_file_manager_state->file_list = lv_obj_create(g_file_manager_state->menu);
+    lv_obj_set_size(g_file_manager_state->file_list, LV_PCT(100), LV_PCT(70));
+    lv_obj_align_to(g_file_manager_state->file_list, g_file_manager_state->status_bar, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 8);
+    lv_obj_set_style_bg_opa(g_file_manager_state->file_list, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(g_file_manager_state->file_list, 0, 0);
+    lv_obj_set_style_pad_all(g_file_manager_state->file_list, 8, 0);
+    
+    // 创建操作按钮容器
+    g_file_manager_state->action_buttons = lv_obj_create(g_file_manager_state->menu);
+    lv_obj_set_size(g_file_manager_state->action_buttons, LV_PCT(100), 60);
+    lv_obj_align_to(g_file_manager_state->action_buttons, g_file_manager_state->file_list, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 8);
+    lv_obj_set_style_bg_opa(g_file_manager_state->action_buttons, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(g_file_manager_state->action_buttons, 0, 0);
+    lv_obj_set_style_pad_all(g_file_manager_state->action_buttons, 8, 0);
+    
+    // 后台统计目录大小（有效的缓存结果直接复用）
+    if (dir_size_init()) {
+        dir_size_request(g_file_manager_state->root_path, false);
+    }
+    
+    // 全局文件名索引（加载保存的索引后在后台增量更新）
+    file_index_init();
+    
+    // 扫描目录并创建UI
+    g_file_manager_state->sd_generation = hal_sdcard_get_generation();
+    g_file_manager_state->watch_timer = app_ctx_timer_create(g_file_manager_state->app, watch_timer_cb, 500, NULL);
+    scan_directory(g_file_manager_state->current_path);
+    create_file_list_ui();
+    update_path_display();
+    update_status_bar();
+    create_action_buttons();
+    
+    if (file_ops_is_busy()) {
+        start_progress_timer();
+    }
+    
+    g_file_manager_state->is_initialized = true;
+    
+    app->user_data = g_file_manager_state;
+    
+    printf("File manager app created successfully\n");
+    app_manager_log_memory_usage("After file manager creation");
+}
+
+// 文件管理器App销毁
+static void file_manager_destroy(app_t* app) {
+    if (!app) {
+        return;
+    }
+    
+    printf("Destroying file manager app\n");
+    app_manager_log_memory_usage("Before file manager destruction");
+    
+    if (g_file_manager_state) {
+        // 刷新定时器已随应用上下文释放；后台操作继续运行，修改的目录由fs_watch使缓存失效
+        if (g_file_manager_state->watched_path[0] != '\0') {
+            fs_watch_remove_dir(g_file_manager_state->watched_path);
+            g_file_manager_state->watched_path[0] = '\0';
+        }
+        
+        // 关闭文本查看器（停止后台索引任务）
+        if (g_file_manager_state->text_viewer) {
+            text_viewer_close(g_file_manager_state->text_viewer);
+            g_file_manager_state->text_viewer = NULL;
+        }
+        
+        // 停止查重（面板随App容器删除）
+        dup_finder_cancel();
+        if (g_file_manager_state->dup_results) {
+            file_listing_free(g_file_manager_state->dup_results);
+            g_file_manager_state->dup_results = NULL;
+        }
+        
+        // 停止搜索并释放结果（面板随App容器删除）
+        file_grep_cancel();
+        if (g_file_manager_state->search_results) {
+            file_listing_free(g_file_manager_state->search_results);
+            g_file_manager_state->search_results = NULL;
+        }
+        
+        // 取消解压并释放压缩包目录（面板随App容器删除）
+        archive_extract_cancel();
+        archive_close(g_file_manager_state->archive);
+        g_file_manager_state->archive = NULL;
+        safe_free(g_file_manager_state->archive_selected);
+        g_file_manager_state->archive_selected = NULL;
+        
+        // 关闭确认对话框（位于顶层，不随App容器删除）
+        if (g_file_manager_state->confirm_box) {
+            lv_msgbox_close(g_file_manager_state->confirm_box);
+            g_file_manager_state->confirm_box = NULL;
+        }
+        
+        if (g_file_manager_state->clipboard) {
+            file_listing_free(g_file_manager_state->clipboard);
+            g_file_manager_state->clipboard = NULL;
+        }
+        
+        // 清理文件列表
+        cleanup_file_list();
+        
+        // 重置状态
+        g_file_manager_state->is_initialized = false;
+        g_file_manager_state->is_scanning = false;
+        
+        // 释放状态结构
+        safe_free(g_file_manager_state);
+        g_file_manager_state = NULL;
+    }
+    
+    if (app) {
+        app->user_data = NULL;
+    }
+    
+    printf("File manager app destroyed\n");
+    app_manager_log_memory_usage("After file manager destruction");
+}
+
+// 文件管理器App挂起：界面和目录缓存保留，停止后台监视（定时器由应用上下文暂停）
+static void file_manager_pause(app_t* app) {
+    (void)app;
+    if (!g_file_manager_state) {
+        return;
+    }
+    
+    if (g_file_manager_state->watched_path[0] != '\0') {
+        fs_watch_remove_dir(g_file_manager_state->watched_path);
+    }
+}
+
+// 文件管理器App恢复：应用上下文恢复定时器并立即运行一次，挂起期间的SD卡插拔和目录变化随之刷新
+static void file_manager_resume(app_t* app) {
+    (void)app;
+    if (!g_file_manager_state) {
+        return;
+    }
+    
+    if (g_file_manager_state->watched_path[0] != '\0') {
+        fs_watch_add_dir(g_file_manager_state->watched_path);
+    }
 }
 
-// 注册文件管理器App
-void register_file_manager_app(void) {
-    app_manager_register_app("文件管理器", LV_SYMBOL_DIRECTORY, 
-                             file_manager_create, file_manager_destroy);
-} 
\ No newline at end of file
+// 文件管理器App描述
+APP_DEFINE(file_manager_app_desc) = {
+    .id = APP_ID_FILE_MANAGER,
+    .name = "文件管理器",
+    .icon = LV_SYMBOL_DIRECTORY,
+    .create_cb = file_manager_create,
+    .destroy_cb = file_manager_destroy,
+    .pause_cb = file_manager_pause,
+    .resume_cb = file_manager_resume,
+    .suspendable = true,
+}; 
\ No newline at end of file
@@ -1,18 +0,0 @@
-#ifndef APP_FILE_MANAGER_H
-#define APP_FILE_MANAGER_H
-
-#include <stdint.h>
-#include <stdbool.h>
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-// 文件管理器App注册函数
-void register_file_manager_app(void);
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif // APP_FILE_MANAGER_H 
\ No newline at end of file
@@ -1,4 +1,3 @@
-#include "app_launcher.h"
 #include "app_manager.h"
 #include "overlay_drawer.h"
 #include <stdio.h>
@@ -58,8 +57,26 @@ static void launcher_app_destroy(app_t* app) {
     app_drawer_close();
 }
 
-// 注册启动器应用
-void register_launcher_app(void) {
-    app_manager_register_app("启动器", LV_SYMBOL_HOME, 
-                             launcher_app_create, launcher_app_destroy);
-} 
\ No newline at end of file
+// 启动器挂起时关闭应用抽屉
+static void launcher_app_pause(app_t* app) {
+    (void)app;
+    app_drawer_close();
+}
+
+// 启动器恢复时重新打开应用抽屉
+static void launcher_app_resume(app_t* app) {
+    (void)app;
+    app_drawer_open();
+}
+
+// 启动器应用描述
+APP_DEFINE(launcher_app_desc) = {
+    .id = APP_ID_LAUNCHER,
+    .name = "启动器",
+    .icon = LV_SYMBOL_HOME,
+    .create_cb = launcher_app_create,
+    .destroy_cb = launcher_app_destroy,
+    .pause_cb = launcher_app_pause,
+    .resume_cb = launcher_app_resume,
+    .suspendable = true,
+}; 
\ No newline at end of file
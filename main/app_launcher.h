@@ -1,6 +0,0 @@
-#pragma once
-
-#include "app_manager.h"
-
-// 注册启动器应用
-void register_launcher_app(void); 
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "app_manager.h"
+#include "app_mem.h"
+#include "app_ctx.h"
+#include "mem_pressure.h"
 #include <string.h>
 #include <stdlib.h>
 #include <esp_heap_caps.h>
@@ -9,39 +12,76 @@
 // 全局应用管理器实例
 static app_manager_t g_app_manager = {0};
 
-// 内存监控结构
-typedef struct {
-    size_t free_heap_before;
-    size_t free_heap_after;
-    size_t psram_free_before;
-    size_t psram_free_after;
-    uint32_t gc_count;
-    uint32_t last_gc_time;
-} memory_monitor_t;
+// 链接时收集的应用描述（linker.lf中SURROUND生成的边界符号）
+extern const app_desc_t _imos_apps_start[];
+extern const app_desc_t _imos_apps_end[];
+
+// 应用运行状态，按ID索引（未编译进来的应用name为NULL）
+static app_t g_app_slots[APP_ID_COUNT];
 
-static memory_monitor_t g_memory_monitor = {0};
+// 名称查找表：开放寻址，名称的哈希只在启动时计算一次
+#define APP_NAME_HASH_SIZE 16   // 2的幂，大于APP_ID_COUNT
+static int8_t g_app_name_hash[APP_NAME_HASH_SIZE];
 
-// 内存阈值配置 - 更宽松的阈值以减少频繁GC
+// 内存阈值配置（低内存的分级处理见mem_pressure.c）
 #define MEMORY_LOW_THRESHOLD    (128 * 1024)   // 128KB低内存阈值
 #define MEMORY_CRITICAL_THRESHOLD (64 * 1024)  // 64KB临界阈值
 #define PSRAM_LOW_THRESHOLD     (512 * 1024)   // 512KB PSRAM低内存阈值
-#define FORCED_GC_INTERVAL      (10000)        // 10秒强制GC间隔
-#define MEMORY_MONITOR_INTERVAL (5000)         // 5秒内存监控间隔
+#define OWNER_SCAN_INTERVAL     (5000)         // 5秒扫描一次定时器和顶层对象的归属
+
+// 挂起应用缓存配置
+#define APP_CACHE_MAX_SUSPENDED   3                    // 最多保留的挂起应用数
+#define APP_CACHE_MEMORY_BUDGET   (4 * 1024 * 1024)    // 挂起应用占用内存总和上限
 
-// 内存监控定时器
-static lv_timer_t* g_memory_monitor_timer = NULL;
+// 切换耗时统计
+static app_switch_stats_t g_switch_stats = {0};
+static int64_t g_switch_start_us = 0;       // 等待首帧的切换开始时间，0表示没有
+static bool g_switch_resumed = false;       // 等待首帧的切换是否为恢复挂起应用
+static int64_t g_last_tap_us = 0;           // 最近一次触摸抬起的时间
+static int64_t g_interactive_start_us = 0;  // 等待创建步骤全部完成的切换开始时间，0表示没有
+
+// 分步创建
+#define APP_BUILD_MAX_STEPS         16
+#define APP_BUILD_BUDGET_US         8000    // 每帧用于创建步骤的时间
+#define APP_BUILD_FRAME_TIMEOUT_US  50000   // 没有重绘时等待下一帧的最长时间
+
+typedef struct {
+    app_t* app;
+    app_build_step_t step;
+    void* ctx;
+} build_step_t;
+
+static build_step_t g_build_steps[APP_BUILD_MAX_STEPS];
+static uint32_t g_build_step_count = 0;
+static lv_timer_t* g_build_timer = NULL;
+static bool g_build_frame_drawn = false;    // 上一片之后已经绘制过一帧
+static int64_t g_build_last_slice_us = 0;
+static uint32_t g_build_slices = 0;         // 本次切换执行的分片数
+
+// 归属扫描定时器
+static lv_timer_t* g_owner_scan_timer = NULL;
 
 // 前向声明
-static void force_garbage_collection(void);
 static void log_memory_usage(const char* context);
-static bool wait_for_memory_stabilization(uint32_t timeout_ms);
-static bool should_force_gc(void);
-static void memory_monitor_timer_cb(lv_timer_t* timer);
-static void start_memory_monitor(void);
-static void stop_memory_monitor(void);
+static void owner_scan_timer_cb(lv_timer_t* timer);
+static void image_cache_pressure_cb(mem_pressure_level_t level, void* user_data);
+static void suspended_apps_pressure_cb(mem_pressure_level_t level, void* user_data);
 static void* safe_app_malloc(size_t size);
 static void safe_app_free(void* ptr);
 static void cleanup_app_memory(app_t* app);
+static void destroy_app(app_t* app);
+static void suspend_app(app_t* app);
+static void leave_current_app(void);
+static void trim_suspended_apps(void);
+static bool evict_lru_suspended_app(const char* reason);
+static void display_refr_ready_cb(lv_event_t* e);
+static void app_registry_init(void);
+static bool launch_app(app_t* app);
+static void indev_released_cb(lv_event_t* e);
+static void app_container_delete_cb(lv_event_t* e);
+static void build_timer_cb(lv_timer_t* timer);
+static void remove_build_steps(app_t* app);
+static void finish_interactive_timing(app_t* app);
 
 // 安全的内存分配函数 - 优先使用PSRAM
 static void* safe_app_malloc(size_t size) {
@@ -91,15 +131,8 @@ static void cleanup_app_memory(app_t* app) {
         app->user_data = NULL;
     }
     
-    // 确保LVGL完成所有渲染和清理
-    lv_refr_now(NULL);
-    vTaskDelay(pdMS_TO_TICKS(30));  // 增加等待时间确保清理完成
-    
-    // 强制垃圾回收
-    if (should_force_gc()) {
-        printf("Forcing GC after app cleanup\n");
-        force_garbage_collection();
-    }
+    // 容器删除时LVGL已同步释放所有对象，不需要刷新或等待；
+    // 内存不足由mem_pressure的后台任务发现并分级处理
 }
 
 // 获取应用管理器实例
@@ -107,84 +140,6 @@ app_manager_t* app_manager_get_instance(void) {
     return &g_app_manager;
 }
 
-// 强制垃圾回收
-static void force_garbage_collection(void) {
-    printf("=== FORCING GARBAGE COLLECTION ===\n");
-    
-    // 记录GC前的内存状态
-    g_memory_monitor.free_heap_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
-    g_memory_monitor.psram_free_before = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-    
-    // 强制LVGL内存清理
-    lv_mem_monitor_t lvgl_mem_before;
-    lv_mem_monitor(&lvgl_mem_before);
-    
-    // 清理LVGL缓存
-    lv_obj_clean(lv_screen_active());
-    lv_refr_now(NULL);
-    
-    // 让系统有时间释放内存
-    vTaskDelay(pdMS_TO_TICKS(100));
-    
-    // 跳过抽屉清理，让空闲清理机制处理
-    printf("Skipping drawer cleanup during GC to avoid conflicts\n");
-    
-    // 再次让系统有时间释放内存
-    vTaskDelay(pdMS_TO_TICKS(100));
-    
-    // 记录GC后的内存状态
-    g_memory_monitor.free_heap_after = heap_caps_get_free_size(MALLOC_CAP_8BIT);
-    g_memory_monitor.psram_free_after = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-    g_memory_monitor.gc_count++;
-    g_memory_monitor.last_gc_time = esp_timer_get_time() / 1000;
-    
-    lv_mem_monitor_t lvgl_mem_after;
-    lv_mem_monitor(&lvgl_mem_after);
-    
-    printf("GC #%lu completed:\n", (unsigned long)g_memory_monitor.gc_count);
-    printf("  Heap: %zu -> %zu (+%d bytes)\n", 
-           g_memory_monitor.free_heap_before, 
-           g_memory_monitor.free_heap_after,
-           (int)(g_memory_monitor.free_heap_after - g_memory_monitor.free_heap_before));
-    printf("  PSRAM: %zu -> %zu (+%d bytes)\n", 
-           g_memory_monitor.psram_free_before, 
-           g_memory_monitor.psram_free_after,
-           (int)(g_memory_monitor.psram_free_after - g_memory_monitor.psram_free_before));
-    printf("  LVGL: %zu -> %zu (+%d bytes)\n", 
-           (size_t)lvgl_mem_before.free_size, 
-           (size_t)lvgl_mem_after.free_size,
-           (int)(lvgl_mem_after.free_size - lvgl_mem_before.free_size));
-    printf("=== GC COMPLETE ===\n");
-}
-
-// 等待内存稳定
-static bool wait_for_memory_stabilization(uint32_t timeout_ms) {
-    uint32_t start_time = esp_timer_get_time() / 1000;
-    size_t prev_free = 0;
-    int stable_count = 0;
-    
-    while ((esp_timer_get_time() / 1000 - start_time) < timeout_ms) {
-        size_t current_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
-        
-        if (prev_free > 0 && abs((int)(current_free - prev_free)) < 1024) {
-            stable_count++;
-            if (stable_count >= 3) {
-                printf("Memory stabilized after %lu ms\n", 
-                       (unsigned long)(esp_timer_get_time() / 1000 - start_time));
-                return true;
-            }
-        } else {
-            stable_count = 0;
-        }
-        
-        prev_free = current_free;
-        vTaskDelay(pdMS_TO_TICKS(50));
-    }
-    
-    printf("Memory stabilization timeout after %lu ms\n", (unsigned long)timeout_ms);
-    return false;
-}
-
 // 记录内存使用情况
 static void log_memory_usage(const char* context) {
     size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
@@ -211,78 +166,94 @@ static void log_memory_usage(const char* context) {
     printf("=== END MEMORY USAGE ===\n");
 }
 
-// 检查是否需要强制GC
-static bool should_force_gc(void) {
-    uint32_t current_time = esp_timer_get_time() / 1000;
-    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
-    size_t free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-    
-    // 只有内存严重不足时才强制GC，优先考虑PSRAM使用情况
-    if (free_heap < MEMORY_CRITICAL_THRESHOLD && free_psram < (256 * 1024)) {
-        printf("Critical memory shortage detected (Heap: %zu, PSRAM: %zu), forcing GC\n", free_heap, free_psram);
-        return true;
+// 定期把新出现的定时器和顶层对象记到当前应用名下
+static void owner_scan_timer_cb(lv_timer_t* timer) {
+    (void)timer;
+    app_mem_scan();
+}
+
+// 内存偏低：丢弃LVGL的图片缓存（解码结果可以重新生成）
+static void image_cache_pressure_cb(mem_pressure_level_t level, void* user_data) {
+    (void)user_data;
+    if (level >= MEM_PRESSURE_TRIM) {
+        lv_image_cache_drop(NULL);
     }
-    
-    return false;
 }
 
-// 内存监控定时器回调
-static void memory_monitor_timer_cb(lv_timer_t* timer) {
-    (void)timer; // 未使用的参数
-    
-    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
-    size_t free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+// 内存不足：按LRU淘汰挂起的应用直到恢复；严重不足时全部淘汰
+static void suspended_apps_pressure_cb(mem_pressure_level_t level, void* user_data) {
+    (void)user_data;
+    if (level < MEM_PRESSURE_HIDDEN_UI) {
+        return;
+    }
     
-    // 检查内存使用情况，只在真正严重不足时干预
-    if (free_heap < MEMORY_CRITICAL_THRESHOLD) {
-        printf("*** CRITICAL MEMORY ALERT: %zu bytes free ***\n", free_heap);
-        printf("Triggering emergency garbage collection\n");
-        force_garbage_collection();
-        
-        // 记录紧急GC后的内存状态
-        free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
-        printf("After emergency GC: %zu bytes free\n", free_heap);
-        
-        if (free_heap < MEMORY_CRITICAL_THRESHOLD) {
-            printf("*** MEMORY STILL CRITICAL AFTER GC ***\n");
+    app_mem_scan();
+    while (level == MEM_PRESSURE_EMERGENCY || mem_pressure_check() >= MEM_PRESSURE_HIDDEN_UI) {
+        if (!evict_lru_suspended_app("low memory")) {
+            break;
         }
     }
-    // 移除低内存警告的主动清理，减少干预
     
-    // 定期记录内存使用情况（每15秒）
-    static uint32_t last_log_time = 0;
-    uint32_t current_time = esp_timer_get_time() / 1000;
-    if (current_time - last_log_time > 15000) {
-        printf("Memory Monitor: Heap=%zu, PSRAM=%zu, GC_Count=%lu\n", 
-               free_heap, free_psram, (unsigned long)g_memory_monitor.gc_count);
-        last_log_time = current_time;
+    // 严重不足时输出各应用的占用，便于找到原因
+    if (level == MEM_PRESSURE_EMERGENCY) {
+        app_mem_log_summary();
     }
 }
 
-// 启动内存监控
-static void start_memory_monitor(void) {
-    if (g_memory_monitor_timer != NULL) {
-        printf("Memory monitor already running\n");
-        return;
-    }
-    
-    printf("Starting memory monitor (interval: %d ms)\n", MEMORY_MONITOR_INTERVAL);
-    g_memory_monitor_timer = lv_timer_create(memory_monitor_timer_cb, 
-                                           MEMORY_MONITOR_INTERVAL, NULL);
-    if (g_memory_monitor_timer) {
-        printf("Memory monitor started successfully\n");
-    } else {
-        printf("Failed to start memory monitor\n");
+// 名称哈希 (FNV-1a)
+static uint32_t app_name_hash(const char* name) {
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
     }
+    return hash;
 }
 
-// 停止内存监控
-static void stop_memory_monitor(void) {
-    if (g_memory_monitor_timer) {
-        printf("Stopping memory monitor\n");
-        lv_timer_del(g_memory_monitor_timer);
-        g_memory_monitor_timer = NULL;
+// 收集应用描述，建立ID表、名称查找表和按ID排序的应用链表
+static void app_registry_init(void) {
+    memset(g_app_slots, 0, sizeof(g_app_slots));
+    memset(g_app_name_hash, -1, sizeof(g_app_name_hash));
+    
+    for (const app_desc_t* desc = _imos_apps_start; desc < _imos_apps_end; desc++) {
+        if (desc->id < 0 || desc->id >= APP_ID_COUNT || !desc->name || !desc->create_cb) {
+            printf("Invalid app descriptor: %s\n", desc->name ? desc->name : "(null)");
+            continue;
+        }
+        
+        app_t* app = &g_app_slots[desc->id];
+        if (app->name) {
+            printf("Duplicate app id %d: %s, %s\n", (int)desc->id, app->name, desc->name);
+            continue;
+        }
+        
+        app->id = desc->id;
+        app->name = desc->name;
+        app->icon = desc->icon ? desc->icon : "";
+        app->type = APP_TYPE_NORMAL;
+        app->state = APP_STATE_INACTIVE;
+        app->create_cb = desc->create_cb;
+        app->destroy_cb = desc->destroy_cb;
+        app->pause_cb = desc->pause_cb;
+        app->resume_cb = desc->resume_cb;
+        app->suspendable = desc->suspendable;
+        
+        uint32_t slot = app_name_hash(desc->name) & (APP_NAME_HASH_SIZE - 1);
+        while (g_app_name_hash[slot] >= 0) {
+            slot = (slot + 1) & (APP_NAME_HASH_SIZE - 1);
+        }
+        g_app_name_hash[slot] = (int8_t)desc->id;
+    }
+    
+    // 应用链表（抽屉按此顺序显示）
+    app_t** tail = &g_app_manager.apps;
+    for (int id = 0; id < APP_ID_COUNT; id++) {
+        if (g_app_slots[id].name) {
+            *tail = &g_app_slots[id];
+            tail = &g_app_slots[id].next;
+        }
     }
+    *tail = NULL;
 }
 
 // 初始化应用管理器
@@ -293,6 +264,8 @@ void app_manager_init(void) {
     
     // 初始化应用管理器
     memset(&g_app_manager, 0, sizeof(app_manager_t));
+    app_registry_init();
+    app_mem_init();
     
     // 创建应用容器（全屏）
     g_app_manager.app_container = lv_obj_create(lv_screen_active());
@@ -318,8 +291,29 @@ void app_manager_init(void) {
     // 确保Overlay容器在App容器之上
     lv_obj_move_foreground(g_app_manager.overlay_container);
     
-    // 启动内存监控
-    start_memory_monitor();
+    // 低内存分级处理：先丢缓存，再淘汰挂起的应用
+    mem_pressure_init();
+    mem_pressure_register(image_cache_pressure_cb, NULL, MEM_PRESSURE_PRIO_CACHE);
+    mem_pressure_register(suspended_apps_pressure_cb, NULL, MEM_PRESSURE_PRIO_HIDDEN_UI);
+    g_owner_scan_timer = lv_timer_create(owner_scan_timer_cb, OWNER_SCAN_INTERVAL, NULL);
+    
+    // 统计应用切换到首帧绘制完成的耗时
+    lv_display_t* disp = lv_display_get_default();
+    if (disp) {
+        lv_display_add_event_cb(disp, display_refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+    }
+    
+    // 分步创建的执行定时器，有步骤时才运行
+    g_build_step_count = 0;
+    g_build_timer = lv_timer_create(build_timer_cb, 1, NULL);
+    if (g_build_timer) {
+        lv_timer_pause(g_build_timer);
+    }
+    
+    // 记录触摸抬起的时间，从点击开始计算切换耗时
+    for (lv_indev_t* indev = lv_indev_get_next(NULL); indev; indev = lv_indev_get_next(indev)) {
+        lv_indev_add_event_cb(indev, indev_released_cb, LV_EVENT_RELEASED, NULL);
+    }
     
     g_app_manager.initialized = true;
 }
@@ -330,24 +324,42 @@ void app_manager_deinit(void) {
         return;
     }
     
-    // 停止内存监控
-    stop_memory_monitor();
+    mem_pressure_unregister(image_cache_pressure_cb, NULL);
+    mem_pressure_unregister(suspended_apps_pressure_cb, NULL);
+    if (g_owner_scan_timer) {
+        lv_timer_delete(g_owner_scan_timer);
+        g_owner_scan_timer = NULL;
+    }
     
-    // 销毁所有应用
-    app_t* app = g_app_manager.apps;
-    while (app) {
-        app_t* next = app->next;
-        if (app->destroy_cb) {
+    if (g_build_timer) {
+        lv_timer_delete(g_build_timer);
+        g_build_timer = NULL;
+    }
+    g_build_step_count = 0;
+    
+    lv_display_t* disp = lv_display_get_default();
+    if (disp) {
+        lv_display_remove_event_cb_with_user_data(disp, display_refr_ready_cb, NULL);
+    }
+    for (lv_indev_t* indev = lv_indev_get_next(NULL); indev; indev = lv_indev_get_next(indev)) {
+        lv_indev_remove_event_cb_with_user_data(indev, indev_released_cb, NULL);
+    }
+    
+    // 销毁运行中和挂起的应用（应用表是常量，不需要释放）
+    for (app_t* app = g_app_manager.apps; app; app = app->next) {
+        app_ctx_release(app);
+        if (app->state != APP_STATE_INACTIVE && app->destroy_cb) {
             app->destroy_cb(app);
         }
-        safe_app_free(app);
-        app = next;
+        app->state = APP_STATE_INACTIVE;
+        app->container = NULL;
     }
     
     // 销毁所有Overlay
     overlay_t* overlay = g_app_manager.overlays;
     while (overlay) {
         overlay_t* next = overlay->next;
+        app_ctx_release(&overlay->base);
         if (overlay->base.destroy_cb) {
             overlay->base.destroy_cb(&overlay->base);
         }
@@ -366,42 +378,6 @@ void app_manager_deinit(void) {
     memset(&g_app_manager, 0, sizeof(app_manager_t));
 }
 
-// 注册应用
-app_t* app_manager_register_app(const char* name, const char* icon, 
-                                app_create_cb_t create_cb, app_destroy_cb_t destroy_cb) {
-    if (!name || !create_cb) {
-        return NULL;
-    }
-    
-    // 检查是否已存在同名应用
-    if (app_manager_get_app(name)) {
-        return NULL;
-    }
-    
-    // 创建新应用 - 优先使用PSRAM
-    app_t* app = (app_t*)safe_app_malloc(sizeof(app_t));
-    if (!app) {
-        printf("Failed to allocate memory for app: %s\n", name);
-        return NULL;
-    }
-    
-    memset(app, 0, sizeof(app_t));
-    strncpy(app->name, name, sizeof(app->name) - 1);
-    if (icon) {
-        strncpy(app->icon, icon, sizeof(app->icon) - 1);
-    }
-    app->type = APP_TYPE_NORMAL;
-    app->state = APP_STATE_INACTIVE;
-    app->create_cb = create_cb;
-    app->destroy_cb = destroy_cb;
-    
-    // 添加到应用链表
-    app->next = g_app_manager.apps;
-    g_app_manager.apps = app;
-    
-    return app;
-}
-
 // 注册Overlay
 overlay_t* app_manager_register_overlay(const char* name, const char* icon, 
                                         app_create_cb_t create_cb, app_destroy_cb_t destroy_cb,
@@ -423,10 +399,9 @@ overlay_t* app_manager_register_overlay(const char* name, const char* icon,
     }
     
     memset(overlay, 0, sizeof(overlay_t));
-    strncpy(overlay->base.name, name, sizeof(overlay->base.name) - 1);
-    if (icon) {
-        strncpy(overlay->base.icon, icon, sizeof(overlay->base.icon) - 1);
-    }
+    overlay->base.id = APP_ID_NONE;
+    overlay->base.name = name;
+    overlay->base.icon = icon ? icon : "";
     overlay->base.type = APP_TYPE_OVERLAY;
     overlay->base.state = APP_STATE_INACTIVE;
     overlay->base.create_cb = create_cb;
@@ -445,20 +420,325 @@ overlay_t* app_manager_register_overlay(const char* name, const char* icon,
     return overlay;
 }
 
-// 启动应用
+// 首帧绘制完成，记录切换耗时
+static void display_refr_ready_cb(lv_event_t* e) {
+    (void)e;
+    // 界面刷新在LVGL任务中，应用的事件回调也在这个任务中运行
+    app_mem_bind_ui_task();
+    g_build_frame_drawn = true;
+    
+    if (g_switch_start_us == 0) {
+        return;
+    }
+    
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - g_switch_start_us);
+    g_switch_start_us = 0;
+    
+    g_switch_stats.switch_count++;
+    g_switch_stats.last_switch_us = elapsed_us;
+    if (g_switch_resumed) {
+        g_switch_stats.resume_count++;
+        g_switch_stats.total_resume_us += elapsed_us;
+        if (elapsed_us > g_switch_stats.max_resume_us) {
+            g_switch_stats.max_resume_us = elapsed_us;
+        }
+    } else {
+        g_switch_stats.total_create_us += elapsed_us;
+        if (elapsed_us > g_switch_stats.max_create_us) {
+            g_switch_stats.max_create_us = elapsed_us;
+        }
+    }
+    
+    printf("App switch to %s took %lu us to first frame (%s)\n",
+           g_app_manager.current_app ? g_app_manager.current_app->name : "(none)",
+           (unsigned long)elapsed_us, g_switch_resumed ? "resumed" : "created");
+    
+    // 没有创建步骤的应用在第一帧时即完全可用
+    if (app_manager_is_app_ready(g_app_manager.current_app)) {
+        finish_interactive_timing(g_app_manager.current_app);
+    }
+}
+
+// 全部创建步骤完成，记录完全可用的耗时
+static void finish_interactive_timing(app_t* app) {
+    if (g_interactive_start_us == 0 || !app) {
+        return;
+    }
+    
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - g_interactive_start_us);
+    g_interactive_start_us = 0;
+    
+    g_switch_stats.last_interactive_us = elapsed_us;
+    if (elapsed_us > g_switch_stats.max_interactive_us) {
+        g_switch_stats.max_interactive_us = elapsed_us;
+    }
+    
+    printf("App %s interactive after %lu us (%lu build slices)\n",
+           app->name, (unsigned long)elapsed_us, (unsigned long)g_build_slices);
+}
+
+// 查找应用的第一个创建步骤
+static int find_build_step(app_t* app) {
+    for (uint32_t i = 0; i < g_build_step_count; i++) {
+        if (g_build_steps[i].app == app) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static void remove_build_step_at(uint32_t index) {
+    memmove(&g_build_steps[index], &g_build_steps[index + 1],
+            (g_build_step_count - index - 1) * sizeof(build_step_t));
+    g_build_step_count--;
+}
+
+// 丢弃应用未执行的创建步骤
+static void remove_build_steps(app_t* app) {
+    int index;
+    while ((index = find_build_step(app)) >= 0) {
+        remove_build_step_at((uint32_t)index);
+    }
+}
+
+// 添加创建步骤
+void app_manager_add_build_step(app_t* app, app_build_step_t step, void* ctx) {
+    if (!app || !step) {
+        return;
+    }
+    
+    if (g_build_step_count >= APP_BUILD_MAX_STEPS || !g_build_timer) {
+        printf("Build step queue full, running step for %s now\n", app->name);
+        while (step(app, ctx)) {
+        }
+        return;
+    }
+    
+    g_build_steps[g_build_step_count].app = app;
+    g_build_steps[g_build_step_count].step = step;
+    g_build_steps[g_build_step_count].ctx = ctx;
+    g_build_step_count++;
+    lv_timer_resume(g_build_timer);
+}
+
+// 应用的创建步骤是否全部完成
+bool app_manager_is_app_ready(app_t* app) {
+    return app && find_build_step(app) < 0;
+}
+
+// 每帧执行一片当前应用的创建步骤
+static void build_timer_cb(lv_timer_t* timer) {
+    app_t* app = g_app_manager.current_app;
+    if (!app || find_build_step(app) < 0) {
+        lv_timer_pause(timer);
+        return;
+    }
+    
+    // 等上一片的结果（第一片是骨架）绘制出来再继续
+    int64_t start_us = esp_timer_get_time();
+    if (!g_build_frame_drawn && start_us - g_build_last_slice_us < APP_BUILD_FRAME_TIMEOUT_US) {
+        return;
+    }
+    
+    int index;
+    while ((index = find_build_step(app)) >= 0) {
+        build_step_t* step = &g_build_steps[index];
+        if (!step->step(app, step->ctx)) {
+            // 步骤中可能添加了新步骤，按指针重新查找
+            int done = find_build_step(app);
+            if (done >= 0) {
+                remove_build_step_at((uint32_t)done);
+            }
+        }
+        if (esp_timer_get_time() - start_us >= APP_BUILD_BUDGET_US) {
+            break;
+        }
+    }
+    
+    g_build_frame_drawn = false;
+    g_build_last_slice_us = esp_timer_get_time();
+    g_build_slices++;
+    
+    if (find_build_step(app) < 0) {
+        finish_interactive_timing(app);
+    }
+}
+
+// 触摸抬起（点击在抬起时触发）
+static void indev_released_cb(lv_event_t* e) {
+    (void)e;
+    g_last_tap_us = esp_timer_get_time();
+}
+
+// 切换的起点：由点击触发时从触摸抬起算起，否则从调用时算起
+static int64_t switch_start_time(void) {
+    int64_t now = esp_timer_get_time();
+    if (lv_indev_active() && g_last_tap_us > 0 && g_last_tap_us <= now) {
+        return g_last_tap_us;
+    }
+    return now;
+}
+
+// 开始等待新界面的首帧
+static void begin_switch_timing(int64_t start_us, bool resumed) {
+    g_switch_start_us = start_us;
+    g_switch_resumed = resumed;
+    g_interactive_start_us = start_us;
+    g_build_slices = 0;
+    
+    // 创建步骤等待新界面的第一帧
+    g_build_frame_drawn = false;
+    g_build_last_slice_us = esp_timer_get_time();
+    if (g_build_timer && find_build_step(g_app_manager.current_app) >= 0) {
+        lv_timer_resume(g_build_timer);
+    }
+}
+
+// 应用容器被删除（包括被GC清屏删除）时清空引用，避免悬空指针
+static void app_container_delete_cb(lv_event_t* e) {
+    app_t* app = (app_t*)lv_event_get_user_data(e);
+    if (app && app->container == lv_event_get_target(e)) {
+        app->container = NULL;
+    }
+}
+
+// 挂起应用：暂停后隐藏容器，保留界面和状态
+static void suspend_app(app_t* app) {
+    app_mem_scan();
+    if (app->pause_cb) {
+        app->pause_cb(app);
+    }
+    app_ctx_pause(app);
+    if (app->container) {
+        lv_obj_add_flag(app->container, LV_OBJ_FLAG_HIDDEN);
+    }
+    app->state = APP_STATE_BACKGROUND;
+    app_mem_set_owner(APP_ID_NONE);
+    
+    // 有归属统计时用实际驻留的内存作为缓存预算中的占用
+    app_mem_stats_t stats = {0};
+    if (app_mem_get_stats(app->id, &stats) && stats.current_bytes > 0) {
+        app->mem_footprint = stats.current_bytes;
+    }
+    printf("Suspended app: %s (resident %zu bytes, peak %zu bytes)\n",
+           app->name, app->mem_footprint, stats.peak_bytes);
+}
+
+// 离开当前应用：可挂起的应用挂起，其余销毁
+static void leave_current_app(void) {
+    app_t* app = g_app_manager.current_app;
+    if (!app) {
+        return;
+    }
+    
+    if (app->suspendable && app->container) {
+        suspend_app(app);
+        g_app_manager.current_app = NULL;
+        return;
+    }
+    
+    printf("Closing current app: %s\n", app->name);
+    app_manager_close_current_app();
+}
+
+// 统计挂起的应用，返回最久未使用的一个
+static app_t* find_lru_suspended_app(uint32_t* count, size_t* footprint) {
+    app_t* lru = NULL;
+    *count = 0;
+    *footprint = 0;
+    
+    for (app_t* app = g_app_manager.apps; app; app = app->next) {
+        if (app->state != APP_STATE_BACKGROUND) {
+            continue;
+        }
+        (*count)++;
+        *footprint += app->mem_footprint;
+        if (!lru || app->last_used < lru->last_used) {
+            lru = app;
+        }
+    }
+    return lru;
+}
+
+// 淘汰最久未使用的挂起应用，没有挂起的应用时返回false
+static bool evict_lru_suspended_app(const char* reason) {
+    uint32_t count;
+    size_t footprint;
+    app_t* lru = find_lru_suspended_app(&count, &footprint);
+    if (!lru) {
+        return false;
+    }
+    
+    printf("Evicting suspended app %s (%lu suspended, %zu bytes, %s)\n",
+           lru->name, (unsigned long)count, footprint, reason);
+    destroy_app(lru);
+    g_switch_stats.evict_count++;
+    return true;
+}
+
+// 按LRU淘汰挂起的应用，直到数量、内存预算和剩余内存都满足要求
+static void trim_suspended_apps(void) {
+    while (true) {
+        uint32_t count;
+        size_t footprint;
+        if (!find_lru_suspended_app(&count, &footprint)) {
+            return;
+        }
+        
+        const char* reason;
+        if (count > APP_CACHE_MAX_SUSPENDED) {
+            reason = "too many";
+        } else if (footprint > APP_CACHE_MEMORY_BUDGET) {
+            reason = "over budget";
+        } else if (mem_pressure_check() >= MEM_PRESSURE_HIDDEN_UI) {
+            reason = "low memory";
+        } else {
+            return;
+        }
+        evict_lru_suspended_app(reason);
+    }
+}
+
+// 销毁所有挂起的应用
+void app_manager_drop_suspended_apps(void) {
+    for (app_t* app = g_app_manager.apps; app; app = app->next) {
+        if (app->state == APP_STATE_BACKGROUND) {
+            printf("Dropping suspended app: %s\n", app->name);
+            destroy_app(app);
+            g_switch_stats.evict_count++;
+        }
+    }
+}
+
+// 按名称启动应用
 bool app_manager_launch_app(const char* name) {
     if (!name) {
         return false;
     }
     
-    printf("Launching app: %s\n", name);
-    log_memory_usage("Before app launch");
-    
     app_t* app = app_manager_get_app(name);
     if (!app) {
         printf("App not found: %s\n", name);
         return false;
     }
+    return launch_app(app);
+}
+
+// 按ID启动应用
+bool app_manager_launch_app_by_id(app_id_t id) {
+    app_t* app = app_manager_get_app_by_id(id);
+    if (!app) {
+        printf("App not found: id %d\n", (int)id);
+        return false;
+    }
+    return launch_app(app);
+}
+
+// 启动应用
+static bool launch_app(app_t* app) {
+    const char* name = app->name;
+    int64_t start_us = switch_start_time();
+    printf("Launching app: %s\n", name);
     
     // 如果已经是当前应用，直接返回
     if (g_app_manager.current_app == app) {
@@ -466,42 +746,64 @@ bool app_manager_launch_app(const char* name) {
         return true;
     }
     
-    // 关闭当前应用并强制等待内存释放
-    if (g_app_manager.current_app) {
-        printf("Closing current app: %s\n", g_app_manager.current_app->name);
-        app_manager_close_current_app();
+    // 挂起的应用：显示容器后恢复，不重建界面，也不等待内存释放
+    if (app->state == APP_STATE_BACKGROUND && app->container) {
+        leave_current_app();
         
-        // 等待内存稳定
-        if (!wait_for_memory_stabilization(2000)) {
-            printf("Warning: Memory may not be fully released\n");
-        }
+        app_mem_scan();
+        app_mem_set_owner(app->id);
+        lv_obj_clear_flag(app->container, LV_OBJ_FLAG_HIDDEN);
+        app->state = APP_STATE_ACTIVE;
+        app->last_used = esp_timer_get_time() / 1000;
+        g_app_manager.current_app = app;
         
-        // 检查是否需要强制GC
-        if (should_force_gc()) {
-            force_garbage_collection();
+        app_ctx_resume(app);
+        if (app->resume_cb) {
+            app->resume_cb(app);
         }
+        
+        // 之前的应用刚挂起，可能需要淘汰最久未用的
+        trim_suspended_apps();
+        begin_switch_timing(start_us, true);
+        
+        printf("App %s resumed (%lu us)\n", name,
+               (unsigned long)(esp_timer_get_time() - start_us));
+        return true;
     }
     
-    log_memory_usage("After previous app cleanup");
-    
-    // 检查内存是否足够
-    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
-    if (free_heap < MEMORY_LOW_THRESHOLD) {
-        printf("Low memory detected (%zu bytes), forcing GC before launch\n", free_heap);
-        force_garbage_collection();
-        
-        // 再次检查内存
-        free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
-        if (free_heap < MEMORY_CRITICAL_THRESHOLD) {
-            printf("Critical memory shortage (%zu bytes), cannot launch app\n", free_heap);
+    // 离开当前应用；销毁时容器删除返回即已释放，不需要等待
+    leave_current_app();
+    if (app->state == APP_STATE_BACKGROUND) {
+        // 挂起时容器已被删除，按正常流程销毁后重建
+        destroy_app(app);
+    }
+    trim_suspended_apps();
+    
+    // 内存紧张时先按级别释放，仍然严重不足则放弃启动
+    mem_pressure_level_t level = mem_pressure_check();
+    if (level > MEM_PRESSURE_NONE) {
+        printf("Low memory before launching %s, releasing caches\n", app->name);
+        mem_pressure_release(level);
+        if (mem_pressure_check() == MEM_PRESSURE_EMERGENCY) {
+            printf("Critical memory shortage (%zu bytes internal), cannot launch app\n",
+                   heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
             return false;
         }
     }
     
+    // 记录创建前的内存，用于估计应用占用（挂起缓存的内存预算）
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    
+    // 之后的分配、定时器和顶层对象归属这个应用，直到离开
+    app_mem_scan();
+    app_mem_begin_cycle(app->id);
+    app_mem_set_owner(app->id);
+    
     // 创建应用容器
     app->container = lv_obj_create(g_app_manager.app_container);
     if (!app->container) {
         printf("Failed to create app container for %s\n", name);
+        app_mem_set_owner(APP_ID_NONE);
         return false;
     }
     
@@ -514,6 +816,7 @@ bool app_manager_launch_app(const char* name) {
     // 确保App容器可以接收点击事件
     lv_obj_add_flag(app->container, LV_OBJ_FLAG_CLICKABLE);
     lv_obj_clear_flag(app->container, LV_OBJ_FLAG_EVENT_BUBBLE);  // 防止事件冒泡，让App自己处理
+    lv_obj_add_event_cb(app->container, app_container_delete_cb, LV_EVENT_DELETE, app);
     
     // 调用应用创建回调
     printf("Creating app UI for %s\n", name);
@@ -521,24 +824,34 @@ bool app_manager_launch_app(const char* name) {
         app->create_cb(app);
     }
     
+    size_t free_after = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    app->mem_footprint = free_before > free_after ? free_before - free_after : 0;
+    app_mem_scan();
+    
     // 更新状态
     app->state = APP_STATE_ACTIVE;
+    app->last_used = esp_timer_get_time() / 1000;
     g_app_manager.current_app = app;
+    begin_switch_timing(start_us, false);
     
     log_memory_usage("After app creation");
-    printf("App %s launched successfully\n", name);
+    printf("App %s launched successfully (%zu bytes)\n", name, app->mem_footprint);
     
     return true;
 }
 
-// 关闭当前应用
-bool app_manager_close_current_app(void) {
-    if (!g_app_manager.current_app) {
-        return false;
-    }
+// 销毁应用的界面和状态（当前应用或挂起的应用）
+static void destroy_app(app_t* app) {
+    // 销毁过程中的分配和释放都归属这个应用（淘汰挂起的应用时当前应用是别的）
+    app_id_t prev_owner = app_mem_get_owner();
+    app_mem_scan();
+    app_mem_set_owner(app->id);
     
-    app_t* app = g_app_manager.current_app;
-    printf("Closing app: %s\n", app->name);
+    // 未执行的创建步骤不再需要
+    remove_build_steps(app);
+    
+    // 先释放应用上下文持有的定时器、动画、任务和事件订阅，销毁回调执行时它们已经停止
+    app_ctx_release(app);
     
     // 调用销毁回调
     if (app->destroy_cb) {
@@ -546,29 +859,38 @@ bool app_manager_close_current_app(void) {
         app->destroy_cb(app);
     }
     
-    // 销毁容器
+    // 销毁容器：删除是同步的，返回时所有子对象已释放，
+    // DELETE事件回调清空app->container；被遮挡的区域由新界面下一帧重绘
     if (app->container) {
-        printf("Destroying UI container for %s\n", app->name);
-        // 先清理容器内容，再删除容器
-        lv_obj_clean(app->container);
-        lv_refr_now(NULL);  // 强制刷新以完成清理
-        
-        // 增加延时确保LVGL任务完成
-        vTaskDelay(pdMS_TO_TICKS(20));
-        
-        lv_obj_del(app->container);
-        app->container = NULL;
+        int64_t start_us = esp_timer_get_time();
+        lv_obj_delete(app->container);
+        printf("UI container for %s freed in %lu us\n", app->name,
+               (unsigned long)(esp_timer_get_time() - start_us));
     }
     
+    // 列出销毁后仍未释放的内存、定时器和对象
+    app_mem_end_cycle(app->id);
+    app_mem_set_owner(prev_owner == app->id ? APP_ID_NONE : prev_owner);
+    
     // 更新状态
     app->state = APP_STATE_INACTIVE;
-    g_app_manager.current_app = NULL;
+    app->mem_footprint = 0;
     
     // 清理应用内存
     cleanup_app_memory(app);
+}
+
+// 关闭当前应用
+bool app_manager_close_current_app(void) {
+    if (!g_app_manager.current_app) {
+        return false;
+    }
     
-    // 等待内存稳定
-    wait_for_memory_stabilization(150);
+    app_t* app = g_app_manager.current_app;
+    printf("Closing app: %s\n", app->name);
+    
+    destroy_app(app);
+    g_app_manager.current_app = NULL;
     
     printf("App %s closed\n", app->name);
     return true;
@@ -639,23 +961,32 @@ bool app_manager_hide_overlay(const char* name) {
     return true;
 }
 
-// 查找应用
+// 按名称查找应用
 app_t* app_manager_get_app(const char* name) {
     if (!name) {
         return NULL;
     }
     
-    app_t* app = g_app_manager.apps;
-    while (app) {
+    uint32_t slot = app_name_hash(name) & (APP_NAME_HASH_SIZE - 1);
+    while (g_app_name_hash[slot] >= 0) {
+        app_t* app = &g_app_slots[g_app_name_hash[slot]];
         if (strcmp(app->name, name) == 0) {
             return app;
         }
-        app = app->next;
+        slot = (slot + 1) & (APP_NAME_HASH_SIZE - 1);
     }
     
     return NULL;
 }
 
+// 按ID查找应用（未编译进来的应用返回NULL）
+app_t* app_manager_get_app_by_id(app_id_t id) {
+    if (id < 0 || id >= APP_ID_COUNT || !g_app_slots[id].name) {
+        return NULL;
+    }
+    return &g_app_slots[id];
+}
+
 // 查找Overlay
 overlay_t* app_manager_get_overlay(const char* name) {
     if (!name) {
@@ -690,18 +1021,18 @@ overlay_t* app_manager_get_overlay_list(void) {
 
 // 跳转到启动器
 void app_manager_go_to_launcher(void) {
-    app_manager_launch_app("启动器");
+    app_manager_launch_app_by_id(APP_ID_LAUNCHER);
 }
 
 // 检查是否是启动器激活状态
 bool app_manager_is_launcher_active(void) {
     return g_app_manager.current_app && 
-           strcmp(g_app_manager.current_app->name, "启动器") == 0;
+           g_app_manager.current_app->id == APP_ID_LAUNCHER;
 }
 
-// 公共API：强制垃圾回收
+// 公共API：强制释放内存（按紧急级别执行所有低内存回调）
 void app_manager_force_gc(void) {
-    force_garbage_collection();
+    mem_pressure_release(MEM_PRESSURE_EMERGENCY);
 }
 
 // 公共API：记录内存使用情况
@@ -718,7 +1049,9 @@ bool app_manager_check_memory_sufficient(void) {
 // 公共API：获取内存监控统计信息
 void app_manager_get_memory_stats(uint32_t* gc_count, size_t* free_heap, size_t* free_psram) {
     if (gc_count) {
-        *gc_count = g_memory_monitor.gc_count;
+        mem_pressure_stats_t stats;
+        mem_pressure_get_stats(&stats);
+        *gc_count = stats.rounds;
     }
     if (free_heap) {
         *free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
@@ -726,4 +1059,148 @@ void app_manager_get_memory_stats(uint32_t* gc_count, size_t* free_heap, size_t*
     if (free_psram) {
         *free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
     }
-} 
\ No newline at end of file
+}
+
+// 公共API：获取应用切换统计
+void app_manager_get_switch_stats(app_switch_stats_t* stats) {
+    if (stats) {
+        *stats = g_switch_stats;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               启动/关闭泄漏检查                              */
+/* -------------------------------------------------------------------------- */
+
+#define LEAK_CHECK_WARMUP       3       // 不计入的启动次数（首次启动会建立字体缓存、共享状态等）
+#define LEAK_CHECK_INTERVAL     20      // 步进定时器周期（ms）
+#define LEAK_CHECK_HEAP_SLACK   1024    // 允许的堆差异（字节，碎片和统计误差）
+
+typedef enum {
+    LEAK_STEP_LAUNCH,
+    LEAK_STEP_WAIT_READY,
+    LEAK_STEP_SETTLE,           // 等一个周期，让异步删除的对象执行完
+} leak_step_t;
+
+static struct {
+    lv_timer_t* timer;
+    app_id_t app_id;
+    uint32_t launches;          // 每个应用计入检查的启动次数
+    uint32_t done;              // 当前应用已完成的次数（含预热）
+    leak_step_t step;
+    uint32_t base_timers;       // 预热后的基线
+    size_t base_internal;
+    size_t base_psram;
+    uint32_t apps_checked;
+    uint32_t apps_leaking;
+} g_leak_check = {0};
+
+static uint32_t count_lv_timers(void) {
+    uint32_t count = 0;
+    for (lv_timer_t* t = lv_timer_get_next(NULL); t; t = lv_timer_get_next(t)) {
+        count++;
+    }
+    return count;
+}
+
+static void leak_check_baseline(void) {
+    g_leak_check.base_timers = count_lv_timers();
+    g_leak_check.base_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    g_leak_check.base_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+}
+
+static void leak_check_report(app_t* app) {
+    int32_t timers = (int32_t)count_lv_timers() - (int32_t)g_leak_check.base_timers;
+    long internal = (long)g_leak_check.base_internal - (long)heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    long psram = (long)g_leak_check.base_psram - (long)heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    bool ok = timers == 0 && internal <= LEAK_CHECK_HEAP_SLACK && psram <= LEAK_CHECK_HEAP_SLACK;
+
+    g_leak_check.apps_checked++;
+    if (!ok) {
+        g_leak_check.apps_leaking++;
+    }
+    printf("Leak check %s: %lu launches, timers %+ld, internal heap %+ld bytes, PSRAM %+ld bytes -> %s\n",
+           app->name, (unsigned long)g_leak_check.launches, (long)timers, internal, psram,
+           ok ? "OK" : "LEAK");
+}
+
+// 下一个已编译进来的应用，没有时返回APP_ID_NONE
+static app_id_t leak_check_next_app(int start) {
+    for (int id = start; id < APP_ID_COUNT; id++) {
+        if (id != APP_ID_LAUNCHER && app_manager_get_app_by_id((app_id_t)id)) {
+            return (app_id_t)id;
+        }
+    }
+    return APP_ID_NONE;
+}
+
+static void leak_check_finish(void) {
+    printf("Leak check finished: %lu apps, %lu leaking\n",
+           (unsigned long)g_leak_check.apps_checked, (unsigned long)g_leak_check.apps_leaking);
+    lv_timer_delete(g_leak_check.timer);
+    g_leak_check.timer = NULL;
+}
+
+static void leak_check_timer_cb(lv_timer_t* timer) {
+    (void)timer;
+    app_t* app = app_manager_get_app_by_id(g_leak_check.app_id);
+
+    switch (g_leak_check.step) {
+        case LEAK_STEP_LAUNCH:
+            if (g_leak_check.done == LEAK_CHECK_WARMUP) {
+                leak_check_baseline();
+            }
+            if (!launch_app(app)) {
+                printf("Leak check: failed to launch %s\n", app->name);
+                leak_check_finish();
+                return;
+            }
+            g_leak_check.step = LEAK_STEP_WAIT_READY;
+            break;
+
+        case LEAK_STEP_WAIT_READY:
+            if (!app_manager_is_app_ready(app)) {
+                return;
+            }
+            // 回到启动器，挂起的应用也一并销毁
+            app_manager_go_to_launcher();
+            app_manager_drop_suspended_apps();
+            g_leak_check.step = LEAK_STEP_SETTLE;
+            break;
+
+        case LEAK_STEP_SETTLE:
+            g_leak_check.step = LEAK_STEP_LAUNCH;
+            if (++g_leak_check.done < LEAK_CHECK_WARMUP + g_leak_check.launches) {
+                break;
+            }
+            leak_check_report(app);
+            g_leak_check.done = 0;
+            g_leak_check.app_id = leak_check_next_app(g_leak_check.app_id + 1);
+            if (g_leak_check.app_id == APP_ID_NONE) {
+                leak_check_finish();
+            }
+            break;
+    }
+}
+
+// 公共API：逐个启动并关闭全部应用，比较LVGL定时器数和空闲堆
+bool app_manager_start_leak_check(uint32_t launches) {
+    if (!g_app_manager.initialized || g_leak_check.timer || launches == 0) {
+        return false;
+    }
+    app_id_t first = leak_check_next_app(APP_ID_LAUNCHER + 1);
+    if (first == APP_ID_NONE) {
+        return false;
+    }
+
+    memset(&g_leak_check, 0, sizeof(g_leak_check));
+    g_leak_check.app_id = first;
+    g_leak_check.launches = launches;
+    g_leak_check.step = LEAK_STEP_LAUNCH;
+    g_leak_check.timer = lv_timer_create(leak_check_timer_cb, LEAK_CHECK_INTERVAL, NULL);
+    if (!g_leak_check.timer) {
+        return false;
+    }
+    printf("Leak check started: %lu launches per app\n", (unsigned long)launches);
+    return true;
+}
@@ -7,10 +7,11 @@
 typedef struct app_manager_t app_manager_t;
 typedef struct app_t app_t;
 typedef struct overlay_t overlay_t;
+typedef struct app_ctx_t app_ctx_t;
 
 // 应用类型
 typedef enum {
-    APP_TYPE_NORMAL,    // 普通应用：全屏显示，离开即销毁
+    APP_TYPE_NORMAL,    // 普通应用：全屏显示，离开即销毁（可挂起的应用离开时挂起）
     APP_TYPE_OVERLAY    // 覆盖层：可后台驻留，显示在App之上
 } app_type_t;
 
@@ -18,19 +19,52 @@ typedef enum {
 typedef enum {
     APP_STATE_INACTIVE,  // 未激活
     APP_STATE_ACTIVE,    // 激活中
-    APP_STATE_BACKGROUND // 后台运行（仅Overlay支持）
+    APP_STATE_BACKGROUND // 后台运行（Overlay隐藏或应用挂起）
 } app_state_t;
 
+// 应用ID：固定值，不随应用的编译开关变化
+typedef enum {
+    APP_ID_LAUNCHER = 0,
+    APP_ID_FILE_MANAGER,
+    APP_ID_PWM_SERVO,
+    APP_ID_PHOTO,
+    APP_ID_SETTINGS,
+    APP_ID_MUSIC_PLAYER,
+    APP_ID_COUNT,
+    APP_ID_NONE = -1            // Overlay没有应用ID
+} app_id_t;
+
 // 应用回调函数类型
 typedef void (*app_create_cb_t)(app_t* app);
 typedef void (*app_destroy_cb_t)(app_t* app);
 typedef void (*app_resume_cb_t)(app_t* app);
 typedef void (*app_pause_cb_t)(app_t* app);
 
+// 分步创建的步骤：返回true表示还没完成，下一次继续调用（可分多次完成的工作）
+typedef bool (*app_build_step_t)(app_t* app, void* ctx);
+
+// 应用描述：常量，由APP_DEFINE放入flash中的应用表，启动时按ID收集
+typedef struct {
+    app_id_t id;
+    const char* name;           // 显示名称
+    const char* icon;           // 图标（LVGL符号）
+    app_create_cb_t create_cb;
+    app_destroy_cb_t destroy_cb;
+    app_pause_cb_t pause_cb;    // 挂起前调用（暂停定时器等）
+    app_resume_cb_t resume_cb;  // 恢复显示后调用
+    bool suspendable;           // 离开时挂起而不是销毁，见app_manager_launch_app
+} app_desc_t;
+
+// 定义应用描述，链接时收集到应用表（.imos_apps段，见linker.lf），不需要在gui.c中注册
+// 用法：APP_DEFINE(my_app) = { .id = APP_ID_xxx, .name = "...", ... };
+#define APP_DEFINE(sym) \
+    static const app_desc_t sym __attribute__((used, section(".imos_apps"), aligned(4)))
+
 // 应用结构体
 struct app_t {
-    char name[32];              // 应用名称
-    char icon[8];               // 应用图标（LVGL符号）
+    app_id_t id;                // 应用ID（Overlay为APP_ID_NONE）
+    const char* name;           // 应用名称（指向描述中的常量字符串）
+    const char* icon;           // 应用图标（LVGL符号）
     app_type_t type;            // 应用类型
     app_state_t state;          // 应用状态
     lv_obj_t* container;        // 应用容器
@@ -41,9 +75,17 @@ struct app_t {
     app_resume_cb_t resume_cb;
     app_pause_cb_t pause_cb;
     
+    // 挂起缓存
+    bool suspendable;           // 离开时挂起（隐藏容器）而不是销毁
+    uint32_t last_used;         // 最近一次切到前台的时间 (ms)，用于LRU淘汰
+    size_t mem_footprint;       // 创建时占用的内存（估计值）
+    
     // 用户数据
     void* user_data;
     
+    // 应用上下文持有的定时器、动画、任务和HAL事件订阅，见app_ctx.h
+    app_ctx_t* ctx;
+    
     // 链表指针
     app_t* next;
 };
@@ -66,26 +108,49 @@ struct app_manager_t {
     bool initialized;           // 初始化标志
 };
 
+// 应用切换统计（耗时从点击或发起切换算起）
+typedef struct {
+    uint32_t switch_count;      // 切换次数
+    uint32_t resume_count;      // 其中从挂起状态恢复的次数
+    uint32_t evict_count;       // 挂起的应用被淘汰的次数
+    uint32_t last_switch_us;    // 最近一次切换到新界面第一帧绘制完成的耗时
+    uint32_t last_interactive_us; // 最近一次切换到全部创建步骤完成（完全可用）的耗时
+    uint32_t max_interactive_us;
+    uint32_t max_resume_us;     // 恢复挂起应用的最大耗时
+    uint32_t max_create_us;     // 重新创建应用的最大耗时
+    uint64_t total_resume_us;   // 恢复耗时总和（除以resume_count得平均值）
+    uint64_t total_create_us;   // 创建耗时总和
+} app_switch_stats_t;
+
 // 应用管理器API
 app_manager_t* app_manager_get_instance(void);
 void app_manager_init(void);
 void app_manager_deinit(void);
 
-// 应用注册和管理
-app_t* app_manager_register_app(const char* name, const char* icon, 
-                                app_create_cb_t create_cb, app_destroy_cb_t destroy_cb);
+// Overlay注册（name和icon需长期有效，通常为字符串常量）
 overlay_t* app_manager_register_overlay(const char* name, const char* icon, 
                                         app_create_cb_t create_cb, app_destroy_cb_t destroy_cb,
                                         int z_index, bool auto_start);
 
 // 应用控制
+// 可挂起的应用离开时隐藏容器并调用pause_cb，切回时调用resume_cb；
+// 最近使用的几个应用保留在内存中，超出数量、内存预算或内存不足时按LRU销毁
 bool app_manager_launch_app(const char* name);
+bool app_manager_launch_app_by_id(app_id_t id);
+
+// 分步创建：create_cb只建立骨架（布局和占位内容），耗时的工作（扫描存储、填充长列表）
+// 用此函数排队；骨架的第一帧绘制后，每帧在时间预算内按顺序执行，应用离开时暂停、
+// 切回时继续，销毁时丢弃未执行的步骤。队列满时立即执行完。
+void app_manager_add_build_step(app_t* app, app_build_step_t step, void* ctx);
+bool app_manager_is_app_ready(app_t* app);
 bool app_manager_close_current_app(void);
 bool app_manager_show_overlay(const char* name);
 bool app_manager_hide_overlay(const char* name);
+void app_manager_drop_suspended_apps(void);
 
 // 应用查询
 app_t* app_manager_get_app(const char* name);
+app_t* app_manager_get_app_by_id(app_id_t id);
 overlay_t* app_manager_get_overlay(const char* name);
 app_t* app_manager_get_current_app(void);
 app_t* app_manager_get_app_list(void);
@@ -99,4 +164,9 @@ bool app_manager_is_launcher_active(void);
 void app_manager_force_gc(void);
 void app_manager_log_memory_usage(const char* context);
 bool app_manager_check_memory_sufficient(void);
-void app_manager_get_memory_stats(uint32_t* gc_count, size_t* free_heap, size_t* free_psram); 
\ No newline at end of file
+void app_manager_get_memory_stats(uint32_t* gc_count, size_t* free_heap, size_t* free_psram);
+void app_manager_get_switch_stats(app_switch_stats_t* stats);
+
+// 调试：逐个启动并关闭每个应用launches次（另加几次预热），
+// 打印前后LVGL定时器数和空闲堆的差异
+bool app_manager_start_leak_check(uint32_t launches);
\ No newline at end of file
@@ -0,0 +1,422 @@
+#include "app_mem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// LVGL定时器和顶层对象的归属表
+#define APP_MEM_MAX_TIMERS      64
+#define APP_MEM_MAX_OBJECTS     64
+#define APP_MEM_MAX_LISTED      8       // 每次销毁最多列出的遗留项
+
+// 归属标记（APP_ID_NONE之外的特殊值）
+#define OWNER_NONE              ((int8_t)APP_ID_NONE)
+#define OWNER_LEAKED            ((int8_t)-2)     // 已报告过的遗留项，不再重复报告
+
+typedef struct {
+    void* item;                 // lv_timer_t* 或 lv_obj_t*
+    int8_t owner;
+} lv_owner_t;
+
+static lv_owner_t g_timers[APP_MEM_MAX_TIMERS];
+static uint32_t g_timer_count = 0;
+static lv_owner_t g_objects[APP_MEM_MAX_OBJECTS];
+static uint32_t g_object_count = 0;
+
+static app_mem_stats_t g_stats[APP_ID_COUNT];
+static volatile int8_t g_owner = OWNER_NONE;
+static TaskHandle_t g_ui_task = NULL;
+static bool g_initialized = false;
+
+#ifdef CONFIG_IMOS_APP_MEM_ACCOUNTING
+// 内存块归属表：开放寻址（线性探测），放在PSRAM；
+// 钩子只在LVGL任务中记录分配，释放可能来自任何任务，所以用自旋锁保护
+#define TRACK_BITS              13
+#define TRACK_SLOTS             (1u << TRACK_BITS)
+#define TRACK_MAX_BLOCK         0x00FFFFFFu     // meta低24位为大小
+
+typedef struct {
+    void* ptr;                  // NULL为空槽
+    uint32_t meta;              // 高8位归属，低24位大小
+} track_slot_t;
+
+static track_slot_t* g_track = NULL;
+static uint32_t g_track_used = 0;
+static uint32_t g_untracked = 0;            // 归属表满时未能记录的分配
+static size_t g_orphan_bytes = 0;           // 已报告遗留、之后才释放的内存
+static portMUX_TYPE g_track_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint32_t IRAM_ATTR track_hash(const void* ptr) {
+    return (((uint32_t)(uintptr_t)ptr >> 3) * 2654435761u) >> (32 - TRACK_BITS);
+}
+
+// 查找内存块所在的槽，不存在返回-1（调用者持有锁）
+static int IRAM_ATTR track_find(const void* ptr) {
+    uint32_t i = track_hash(ptr);
+    while (g_track[i].ptr) {
+        if (g_track[i].ptr == ptr) {
+            return (int)i;
+        }
+        i = (i + 1) & (TRACK_SLOTS - 1);
+    }
+    return -1;
+}
+
+// 删除槽并把后面探测链上的项前移，保持查找正确（调用者持有锁）
+static void IRAM_ATTR track_remove_at(uint32_t i) {
+    uint32_t j = i;
+    while (true) {
+        j = (j + 1) & (TRACK_SLOTS - 1);
+        if (!g_track[j].ptr) {
+            break;
+        }
+        uint32_t home = track_hash(g_track[j].ptr);
+        // home不在(i, j]区间内时，j处的项可以移到i
+        bool movable = (i <= j) ? (home <= i || home > j) : (home <= i && home > j);
+        if (movable) {
+            g_track[i] = g_track[j];
+            i = j;
+        }
+    }
+    g_track[i].ptr = NULL;
+    g_track[i].meta = 0;
+    g_track_used--;
+}
+
+// 释放的内存从归属的应用扣除（调用者持有锁）
+static void IRAM_ATTR track_release(uint32_t meta) {
+    int8_t owner = (int8_t)(meta >> 24);
+    size_t size = meta & TRACK_MAX_BLOCK;
+
+    if (owner >= 0 && owner < APP_ID_COUNT) {
+        app_mem_stats_t* stats = &g_stats[owner];
+        stats->current_bytes -= size < stats->current_bytes ? size : stats->current_bytes;
+        if (stats->current_blocks > 0) {
+            stats->current_blocks--;
+        }
+    } else if (owner == OWNER_LEAKED) {
+        g_orphan_bytes += size;
+    }
+}
+
+// 堆分配钩子（CONFIG_HEAP_USE_HOOKS），在分配函数内部调用，不能分配内存或阻塞
+void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    (void)caps;
+    int8_t owner = g_owner;
+    if (owner < 0 || !g_track || xPortInIsrContext() || xTaskGetCurrentTaskHandle() != g_ui_task) {
+        return;
+    }
+    if (size > TRACK_MAX_BLOCK) {
+        size = TRACK_MAX_BLOCK;
+    }
+
+    portENTER_CRITICAL_SAFE(&g_track_lock);
+    int found = track_find(ptr);
+    if (found >= 0) {
+        // 原地realloc：先扣除旧的大小
+        track_release(g_track[found].meta);
+        track_remove_at((uint32_t)found);
+    }
+    if (g_track_used < TRACK_SLOTS * 3 / 4) {
+        uint32_t i = track_hash(ptr);
+        while (g_track[i].ptr) {
+            i = (i + 1) & (TRACK_SLOTS - 1);
+        }
+        g_track[i].ptr = ptr;
+        g_track[i].meta = ((uint32_t)(uint8_t)owner << 24) | (uint32_t)size;
+        g_track_used++;
+
+        app_mem_stats_t* stats = &g_stats[owner];
+        stats->current_bytes += size;
+        stats->current_blocks++;
+        if (stats->current_bytes > stats->peak_bytes) {
+            stats->peak_bytes = stats->current_bytes;
+        }
+    } else {
+        g_untracked++;
+    }
+    portEXIT_CRITICAL_SAFE(&g_track_lock);
+}
+
+void IRAM_ATTR esp_heap_trace_free_hook(void* ptr) {
+    if (!g_track || g_track_used == 0 || !ptr) {
+        return;
+    }
+
+    portENTER_CRITICAL_SAFE(&g_track_lock);
+    int found = track_find(ptr);
+    if (found >= 0) {
+        track_release(g_track[found].meta);
+        track_remove_at((uint32_t)found);
+    }
+    portEXIT_CRITICAL_SAFE(&g_track_lock);
+}
+
+// 列出应用仍持有的内存块，并标记为已报告
+static void report_leaked_blocks(app_id_t id, const char* name) {
+    uint32_t listed = 0;
+    uint32_t blocks = 0;
+    size_t bytes = 0;
+
+    // 分段加锁，避免长时间关中断
+    for (uint32_t base = 0; base < TRACK_SLOTS; base += 256) {
+        struct { void* ptr; size_t size; } found[APP_MEM_MAX_LISTED];
+        uint32_t found_count = 0;
+
+        portENTER_CRITICAL(&g_track_lock);
+        for (uint32_t i = base; i < base + 256; i++) {
+            if (!g_track[i].ptr || (int8_t)(g_track[i].meta >> 24) != (int8_t)id) {
+                continue;
+            }
+            size_t size = g_track[i].meta & TRACK_MAX_BLOCK;
+            if (listed + found_count < APP_MEM_MAX_LISTED) {
+                found[found_count].ptr = g_track[i].ptr;
+                found[found_count].size = size;
+                found_count++;
+            }
+            g_track[i].meta = ((uint32_t)(uint8_t)OWNER_LEAKED << 24) | (uint32_t)size;
+            blocks++;
+            bytes += size;
+        }
+        portEXIT_CRITICAL(&g_track_lock);
+
+        for (uint32_t k = 0; k < found_count; k++) {
+            printf("  leaked block %p: %zu bytes\n", found[k].ptr, found[k].size);
+        }
+        listed += found_count;
+    }
+
+    if (blocks > listed) {
+        printf("  ... and %lu more blocks\n", (unsigned long)(blocks - listed));
+    }
+    if (blocks > 0) {
+        printf("App %s still holds %zu bytes in %lu blocks after destroy\n",
+               name, bytes, (unsigned long)blocks);
+    }
+
+    portENTER_CRITICAL(&g_track_lock);
+    g_stats[id].leaked_bytes += bytes;
+    g_stats[id].leaked_blocks += blocks;
+    g_stats[id].current_bytes = 0;
+    g_stats[id].current_blocks = 0;
+    portEXIT_CRITICAL(&g_track_lock);
+}
+#endif // CONFIG_IMOS_APP_MEM_ACCOUNTING
+
+// 初始化
+void app_mem_init(void) {
+    if (g_initialized) {
+        return;
+    }
+
+    memset(g_stats, 0, sizeof(g_stats));
+    g_timer_count = 0;
+    g_object_count = 0;
+    g_ui_task = xTaskGetCurrentTaskHandle();
+
+#ifdef CONFIG_IMOS_APP_MEM_ACCOUNTING
+    // 先分配归属表再启用钩子（g_track非NULL后钩子才生效）
+    track_slot_t* track = heap_caps_calloc(TRACK_SLOTS, sizeof(track_slot_t), MALLOC_CAP_SPIRAM);
+    if (!track) {
+        track = calloc(TRACK_SLOTS, sizeof(track_slot_t));
+    }
+    if (track) {
+        g_track = track;
+        printf("App memory accounting enabled (%u slots)\n", (unsigned)TRACK_SLOTS);
+    } else {
+        printf("App memory accounting disabled: no memory for tracking table\n");
+    }
+#endif
+
+    g_initialized = true;
+}
+
+void app_mem_set_owner(app_id_t id) {
+    g_owner = (id >= 0 && id < APP_ID_COUNT) ? (int8_t)id : OWNER_NONE;
+}
+
+app_id_t app_mem_get_owner(void) {
+    return (app_id_t)g_owner;
+}
+
+void app_mem_bind_ui_task(void) {
+    g_ui_task = xTaskGetCurrentTaskHandle();
+}
+
+// 在归属表中查找
+static lv_owner_t* owner_find(lv_owner_t* table, uint32_t count, const void* item) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (table[i].item == item) {
+            return &table[i];
+        }
+    }
+    return NULL;
+}
+
+// 记录一个存在的项：新项归属当前应用；seen标记本轮扫描到的项
+static void owner_track(lv_owner_t* table, uint32_t* count, uint32_t max, void* item, bool* seen) {
+    lv_owner_t* entry = owner_find(table, *count, item);
+    if (!entry) {
+        if (*count >= max) {
+            return;
+        }
+        entry = &table[(*count)++];
+        entry->item = item;
+        entry->owner = g_owner;
+    }
+    seen[entry - table] = true;
+}
+
+// 删除本轮没有扫描到的项（已被删除）
+static void owner_compact(lv_owner_t* table, uint32_t* count, const bool* seen) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < *count; i++) {
+        if (seen[i]) {
+            table[kept++] = table[i];
+        }
+    }
+    *count = kept;
+}
+
+static void scan_layer(lv_obj_t* layer, bool* seen) {
+    if (!layer) {
+        return;
+    }
+
+    app_manager_t* manager = app_manager_get_instance();
+    uint32_t child_count = lv_obj_get_child_count(layer);
+    for (uint32_t i = 0; i < child_count; i++) {
+        lv_obj_t* child = lv_obj_get_child(layer, i);
+        if (child == manager->app_container || child == manager->overlay_container) {
+            continue;
+        }
+        owner_track(g_objects, &g_object_count, APP_MEM_MAX_OBJECTS, child, seen);
+    }
+}
+
+void app_mem_scan(void) {
+    if (!g_initialized) {
+        return;
+    }
+
+    bool seen[APP_MEM_MAX_OBJECTS > APP_MEM_MAX_TIMERS ? APP_MEM_MAX_OBJECTS : APP_MEM_MAX_TIMERS];
+
+    memset(seen, 0, sizeof(seen));
+    for (lv_timer_t* timer = lv_timer_get_next(NULL); timer; timer = lv_timer_get_next(timer)) {
+        owner_track(g_timers, &g_timer_count, APP_MEM_MAX_TIMERS, timer, seen);
+    }
+    owner_compact(g_timers, &g_timer_count, seen);
+
+    memset(seen, 0, sizeof(seen));
+    scan_layer(lv_screen_active(), seen);
+    scan_layer(lv_layer_top(), seen);
+    scan_layer(lv_layer_sys(), seen);
+    owner_compact(g_objects, &g_object_count, seen);
+}
+
+void app_mem_begin_cycle(app_id_t id) {
+    if (id < 0 || id >= APP_ID_COUNT) {
+        return;
+    }
+
+    g_stats[id].peak_bytes = g_stats[id].current_bytes;
+    g_stats[id].launches++;
+}
+
+// 统计应用持有的LVGL项
+static uint32_t count_owned(const lv_owner_t* table, uint32_t count, app_id_t id) {
+    uint32_t owned = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (table[i].owner == (int8_t)id) {
+            owned++;
+        }
+    }
+    return owned;
+}
+
+// 列出应用仍持有的LVGL项，并标记为已报告
+static uint32_t report_leaked_items(lv_owner_t* table, uint32_t count, app_id_t id, bool is_timer) {
+    uint32_t leaked = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (table[i].owner != (int8_t)id) {
+            continue;
+        }
+        if (leaked < APP_MEM_MAX_LISTED) {
+            if (is_timer) {
+                printf("  leaked timer %p (user_data %p)\n", table[i].item,
+                       lv_timer_get_user_data((lv_timer_t*)table[i].item));
+            } else {
+                printf("  leaked object %p (%lu children)\n", table[i].item,
+                       (unsigned long)lv_obj_get_child_count((lv_obj_t*)table[i].item));
+            }
+        }
+        table[i].owner = OWNER_LEAKED;
+        leaked++;
+    }
+    return leaked;
+}
+
+void app_mem_end_cycle(app_id_t id) {
+    if (!g_initialized || id < 0 || id >= APP_ID_COUNT) {
+        return;
+    }
+
+    app_t* app = app_manager_get_app_by_id(id);
+    const char* name = app ? app->name : "?";
+    app_mem_stats_t* stats = &g_stats[id];
+
+    // 销毁回调中创建的项也算在应用名下
+    app_mem_scan();
+
+    printf("=== APP MEMORY [%s] launch #%lu ===\n", name, (unsigned long)stats->launches);
+    printf("  Peak: %zu bytes, held after destroy: %zu bytes in %lu blocks\n",
+           stats->peak_bytes, stats->current_bytes, (unsigned long)stats->current_blocks);
+
+    uint32_t timers = report_leaked_items(g_timers, g_timer_count, id, true);
+    uint32_t objects = report_leaked_items(g_objects, g_object_count, id, false);
+    if (timers > 0 || objects > 0) {
+        printf("App %s left %lu timers and %lu top-level objects\n",
+               name, (unsigned long)timers, (unsigned long)objects);
+    }
+
+#ifdef CONFIG_IMOS_APP_MEM_ACCOUNTING
+    if (g_track) {
+        report_leaked_blocks(id, name);
+    }
+#endif
+
+    printf("=== END APP MEMORY ===\n");
+}
+
+bool app_mem_get_stats(app_id_t id, app_mem_stats_t* stats) {
+    if (!stats || id < 0 || id >= APP_ID_COUNT) {
+        return false;
+    }
+
+    *stats = g_stats[id];
+    stats->timers = count_owned(g_timers, g_timer_count, id);
+    stats->objects = count_owned(g_objects, g_object_count, id);
+    return true;
+}
+
+void app_mem_log_summary(void) {
+    printf("=== APP MEMORY SUMMARY ===\n");
+    for (app_t* app = app_manager_get_app_list(); app; app = app->next) {
+        app_mem_stats_t stats;
+        if (!app_mem_get_stats(app->id, &stats) || stats.launches == 0) {
+            continue;
+        }
+        printf("  %s: current %zu, peak %zu, leaked %zu bytes/%lu blocks, timers %lu, objects %lu\n",
+               app->name, stats.current_bytes, stats.peak_bytes, stats.leaked_bytes,
+               (unsigned long)stats.leaked_blocks, (unsigned long)stats.timers,
+               (unsigned long)stats.objects);
+    }
+#ifdef CONFIG_IMOS_APP_MEM_ACCOUNTING
+    printf("  Tracked blocks: %lu, untracked: %lu, leaked then freed: %zu bytes\n",
+           (unsigned long)g_track_used, (unsigned long)g_untracked, g_orphan_bytes);
+#endif
+    printf("=== END APP MEMORY SUMMARY ===\n");
+}
@@ -0,0 +1,81 @@
+#ifndef APP_MEM_H
+#define APP_MEM_H
+
+#include "app_manager.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 单个应用的内存统计
+typedef struct {
+    size_t current_bytes;       // 当前持有的堆内存
+    size_t peak_bytes;          // 本次启动以来的峰值
+    uint32_t current_blocks;    // 当前持有的内存块数
+    size_t leaked_bytes;        // 历次销毁后仍未释放的内存（累计）
+    uint32_t leaked_blocks;
+    uint32_t timers;            // 当前持有的LVGL定时器
+    uint32_t objects;           // 应用容器之外的顶层LVGL对象（顶层、系统层上的弹窗等）
+    uint32_t launches;          // 启动次数
+} app_mem_stats_t;
+
+/**
+ * @brief 初始化内存归属统计（由app_manager_init调用）
+ *
+ * 开启CONFIG_IMOS_APP_MEM_ACCOUNTING时通过堆分配钩子记录每个内存块的归属；
+ * 否则只统计LVGL定时器和顶层对象。
+ */
+void app_mem_init(void);
+
+/**
+ * @brief 设置当前归属的应用（APP_ID_NONE表示不归属任何应用）
+ *
+ * 只有LVGL任务中的分配计入应用，后台任务的分配不计入。
+ */
+void app_mem_set_owner(app_id_t id);
+
+/**
+ * @brief 获取当前归属的应用
+ */
+app_id_t app_mem_get_owner(void);
+
+/**
+ * @brief 记录调用者所在的任务为LVGL任务（在LVGL回调中调用）
+ */
+void app_mem_bind_ui_task(void);
+
+/**
+ * @brief 把新出现的LVGL定时器和顶层对象记到当前归属的应用名下
+ *
+ * 在切换归属前调用，使上一段时间创建的对象归属正确。
+ */
+void app_mem_scan(void);
+
+/**
+ * @brief 应用启动：重置本次启动的峰值统计
+ */
+void app_mem_begin_cycle(app_id_t id);
+
+/**
+ * @brief 应用销毁完成：列出仍未释放的内存块、定时器和对象，输出本次启动的汇总
+ */
+void app_mem_end_cycle(app_id_t id);
+
+/**
+ * @brief 获取应用的内存统计
+ */
+bool app_mem_get_stats(app_id_t id, app_mem_stats_t* stats);
+
+/**
+ * @brief 输出所有应用的内存统计
+ */
+void app_mem_log_summary(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APP_MEM_H
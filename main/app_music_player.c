@@ -1,14 +1,17 @@
 #include "app_music_player.h"
 #include "app_manager.h"
+#include "app_ctx.h"
 #include "hal_sdcard.h"
 #include "hal_audio.h"
+#include "hal_event.h"
+#include "file_types.h"
+#include "fs_watch.h"
+#include "ui_bind.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <stddef.h>
-#include <dirent.h>
-#include <sys/stat.h>
 #include <ctype.h>
 #include <math.h>
 
@@ -27,6 +30,7 @@ LV_FONT_DECLARE(simhei_32);
 #define LARGE_FONT_SIZE 24
 #define MEDIUM_FONT_SIZE 18
 #define SMALL_FONT_SIZE 14
+#define LIST_FILL_BATCH 24      // 分步创建时每次添加的列表项数
 
 // 全局音乐播放器数据
 static music_player_data_t g_music_data = {
@@ -49,6 +53,27 @@ static lv_obj_t* g_next_btn = NULL;
 static lv_obj_t* g_current_song_label = NULL;
 static lv_obj_t* g_progress_bar = NULL;
 static lv_obj_t* g_time_label = NULL;
+static lv_obj_t* g_file_list = NULL;
+static uint32_t g_sd_generation = 0;    // 播放列表对应的SD卡挂载版本
+static uint32_t g_dir_generation = 0;   // 播放列表对应的音乐目录版本
+static bool g_list_building = false;    // 播放列表正在分步创建
+static uint32_t g_list_fill_index = 0;  // 分步创建时下一个要添加的列表项
+
+// 播放界面状态：值改变时才更新绑定的控件，每秒的刷新不再重绘没有变化的部分
+static bool g_subjects_ready = false;
+static lv_subject_t g_state_subject;        // play_state_t
+static lv_subject_t g_title_subject;
+static char g_title_buf[128];
+static lv_subject_t g_progress_subject;     // 0-100
+static lv_subject_t g_time_subject;
+static char g_time_buf[32];
+
+static const char* const g_play_symbols[] = {
+    [PLAY_STATE_STOPPED] = LV_SYMBOL_PLAY,
+    [PLAY_STATE_PLAYING] = LV_SYMBOL_PAUSE,
+    [PLAY_STATE_PAUSED]  = LV_SYMBOL_PLAY,
+    [PLAY_STATE_LOADING] = LV_SYMBOL_REFRESH,
+};
 
 // 文件列表点击事件处理
 static void file_list_event_cb(lv_event_t* e);
@@ -60,22 +85,20 @@ static void next_button_event_cb(lv_event_t* e);
 
 // 刷新文件列表显示
 static void refresh_file_list(lv_obj_t* list);
+static bool reset_file_list(lv_obj_t* list);
+static void add_file_list_items(lv_obj_t* list, uint32_t from, uint32_t to);
 
 // 检查SD卡是否挂载
 static bool is_sd_card_mounted(void);
 
 // UI更新定时器回调
-static void ui_update_timer_cb(lv_timer_t* timer);
+static void dir_check_timer_cb(lv_timer_t* timer);
+static void check_playlist_changes(void);
+static void hal_event_cb(const hal_event_t* event, void* user_data);
+static void init_ui_subjects(void);
 
 bool is_mp3_file(const char* filename) {
-    if (!filename) return false;
-    
-    size_t len = strlen(filename);
-    if (len < 4) return false;
-    
-    // 检查文件扩展名
-    const char* ext = filename + len - 4;
-    return (strcasecmp(ext, ".mp3") == 0);
+    return file_types_has_cap(filename, FILE_CAP_PLAY);
 }
 
 void extract_title_from_filename(const char* filename, char* title, size_t title_size) {
@@ -111,6 +134,48 @@ static bool is_sd_card_mounted(void) {
     return hal_sdcard_is_mounted();
 }
 
+// MP3扫描上下文
+typedef struct {
+    music_player_data_t* data;
+    const char* mount_point;
+    uint32_t capacity;
+} mp3_scan_ctx_t;
+
+static bool count_mp3_cb(const hal_sdcard_entry_t* entry, void* user_data) {
+    (void)entry;
+    (void)user_data;
+    return true;
+}
+
+static bool fill_mp3_cb(const hal_sdcard_entry_t* entry, void* user_data) {
+    mp3_scan_ctx_t* ctx = (mp3_scan_ctx_t*)user_data;
+    music_player_data_t* data = ctx->data;
+    
+    if (data->file_count >= ctx->capacity) {
+        return false;
+    }
+    
+    mp3_file_info_t* file_info = &data->files[data->file_count];
+    
+    // 构建完整文件路径
+    snprintf(file_info->filename, sizeof(file_info->filename), 
+             "%s/%s", ctx->mount_point, entry->name);
+    
+    // 提取标题
+    extract_title_from_filename(entry->name, file_info->title, sizeof(file_info->title));
+    
+    // 文件大小
+    file_info->file_size = (uint32_t)entry->size;
+    
+    // 暂时设置为空或默认值
+    strcpy(file_info->artist, "Unknown Artist");
+    strcpy(file_info->album, "Unknown Album");
+    file_info->duration = 0;
+    
+    data->file_count++;
+    return true;
+}
+
 uint32_t scan_mp3_files(music_player_data_t* data) {
     if (!data) return 0;
     
@@ -127,26 +192,19 @@ uint32_t scan_mp3_files(music_player_data_t* data) {
     data->is_scanning = true;
     
     const char* mount_point = hal_sdcard_get_mount_point();
-    DIR* dir = opendir(mount_point);
-    if (!dir) {
+    
+    // 第一次扫描：计算MP3文件数量（仅匹配*.mp3，无需stat）
+    int count = hal_sdcard_list_dir(mount_point, "*.mp3", HAL_SDCARD_LIST_FILES_ONLY,
+                                    count_mp3_cb, NULL);
+    if (count < 0) {
         printf("Failed to open SD card directory: %s\n", mount_point);
         data->is_scanning = false;
         return 0;
     }
-    
-    // 第一次扫描：计算MP3文件数量
-    struct dirent* entry;
-    uint32_t mp3_count = 0;
-    
-    while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_type == DT_REG && is_mp3_file(entry->d_name)) {
-            mp3_count++;
-        }
-    }
+    uint32_t mp3_count = (uint32_t)count;
     
     if (mp3_count == 0) {
         printf("No MP3 files found\n");
-        closedir(dir);
         data->is_scanning = false;
         return 0;
     }
@@ -155,44 +213,19 @@ uint32_t scan_mp3_files(music_player_data_t* data) {
     data->files = (mp3_file_info_t*)malloc(mp3_count * sizeof(mp3_file_info_t));
     if (!data->files) {
         printf("Failed to allocate memory for MP3 files\n");
-        closedir(dir);
         data->is_scanning = false;
         return 0;
     }
     
-    // 重新扫描目录
-    rewinddir(dir);
+    // 重新扫描目录，文件大小直接来自目录记录
     data->file_count = 0;
+    mp3_scan_ctx_t ctx = {
+        .data = data,
+        .mount_point = mount_point,
+        .capacity = mp3_count,
+    };
+    hal_sdcard_list_dir(mount_point, "*.mp3", HAL_SDCARD_LIST_FILES_ONLY, fill_mp3_cb, &ctx);
     
-    while ((entry = readdir(dir)) != NULL && data->file_count < mp3_count) {
-        if (entry->d_type == DT_REG && is_mp3_file(entry->d_name)) {
-            mp3_file_info_t* file_info = &data->files[data->file_count];
-            
-            // 构建完整文件路径
-            snprintf(file_info->filename, sizeof(file_info->filename), 
-                     "%s/%s", mount_point, entry->d_name);
-            
-            // 提取标题
-            extract_title_from_filename(entry->d_name, file_info->title, sizeof(file_info->title));
-            
-            // 获取文件大小
-            struct stat file_stat;
-            if (stat(file_info->filename, &file_stat) == 0) {
-                file_info->file_size = file_stat.st_size;
-            } else {
-                file_info->file_size = 0;
-            }
-            
-            // 暂时设置为空或默认值
-            strcpy(file_info->artist, "Unknown Artist");
-            strcpy(file_info->album, "Unknown Album");
-            file_info->duration = 0;
-            
-            data->file_count++;
-        }
-    }
-    
-    closedir(dir);
     data->is_scanning = false;
     data->current_index = 0;
     
@@ -236,7 +269,7 @@ static void file_list_event_cb(lv_event_t* e) {
             lv_obj_align(feedback, LV_ALIGN_TOP_MID, 0, 20);
             
             // 2秒后自动删除提示
-            lv_obj_delete_delayed(feedback, 2000);
+            app_ctx_obj_delete_delayed(app_manager_get_app_by_id(APP_ID_MUSIC_PLAYER), feedback, 2000);
         }
     }
 }
@@ -279,7 +312,14 @@ static void next_button_event_cb(lv_event_t* e) {
 }
 
 static void refresh_file_list(lv_obj_t* list) {
-    if (!list) return;
+    if (reset_file_list(list)) {
+        add_file_list_items(list, 0, g_music_data.file_count);
+    }
+}
+
+// 清空列表，没有可添加的文件时显示提示，返回是否需要添加文件
+static bool reset_file_list(lv_obj_t* list) {
+    if (!list) return false;
     
     // 清空现有列表
     lv_obj_clean(list);
@@ -289,7 +329,7 @@ static void refresh_file_list(lv_obj_t* list) {
         lv_obj_t* item = lv_list_add_text(list, "SD卡未挂载");
         lv_obj_set_style_text_color(item, lv_color_hex(0xFF0000), 0);
         lv_obj_set_style_text_font(item, &simhei_32, 0);
-        return;
+        return false;
     }
     
     if (g_music_data.file_count == 0) {
@@ -297,11 +337,19 @@ static void refresh_file_list(lv_obj_t* list) {
         lv_obj_t* item = lv_list_add_text(list, "未找到MP3文件");
         lv_obj_set_style_text_color(item, lv_color_hex(0x888888), 0);
         lv_obj_set_style_text_font(item, &simhei_32, 0);
-        return;
+        return false;
+    }
+    
+    return true;
+}
+
+// 添加第from到to-1个MP3文件到列表
+static void add_file_list_items(lv_obj_t* list, uint32_t from, uint32_t to) {
+    if (to > g_music_data.file_count) {
+        to = g_music_data.file_count;
     }
     
-    // 添加MP3文件到列表
-    for (uint32_t i = 0; i < g_music_data.file_count; i++) {
+    for (uint32_t i = from; i < to; i++) {
         mp3_file_info_t* file = &g_music_data.files[i];
         
         // 创建列表项
@@ -326,11 +374,48 @@ static void refresh_file_list(lv_obj_t* list) {
     }
 }
 
+// 分步创建：扫描SD卡上的MP3文件
+static bool build_scan_step(app_t* app, void* ctx) {
+    (void)app;
+    lv_obj_t* list = (lv_obj_t*)ctx;
+    
+    g_sd_generation = hal_sdcard_get_generation();
+    g_dir_generation = fs_watch_get_generation(hal_sdcard_get_mount_point());
+    scan_mp3_files(&g_music_data);
+    
+    g_list_fill_index = 0;
+    if (!reset_file_list(list)) {
+        g_list_building = false;
+    }
+    return false;
+}
+
+// 分步创建：每次添加一批列表项
+static bool build_fill_step(app_t* app, void* ctx) {
+    (void)app;
+    lv_obj_t* list = (lv_obj_t*)ctx;
+    
+    if (!g_list_building) {
+        return false;
+    }
+    
+    uint32_t to = g_list_fill_index + LIST_FILL_BATCH;
+    add_file_list_items(list, g_list_fill_index, to);
+    g_list_fill_index = to;
+    
+    if (g_list_fill_index >= g_music_data.file_count) {
+        g_list_building = false;
+        return false;
+    }
+    return true;
+}
+
 // 音乐播放器应用创建
 static void music_player_app_create(app_t* app) {
     if (!app || !app->container) {
         return;
     }
+    init_ui_subjects();
     
     // 设置红色背景
     lv_obj_set_style_bg_color(app->container, lv_color_hex(0xFF4F4F), 0);
@@ -411,12 +496,12 @@ static void music_player_app_create(app_t* app) {
     
     // 当前歌曲标签
     g_current_song_label = lv_label_create(text_info_container);
-    lv_label_set_text(g_current_song_label, "未选择歌曲");
     lv_obj_set_style_text_color(g_current_song_label, lv_color_hex(0xFFFFFF), 0);  // 白色文字
     lv_obj_set_style_text_font(g_current_song_label, &simhei_32, 0);
     lv_obj_align(g_current_song_label, LV_ALIGN_TOP_LEFT, 0, 10);
     lv_label_set_long_mode(g_current_song_label, LV_LABEL_LONG_WRAP);
     lv_obj_set_width(g_current_song_label, main_width - 280);
+    lv_label_bind_text(g_current_song_label, &g_title_subject, NULL);
     
     // 进度条
     g_progress_bar = lv_bar_create(text_info_container);
@@ -427,14 +512,15 @@ static void music_player_app_create(app_t* app) {
     lv_obj_set_style_bg_color(g_progress_bar, lv_color_hex(0xFFFFFF), LV_PART_INDICATOR);  // 白色进度
     lv_obj_set_style_border_width(g_progress_bar, 0, 0);  // 无边框
     lv_obj_set_style_radius(g_progress_bar, 4, 0);
-    lv_bar_set_value(g_progress_bar, 0, LV_ANIM_OFF);
+    lv_bar_set_value(g_progress_bar, lv_subject_get_int(&g_progress_subject), LV_ANIM_OFF);
+    ui_bind_bar_value(g_progress_bar, &g_progress_subject);
     
     // 时间标签
     g_time_label = lv_label_create(text_info_container);
-    lv_label_set_text(g_time_label, "00:00 / 00:00");
     lv_obj_set_style_text_color(g_time_label, lv_color_hex(0xFFFFFF), 0);  // 白色文字
     lv_obj_set_style_text_font(g_time_label, &lv_font_montserrat_16, 0);
     lv_obj_align(g_time_label, LV_ALIGN_BOTTOM_LEFT, 0, -10);
+    lv_label_bind_text(g_time_label, &g_time_subject, NULL);
     
     /* === 右侧下半部分：播放控制 === */
     lv_obj_t* control_container = lv_obj_create(main_container);
@@ -479,9 +565,10 @@ static void music_player_app_create(app_t* app) {
     lv_obj_add_event_cb(g_play_pause_btn, play_pause_button_event_cb, LV_EVENT_CLICKED, NULL);
     
     lv_obj_t* play_label = lv_label_create(g_play_pause_btn);
-    lv_label_set_text(play_label, LV_SYMBOL_PLAY);
     lv_obj_set_style_text_color(play_label, lv_color_hex(0xFFFFFF), 0);  // 白色文字
     lv_obj_set_style_text_font(play_label, &lv_font_montserrat_40, 0);
+    ui_bind_label_map(play_label, &g_state_subject, g_play_symbols,
+                      sizeof(g_play_symbols) / sizeof(g_play_symbols[0]));
     lv_obj_center(play_label);
     
     // 下一曲按钮
@@ -509,15 +596,27 @@ static void music_player_app_create(app_t* app) {
     // 保存UI元素到用户数据 (保持原有逻辑)
     app->user_data = list;
     
-    // 自动扫描一次 (保持原有逻辑)
-    scan_mp3_files(&g_music_data);
-    refresh_file_list(list);
+    // 先显示占位提示，扫描和填充列表在界面显示后分步进行
+    g_file_list = list;
+    fs_watch_add_dir(hal_sdcard_get_mount_point());
+    lv_obj_t* loading = lv_list_add_text(list, "正在扫描...");
+    lv_obj_set_style_text_color(loading, lv_color_hex(0x888888), 0);
+    lv_obj_set_style_text_font(loading, &simhei_32, 0);
+    
+    g_list_building = true;
+    g_list_fill_index = 0;
+    app_manager_add_build_step(app, build_scan_step, list);
+    app_manager_add_build_step(app, build_fill_step, list);
     
     // 初始化UI状态 (保持原有逻辑)
     update_playback_ui(app->container, &g_music_data);
     
-    // 创建定时器定期更新播放进度 (保持原有逻辑)
-    lv_timer_create(ui_update_timer_cb, 1000, NULL);  // 每秒更新一次
+    // 播放状态、进度和SD卡插拔由HAL事件推送，只有目录内容变化需要定期检查；
+    // 订阅和定时器属于应用上下文，挂起时定时器暂停，销毁时一起释放
+    app_ctx_subscribe(app, HAL_EVENT_PLAYBACK_POSITION, hal_event_cb, NULL);
+    app_ctx_subscribe(app, HAL_EVENT_PLAYBACK_FINISHED, hal_event_cb, NULL);
+    app_ctx_subscribe(app, HAL_EVENT_SDCARD, hal_event_cb, NULL);
+    app_ctx_timer_create(app, dir_check_timer_cb, 1000, NULL);
 }
 
 // 音乐播放器应用销毁
@@ -535,6 +634,9 @@ static void music_player_app_destroy(app_t* app) {
     g_current_song_label = NULL;
     g_progress_bar = NULL;
     g_time_label = NULL;
+    g_file_list = NULL;
+    g_list_building = false;
+    fs_watch_remove_dir(hal_sdcard_get_mount_point());
     
     // 清空用户数据
     if (app) {
@@ -653,75 +755,114 @@ void play_previous_music(music_player_data_t* data) {
     printf("Playing previous: %s\n", data->files[data->current_index].title);
 }
 
+// 界面状态只初始化一次，控件删除时绑定自动解除
+static void init_ui_subjects(void) {
+    if (g_subjects_ready) {
+        return;
+    }
+    g_subjects_ready = true;
+    lv_subject_init_int(&g_state_subject, PLAY_STATE_STOPPED);
+    lv_subject_init_string(&g_title_subject, g_title_buf, NULL, sizeof(g_title_buf), "未选择歌曲");
+    lv_subject_init_int(&g_progress_subject, 0);
+    lv_subject_init_string(&g_time_subject, g_time_buf, NULL, sizeof(g_time_buf), "00:00 / 00:00");
+}
+
 void update_playback_ui(lv_obj_t* container, music_player_data_t* data) {
     if (!data) return;
+    init_ui_subjects();
     
-    // 更新播放位置（如果正在播放MP3）
-    if (data->play_state == PLAY_STATE_PLAYING) {
-        data->play_position = hal_audio_get_mp3_position();
-        
-        // 检查播放是否自然结束
-        if (!hal_audio_is_mp3_playing() && data->play_state == PLAY_STATE_PLAYING) {
-            data->play_state = PLAY_STATE_STOPPED;
-            data->play_position = 0;
-            printf("MP3 playback finished naturally\n");
-        }
+    // 播放位置和播放结束由hal_event_cb更新；只写状态，没有变化的控件不会重绘
+    ui_bind_set_int(&g_state_subject, data->play_state);
+    
+    if (data->files && data->current_index < data->file_count) {
+        ui_bind_set_text(&g_title_subject, data->files[data->current_index].title);
+    } else {
+        ui_bind_set_text(&g_title_subject, "未选择歌曲");
     }
     
-    // 更新播放/暂停按钮
-    if (g_play_pause_btn) {
-        lv_obj_t* btn_label = lv_obj_get_child(g_play_pause_btn, 0);
-        if (btn_label) {
-            switch (data->play_state) {
-                case PLAY_STATE_PLAYING:
-                    lv_label_set_text(btn_label, LV_SYMBOL_PAUSE);
-                    break;
-                case PLAY_STATE_PAUSED:
-                case PLAY_STATE_STOPPED:
-                    lv_label_set_text(btn_label, LV_SYMBOL_PLAY);
-                    break;
-                case PLAY_STATE_LOADING:
-                    lv_label_set_text(btn_label, LV_SYMBOL_REFRESH);
-                    break;
-            }
-        }
+    if (data->play_duration > 0) {
+        ui_bind_set_int(&g_progress_subject, (int32_t)((data->play_position * 100) / data->play_duration));
     }
     
-    // 更新当前歌曲信息
-    if (g_current_song_label) {
-        if (data->files && data->current_index < data->file_count) {
-            lv_label_set_text(g_current_song_label, data->files[data->current_index].title);
-        } else {
-            lv_label_set_text(g_current_song_label, "未选择歌曲");
-        }
-        // 确保使用中文字体
-        lv_obj_set_style_text_font(g_current_song_label, &simhei_32, 0);
+    ui_bind_set_textf(&g_time_subject, "%02lu:%02lu / %02lu:%02lu",
+                      (unsigned long)(data->play_position / 60),
+                      (unsigned long)(data->play_position % 60),
+                      (unsigned long)(data->play_duration / 60),
+                      (unsigned long)(data->play_duration % 60));
+}
+
+// SD卡插拔或音乐目录变化后重新扫描播放列表
+static void check_playlist_changes(void) {
+    // 播放列表还在分步创建，完成后再检查变化
+    if (!g_file_list || g_list_building) {
+        return;
     }
     
-    // 更新进度条
-    if (g_progress_bar && data->play_duration > 0) {
-        int32_t progress = (int32_t)((data->play_position * 100) / data->play_duration);
-        lv_bar_set_value(g_progress_bar, progress, LV_ANIM_ON);
+    // SD卡插拔后重新扫描（拔卡时正在播放的文件已无法读取）
+    uint32_t generation = hal_sdcard_get_generation();
+    if (generation != g_sd_generation) {
+        g_sd_generation = generation;
+        g_dir_generation = fs_watch_get_generation(hal_sdcard_get_mount_point());
+        stop_music(&g_music_data);
+        scan_mp3_files(&g_music_data);
+        refresh_file_list(g_file_list);
     }
     
-    // 更新时间标签
-    if (g_time_label) {
-        lv_label_set_text_fmt(g_time_label, "%02lu:%02lu / %02lu:%02lu",
-                              (unsigned long)(data->play_position / 60),
-                              (unsigned long)(data->play_position % 60),
-                              (unsigned long)(data->play_duration / 60),
-                              (unsigned long)(data->play_duration % 60));
+    // 音乐目录有文件增删时重新扫描；播放中不打乱列表顺序，停止后再刷新
+    uint32_t dir_generation = fs_watch_get_generation(hal_sdcard_get_mount_point());
+    if (dir_generation != g_dir_generation && g_music_data.play_state == PLAY_STATE_STOPPED) {
+        g_dir_generation = dir_generation;
+        scan_mp3_files(&g_music_data);
+        refresh_file_list(g_file_list);
     }
 }
 
-// UI更新定时器回调
-static void ui_update_timer_cb(lv_timer_t* timer) {
+// 目录检查定时器回调
+static void dir_check_timer_cb(lv_timer_t* timer) {
     (void)timer; // 避免未使用参数警告
+    check_playlist_changes();
+}
+
+// HAL事件回调（在LVGL任务中调用）
+static void hal_event_cb(const hal_event_t* event, void* user_data) {
+    (void)user_data;
+    
+    switch (event->type) {
+        case HAL_EVENT_PLAYBACK_POSITION:
+            if (g_music_data.play_state == PLAY_STATE_PLAYING) {
+                g_music_data.play_position = event->value;
+            }
+            break;
+        case HAL_EVENT_PLAYBACK_FINISHED:
+            if (g_music_data.play_state == PLAY_STATE_PLAYING) {
+                g_music_data.play_state = PLAY_STATE_STOPPED;
+                g_music_data.play_position = 0;
+                printf("MP3 playback finished naturally\n");
+            }
+            break;
+        case HAL_EVENT_SDCARD:
+            check_playlist_changes();
+            break;
+        default:
+            return;
+    }
     update_playback_ui(NULL, &g_music_data);
 }
 
-// 注册音乐播放器应用
-void register_music_player_app(void) {
-    app_manager_register_app("音乐播放器", LV_SYMBOL_AUDIO, 
-                             music_player_app_create, music_player_app_destroy);
-} 
\ No newline at end of file
+// 音乐播放器恢复：立即检查播放列表（目录检查定时器在挂起期间由应用上下文暂停，
+// 播放事件仍然处理，播放进度保持正确）
+static void music_player_app_resume(app_t* app) {
+    (void)app;
+    check_playlist_changes();
+}
+
+// 音乐播放器应用描述
+APP_DEFINE(music_player_app_desc) = {
+    .id = APP_ID_MUSIC_PLAYER,
+    .name = "音乐播放器",
+    .icon = LV_SYMBOL_AUDIO,
+    .create_cb = music_player_app_create,
+    .destroy_cb = music_player_app_destroy,
+    .resume_cb = music_player_app_resume,
+    .suspendable = true,
+}; 
\ No newline at end of file
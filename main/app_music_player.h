@@ -40,11 +40,6 @@ typedef struct {
     bool shuffle_mode;          // 随机播放模式
 } music_player_data_t;
 
-/**
- * @brief 注册音乐播放器应用
- */
-void register_music_player_app(void);
-
 /**
  * @brief 扫描SD卡中的MP3文件
  * 
@@ -1,4 +1,3 @@
-#include "app_photo.h"
 #include "app_manager.h"
 #include "menu_utils.h"
 #include <stdlib.h>
@@ -298,10 +297,6 @@ static void photo_app_destroy(app_t* app) {
         // 重置状态
         g_photo_state->is_initialized = false;
         
-        // 等待LVGL任务完成
-        lv_refr_now(NULL);
-        vTaskDelay(pdMS_TO_TICKS(20));
-        
         // 释放状态结构
         safe_free(g_photo_state);
         g_photo_state = NULL;
@@ -315,8 +310,11 @@ static void photo_app_destroy(app_t* app) {
     app_manager_log_memory_usage("After photo app destruction");
 }
 
-// 注册照片应用
-void register_photo_app(void) {
-    app_manager_register_app("照片", LV_SYMBOL_IMAGE, 
-                             photo_app_create, photo_app_destroy);
-}
\ No newline at end of file
+// 照片应用描述
+APP_DEFINE(photo_app_desc) = {
+    .id = APP_ID_PHOTO,
+    .name = "照片",
+    .icon = LV_SYMBOL_IMAGE,
+    .create_cb = photo_app_create,
+    .destroy_cb = photo_app_destroy,
+};
\ No newline at end of file
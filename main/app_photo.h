@@ -1,18 +0,0 @@
-#ifndef APP_PHOTO_H
-#define APP_PHOTO_H
-
-#include <stdint.h>
-#include <stdbool.h>
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-// 照片应用注册函数
-void register_photo_app(void);
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif // APP_PHOTO_H
\ No newline at end of file
@@ -46,11 +46,14 @@ static void safe_pwm_free(void* ptr) {
     }
 }
 
-// 注册PWM舵机应用
-void register_pwm_servo_app(void) {
-    app_manager_register_app("PWM调试", LV_SYMBOL_SETTINGS, 
-                             pwm_servo_app_create, pwm_servo_app_destroy);
-}
+// PWM舵机应用描述
+APP_DEFINE(pwm_servo_app_desc) = {
+    .id = APP_ID_PWM_SERVO,
+    .name = "PWM调试",
+    .icon = LV_SYMBOL_SETTINGS,
+    .create_cb = pwm_servo_app_create,
+    .destroy_cb = pwm_servo_app_destroy,
+};
 
 // 应用创建函数
 void pwm_servo_app_create(app_t* app) {
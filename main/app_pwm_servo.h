@@ -50,11 +50,6 @@ typedef struct {
 extern const pin_option_t g_pin_options[];
 extern const size_t g_pin_options_count;
 
-/**
- * @brief 注册PWM舵机测试应用
- */
-void register_pwm_servo_app(void);
-
 /**
  * @brief PWM舵机应用创建回调
  * 
@@ -1,7 +1,11 @@
-#include "app_settings.h"
 #include "app_manager.h"
+#include "app_ctx.h"
 #include "menu_utils.h"
 #include "hal.h"
+#include "hal_sdcard.h"
+#include "ui_bind.h"
+#include "sd_bench.h"
+#include "sd_selftest.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -18,6 +22,7 @@ typedef enum {
     PAGE_TYPE_ABOUT,
     PAGE_TYPE_DISPLAY,
     PAGE_TYPE_SOUND,
+    PAGE_TYPE_STORAGE,
     PAGE_TYPE_COUNT
 } settings_page_type_t;
 
@@ -37,6 +42,11 @@ typedef struct {
     settings_page_t pages[PAGE_TYPE_COUNT];
     settings_page_type_t current_page;
     bool is_initialized;
+    lv_obj_t* bench_button;     // 存储页：测速按钮
+    lv_obj_t* bench_label;      // 存储页：测速状态
+    lv_obj_t* selftest_button;  // 存储页：自检按钮
+    lv_obj_t* selftest_label;   // 存储页：自检结果
+    lv_timer_t* bench_timer;    // 刷新测速和自检进度（属于应用上下文，挂起时暂停，销毁时释放）
 } settings_state_t;
 
 // 全局状态变量
@@ -49,10 +59,13 @@ static void page_event_handler(lv_event_t* e);
 static lv_obj_t* create_about_page(lv_obj_t* menu);
 static lv_obj_t* create_display_page(lv_obj_t* menu);
 static lv_obj_t* create_sound_page(lv_obj_t* menu);
+static lv_obj_t* create_storage_page(lv_obj_t* menu);
 static void update_sidebar_highlight(settings_page_type_t active_page);
-static void brightness_slider_event_cb(lv_event_t* e);
-static void volume_slider_event_cb(lv_event_t* e);
 static void speaker_switch_event_cb(lv_event_t* e);
+static void bench_button_event_cb(lv_event_t* e);
+static void bench_timer_cb(lv_timer_t* timer);
+static void selftest_button_event_cb(lv_event_t* e);
+static void update_selftest_status(void);
 
 // 安全的内存分配函数
 static void* safe_malloc(size_t size) {
@@ -85,42 +98,6 @@ static void safe_free(void* ptr) {
     }
 }
 
-// 亮度滑块事件回调
-static void brightness_slider_event_cb(lv_event_t* e) {
-    lv_event_code_t code = lv_event_get_code(e);
-    lv_obj_t* slider = lv_event_get_target(e);
-    
-    if (code == LV_EVENT_VALUE_CHANGED) {
-        int32_t value = lv_slider_get_value(slider);
-        hal_set_display_brightness((uint8_t)value);
-        
-        // 更新标签显示
-        lv_obj_t* label = lv_event_get_user_data(e);
-        if (label) {
-            lv_label_set_text_fmt(label, "亮度: %d%%", (int)value);
-        }
-        printf("Brightness changed to: %d%%\n", (int)value);
-    }
-}
-
-// 音量滑块事件回调
-static void volume_slider_event_cb(lv_event_t* e) {
-    lv_event_code_t code = lv_event_get_code(e);
-    lv_obj_t* slider = lv_event_get_target(e);
-    
-    if (code == LV_EVENT_VALUE_CHANGED) {
-        int32_t value = lv_slider_get_value(slider);
-        hal_set_speaker_volume((uint8_t)value);
-        
-        // 更新标签显示
-        lv_obj_t* label = lv_event_get_user_data(e);
-        if (label) {
-            lv_label_set_text_fmt(label, "音量: %d%%", (int)value);
-        }
-        printf("Volume changed to: %d%%\n", (int)value);
-    }
-}
-
 // 扬声器开关事件回调
 static void speaker_switch_event_cb(lv_event_t* e) {
     lv_event_code_t code = lv_event_get_code(e);
@@ -130,10 +107,8 @@ static void speaker_switch_event_cb(lv_event_t* e) {
         // 获取开关的当前状态
         bool enabled = lv_obj_has_state(switch_obj, LV_STATE_CHECKED);
         
-        // 调用HAL函数设置扬声器状态
-        hal_set_speaker_enable(enabled);
-        
-        printf("Speaker %s\n", enabled ? "enabled" : "disabled");
+        // 开关表示静音；写入共享状态，由ui_bind写回HAL并同步控制中心
+        ui_bind_set_int(ui_bind_speaker(), enabled ? 0 : 1);
     }
 }
 
@@ -257,7 +232,7 @@ static lv_obj_t* create_display_page(lv_obj_t* menu) {
     
     // 创建亮度标签
     lv_obj_t* brightness_label = lv_label_create(section);
-    lv_label_set_text_fmt(brightness_label, "亮度: %d%%", hal_get_display_brightness());
+    lv_label_bind_text(brightness_label, ui_bind_brightness(), "亮度: %d%%");
     lv_obj_set_style_text_font(brightness_label, &simhei_32, 0);
     lv_obj_set_style_pad_all(brightness_label, 10, 0);
     
@@ -272,16 +247,13 @@ static lv_obj_t* create_display_page(lv_obj_t* menu) {
     lv_obj_t* brightness_slider = lv_slider_create(slider_cont);
     lv_obj_set_size(brightness_slider, LV_PCT(100), 20);
     lv_slider_set_range(brightness_slider, 20, 100);  // 最低亮度20%
-    lv_slider_set_value(brightness_slider, hal_get_display_brightness(), LV_ANIM_OFF);
+    lv_slider_bind_value(brightness_slider, ui_bind_brightness());  // 双向绑定，拖动时写回HAL
     
     // 设置亮度滑块样式 (蓝色主题)
     lv_obj_set_style_bg_color(brightness_slider, lv_color_hex(0x6699FF), LV_PART_MAIN);
     lv_obj_set_style_bg_color(brightness_slider, lv_color_hex(0x0066FF), LV_PART_INDICATOR);
     lv_obj_set_style_bg_color(brightness_slider, lv_color_hex(0x0044CC), LV_PART_KNOB);
     
-    // 添加亮度滑块事件
-    lv_obj_add_event_cb(brightness_slider, brightness_slider_event_cb, LV_EVENT_VALUE_CHANGED, brightness_label);
-    
     // 添加说明文本
     lv_obj_t* note = lv_label_create(section);
     lv_label_set_text(note, "亮度设置将同步到控制中心");
@@ -303,7 +275,7 @@ static lv_obj_t* create_sound_page(lv_obj_t* menu) {
     
     // 创建音量标签
     lv_obj_t* volume_label = lv_label_create(section);
-    lv_label_set_text_fmt(volume_label, "音量: %d%%", hal_get_speaker_volume());
+    lv_label_bind_text(volume_label, ui_bind_volume(), "音量: %d%%");
     lv_obj_set_style_text_font(volume_label, &simhei_32, 0);
     lv_obj_set_style_pad_all(volume_label, 10, 0);
     
@@ -318,16 +290,13 @@ static lv_obj_t* create_sound_page(lv_obj_t* menu) {
     lv_obj_t* volume_slider = lv_slider_create(slider_cont);
     lv_obj_set_size(volume_slider, LV_PCT(100), 20);
     lv_slider_set_range(volume_slider, 0, 100);
-    lv_slider_set_value(volume_slider, hal_get_speaker_volume(), LV_ANIM_OFF);
+    lv_slider_bind_value(volume_slider, ui_bind_volume());
     
     // 设置音量滑块样式 (橙色主题)
     lv_obj_set_style_bg_color(volume_slider, lv_color_hex(0xFF9966), LV_PART_MAIN);
     lv_obj_set_style_bg_color(volume_slider, lv_color_hex(0xFF6600), LV_PART_INDICATOR);
     lv_obj_set_style_bg_color(volume_slider, lv_color_hex(0xFF4400), LV_PART_KNOB);
     
-    // 添加音量滑块事件
-    lv_obj_add_event_cb(volume_slider, volume_slider_event_cb, LV_EVENT_VALUE_CHANGED, volume_label);
-    
     // 创建静音开关容器
     lv_obj_t* switch_cont = lv_obj_create(section);
     lv_obj_set_size(switch_cont, LV_PCT(100), 60);
@@ -346,11 +315,8 @@ static lv_obj_t* create_sound_page(lv_obj_t* menu) {
     lv_obj_t* speaker_switch = lv_switch_create(switch_cont);
     lv_obj_set_style_pad_left(speaker_switch, 20, 0);
     
-    // 设置开关状态
-    bool speaker_enabled = hal_get_speaker_enable();
-    if (!speaker_enabled) {
-        lv_obj_add_state(speaker_switch, LV_STATE_CHECKED);
-    }
+    // 开关表示静音，扬声器关闭时为选中
+    lv_obj_bind_state_if_eq(speaker_switch, ui_bind_speaker(), LV_STATE_CHECKED, 0);
     
     // 设置开关样式 (绿色主题)
     lv_obj_set_style_bg_color(speaker_switch, lv_color_hex(0xCCCCCC), LV_PART_MAIN);
@@ -370,6 +336,181 @@ static lv_obj_t* create_sound_page(lv_obj_t* menu) {
     return page;
 }
 
+// Storage页面创建函数
+static lv_obj_t* create_storage_page(lv_obj_t* menu) {
+    printf("Creating Storage page\n");
+    
+    lv_obj_t* page = lv_menu_page_create(menu, "存储");
+    lv_obj_set_style_pad_hor(page, lv_obj_get_style_pad_left(lv_menu_get_main_header(menu), 0), 0);
+    lv_menu_separator_create(page);
+    lv_obj_t* section = lv_menu_section_create(page);
+    
+    // 容量信息
+    lv_obj_t* usage_label = lv_label_create(section);
+    uint64_t total_bytes = 0;
+    uint64_t free_bytes = 0;
+    if (hal_sdcard_get_usage(&total_bytes, &free_bytes)) {
+        lv_label_set_text_fmt(usage_label, "SD卡: 已用 %.1f GB / 共 %.1f GB",
+                              (double)(total_bytes - free_bytes) / (1024.0 * 1024 * 1024),
+                              (double)total_bytes / (1024.0 * 1024 * 1024));
+    } else {
+        lv_label_set_text(usage_label, "SD卡未挂载");
+    }
+    lv_obj_set_style_text_font(usage_label, &simhei_32, 0);
+    lv_obj_set_style_pad_all(usage_label, 10, 0);
+    
+    // 测速按钮
+    lv_obj_t* button = lv_button_create(section);
+    lv_obj_set_size(button, 240, 60);
+    lv_obj_set_style_bg_color(button, lv_color_hex(0x0066CC), 0);
+    lv_obj_add_event_cb(button, bench_button_event_cb, LV_EVENT_CLICKED, NULL);
+    lv_obj_t* button_label = lv_label_create(button);
+    lv_label_set_text(button_label, "SD卡测速");
+    lv_obj_set_style_text_font(button_label, &simhei_32, 0);
+    lv_obj_center(button_label);
+    if (!hal_sdcard_is_mounted()) {
+        lv_obj_add_state(button, LV_STATE_DISABLED);
+    }
+    
+    // 测速状态和结果
+    lv_obj_t* status = lv_label_create(section);
+    lv_label_set_text(status, "测试约需1分钟，详细结果保存在 .imos/sd_bench.csv");
+    lv_obj_set_style_text_font(status, &simhei_32, 0);
+    lv_obj_set_style_text_color(status, lv_color_hex(0x888888), 0);
+    lv_obj_set_style_pad_all(status, 10, 0);
+    
+    // 自检按钮：依次运行各存储模块的自检
+    lv_obj_t* selftest_button = lv_button_create(section);
+    lv_obj_set_size(selftest_button, 240, 60);
+    lv_obj_set_style_bg_color(selftest_button, lv_color_hex(0x0066CC), 0);
+    lv_obj_add_event_cb(selftest_button, selftest_button_event_cb, LV_EVENT_CLICKED, NULL);
+    button_label = lv_label_create(selftest_button);
+    lv_label_set_text(button_label, "存储自检");
+    lv_obj_set_style_text_font(button_label, &simhei_32, 0);
+    lv_obj_center(button_label);
+    if (!hal_sdcard_is_mounted()) {
+        lv_obj_add_state(selftest_button, LV_STATE_DISABLED);
+    }
+    
+    lv_obj_t* selftest_status = lv_label_create(section);
+    lv_label_set_text(selftest_status, "检查复制、移动、删除等功能，详细输出见串口");
+    lv_obj_set_style_text_font(selftest_status, &simhei_32, 0);
+    lv_obj_set_style_text_color(selftest_status, lv_color_hex(0x888888), 0);
+    lv_obj_set_style_pad_all(selftest_status, 10, 0);
+    
+    g_settings_state->bench_button = button;
+    g_settings_state->bench_label = status;
+    g_settings_state->selftest_button = selftest_button;
+    g_settings_state->selftest_label = selftest_status;
+    if (!g_settings_state->bench_timer) {
+        g_settings_state->bench_timer = app_ctx_timer_create(app_manager_get_app_by_id(APP_ID_SETTINGS),
+                                                             bench_timer_cb, 500, NULL);
+    }
+    bench_timer_cb(NULL);
+    
+    return page;
+}
+
+// 开始SD卡测速
+static void bench_button_event_cb(lv_event_t* e) {
+    (void)e;
+    if (sd_bench_is_busy()) {
+        sd_bench_cancel();
+        return;
+    }
+    if (!sd_bench_start(8)) {
+        printf("Failed to start SD card benchmark\n");
+        if (g_settings_state && g_settings_state->bench_label) {
+            lv_label_set_text(g_settings_state->bench_label, "无法启动测速");
+        }
+        return;
+    }
+    bench_timer_cb(NULL);
+}
+
+// 开始存储自检
+static void selftest_button_event_cb(lv_event_t* e) {
+    (void)e;
+    if (sd_selftest_is_busy()) {
+        sd_selftest_cancel();
+        return;
+    }
+    if (!sd_selftest_start()) {
+        printf("Failed to start storage self test\n");
+        if (g_settings_state && g_settings_state->selftest_label) {
+            lv_label_set_text(g_settings_state->selftest_label, "无法启动自检");
+        }
+        return;
+    }
+    update_selftest_status();
+}
+
+static void update_selftest_status(void) {
+    sd_selftest_progress_t progress;
+    if (!sd_selftest_get_progress(&progress)) {
+        return;
+    }
+    
+    lv_obj_t* button_label = lv_obj_get_child(g_settings_state->selftest_button, 0);
+    lv_label_set_text(button_label, progress.state == SD_SELFTEST_STATE_RUNNING ? "取消" : "存储自检");
+    
+    switch (progress.state) {
+        case SD_SELFTEST_STATE_RUNNING:
+            lv_label_set_text_fmt(g_settings_state->selftest_label, "自检中 %lu/%lu %s\n%s",
+                                  (unsigned long)progress.tests_done, (unsigned long)progress.tests_total,
+                                  progress.current, progress.summary);
+            break;
+        case SD_SELFTEST_STATE_DONE:
+            lv_label_set_text_fmt(g_settings_state->selftest_label, "%s\n%lu项失败",
+                                  progress.summary, (unsigned long)progress.tests_failed);
+            break;
+        case SD_SELFTEST_STATE_CANCELLED:
+            lv_label_set_text(g_settings_state->selftest_label, "自检已取消");
+            break;
+        default:
+            break;
+    }
+}
+
+// 刷新测速和自检进度（只在存储页显示时更新）
+static void bench_timer_cb(lv_timer_t* timer) {
+    (void)timer;
+    if (!g_settings_state || g_settings_state->current_page != PAGE_TYPE_STORAGE ||
+        !g_settings_state->pages[PAGE_TYPE_STORAGE].is_created || !g_settings_state->bench_label) {
+        return;
+    }
+    
+    update_selftest_status();
+    
+    sd_bench_progress_t progress;
+    if (!sd_bench_get_progress(&progress)) {
+        return;
+    }
+    
+    lv_obj_t* button_label = lv_obj_get_child(g_settings_state->bench_button, 0);
+    lv_label_set_text(button_label, progress.state == SD_BENCH_STATE_RUNNING ? "取消" : "SD卡测速");
+    
+    switch (progress.state) {
+        case SD_BENCH_STATE_RUNNING:
+            lv_label_set_text_fmt(g_settings_state->bench_label, "测试中 %lu/%lu %s\n%s",
+                                  (unsigned long)progress.tests_done, (unsigned long)progress.tests_total,
+                                  progress.last_test, progress.summary);
+            break;
+        case SD_BENCH_STATE_DONE:
+            lv_label_set_text_fmt(g_settings_state->bench_label, "%s\n详细结果: %s",
+                                  progress.summary, progress.csv_path);
+            break;
+        case SD_BENCH_STATE_CANCELLED:
+            lv_label_set_text(g_settings_state->bench_label, "测速已取消");
+            break;
+        case SD_BENCH_STATE_FAILED:
+            lv_label_set_text(g_settings_state->bench_label, "测速失败，请检查SD卡剩余空间");
+            break;
+        default:
+            break;
+    }
+}
+
 // 页面事件处理器
 static void page_event_handler(lv_event_t* e) {
     if (!g_settings_state) return;
@@ -428,6 +569,9 @@ static void create_page_on_demand(settings_page_type_t page_type) {
         case PAGE_TYPE_SOUND:
             page = create_sound_page(g_settings_state->menu);
             break;
+        case PAGE_TYPE_STORAGE:
+            page = create_storage_page(g_settings_state->menu);
+            break;
         default:
             printf("Unknown page type: %d\n", page_type);
             return;
@@ -533,6 +677,11 @@ static void settings_app_create(app_t* app) {
     cont = menu_create_text(section, LV_SYMBOL_VOLUME_MAX, "声音", LV_MENU_ITEM_BUILDER_VARIANT_1);
     lv_obj_add_event_cb(cont, page_event_handler, LV_EVENT_CLICKED, (void*)PAGE_TYPE_SOUND);
     g_settings_state->pages[PAGE_TYPE_SOUND].sidebar_item = cont;
+    
+    // Storage
+    cont = menu_create_text(section, LV_SYMBOL_SD_CARD, "存储", LV_MENU_ITEM_BUILDER_VARIANT_1);
+    lv_obj_add_event_cb(cont, page_event_handler, LV_EVENT_CLICKED, (void*)PAGE_TYPE_STORAGE);
+    g_settings_state->pages[PAGE_TYPE_STORAGE].sidebar_item = cont;
 
     lv_menu_set_sidebar_page(menu, g_settings_state->root_page);
 
@@ -563,6 +712,13 @@ static void settings_app_destroy(app_t* app) {
     app_manager_log_memory_usage("Before settings app destruction");
     
     if (g_settings_state) {
+        // 测速在后台继续运行，界面刷新定时器已随应用上下文释放
+        g_settings_state->bench_timer = NULL;
+        g_settings_state->bench_button = NULL;
+        g_settings_state->bench_label = NULL;
+        g_settings_state->selftest_button = NULL;
+        g_settings_state->selftest_label = NULL;
+        
         // 重置状态标志
         for (int i = 0; i < PAGE_TYPE_COUNT; i++) {
             g_settings_state->pages[i].page_obj = NULL;
@@ -576,10 +732,6 @@ static void settings_app_destroy(app_t* app) {
         g_settings_state->root_page = NULL;
         g_settings_state->is_initialized = false;
         
-        // 等待LVGL任务完成当前的渲染周期
-        lv_refr_now(NULL);
-        vTaskDelay(pdMS_TO_TICKS(20));
-        
         // 释放状态结构
         safe_free(g_settings_state);
         g_settings_state = NULL;
@@ -593,8 +745,12 @@ static void settings_app_destroy(app_t* app) {
     app_manager_log_memory_usage("After settings app destruction");
 }
 
-// 注册设置应用
-void register_settings_app(void) {
-    app_manager_register_app("设置", LV_SYMBOL_SETTINGS, 
-                             settings_app_create, settings_app_destroy);
-}
\ No newline at end of file
+// 设置应用描述
+APP_DEFINE(settings_app_desc) = {
+    .id = APP_ID_SETTINGS,
+    .name = "设置",
+    .icon = LV_SYMBOL_SETTINGS,
+    .create_cb = settings_app_create,
+    .destroy_cb = settings_app_destroy,
+    .suspendable = true,
+};
\ No newline at end of file
@@ -1,6 +0,0 @@
-#pragma once
-
-#include "app_manager.h"
-
-// 注册设置应用
-void register_settings_app(void); 
\ No newline at end of file
@@ -0,0 +1,1234 @@
+#include "archive.h"
+#include "inflate.h"
+#include "file_types.h"
+#include "fs_watch.h"
+#include "io_sched.h"
+#include "hal_sdcard.h"
+#include "sd_selftest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <esp_rom_crc.h>
+
+// 配置
+#define ARCHIVE_MAX_PATH        512
+#define ARCHIVE_READ_BUFFER     (16 * 1024)     // 读取目录时的stdio缓冲
+#define ARCHIVE_TASK_STACK      6144
+#define ARCHIVE_TASK_PRIORITY   3               // 与文件操作相同，低于LVGL任务
+
+// ZIP结构
+#define ZIP_LOCAL_SIG           0x04034b50
+#define ZIP_CENTRAL_SIG         0x02014b50
+#define ZIP_END_SIG             0x06054b50
+#define ZIP_LOCAL_SIZE          30
+#define ZIP_CENTRAL_SIZE        46
+#define ZIP_END_SIZE            22
+#define ZIP_MAX_COMMENT         65535
+#define ZIP_FLAG_ENCRYPTED      (1 << 0)
+
+// TAR结构
+#define TAR_BLOCK               512
+
+// 解压任务（持有条目副本，不依赖调用方的archive_t）
+typedef struct {
+    archive_format_t format;
+    char archive_path[256];
+    archive_t items;                        // 要解压的条目
+    char dest_dir[ARCHIVE_MAX_PATH];
+    char path[ARCHIVE_MAX_PATH];            // 当前输出文件
+    int src_fd;
+    int dst_fd;
+    uint32_t remaining;                     // 当前条目剩余的输入字节
+    uint32_t crc;
+    inflate_ctx_t* inflater;
+} extract_job_t;
+
+// 全局状态
+static struct {
+    SemaphoreHandle_t lock;                 // 保护progress
+    archive_progress_t progress;
+    bool has_progress;
+    int64_t start_time;
+    volatile bool busy;
+    volatile bool cancel_requested;
+} g_archive = {0};
+
+/* -------------------------------------------------------------------------- */
+/*                                  Catalog                                   */
+/* -------------------------------------------------------------------------- */
+
+static void* archive_realloc(void* ptr, size_t size) {
+    void* new_ptr = heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM);
+    if (!new_ptr) {
+        new_ptr = heap_caps_realloc(ptr, size, MALLOC_CAP_DEFAULT);
+    }
+    return new_ptr;
+}
+
+static inline uint16_t get_le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static archive_t* archive_create(archive_format_t format, const char* path) {
+    archive_t* archive = archive_realloc(NULL, sizeof(archive_t));
+    if (!archive) {
+        return NULL;
+    }
+    memset(archive, 0, sizeof(archive_t));
+    archive->format = format;
+    strncpy(archive->path, path, sizeof(archive->path) - 1);
+    return archive;
+}
+
+static bool archive_add(archive_t* archive, const char* name, size_t name_len, const archive_entry_t* entry) {
+    if (archive->count == archive->capacity) {
+        uint32_t capacity = archive->capacity ? archive->capacity * 2 : 64;
+        archive_entry_t* entries = archive_realloc(archive->entries, capacity * sizeof(archive_entry_t));
+        if (!entries) {
+            return false;
+        }
+        archive->entries = entries;
+        archive->capacity = capacity;
+    }
+    if (archive->names_used + name_len + 1 > archive->names_capacity) {
+        uint32_t capacity = archive->names_capacity ? archive->names_capacity : 4096;
+        while (capacity < archive->names_used + name_len + 1) {
+            capacity *= 2;
+        }
+        char* names = archive_realloc(archive->names, capacity);
+        if (!names) {
+            return false;
+        }
+        archive->names = names;
+        archive->names_capacity = capacity;
+    }
+
+    archive_entry_t* dst = &archive->entries[archive->count++];
+    *dst = *entry;
+    dst->name_offset = archive->names_used;
+    memcpy(archive->names + archive->names_used, name, name_len);
+    archive->names[archive->names_used + name_len] = '\0';
+    archive->names_used += (uint32_t)name_len + 1;
+    if (!entry->is_dir) {
+        archive->total_size += entry->size;
+    }
+    return true;
+}
+
+// 从文件末尾查找ZIP结束记录，读取中央目录
+static bool read_zip_catalog(archive_t* archive, FILE* fp, uint32_t file_size) {
+    uint32_t tail_size = file_size < ZIP_END_SIZE + ZIP_MAX_COMMENT ? file_size : ZIP_END_SIZE + ZIP_MAX_COMMENT;
+    uint8_t* tail = archive_realloc(NULL, tail_size);
+    if (!tail) {
+        return false;
+    }
+
+    bool ok = fseek(fp, (long)(file_size - tail_size), SEEK_SET) == 0 &&
+              fread(tail, 1, tail_size, fp) == tail_size;
+
+    const uint8_t* end = NULL;
+    for (int32_t i = (int32_t)tail_size - ZIP_END_SIZE; ok && i >= 0; i--) {
+        if (get_le32(tail + i) == ZIP_END_SIG) {
+            end = tail + i;
+            break;
+        }
+    }
+    if (!end) {
+        heap_caps_free(tail);
+        printf("Archive: ZIP end record not found\n");
+        return false;
+    }
+
+    uint32_t entry_count = get_le16(end + 10);
+    uint32_t cd_offset = get_le32(end + 16);
+    heap_caps_free(tail);
+
+    if (entry_count == 0xFFFF || cd_offset == 0xFFFFFFFF) {
+        printf("Archive: ZIP64 not supported\n");
+        return false;
+    }
+    if (fseek(fp, (long)cd_offset, SEEK_SET) != 0) {
+        return false;
+    }
+
+    char name[ARCHIVE_MAX_PATH];
+    for (uint32_t i = 0; i < entry_count; i++) {
+        uint8_t header[ZIP_CENTRAL_SIZE];
+        if (fread(header, 1, sizeof(header), fp) != sizeof(header) || get_le32(header) != ZIP_CENTRAL_SIG) {
+            printf("Archive: bad central directory entry %lu\n", (unsigned long)i);
+            return false;
+        }
+
+        uint16_t flags = get_le16(header + 8);
+        uint16_t method = get_le16(header + 10);
+        uint16_t name_len = get_le16(header + 28);
+        uint16_t extra_len = get_le16(header + 30);
+        uint16_t comment_len = get_le16(header + 32);
+
+        archive_entry_t entry = {0};
+        entry.crc32 = get_le32(header + 16);
+        entry.compressed_size = get_le32(header + 20);
+        entry.size = get_le32(header + 24);
+        entry.header_offset = get_le32(header + 42);
+
+        size_t keep = name_len < sizeof(name) - 1 ? name_len : sizeof(name) - 1;
+        if (fread(name, 1, keep, fp) != keep ||
+            fseek(fp, (long)(name_len - keep + extra_len + comment_len), SEEK_CUR) != 0) {
+            return false;
+        }
+        name[keep] = '\0';
+
+        entry.is_dir = keep > 0 && name[keep - 1] == '/';
+        if ((flags & ZIP_FLAG_ENCRYPTED) || entry.size == 0xFFFFFFFF ||
+            entry.compressed_size == 0xFFFFFFFF || entry.header_offset == 0xFFFFFFFF) {
+            entry.method = ARCHIVE_METHOD_UNSUPPORTED;
+        } else if (method == 0) {
+            entry.method = ARCHIVE_METHOD_STORED;
+        } else if (method == 8) {
+            entry.method = ARCHIVE_METHOD_DEFLATE;
+        } else {
+            entry.method = ARCHIVE_METHOD_UNSUPPORTED;
+        }
+
+        if (!archive_add(archive, name, keep, &entry)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t parse_octal(const uint8_t* field, size_t len) {
+    uint32_t value = 0;
+    size_t i = 0;
+    while (i < len && field[i] == ' ') {
+        i++;
+    }
+    for (; i < len && field[i] >= '0' && field[i] <= '7'; i++) {
+        value = (value << 3) | (uint32_t)(field[i] - '0');
+    }
+    return value;
+}
+
+// pax扩展头中的path记录（"长度 path=值\n"）
+static bool parse_pax_path(const char* data, size_t len, char* name, size_t name_size) {
+    size_t pos = 0;
+    while (pos < len) {
+        size_t record_len = (size_t)strtoul(data + pos, NULL, 10);
+        if (record_len == 0 || pos + record_len > len) {
+            break;
+        }
+        const char* key = memchr(data + pos, ' ', record_len);
+        if (key && (size_t)(key - (data + pos)) + 6 < record_len && strncmp(key + 1, "path=", 5) == 0) {
+            size_t value_len = record_len - (size_t)(key + 6 - (data + pos)) - 1;
+            if (value_len < name_size) {
+                memcpy(name, key + 6, value_len);
+                name[value_len] = '\0';
+                return true;
+            }
+        }
+        pos += record_len;
+    }
+    return false;
+}
+
+// 依次读取TAR条目头，跳过数据
+static bool read_tar_catalog(archive_t* archive, FILE* fp, uint32_t file_size) {
+    uint8_t header[TAR_BLOCK];
+    char name[ARCHIVE_MAX_PATH];
+    bool long_name = false;         // 上一个GNU 'L'或pax头给出了完整名称
+    uint32_t offset = 0;
+
+    while (offset + TAR_BLOCK <= file_size) {
+        if (fread(header, 1, TAR_BLOCK, fp) != TAR_BLOCK) {
+            return false;
+        }
+        offset += TAR_BLOCK;
+
+        // 全零块表示结束
+        bool empty = true;
+        for (int i = 0; i < TAR_BLOCK && empty; i++) {
+            empty = header[i] == 0;
+        }
+        if (empty) {
+            break;
+        }
+
+        uint32_t checksum = parse_octal(header + 148, 8);
+        uint32_t sum = 0;
+        for (int i = 0; i < TAR_BLOCK; i++) {
+            sum += (i >= 148 && i < 156) ? ' ' : header[i];
+        }
+        if (sum != checksum) {
+            printf("Archive: TAR checksum mismatch at %lu\n", (unsigned long)(offset - TAR_BLOCK));
+            return archive->count > 0;
+        }
+
+        uint32_t size = parse_octal(header + 124, 12);
+        uint32_t padded = (size + TAR_BLOCK - 1) & ~(uint32_t)(TAR_BLOCK - 1);
+        char type = (char)header[156];
+
+        if (type == 'L' || type == 'x') {
+            // 下一条目的长名称
+            char* data = size < 65536 ? archive_realloc(NULL, padded + 1) : NULL;
+            if (!data || fread(data, 1, padded, fp) != padded) {
+                heap_caps_free(data);
+                return false;
+            }
+            data[size] = '\0';
+            if (type == 'L') {
+                strncpy(name, data, sizeof(name) - 1);
+                name[sizeof(name) - 1] = '\0';
+                long_name = true;
+            } else {
+                long_name = parse_pax_path(data, size, name, sizeof(name));
+            }
+            heap_caps_free(data);
+            offset += padded;
+            continue;
+        }
+
+        if (!long_name) {
+            // ustar: prefix + "/" + name
+            size_t len = 0;
+            if (memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0') {
+                len = strnlen((const char*)header + 345, 155);
+                memcpy(name, header + 345, len);
+                name[len++] = '/';
+            }
+            size_t name_len = strnlen((const char*)header, 100);
+            memcpy(name + len, header, name_len);
+            name[len + name_len] = '\0';
+        }
+        long_name = false;
+
+        archive_entry_t entry = {0};
+        entry.header_offset = offset;
+        entry.size = size;
+        entry.compressed_size = size;
+        entry.method = ARCHIVE_METHOD_STORED;
+
+        if (type == '5') {
+            entry.is_dir = true;
+            entry.size = entry.compressed_size = 0;
+        } else if (type != '0' && type != '\0' && type != '7') {
+            // 链接、设备文件等
+            entry.method = ARCHIVE_METHOD_UNSUPPORTED;
+        }
+
+        if ((type == '0' || type == '\0' || type == '5' || type == '7') &&
+            !archive_add(archive, name, strlen(name), &entry)) {
+            return false;
+        }
+
+        if (fseek(fp, (long)padded, SEEK_CUR) != 0) {
+            return false;
+        }
+        offset += padded;
+    }
+    return true;
+}
+
+bool archive_is_supported(const char* filename) {
+    return file_types_has_cap(filename, FILE_CAP_EXTRACT);
+}
+
+archive_t* archive_open(const char* path) {
+    if (!path || strlen(path) >= sizeof(((archive_t*)0)->path)) {
+        return NULL;
+    }
+
+    // 以文件头为准选择格式（扩展名可能不准）
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        printf("Archive: failed to stat %s\n", path);
+        return NULL;
+    }
+    const file_type_info_t* type = file_types_sniff(path, (uint32_t)st.st_size, (uint32_t)st.st_mtime);
+    if (type->kind != FILE_KIND_ARCHIVE) {
+        printf("Archive: %s is not a supported archive\n", path);
+        return NULL;
+    }
+
+    int64_t start = esp_timer_get_time();
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        printf("Archive: failed to open %s\n", path);
+        return NULL;
+    }
+    setvbuf(fp, NULL, _IOFBF, ARCHIVE_READ_BUFFER);
+
+    archive_format_t format = strcmp(type->extension, "zip") == 0 ? ARCHIVE_FORMAT_ZIP : ARCHIVE_FORMAT_TAR;
+    archive_t* archive = archive_create(format, path);
+
+    bool ok = archive != NULL;
+    if (ok) {
+        ok = format == ARCHIVE_FORMAT_ZIP ? read_zip_catalog(archive, fp, (uint32_t)st.st_size)
+                                          : read_tar_catalog(archive, fp, (uint32_t)st.st_size);
+    }
+    fclose(fp);
+
+    if (!ok) {
+        printf("Archive: failed to read catalog of %s\n", path);
+        archive_close(archive);
+        return NULL;
+    }
+
+    printf("Archive opened %s: %lu entries, %llu bytes uncompressed, catalog in %lld ms\n",
+           path, (unsigned long)archive->count, (unsigned long long)archive->total_size,
+           (long long)((esp_timer_get_time() - start) / 1000));
+    return archive;
+}
+
+void archive_close(archive_t* archive) {
+    if (!archive) {
+        return;
+    }
+    heap_caps_free(archive->entries);
+    heap_caps_free(archive->names);
+    heap_caps_free(archive);
+}
+
+const char* archive_entry_name(const archive_t* archive, uint32_t index) {
+    if (!archive || index >= archive->count) {
+        return "";
+    }
+    return archive->names + archive->entries[index].name_offset;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Progress                                  */
+/* -------------------------------------------------------------------------- */
+
+static void progress_lock(void) {
+    xSemaphoreTake(g_archive.lock, portMAX_DELAY);
+}
+
+static void progress_unlock(void) {
+    xSemaphoreGive(g_archive.lock);
+}
+
+static void progress_set_current(const char* name) {
+    progress_lock();
+    strncpy(g_archive.progress.current, name, sizeof(g_archive.progress.current) - 1);
+    g_archive.progress.current[sizeof(g_archive.progress.current) - 1] = '\0';
+    progress_unlock();
+}
+
+static void progress_set_error(const char* what, const char* name) {
+    printf("Archive error: %s %s (errno %d)\n", what, name, errno);
+
+    progress_lock();
+    if (g_archive.progress.error[0] == '\0') {
+        snprintf(g_archive.progress.error, sizeof(g_archive.progress.error), "%s: %s", what, name);
+    }
+    progress_unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Extract                                   */
+/* -------------------------------------------------------------------------- */
+
+// 拼接输出路径，拒绝绝对路径和".."（防止写到目标目录之外）
+static bool build_output_path(extract_job_t* job, const char* name) {
+    while (name[0] == '.' && name[1] == '/') {
+        name += 2;
+    }
+    if (name[0] == '/' || name[0] == '\\') {
+        return false;
+    }
+    if (name[0] == '\0' || strcmp(name, ".") == 0) {
+        // TAR常见的"./"根目录条目
+        strcpy(job->path, job->dest_dir);
+        return true;
+    }
+
+    int len = snprintf(job->path, sizeof(job->path), "%s/%s", job->dest_dir, name);
+    if (len <= 0 || (size_t)len >= sizeof(job->path)) {
+        return false;
+    }
+
+    char* rel = job->path + strlen(job->dest_dir) + 1;
+    for (char* p = rel; *p; p++) {
+        if (*p == '\\') {
+            *p = '/';
+        }
+    }
+    for (char* p = rel; p && *p; ) {
+        if (p[0] == '.' && p[1] == '.' && (p[2] == '/' || p[2] == '\0')) {
+            return false;
+        }
+        p = strchr(p, '/');
+        if (p) {
+            p++;
+        }
+    }
+
+    // 去掉目录条目末尾的'/'
+    size_t path_len = strlen(job->path);
+    while (path_len > 0 && job->path[path_len - 1] == '/') {
+        job->path[--path_len] = '\0';
+    }
+    return true;
+}
+
+// 逐级创建path的上级目录（include_last为true时也创建path本身）
+static bool make_dirs(char* path, size_t skip, bool include_last) {
+    char* p = path + skip;
+    for (p += *p ? 1 : 0; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            bool created = mkdir(path, 0777) == 0;
+            bool ok = created || errno == EEXIST;
+            if (created) {
+                fs_watch_path_changed(path);
+            }
+            *p = '/';
+            if (!ok) {
+                return false;
+            }
+        }
+    }
+    if (!include_last) {
+        return true;
+    }
+    if (mkdir(path, 0777) == 0) {
+        fs_watch_path_changed(path);
+        return true;
+    }
+    return errno == EEXIST;
+}
+
+static size_t extract_read_cb(uint8_t* buffer, size_t size, void* user_data) {
+    extract_job_t* job = (extract_job_t*)user_data;
+    if (size > job->remaining) {
+        size = job->remaining;
+    }
+    if (size == 0) {
+        return 0;
+    }
+
+    // 批量读写走后台类别，让位于音频流和界面读取
+    ssize_t n = io_sched_read(job->src_fd, IO_SCHED_CURRENT, buffer, size, IO_CLASS_BACKGROUND);
+    if (n <= 0) {
+        return 0;
+    }
+    job->remaining -= (uint32_t)n;
+    return (size_t)n;
+}
+
+static bool extract_write_cb(const uint8_t* data, size_t len, void* user_data) {
+    extract_job_t* job = (extract_job_t*)user_data;
+    if (g_archive.cancel_requested) {
+        return false;
+    }
+
+    if (io_sched_write(job->dst_fd, data, len, IO_CLASS_BACKGROUND) != (ssize_t)len) {
+        return false;
+    }
+
+    job->crc = esp_rom_crc32_le(job->crc, data, (uint32_t)len);
+    progress_lock();
+    g_archive.progress.bytes_done += len;
+    progress_unlock();
+    return true;
+}
+
+// 定位条目数据：ZIP需读取本地文件头（扩展字段长度可能与中央目录不同）
+static bool seek_to_data(extract_job_t* job, const archive_entry_t* entry) {
+    uint32_t data_offset = entry->header_offset;
+
+    if (job->format == ARCHIVE_FORMAT_ZIP) {
+        uint8_t header[ZIP_LOCAL_SIZE];
+        if (io_sched_read(job->src_fd, entry->header_offset, header, sizeof(header),
+                          IO_CLASS_BACKGROUND) != sizeof(header) ||
+            get_le32(header) != ZIP_LOCAL_SIG) {
+            return false;
+        }
+        data_offset += ZIP_LOCAL_SIZE + get_le16(header + 26) + get_le16(header + 28);
+    }
+
+    return lseek(job->src_fd, (off_t)data_offset, SEEK_SET) >= 0;
+}
+
+// 解压一个文件条目；失败时删除不完整的输出
+static bool extract_file(extract_job_t* job, const archive_entry_t* entry, const char* name) {
+    if (!seek_to_data(job, entry)) {
+        progress_set_error("无法定位数据", name);
+        return false;
+    }
+
+    job->dst_fd = open(job->path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (job->dst_fd < 0) {
+        progress_set_error("无法创建", name);
+        return false;
+    }
+
+    job->remaining = entry->compressed_size;
+    job->crc = 0;
+    bool ok;
+
+    if (entry->method == ARCHIVE_METHOD_DEFLATE) {
+        int result = inflate_run(job->inflater, extract_read_cb, extract_write_cb, job);
+        ok = result == INFLATE_OK;
+        if (!ok && !g_archive.cancel_requested) {
+            progress_set_error(result == INFLATE_ERR_WRITE ? "写入失败" : "数据损坏", name);
+        }
+    } else {
+        // 未压缩：借用解压器窗口作为复制缓冲
+        size_t buffer_size;
+        uint8_t* buffer = inflate_get_buffer(job->inflater, &buffer_size);
+        ok = true;
+        while (ok && job->remaining > 0) {
+            size_t n = extract_read_cb(buffer, buffer_size, job);
+            ok = n > 0 && extract_write_cb(buffer, n, job);
+        }
+        if (!ok && !g_archive.cancel_requested) {
+            progress_set_error("读写失败", name);
+        }
+    }
+
+    ok = (close(job->dst_fd) == 0) && ok;
+    job->dst_fd = -1;
+    fs_watch_path_changed(job->path);
+
+    if (ok && job->format == ARCHIVE_FORMAT_ZIP && job->crc != entry->crc32) {
+        progress_set_error("校验失败", name);
+        ok = false;
+    }
+    if (!ok) {
+        unlink(job->path);
+    }
+    return ok;
+}
+
+static void free_job(extract_job_t* job) {
+    if (job->src_fd >= 0) {
+        close(job->src_fd);
+    }
+    inflate_free(job->inflater);
+    heap_caps_free(job->items.entries);
+    heap_caps_free(job->items.names);
+    heap_caps_free(job);
+}
+
+static void extract_task(void* arg) {
+    extract_job_t* job = (extract_job_t*)arg;
+
+    // 任务期间占用SD卡：卸载时先取消解压，等打开的文件都关闭后才释放驱动
+    bool in_io = hal_sdcard_io_begin();
+    bool ok = in_io && make_dirs(job->dest_dir, 0, true);
+    if (!in_io) {
+        progress_set_error("SD卡已卸载", job->dest_dir);
+    } else if (!ok) {
+        progress_set_error("无法创建目录", job->dest_dir);
+    }
+
+    for (uint32_t i = 0; ok && i < job->items.count && !g_archive.cancel_requested; i++) {
+        const archive_entry_t* entry = &job->items.entries[i];
+        const char* name = job->items.names + entry->name_offset;
+        progress_set_current(name);
+
+        if (entry->method == ARCHIVE_METHOD_UNSUPPORTED || !build_output_path(job, name)) {
+            printf("Archive: skipping %s\n", name);
+            progress_lock();
+            g_archive.progress.files_skipped++;
+            progress_unlock();
+            continue;
+        }
+
+        size_t dest_len = strlen(job->dest_dir);
+        if (!make_dirs(job->path, dest_len, entry->is_dir)) {
+            progress_set_error("无法创建目录", name);
+            ok = false;
+        } else if (!entry->is_dir) {
+            ok = extract_file(job, entry, name);
+        }
+
+        if (ok) {
+            progress_lock();
+            g_archive.progress.files_done++;
+            progress_unlock();
+        }
+    }
+
+    progress_lock();
+    g_archive.progress.elapsed_ms = (uint32_t)((esp_timer_get_time() - g_archive.start_time) / 1000);
+    if (g_archive.progress.elapsed_ms > 0) {
+        g_archive.progress.mb_per_sec = (float)g_archive.progress.bytes_done / 1048576.0f /
+                                        ((float)g_archive.progress.elapsed_ms / 1000.0f);
+    }
+    if (g_archive.cancel_requested) {
+        g_archive.progress.state = ARCHIVE_STATE_CANCELLED;
+    } else {
+        g_archive.progress.state = ok ? ARCHIVE_STATE_DONE : ARCHIVE_STATE_FAILED;
+    }
+    printf("Archive extract finished: state %d, %lu/%lu entries, %llu bytes in %lu ms (%.2f MB/s)\n",
+           g_archive.progress.state,
+           (unsigned long)g_archive.progress.files_done,
+           (unsigned long)g_archive.progress.files_total,
+           (unsigned long long)g_archive.progress.bytes_done,
+           (unsigned long)g_archive.progress.elapsed_ms,
+           g_archive.progress.mb_per_sec);
+    progress_unlock();
+
+    free_job(job);
+    if (in_io) {
+        hal_sdcard_io_end();
+    }
+    g_archive.busy = false;
+    vTaskDelete(NULL);
+}
+
+// SD卡即将卸载：取消正在进行的解压（在监视任务中调用）
+static void sdcard_event_cb(hal_sdcard_event_t event, uint32_t generation, void* user_data) {
+    (void)generation;
+    (void)user_data;
+    if (event == HAL_SDCARD_EVENT_UNMOUNTING) {
+        archive_extract_cancel();
+    }
+}
+
+bool archive_extract_start(const archive_t* archive, const uint32_t* indices, uint32_t count, const char* dest_dir) {
+    if (!archive || !dest_dir || strlen(dest_dir) >= ARCHIVE_MAX_PATH) {
+        return false;
+    }
+    if (!indices) {
+        count = archive->count;
+    }
+    if (count == 0) {
+        return false;
+    }
+    if (!hal_sdcard_is_mounted()) {
+        printf("Archive: SD card not mounted\n");
+        return false;
+    }
+
+    if (!g_archive.lock) {
+        g_archive.lock = xSemaphoreCreateMutex();
+        if (!g_archive.lock) {
+            return false;
+        }
+        hal_sdcard_add_listener(sdcard_event_cb, NULL);
+    }
+    if (g_archive.busy) {
+        printf("Archive: another extraction is running\n");
+        return false;
+    }
+
+    extract_job_t* job = archive_realloc(NULL, sizeof(extract_job_t));
+    if (!job) {
+        return false;
+    }
+    memset(job, 0, sizeof(extract_job_t));
+    job->src_fd = -1;
+    job->dst_fd = -1;
+    job->format = archive->format;
+    strcpy(job->archive_path, archive->path);
+    strcpy(job->dest_dir, dest_dir);
+
+    // 复制要解压的条目
+    uint64_t bytes_total = 0;
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        uint32_t index = indices ? indices[i] : i;
+        if (index >= archive->count) {
+            continue;
+        }
+        const archive_entry_t* entry = &archive->entries[index];
+        const char* name = archive->names + entry->name_offset;
+        ok = archive_add(&job->items, name, strlen(name), entry);
+        if (!entry->is_dir && entry->method != ARCHIVE_METHOD_UNSUPPORTED) {
+            bytes_total += entry->size;
+        }
+    }
+
+    job->inflater = ok ? inflate_create() : NULL;
+    job->src_fd = open(job->archive_path, O_RDONLY);
+    if (!ok || !job->inflater || job->src_fd < 0) {
+        printf("Archive: failed to prepare extraction\n");
+        free_job(job);
+        return false;
+    }
+
+    progress_lock();
+    memset(&g_archive.progress, 0, sizeof(g_archive.progress));
+    g_archive.progress.state = ARCHIVE_STATE_RUNNING;
+    g_archive.progress.files_total = job->items.count;
+    g_archive.progress.bytes_total = bytes_total;
+    g_archive.has_progress = true;
+    g_archive.start_time = esp_timer_get_time();
+    progress_unlock();
+
+    g_archive.cancel_requested = false;
+    g_archive.busy = true;
+
+    // 任务结束时释放job，创建后不能再访问
+    uint32_t entry_count = job->items.count;
+    if (xTaskCreate(extract_task, "archive", ARCHIVE_TASK_STACK, job, ARCHIVE_TASK_PRIORITY, NULL) != pdPASS) {
+        printf("Archive: failed to create task\n");
+        progress_lock();
+        g_archive.progress.state = ARCHIVE_STATE_FAILED;
+        progress_unlock();
+        free_job(job);
+        g_archive.busy = false;
+        return false;
+    }
+
+    printf("Archive extract started: %lu entries from %s to %s\n",
+           (unsigned long)entry_count, archive->path, dest_dir);
+    return true;
+}
+
+void archive_extract_cancel(void) {
+    if (g_archive.busy) {
+        g_archive.cancel_requested = true;
+    }
+}
+
+bool archive_extract_is_busy(void) {
+    return g_archive.busy;
+}
+
+bool archive_extract_get_progress(archive_progress_t* progress) {
+    if (!progress || !g_archive.lock) {
+        return false;
+    }
+
+    progress_lock();
+    bool has_progress = g_archive.has_progress;
+    if (has_progress) {
+        *progress = g_archive.progress;
+        if (progress->state == ARCHIVE_STATE_RUNNING) {
+            progress->elapsed_ms = (uint32_t)((esp_timer_get_time() - g_archive.start_time) / 1000);
+            if (progress->elapsed_ms > 0) {
+                progress->mb_per_sec = (float)progress->bytes_done / 1048576.0f /
+                                       ((float)progress->elapsed_ms / 1000.0f);
+            }
+        }
+    }
+    progress_unlock();
+    return has_progress;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Self Test                                  */
+/* -------------------------------------------------------------------------- */
+
+// zlib level 9生成的动态哈夫曼块，原文为40行"NN: the quick brown fox jumps over the lazy dog\n"
+static const uint8_t k_dynamic_sample[] = {
+    0x95, 0xD1, 0xC7, 0x11, 0xC2, 0x50, 0x10, 0x04, 0xD1, 0x3B, 0x51, 0x6C, 0x08, 0x7F, 0x67, 0xF0,
+    0xD9, 0x60, 0x24, 0x3C, 0x1F, 0x04, 0xC2, 0x28, 0x7A, 0xAA, 0xC8, 0xA0, 0xCF, 0xDD, 0xB7, 0x57,
+    0xCA, 0x32, 0x9E, 0xFB, 0x26, 0xEE, 0xFD, 0x61, 0x73, 0x8A, 0x75, 0x57, 0xDF, 0xD7, 0x68, 0xEB,
+    0x27, 0x8E, 0xFD, 0xE5, 0xF6, 0x88, 0xFA, 0x6A, 0xBA, 0x7F, 0x3E, 0xAF, 0x86, 0x6F, 0x6C, 0xEB,
+    0x6E, 0x54, 0x12, 0xFE, 0x82, 0xBF, 0xE1, 0x3F, 0x86, 0xFF, 0x04, 0xFE, 0x53, 0xF8, 0xCF, 0xE0,
+    0x3F, 0x87, 0xFF, 0x82, 0xFD, 0x09, 0x7D, 0x13, 0xFA, 0x26, 0xF4, 0x4D, 0xE8, 0x9B, 0xD0, 0x37,
+    0xA1, 0x6F, 0x42, 0xDF, 0x84, 0xBE, 0x09, 0x7D, 0x13, 0xFA, 0x0A, 0xFA, 0x0A, 0xFA, 0x0A, 0xFA,
+    0x0A, 0xFA, 0x0A, 0xFA, 0x0A, 0xFA, 0x0A, 0xFA, 0x0A, 0xFA, 0x0A, 0xFA, 0x0A, 0xFA, 0x1A, 0xFA,
+    0x1A, 0xFA, 0x1A, 0xFA, 0x1A, 0xFA, 0x1A, 0xFA, 0x1A, 0xFA, 0x1A, 0xFA, 0x1A, 0xFA, 0x1A, 0xFA,
+    0x1A, 0xFA, 0xFE, 0x00,
+};
+#define DYNAMIC_SAMPLE_LINES    40
+#define DYNAMIC_SAMPLE_SIZE     (DYNAMIC_SAMPLE_LINES * 48)
+
+// 测试数据：64字节周期的文本
+#define PATTERN_PERIOD          64
+#define SELF_TEST_DIR_MAX       (ARCHIVE_MAX_PATH - 32)     // 工作目录下路径的最大长度
+
+static uint8_t pattern_byte(uint32_t pos) {
+    static const char text[PATTERN_PERIOD + 1] =
+        "ImOS archive self test: streaming inflate into bounded buffers\r\n";
+    return (uint8_t)text[pos % PATTERN_PERIOD];
+}
+
+// 固定哈夫曼编码器（只用于生成测试数据）：先输出一个周期的字面量，之后全部为长度258、距离64的匹配
+typedef struct {
+    uint8_t* data;
+    uint32_t len;
+    uint32_t capacity;
+    uint32_t bitbuf;
+    uint32_t bitcnt;
+} bit_writer_t;
+
+static void put_bits(bit_writer_t* w, uint32_t value, uint32_t n) {
+    w->bitbuf |= value << w->bitcnt;
+    w->bitcnt += n;
+    while (w->bitcnt >= 8) {
+        if (w->len < w->capacity) {
+            w->data[w->len++] = (uint8_t)w->bitbuf;
+        }
+        w->bitbuf >>= 8;
+        w->bitcnt -= 8;
+    }
+}
+
+static void put_code(bit_writer_t* w, uint32_t code, uint32_t len) {
+    uint32_t reversed = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    put_bits(w, reversed, len);
+}
+
+static void put_fixed_literal(bit_writer_t* w, uint32_t sym) {
+    if (sym < 144) {
+        put_code(w, 0x30 + sym, 8);
+    } else if (sym < 256) {
+        put_code(w, 0x190 + sym - 144, 9);
+    } else if (sym < 280) {
+        put_code(w, sym - 256, 7);
+    } else {
+        put_code(w, 0xC0 + sym - 280, 8);
+    }
+}
+
+static bool deflate_pattern(bit_writer_t* w, uint32_t size) {
+    put_bits(w, 1, 1);          // BFINAL
+    put_bits(w, 1, 2);          // 固定哈夫曼
+
+    uint32_t pos = 0;
+    for (; pos < size && pos < PATTERN_PERIOD; pos++) {
+        put_fixed_literal(w, pattern_byte(pos));
+    }
+    while (size - pos >= 258) {
+        put_fixed_literal(w, 285);      // 长度258
+        put_code(w, 11, 5);             // 距离码11：49 + 4位附加值
+        put_bits(w, PATTERN_PERIOD - 49, 4);
+        pos += 258;
+    }
+    for (; pos < size; pos++) {
+        put_fixed_literal(w, pattern_byte(pos));
+    }
+    put_fixed_literal(w, 256);
+    put_bits(w, 0, 7);
+    return w->len < w->capacity;
+}
+
+static void put_le16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t* p, uint32_t v) {
+    put_le16(p, (uint16_t)v);
+    put_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+typedef struct {
+    const char* name;
+    uint16_t method;
+    const uint8_t* data;        // 压缩后数据（NULL表示生成的周期文本，未压缩）
+    uint32_t data_len;
+    uint32_t size;
+    uint32_t crc;
+    uint32_t offset;
+} zip_test_entry_t;
+
+static uint32_t pattern_crc(uint32_t size) {
+    uint8_t chunk[PATTERN_PERIOD * 4];
+    uint32_t crc = 0;
+    for (uint32_t pos = 0; pos < size; pos += sizeof(chunk)) {
+        uint32_t n = size - pos < sizeof(chunk) ? size - pos : sizeof(chunk);
+        for (uint32_t i = 0; i < n; i++) {
+            chunk[i] = pattern_byte(pos + i);
+        }
+        crc = esp_rom_crc32_le(crc, chunk, n);
+    }
+    return crc;
+}
+
+static bool write_pattern(FILE* fp, uint32_t size) {
+    uint8_t chunk[PATTERN_PERIOD * 4];
+    for (uint32_t i = 0; i < sizeof(chunk); i++) {
+        chunk[i] = pattern_byte(i);
+    }
+    for (uint32_t pos = 0; pos < size; pos += sizeof(chunk)) {
+        uint32_t n = size - pos < sizeof(chunk) ? size - pos : sizeof(chunk);
+        if (fwrite(chunk, 1, n, fp) != n) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool write_test_zip(const char* path, zip_test_entry_t* entries, int count) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        return false;
+    }
+
+    bool ok = true;
+    uint8_t header[ZIP_CENTRAL_SIZE];
+    uint32_t offset = 0;
+    for (int i = 0; ok && i < count; i++) {
+        zip_test_entry_t* e = &entries[i];
+        uint16_t name_len = (uint16_t)strlen(e->name);
+        memset(header, 0, sizeof(header));
+        put_le32(header, ZIP_LOCAL_SIG);
+        put_le16(header + 4, 20);
+        put_le16(header + 8, e->method);
+        put_le32(header + 14, e->crc);
+        put_le32(header + 18, e->data_len);
+        put_le32(header + 22, e->size);
+        put_le16(header + 26, name_len);
+        e->offset = offset;
+
+        ok = fwrite(header, 1, ZIP_LOCAL_SIZE, fp) == ZIP_LOCAL_SIZE &&
+             fwrite(e->name, 1, name_len, fp) == name_len &&
+             (e->data ? fwrite(e->data, 1, e->data_len, fp) == e->data_len : write_pattern(fp, e->data_len));
+        offset += ZIP_LOCAL_SIZE + name_len + e->data_len;
+    }
+
+    uint32_t cd_offset = offset;
+    for (int i = 0; ok && i < count; i++) {
+        zip_test_entry_t* e = &entries[i];
+        uint16_t name_len = (uint16_t)strlen(e->name);
+        memset(header, 0, sizeof(header));
+        put_le32(header, ZIP_CENTRAL_SIG);
+        put_le16(header + 4, 20);
+        put_le16(header + 6, 20);
+        put_le16(header + 10, e->method);
+        put_le32(header + 16, e->crc);
+        put_le32(header + 20, e->data_len);
+        put_le32(header + 24, e->size);
+        put_le16(header + 28, name_len);
+        put_le32(header + 42, e->offset);
+        ok = fwrite(header, 1, ZIP_CENTRAL_SIZE, fp) == ZIP_CENTRAL_SIZE &&
+             fwrite(e->name, 1, name_len, fp) == name_len;
+        offset += ZIP_CENTRAL_SIZE + name_len;
+    }
+
+    memset(header, 0, ZIP_END_SIZE);
+    put_le32(header, ZIP_END_SIG);
+    put_le16(header + 8, (uint16_t)count);
+    put_le16(header + 10, (uint16_t)count);
+    put_le32(header + 12, offset - cd_offset);
+    put_le32(header + 16, cd_offset);
+    ok = ok && fwrite(header, 1, ZIP_END_SIZE, fp) == ZIP_END_SIZE;
+
+    ok = (fclose(fp) == 0) && ok;
+    return ok;
+}
+
+static bool write_tar_header(FILE* fp, const char* name, char type, uint32_t size) {
+    uint8_t header[TAR_BLOCK];
+    memset(header, 0, sizeof(header));
+    strncpy((char*)header, name, 100);
+    memcpy(header + 100, "0000644", 8);
+    memcpy(header + 108, "0000000", 8);
+    memcpy(header + 116, "0000000", 8);
+    snprintf((char*)header + 124, 12, "%011lo", (unsigned long)size);
+    memcpy(header + 136, "00000000000", 12);
+    header[156] = (uint8_t)type;
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+
+    uint32_t sum = 0;
+    for (int i = 0; i < TAR_BLOCK; i++) {
+        sum += (i >= 148 && i < 156) ? ' ' : header[i];
+    }
+    // 校验和最大512*255，6位八进制足够；字段为6位数字 + NUL + 空格
+    snprintf((char*)header + 148, 8, "%06lo", (unsigned long)(sum & 0777777));
+    header[155] = ' ';
+    return fwrite(header, 1, TAR_BLOCK, fp) == TAR_BLOCK;
+}
+
+static bool write_tar_padding(FILE* fp, uint32_t size) {
+    static const uint8_t zeros[TAR_BLOCK] = {0};
+    uint32_t pad = (TAR_BLOCK - (size % TAR_BLOCK)) % TAR_BLOCK;
+    return fwrite(zeros, 1, pad, fp) == pad;
+}
+
+// TAR：目录 + 文件 + GNU长文件名条目
+static bool write_test_tar(const char* path, const char* long_name, uint32_t size) {
+    static const uint8_t zeros[TAR_BLOCK * 2] = {0};
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        return false;
+    }
+
+    uint32_t long_len = (uint32_t)strlen(long_name) + 1;
+    bool ok = write_tar_header(fp, "tar_dir/", '5', 0) &&
+              write_tar_header(fp, "tar_dir/pattern.txt", '0', size) &&
+              write_pattern(fp, size) && write_tar_padding(fp, size) &&
+              write_tar_header(fp, "././@LongLink", 'L', long_len) &&
+              fwrite(long_name, 1, long_len, fp) == long_len && write_tar_padding(fp, long_len) &&
+              write_tar_header(fp, "truncated", '0', PATTERN_PERIOD) &&
+              write_pattern(fp, PATTERN_PERIOD) && write_tar_padding(fp, PATTERN_PERIOD) &&
+              fwrite(zeros, 1, sizeof(zeros), fp) == sizeof(zeros);
+
+    ok = (fclose(fp) == 0) && ok;
+    return ok;
+}
+
+static bool file_crc(const char* path, uint32_t* crc, uint32_t* size) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+    uint8_t chunk[512];
+    size_t n;
+    *crc = 0;
+    *size = 0;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        *crc = esp_rom_crc32_le(*crc, chunk, (uint32_t)n);
+        *size += (uint32_t)n;
+    }
+    fclose(fp);
+    return true;
+}
+
+static bool check_file(const char* dir, const char* name, uint32_t expected_crc, uint32_t expected_size) {
+    char path[ARCHIVE_MAX_PATH];
+    uint32_t crc, size;
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    bool ok = file_crc(path, &crc, &size) && crc == expected_crc && size == expected_size;
+    printf("  %s: %s\n", name, ok ? "OK" : "MISMATCH");
+    unlink(path);
+    return ok;
+}
+
+static bool wait_for_extract(archive_progress_t* progress) {
+    while (archive_extract_is_busy()) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    return archive_extract_get_progress(progress) && progress->state == ARCHIVE_STATE_DONE;
+}
+
+// 内存中的压缩数据源，解压输出只计算CRC
+typedef struct {
+    const uint8_t* data;
+    uint32_t len;
+    uint32_t pos;
+    uint32_t crc;
+} memory_source_t;
+
+static size_t memory_read_cb(uint8_t* buffer, size_t size, void* user_data) {
+    memory_source_t* src = (memory_source_t*)user_data;
+    size_t n = src->len - src->pos < size ? src->len - src->pos : size;
+    memcpy(buffer, src->data + src->pos, n);
+    src->pos += (uint32_t)n;
+    return n;
+}
+
+static bool memory_write_cb(const uint8_t* data, size_t len, void* user_data) {
+    memory_source_t* src = (memory_source_t*)user_data;
+    src->crc = esp_rom_crc32_le(src->crc, data, (uint32_t)len);
+    return true;
+}
+
+bool archive_self_test(const char* work_dir, uint32_t size_kb) {
+    // 输出目录留出拼接子路径的空间
+    if (!work_dir || size_kb == 0 || strlen(work_dir) + sizeof("/test.zip") > SELF_TEST_DIR_MAX) {
+        return false;
+    }
+
+    uint32_t size = size_kb * 1024;
+    printf("Archive self test in %s (%lu KB entries)\n", work_dir, (unsigned long)size_kb);
+
+    // 生成deflate数据（每258字节约17位，加上首个周期的字面量）
+    bit_writer_t w = { .capacity = size / 64 + 1024 };
+    w.data = archive_realloc(NULL, w.capacity);
+    if (!w.data || !deflate_pattern(&w, size)) {
+        heap_caps_free(w.data);
+        return false;
+    }
+
+    // 内存中解压：只测inflate本身
+    uint32_t expected_crc = pattern_crc(size);
+    inflate_ctx_t* inflater = inflate_create();
+    bool ok = inflater != NULL;
+    if (ok) {
+        memory_source_t src = { .data = w.data, .len = w.len };
+        int64_t start = esp_timer_get_time();
+        int result = inflate_run(inflater, memory_read_cb, memory_write_cb, &src);
+        int64_t elapsed = esp_timer_get_time() - start;
+        ok = result == INFLATE_OK && src.crc == expected_crc;
+        printf("Inflate in memory: %lu -> %lu bytes, %.1f MB/s (%s)\n",
+               (unsigned long)w.len, (unsigned long)size,
+               elapsed > 0 ? (float)size / (float)elapsed : 0.0f, ok ? "OK" : "FAILED");
+    }
+    inflate_free(inflater);
+
+    char zip_path[SELF_TEST_DIR_MAX], tar_path[SELF_TEST_DIR_MAX], out_dir[SELF_TEST_DIR_MAX];
+    snprintf(zip_path, sizeof(zip_path), "%s/test.zip", work_dir);
+    snprintf(tar_path, sizeof(tar_path), "%s/test.tar", work_dir);
+    snprintf(out_dir, sizeof(out_dir), "%s/out", work_dir);
+
+    zip_test_entry_t entries[] = {
+        { "stored.txt", 0, NULL, size, size, expected_crc, 0 },
+        { "dir/", 0, NULL, 0, 0, 0, 0 },
+        { "dir/deflate.txt", 8, w.data, w.len, size, expected_crc, 0 },
+        { "dir/dynamic.txt", 8, k_dynamic_sample, sizeof(k_dynamic_sample), DYNAMIC_SAMPLE_SIZE, 0x2f7cfb33, 0 },
+        { "../escape.txt", 0, NULL, PATTERN_PERIOD, PATTERN_PERIOD, pattern_crc(PATTERN_PERIOD), 0 },
+    };
+    const int entry_count = sizeof(entries) / sizeof(entries[0]);
+
+    ok = ok && sd_selftest_mkdir(work_dir) && write_test_zip(zip_path, entries, entry_count);
+    heap_caps_free(w.data);
+    if (!ok) {
+        printf("Self test: failed to create test zip\n");
+        return false;
+    }
+
+    // ZIP：目录、解压和校验，"../"条目必须被跳过
+    archive_progress_t progress;
+    archive_t* archive = archive_open(zip_path);
+    ok = archive && archive->count == (uint32_t)entry_count &&
+         archive_extract_start(archive, NULL, 0, out_dir) && wait_for_extract(&progress);
+    archive_close(archive);
+    if (ok) {
+        printf("Self test zip: %lu entries, %lu skipped, %.2f MB/s\n",
+               (unsigned long)progress.files_done, (unsigned long)progress.files_skipped, progress.mb_per_sec);
+        ok = progress.files_skipped == 1;
+        ok = check_file(out_dir, "stored.txt", expected_crc, size) && ok;
+        ok = check_file(out_dir, "dir/deflate.txt", expected_crc, size) && ok;
+        ok = check_file(out_dir, "dir/dynamic.txt", 0x2f7cfb33, DYNAMIC_SAMPLE_SIZE) && ok;
+
+        char path[ARCHIVE_MAX_PATH];
+        snprintf(path, sizeof(path), "%s/escape.txt", work_dir);
+        ok = access(path, F_OK) != 0 && ok;
+        snprintf(path, sizeof(path), "%s/dir", out_dir);
+        rmdir(path);
+    } else {
+        printf("Self test zip: FAILED\n");
+    }
+
+    // TAR：目录、GNU长文件名
+    char long_name[160];
+    snprintf(long_name, sizeof(long_name), "tar_dir/%s.txt",
+             "a_very_long_file_name_that_does_not_fit_into_the_one_hundred_byte_ustar_name_field_of_the_header");
+    bool tar_ok = write_test_tar(tar_path, long_name, size);
+    archive = tar_ok ? archive_open(tar_path) : NULL;
+    tar_ok = archive && archive->count == 3 &&
+             archive_extract_start(archive, NULL, 0, out_dir) && wait_for_extract(&progress);
+    archive_close(archive);
+    if (tar_ok) {
+        printf("Self test tar: %lu entries, %.2f MB/s\n", (unsigned long)progress.files_done, progress.mb_per_sec);
+        tar_ok = check_file(out_dir, "tar_dir/pattern.txt", expected_crc, size);
+        tar_ok = check_file(out_dir, long_name, pattern_crc(PATTERN_PERIOD), PATTERN_PERIOD) && tar_ok;
+        char path[ARCHIVE_MAX_PATH];
+        snprintf(path, sizeof(path), "%s/tar_dir", out_dir);
+        rmdir(path);
+    } else {
+        printf("Self test tar: FAILED\n");
+    }
+
+    unlink(zip_path);
+    unlink(tar_path);
+    rmdir(out_dir);
+    rmdir(work_dir);
+    return ok && tar_ok;
+}
@@ -0,0 +1,141 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 压缩包格式
+typedef enum {
+    ARCHIVE_FORMAT_ZIP,
+    ARCHIVE_FORMAT_TAR
+} archive_format_t;
+
+// 条目存储方式
+typedef enum {
+    ARCHIVE_METHOD_STORED,          // 未压缩（TAR或ZIP存储）
+    ARCHIVE_METHOD_DEFLATE,         // ZIP deflate
+    ARCHIVE_METHOD_UNSUPPORTED      // 加密、ZIP64或其他压缩算法
+} archive_method_t;
+
+// 压缩包条目
+typedef struct {
+    uint32_t name_offset;           // 名称池偏移（包内完整路径，'\0'结尾）
+    uint32_t size;                  // 解压后大小
+    uint32_t compressed_size;       // 压缩后大小
+    uint32_t header_offset;         // ZIP: 本地文件头偏移；TAR: 数据偏移
+    uint32_t crc32;                 // ZIP: CRC-32（TAR为0）
+    uint8_t method;                 // archive_method_t
+    uint8_t is_dir;
+    uint16_t reserved;
+} archive_entry_t;
+
+// 压缩包目录（只读取目录结构，不解压数据）
+typedef struct {
+    archive_format_t format;
+    char path[256];
+    archive_entry_t* entries;
+    uint32_t count;
+    uint32_t capacity;
+    char* names;                    // 名称池
+    uint32_t names_used;
+    uint32_t names_capacity;
+    uint64_t total_size;            // 解压后总大小
+} archive_t;
+
+// 解压任务状态
+typedef enum {
+    ARCHIVE_STATE_IDLE,
+    ARCHIVE_STATE_RUNNING,
+    ARCHIVE_STATE_DONE,
+    ARCHIVE_STATE_CANCELLED,
+    ARCHIVE_STATE_FAILED
+} archive_state_t;
+
+// 解压进度快照
+typedef struct {
+    archive_state_t state;
+    uint32_t files_done;            // 已解压条目数
+    uint32_t files_total;           // 条目总数
+    uint32_t files_skipped;         // 不支持或路径不安全而跳过的条目数
+    uint64_t bytes_done;            // 已写入字节数
+    uint64_t bytes_total;           // 需要写入的总字节数
+    uint32_t elapsed_ms;            // 已用时间
+    float mb_per_sec;               // 平均输出吞吐量 (MB/s)
+    char current[128];              // 当前条目名
+    char error[128];                // 失败原因
+} archive_progress_t;
+
+/**
+ * @brief 判断文件名是否为支持的压缩包（.zip/.tar）
+ */
+bool archive_is_supported(const char* filename);
+
+/**
+ * @brief 读取压缩包目录
+ *
+ * ZIP只读取中央目录，TAR只读取各条目头并跳过数据，内存占用与条目数成正比。
+ *
+ * @return 压缩包目录，失败返回NULL
+ */
+archive_t* archive_open(const char* path);
+
+/**
+ * @brief 释放压缩包目录（可在解压进行中调用，解压任务使用自己的副本）
+ */
+void archive_close(archive_t* archive);
+
+/**
+ * @brief 获取条目名称
+ */
+const char* archive_entry_name(const archive_t* archive, uint32_t index);
+
+/**
+ * @brief 在后台解压条目
+ *
+ * 数据流式解压到目标文件，峰值内存固定（一个解压器），与压缩包大小无关。
+ * 包含".."或绝对路径的条目会被跳过。同一时间只允许一个任务运行。
+ *
+ * @param archive 压缩包目录
+ * @param indices 要解压的条目下标，NULL表示全部
+ * @param count indices中的条目数
+ * @param dest_dir 目标目录（不存在时自动创建）
+ * @return 启动成功返回true
+ */
+bool archive_extract_start(const archive_t* archive, const uint32_t* indices, uint32_t count, const char* dest_dir);
+
+/**
+ * @brief 请求取消解压（在下一个数据块边界生效，未完成的文件会被删除）
+ */
+void archive_extract_cancel(void);
+
+/**
+ * @brief 是否有解压任务正在运行
+ */
+bool archive_extract_is_busy(void);
+
+/**
+ * @brief 获取当前（或最近一次）解压任务的进度快照，可从任意任务调用
+ *
+ * @return 从未启动过任务时返回false
+ */
+bool archive_extract_get_progress(archive_progress_t* progress);
+
+/**
+ * @brief 生成测试用ZIP（存储 + deflate）和TAR，读取目录、解压并校验内容，
+ *        打印内存中的inflate吞吐量和从SD卡解压的MB/s
+ *
+ * @param work_dir 临时工作目录（结束时删除）
+ * @param size_kb 测试条目大小（KB）
+ * @return 全部步骤成功返回true
+ */
+bool archive_self_test(const char* work_dir, uint32_t size_kb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ARCHIVE_H
@@ -0,0 +1,718 @@
+#include "dir_size.h"
+#include "hal_sdcard.h"
+#include "fs_watch.h"
+#include "file_listing.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+// 配置
+#define DIR_SIZE_MAX_PATH        512
+#define DIR_SIZE_TASK_STACK      6144
+#define DIR_SIZE_TASK_PRIORITY   (tskIDLE_PRIORITY + 1)   // 最低优先级，不影响音频和界面
+#define DIR_SIZE_QUEUE_LEN       16
+#define DIR_SIZE_SAVE_DELAY_MS   2000                     // 空闲2秒后保存结果
+#define DIR_SIZE_YIELD_EVERY     16                       // 每统计16个目录让出一次CPU
+
+// 持久化文件（位于SD卡隐藏目录）
+#define DIR_SIZE_CACHE_DIR       ".imos"
+#define DIR_SIZE_CACHE_FILE      "dirsize.bin"
+#define DIR_SIZE_CACHE_TMP       "dirsize.tmp"
+#define DIR_SIZE_MAGIC           0x315A5344               // "DSZ1"
+#define DIR_SIZE_VERSION         1
+
+// 记录标志
+#define RECORD_FLAG_DIRTY        (1 << 0)
+
+// 目录记录
+typedef struct {
+    char* path;
+    uint64_t own_bytes;
+    uint64_t total_bytes;
+    uint32_t own_files;
+    uint32_t total_files;
+    uint32_t total_dirs;
+    uint32_t mtime;             // 目录项修改时间（来自上级目录的记录）
+    uint8_t flags;
+} dir_record_t;
+
+// 持久化格式
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+} dir_cache_header_t;
+
+typedef struct {
+    uint64_t own_bytes;
+    uint64_t total_bytes;
+    uint32_t own_files;
+    uint32_t total_files;
+    uint32_t total_dirs;
+    uint32_t mtime;
+    uint16_t path_len;
+    uint16_t reserved;
+} dir_cache_record_t;
+
+// 请求类型
+typedef enum {
+    DIR_SIZE_REQ_SCAN,          // 统计目录树（复用有效缓存）
+    DIR_SIZE_REQ_SCAN_FORCE,    // 忽略缓存重新统计
+    DIR_SIZE_REQ_UPDATE,        // 重新统计单个目录并增量更新上级
+    DIR_SIZE_REQ_RELOAD         // SD卡插拔：丢弃全部记录并从卡上重新加载缓存
+} dir_size_req_type_t;
+
+typedef struct {
+    dir_size_req_type_t type;
+    char* path;
+} dir_size_req_t;
+
+// 统计结果
+typedef struct {
+    uint64_t bytes;
+    uint32_t files;
+    uint32_t dirs;
+} dir_totals_t;
+
+// 全局状态
+static struct {
+    SemaphoreHandle_t lock;         // 保护记录表
+    QueueHandle_t queue;
+    dir_record_t* records;
+    uint32_t count;
+    uint32_t capacity;
+    int32_t* index;                 // 开放寻址哈希表，-1为空
+    uint32_t index_size;
+    char path[DIR_SIZE_MAX_PATH];   // 后台任务遍历时复用的路径
+    uint32_t visited;
+    volatile bool busy;
+    volatile uint32_t generation;
+} g_dir_size = {0};
+
+/* -------------------------------------------------------------------------- */
+/*                                Record Table                                */
+/* -------------------------------------------------------------------------- */
+
+static void* ds_realloc(void* ptr, size_t size) {
+    void* new_ptr = heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM);
+    if (!new_ptr) {
+        new_ptr = heap_caps_realloc(ptr, size, MALLOC_CAP_DEFAULT);
+    }
+    return new_ptr;
+}
+
+static char* ds_strdup(const char* str, size_t len) {
+    char* copy = ds_realloc(NULL, len + 1);
+    if (copy) {
+        memcpy(copy, str, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+static uint32_t hash_path(const char* path) {
+    uint32_t hash = 2166136261u;
+    while (*path) {
+        hash ^= (uint8_t)*path++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 查找记录（调用者持有锁）
+static dir_record_t* record_find(const char* path) {
+    if (!g_dir_size.index) {
+        return NULL;
+    }
+
+    uint32_t mask = g_dir_size.index_size - 1;
+    for (uint32_t slot = hash_path(path) & mask; ; slot = (slot + 1) & mask) {
+        int32_t i = g_dir_size.index[slot];
+        if (i < 0) {
+            return NULL;
+        }
+        if (strcmp(g_dir_size.records[i].path, path) == 0) {
+            return &g_dir_size.records[i];
+        }
+    }
+}
+
+static bool index_rebuild(uint32_t size) {
+    int32_t* index = ds_realloc(NULL, size * sizeof(int32_t));
+    if (!index) {
+        return false;
+    }
+    memset(index, 0xFF, size * sizeof(int32_t));
+
+    uint32_t mask = size - 1;
+    for (uint32_t i = 0; i < g_dir_size.count; i++) {
+        uint32_t slot = hash_path(g_dir_size.records[i].path) & mask;
+        while (index[slot] >= 0) {
+            slot = (slot + 1) & mask;
+        }
+        index[slot] = (int32_t)i;
+    }
+
+    heap_caps_free(g_dir_size.index);
+    g_dir_size.index = index;
+    g_dir_size.index_size = size;
+    return true;
+}
+
+// 查找或创建记录（调用者持有锁）
+static dir_record_t* record_upsert(const char* path, size_t path_len) {
+    dir_record_t* record = record_find(path);
+    if (record) {
+        return record;
+    }
+
+    if (g_dir_size.count == g_dir_size.capacity) {
+        uint32_t new_capacity = g_dir_size.capacity ? g_dir_size.capacity * 2 : 256;
+        dir_record_t* records = ds_realloc(g_dir_size.records, new_capacity * sizeof(dir_record_t));
+        if (!records) {
+            return NULL;
+        }
+        g_dir_size.records = records;
+        g_dir_size.capacity = new_capacity;
+    }
+
+    // 负载因子保持在50%以下
+    if ((g_dir_size.count + 1) * 2 > g_dir_size.index_size) {
+        if (!index_rebuild(g_dir_size.index_size ? g_dir_size.index_size * 2 : 512)) {
+            return NULL;
+        }
+    }
+
+    char* path_copy = ds_strdup(path, path_len);
+    if (!path_copy) {
+        return NULL;
+    }
+
+    record = &g_dir_size.records[g_dir_size.count];
+    memset(record, 0, sizeof(dir_record_t));
+    record->path = path_copy;
+
+    uint32_t mask = g_dir_size.index_size - 1;
+    uint32_t slot = hash_path(path_copy) & mask;
+    while (g_dir_size.index[slot] >= 0) {
+        slot = (slot + 1) & mask;
+    }
+    g_dir_size.index[slot] = (int32_t)g_dir_size.count;
+    g_dir_size.count++;
+    return record;
+}
+
+// 清空全部记录
+static void records_clear(void) {
+    xSemaphoreTake(g_dir_size.lock, portMAX_DELAY);
+    for (uint32_t i = 0; i < g_dir_size.count; i++) {
+        heap_caps_free(g_dir_size.records[i].path);
+    }
+    g_dir_size.count = 0;
+    if (g_dir_size.index) {
+        memset(g_dir_size.index, 0xFF, g_dir_size.index_size * sizeof(int32_t));
+    }
+    g_dir_size.generation++;
+    xSemaphoreGive(g_dir_size.lock);
+}
+
+// 把path目录树下的全部记录及其各级上级标记失效，不访问SD卡
+static void records_invalidate_tree(const char* path) {
+    size_t path_len = strlen(path);
+    uint32_t marked = 0;
+
+    xSemaphoreTake(g_dir_size.lock, portMAX_DELAY);
+    for (uint32_t i = 0; i < g_dir_size.count; i++) {
+        dir_record_t* record = &g_dir_size.records[i];
+        size_t len = strlen(record->path);
+        bool inside = strncmp(record->path, path, path_len) == 0 &&
+                      (record->path[path_len] == '/' || record->path[path_len] == '\0');
+        bool ancestor = len < path_len && strncmp(path, record->path, len) == 0 && path[len] == '/';
+        if ((inside || ancestor) && !(record->flags & RECORD_FLAG_DIRTY)) {
+            record->flags |= RECORD_FLAG_DIRTY;
+            marked++;
+        }
+    }
+    g_dir_size.generation++;
+    xSemaphoreGive(g_dir_size.lock);
+
+    printf("Dir size: %lu records under %s invalidated\n", (unsigned long)marked, path);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                Persistence                                 */
+/* -------------------------------------------------------------------------- */
+
+static bool build_cache_path(char* buffer, size_t size, const char* file_name) {
+    const char* mount_point = hal_sdcard_get_mount_point();
+    int len = snprintf(buffer, size, "%s/%s/%s", mount_point, DIR_SIZE_CACHE_DIR, file_name);
+    return len > 0 && (size_t)len < size;
+}
+
+static void load_cache(void) {
+    char cache_path[128];
+    if (!build_cache_path(cache_path, sizeof(cache_path), DIR_SIZE_CACHE_FILE)) {
+        return;
+    }
+
+    FILE* fp = fopen(cache_path, "rb");
+    if (!fp) {
+        return;
+    }
+    setvbuf(fp, NULL, _IOFBF, 8192);
+
+    int64_t start = esp_timer_get_time();
+    dir_cache_header_t header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        header.magic != DIR_SIZE_MAGIC || header.version != DIR_SIZE_VERSION) {
+        printf("Dir size cache invalid, ignoring\n");
+        fclose(fp);
+        return;
+    }
+
+    uint32_t loaded = 0;
+    char path[DIR_SIZE_MAX_PATH];
+    for (uint32_t i = 0; i < header.count; i++) {
+        dir_cache_record_t disk;
+        if (fread(&disk, sizeof(disk), 1, fp) != 1 || disk.path_len >= sizeof(path) ||
+            fread(path, 1, disk.path_len, fp) != disk.path_len) {
+            break;
+        }
+        path[disk.path_len] = '\0';
+
+        xSemaphoreTake(g_dir_size.lock, portMAX_DELAY);
+        dir_record_t* record = record_upsert(path, disk.path_len);
+        if (record) {
+            record->own_bytes = disk.own_bytes;
+            record->total_bytes = disk.total_bytes;
+            record->own_files = disk.own_files;
+            record->total_files = disk.total_files;
+            record->total_dirs = disk.total_dirs;
+            record->mtime = disk.mtime;
+            // FAT目录内容变化时不更新目录修改时间，卡也可能在电脑上被修改过，
+            // 保存的结果只用于立即显示，查看目录时重新统计
+            record->flags = RECORD_FLAG_DIRTY;
+            loaded++;
+        }
+        xSemaphoreGive(g_dir_size.lock);
+    }
+    fclose(fp);
+
+    g_dir_size.generation++;
+    printf("Dir size cache loaded: %lu records in %lld ms\n",
+           (unsigned long)loaded, (long long)((esp_timer_get_time() - start) / 1000));
+}
+
+static void save_cache(void) {
+    char cache_path[128], tmp_path[128], dir_path[128];
+    if (!build_cache_path(cache_path, sizeof(cache_path), DIR_SIZE_CACHE_FILE) ||
+        !build_cache_path(tmp_path, sizeof(tmp_path), DIR_SIZE_CACHE_TMP)) {
+        return;
+    }
+    snprintf(dir_path, sizeof(dir_path), "%s/%s", hal_sdcard_get_mount_point(), DIR_SIZE_CACHE_DIR);
+    if (mkdir(dir_path, 0777) != 0 && errno != EEXIST) {
+        return;
+    }
+
+    // 加锁期间只做内存序列化，写卡时不阻塞UI查询
+    xSemaphoreTake(g_dir_size.lock, portMAX_DELAY);
+    size_t size = sizeof(dir_cache_header_t);
+    for (uint32_t i = 0; i < g_dir_size.count; i++) {
+        size += sizeof(dir_cache_record_t) + strlen(g_dir_size.records[i].path);
+    }
+
+    uint8_t* blob = ds_realloc(NULL, size);
+    if (!blob) {
+        xSemaphoreGive(g_dir_size.lock);
+        return;
+    }
+
+    dir_cache_header_t header = { DIR_SIZE_MAGIC, DIR_SIZE_VERSION, g_dir_size.count };
+    memcpy(blob, &header, sizeof(header));
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < g_dir_size.count; i++) {
+        const dir_record_t* record = &g_dir_size.records[i];
+        dir_cache_record_t disk = {
+            .own_bytes = record->own_bytes,
+            .total_bytes = record->total_bytes,
+            .own_files = record->own_files,
+            .total_files = record->total_files,
+            .total_dirs = record->total_dirs,
+            .mtime = record->mtime,
+            .path_len = (uint16_t)strlen(record->path),
+        };
+        memcpy(blob + offset, &disk, sizeof(disk));
+        offset += sizeof(disk);
+        memcpy(blob + offset, record->path, disk.path_len);
+        offset += disk.path_len;
+    }
+    xSemaphoreGive(g_dir_size.lock);
+
+    // 先写临时文件再替换，避免掉电时留下损坏的缓存
+    bool ok = false;
+    FILE* fp = fopen(tmp_path, "wb");
+    if (fp) {
+        ok = fwrite(blob, 1, size, fp) == size;
+        ok = (fclose(fp) == 0) && ok;
+    }
+    heap_caps_free(blob);
+
+    if (ok) {
+        unlink(cache_path);
+        ok = rename(tmp_path, cache_path) == 0;
+    }
+    printf("Dir size cache %s: %lu records, %zu bytes\n", ok ? "saved" : "save failed",
+           (unsigned long)header.count, size);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Walker                                   */
+/* -------------------------------------------------------------------------- */
+
+typedef struct {
+    file_listing_t* dirs;       // 子目录（名称和修改时间）
+    uint64_t own_bytes;
+    uint32_t own_files;
+    bool failed;
+} scan_ctx_t;
+
+static bool scan_entry_cb(const hal_sdcard_entry_t* entry, void* user_data) {
+    scan_ctx_t* ctx = (scan_ctx_t*)user_data;
+    if (!entry->is_dir) {
+        ctx->own_bytes += entry->size;
+        ctx->own_files++;
+        return true;
+    }
+
+    if (!file_listing_add(ctx->dirs, entry->name, FILE_TYPE_DIRECTORY, 0, entry->mtime)) {
+        ctx->failed = true;
+        return false;
+    }
+    return true;
+}
+
+static bool path_push(const char* name, size_t* saved_len) {
+    size_t len = strlen(g_dir_size.path);
+    size_t name_len = strlen(name);
+    if (len + 1 + name_len >= sizeof(g_dir_size.path)) {
+        return false;
+    }
+
+    g_dir_size.path[len] = '/';
+    memcpy(g_dir_size.path + len + 1, name, name_len + 1);
+    *saved_len = len;
+    return true;
+}
+
+// 统计g_dir_size.path目录树，结果写入记录表
+static bool compute_dir(uint32_t mtime, bool force, dir_totals_t* out) {
+    scan_ctx_t ctx = { .dirs = file_listing_create(g_dir_size.path) };
+    if (!ctx.dirs) {
+        return false;
+    }
+
+    if (hal_sdcard_list_dir(g_dir_size.path, NULL, 0, scan_entry_cb, &ctx) < 0 || ctx.failed) {
+        file_listing_free(ctx.dirs);
+        return false;
+    }
+
+    dir_totals_t totals = { .bytes = ctx.own_bytes, .files = ctx.own_files, .dirs = 0 };
+
+    for (uint32_t i = 0; i < ctx.dirs->count; i++) {
+        size_t saved_len;
+        if (!path_push(file_listing_name(ctx.dirs, i), &saved_len)) {
+            continue;
+        }
+
+        // 本次挂载后统计过、之后没有被标记失效的子目录直接使用缓存结果
+        // （修改时间只作为附加检查，FAT不会因目录内容变化而更新它）
+        dir_totals_t child;
+        bool have_child = false;
+        uint32_t child_mtime = ctx.dirs->entries[i].modified_time;
+        if (!force) {
+            xSemaphoreTake(g_dir_size.lock, portMAX_DELAY);
+            dir_record_t* record = record_find(g_dir_size.path);
+            if (record && !(record->flags & RECORD_FLAG_DIRTY) && record->mtime == child_mtime) {
+                child.bytes = record->total_bytes;
+                child.files = record->total_files;
+                child.dirs = record->total_dirs;
+                have_child = true;
+            }
+            xSemaphoreGive(g_dir_size.lock);
+        }
+
+        if (!have_child) {
+            have_child = compute_dir(child_mtime, force, &child);
+        }
+        g_dir_size.path[saved_len] = '\0';
+
+        if (have_child) {
+            totals.bytes += child.bytes;
+            totals.files += child.files;
+            totals.dirs += child.dirs + 1;
+        }
+    }
+    file_listing_free(ctx.dirs);
+
+    xSemaphoreTake(g_dir_size.lock, portMAX_DELAY);
+    dir_record_t* record = record_upsert(g_dir_size.path, strlen(g_dir_size.path));
+    if (record) {
+        record->own_bytes = ctx.own_bytes;
+        record->own_files = ctx.own_files;
+        record->total_bytes = totals.bytes;
+        record->total_files = totals.files;
+        record->total_dirs = totals.dirs;
+        record->mtime = mtime;
+        record->flags &= ~RECORD_FLAG_DIRTY;
+    }
+    g_dir_size.generation++;
+    xSemaphoreGive(g_dir_size.lock);
+
+    // 低优先级任务也定期让出CPU，减少对SD卡的连续占用
+    if (++g_dir_size.visited % DIR_SIZE_YIELD_EVERY == 0) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    *out = totals;
+    return true;
+}
+
+static uint32_t get_dir_mtime(const char* path) {
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        return (uint32_t)st.st_mtime;
+    }
+    return 0;
+}
+
+// 重新统计单个目录，把差值累加到各级上级目录
+static void update_dir(void) {
+    dir_totals_t old_totals = {0};
+    bool had_record = false;
+
+    xSemaphoreTake(g_dir_size.lock, portMAX_DELAY);
+    dir_record_t* record = record_find(g_dir_size.path);
+    if (record) {
+        old_totals.bytes = record->total_bytes;
+        old_totals.files = record->total_files;
+        old_totals.dirs = record->total_dirs;
+        had_record = true;
+    }
+    xSemaphoreGive(g_dir_size.lock);
+
+    dir_totals_t new_totals;
+    if (!compute_dir(get_dir_mtime(g_dir_size.path), false, &new_totals) || !had_record) {
+        return;
+    }
+
+    int64_t delta_bytes = (int64_t)new_totals.bytes - (int64_t)old_totals.bytes;
+    int64_t delta_files = (int64_t)new_totals.files - (int64_t)old_totals.files;
+    int64_t delta_dirs = (int64_t)new_totals.dirs - (int64_t)old_totals.dirs;
+    if (delta_bytes == 0 && delta_files == 0 && delta_dirs == 0) {
+        return;
+    }
+
+    size_t root_len = strlen(hal_sdcard_get_mount_point());
+    xSemaphoreTake(g_dir_size.lock, portMAX_DELAY);
+    char* slash;
+    while ((slash = strrchr(g_dir_size.path, '/')) != NULL && (size_t)(slash - g_dir_size.path) >= root_len) {
+        *slash = '\0';
+        dir_record_t* parent = record_find(g_dir_size.path);
+        if (!parent) {
+            break;
+        }
+        parent->total_bytes = (uint64_t)((int64_t)parent->total_bytes + delta_bytes);
+        parent->total_files = (uint32_t)((int64_t)parent->total_files + delta_files);
+        parent->total_dirs = (uint32_t)((int64_t)parent->total_dirs + delta_dirs);
+    }
+    g_dir_size.generation++;
+    xSemaphoreGive(g_dir_size.lock);
+
+    printf("Dir size updated incrementally (%+lld bytes)\n", (long long)delta_bytes);
+}
+
+static void dir_size_task(void* arg) {
+    (void)arg;
+    bool unsaved = false;
+
+    if (hal_sdcard_io_begin()) {
+        load_cache();
+        hal_sdcard_io_end();
+    }
+
+    while (true) {
+        dir_size_req_t req;
+        if (xQueueReceive(g_dir_size.queue, &req, pdMS_TO_TICKS(DIR_SIZE_SAVE_DELAY_MS)) != pdTRUE) {
+            if (unsaved && hal_sdcard_io_begin()) {
+                save_cache();
+                hal_sdcard_io_end();
+                unsaved = false;
+            }
+            continue;
+        }
+
+        // 未保存的记录属于上一张卡，直接丢弃
+        if (req.type == DIR_SIZE_REQ_RELOAD) {
+            records_clear();
+            unsaved = false;
+            if (hal_sdcard_io_begin()) {
+                load_cache();
+                hal_sdcard_io_end();
+            }
+            g_dir_size.busy = uxQueueMessagesWaiting(g_dir_size.queue) > 0;
+            heap_caps_free(req.path);
+            continue;
+        }
+
+        // 扫描期间占用SD卡，卸载时等待扫描结束（卸载开始后list_dir立即失败）
+        if (strlen(req.path) < sizeof(g_dir_size.path) && hal_sdcard_io_begin()) {
+            g_dir_size.busy = true;
+            strcpy(g_dir_size.path, req.path);
+            g_dir_size.visited = 0;
+            int64_t start = esp_timer_get_time();
+
+            if (req.type == DIR_SIZE_REQ_UPDATE) {
+                update_dir();
+            } else {
+                dir_totals_t totals;
+                if (compute_dir(get_dir_mtime(req.path), req.type == DIR_SIZE_REQ_SCAN_FORCE, &totals)) {
+                    printf("Dir size %s: %llu bytes, %lu files (%lu dirs visited, %lld ms)\n",
+                           req.path, (unsigned long long)totals.bytes, (unsigned long)totals.files,
+                           (unsigned long)g_dir_size.visited,
+                           (long long)((esp_timer_get_time() - start) / 1000));
+                }
+            }
+
+            hal_sdcard_io_end();
+            g_dir_size.busy = uxQueueMessagesWaiting(g_dir_size.queue) > 0;
+            unsaved = true;
+        }
+        heap_caps_free(req.path);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Public API                                 */
+/* -------------------------------------------------------------------------- */
+
+static void post_request(dir_size_req_type_t type, const char* path);
+
+// SD卡挂载状态变化（在监视任务中调用）
+static void sdcard_event_cb(hal_sdcard_event_t event, uint32_t generation, void* user_data) {
+    (void)generation;
+    (void)user_data;
+    // 卸载开始时扫描会自行失败，卸载完成后再清空
+    if (event == HAL_SDCARD_EVENT_UNMOUNTING) {
+        return;
+    }
+    post_request(DIR_SIZE_REQ_RELOAD, hal_sdcard_get_mount_point());
+}
+
+// 目录内容变化（在变化监视任务中调用）
+static void fs_watch_event_cb(const char* dir_path, bool recursive, void* user_data) {
+    (void)user_data;
+    if (recursive) {
+        // 变化过多、不知道具体目录：只标记失效，界面查看目录时再按需统计，
+        // 不立即重新遍历整个目录树
+        records_invalidate_tree(dir_path);
+    } else {
+        dir_size_invalidate(dir_path);
+    }
+}
+
+bool dir_size_init(void) {
+    if (g_dir_size.queue) {
+        return true;
+    }
+
+    g_dir_size.lock = xSemaphoreCreateMutex();
+    g_dir_size.queue = xQueueCreate(DIR_SIZE_QUEUE_LEN, sizeof(dir_size_req_t));
+    if (!g_dir_size.lock || !g_dir_size.queue) {
+        printf("Failed to create dir size queue\n");
+        return false;
+    }
+
+    if (xTaskCreate(dir_size_task, "dir_size", DIR_SIZE_TASK_STACK, NULL,
+                    DIR_SIZE_TASK_PRIORITY, NULL) != pdPASS) {
+        printf("Failed to create dir size task\n");
+        vQueueDelete(g_dir_size.queue);
+        g_dir_size.queue = NULL;
+        return false;
+    }
+
+    hal_sdcard_add_listener(sdcard_event_cb, NULL);
+    fs_watch_subscribe(fs_watch_event_cb, NULL);
+    printf("Dir size calculator initialized\n");
+    return true;
+}
+
+static void post_request(dir_size_req_type_t type, const char* path) {
+    if (!g_dir_size.queue || !path) {
+        return;
+    }
+
+    dir_size_req_t req = { .type = type, .path = ds_strdup(path, strlen(path)) };
+    if (!req.path) {
+        return;
+    }
+    if (xQueueSend(g_dir_size.queue, &req, 0) != pdTRUE) {
+        printf("Dir size queue full, dropping %s\n", path);
+        heap_caps_free(req.path);
+        return;
+    }
+    g_dir_size.busy = true;
+}
+
+void dir_size_request(const char* path, bool force) {
+    post_request(force ? DIR_SIZE_REQ_SCAN_FORCE : DIR_SIZE_REQ_SCAN, path);
+}
+
+void dir_size_invalidate(const char* path) {
+    if (!g_dir_size.lock || !path) {
+        return;
+    }
+
+    xSemaphoreTake(g_dir_size.lock, portMAX_DELAY);
+    dir_record_t* record = record_find(path);
+    if (record) {
+        record->flags |= RECORD_FLAG_DIRTY;
+    }
+    xSemaphoreGive(g_dir_size.lock);
+
+    post_request(DIR_SIZE_REQ_UPDATE, path);
+}
+
+bool dir_size_get(const char* path, dir_size_info_t* info) {
+    if (!g_dir_size.lock || !path || !info) {
+        return false;
+    }
+
+    xSemaphoreTake(g_dir_size.lock, portMAX_DELAY);
+    dir_record_t* record = record_find(path);
+    if (record) {
+        info->total_bytes = record->total_bytes;
+        info->own_bytes = record->own_bytes;
+        info->total_files = record->total_files;
+        info->total_dirs = record->total_dirs;
+        info->pending = (record->flags & RECORD_FLAG_DIRTY) != 0;
+    }
+    xSemaphoreGive(g_dir_size.lock);
+    return record != NULL;
+}
+
+bool dir_size_is_busy(void) {
+    return g_dir_size.busy;
+}
+
+uint32_t dir_size_get_generation(void) {
+    return g_dir_size.generation;
+}
@@ -0,0 +1,70 @@
+#ifndef DIR_SIZE_H
+#define DIR_SIZE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 目录大小信息（递归统计）
+typedef struct {
+    uint64_t total_bytes;     // 目录下所有文件的总大小
+    uint64_t own_bytes;       // 直接包含的文件大小（不含子目录）
+    uint32_t total_files;     // 文件总数
+    uint32_t total_dirs;      // 子目录总数
+    bool pending;             // 已失效，等待或正在后台重新计算
+} dir_size_info_t;
+
+/**
+ * @brief 初始化目录大小统计（创建低优先级后台任务，加载SD卡上保存的结果）
+ *
+ * 保存的结果可能已过时（卡在别处被修改过），加载后标记为失效，见dir_size_request。
+ *
+ * 可重复调用，已初始化时直接返回true。
+ */
+bool dir_size_init(void);
+
+/**
+ * @brief 请求后台统计目录树
+ *
+ * 失效（pending）的记录不会自动重新统计：从卡上加载的结果，以及变化监视报告
+ * 整个目录树可能变化时（变化过多无法逐个记录）该目录树下的记录和各级上级。
+ * 查看目录时以force=false调用，只重新统计失效的部分。
+ *
+ * @param path 目录路径
+ * @param force 为true时忽略缓存重新遍历整个目录树
+ */
+void dir_size_request(const char* path, bool force);
+
+/**
+ * @brief 查询缓存的目录大小（不访问SD卡，可在UI线程调用）
+ *
+ * @return 有缓存结果时返回true
+ */
+bool dir_size_get(const char* path, dir_size_info_t* info);
+
+/**
+ * @brief 目录内容变化后调用：后台重新统计该目录，并把差值增量更新到各级上级目录
+ *
+ * FAT在目录内容变化时通常不会更新目录自身的修改时间，
+ * 因此本机修改文件后必须显式调用。
+ */
+void dir_size_invalidate(const char* path);
+
+/**
+ * @brief 后台任务是否正在统计
+ */
+bool dir_size_is_busy(void);
+
+/**
+ * @brief 结果变化计数，界面可据此判断是否需要刷新
+ */
+uint32_t dir_size_get_generation(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DIR_SIZE_H
@@ -0,0 +1,1086 @@
+#include "dup_finder.h"
+#include "io_sched.h"
+#include "hal_sdcard.h"
+#include "sd_selftest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <mbedtls/sha256.h>
+
+// 配置
+#define DUP_MAX_PATH            512
+#define DUP_HASH_SIZE           16              // 保留SHA-256的前128位
+#define DUP_PARTIAL_BLOCK       4096            // 首尾各哈希一个数据块
+#define DUP_BUFFER_SIZE         (32 * 1024)     // 全文哈希时的读取块
+#define DUP_BUFFER_MIN          (8 * 1024)
+#define DUP_BUFFER_ALIGN        64              // 缓存行对齐，避免SDMMC驱动使用中转缓冲
+#define DUP_YIELD_BYTES         (128 * 1024)    // 每读取128KB让出一次SD卡
+#define DUP_TASK_STACK          6144
+#define DUP_TASK_PRIORITY       (tskIDLE_PRIORITY + 1)  // 低于音频和LVGL任务
+
+// 持久化文件（位于SD卡隐藏目录）
+#define DUP_CACHE_DIR           ".imos"
+#define DUP_CACHE_FILE          "duphash.bin"
+#define DUP_CACHE_TMP           "duphash.tmp"
+#define DUP_CACHE_MAGIC         0x31505544      // "DUP1"
+#define DUP_CACHE_VERSION       1
+
+// 文件标志
+#define FILE_FLAG_PARTIAL       (1 << 0)        // partial有效
+#define FILE_FLAG_FULL          (1 << 1)        // full有效
+#define FILE_FLAG_SEEN          (1 << 2)        // 缓存记录已被本次遍历到的文件取代
+#define FILE_FLAG_ERROR         (1 << 3)        // 读取失败，不参与比较
+
+typedef struct {
+    uint32_t path_offset;
+    uint32_t size;
+    uint32_t mtime;
+    uint8_t flags;
+    uint8_t partial[DUP_HASH_SIZE];     // 首尾数据块的哈希（小文件等于full）
+    uint8_t full[DUP_HASH_SIZE];        // 全部内容的哈希
+} dup_file_t;
+
+// 文件表：条目数组 + 完整路径池
+typedef struct {
+    dup_file_t* files;
+    uint32_t count;
+    uint32_t capacity;
+    char* paths;
+    uint32_t paths_used;
+    uint32_t paths_capacity;
+    int32_t* index;                     // 路径哈希表（只用于缓存）
+    uint32_t index_size;
+} file_table_t;
+
+// 持久化格式
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+} dup_cache_header_t;
+
+typedef struct {
+    uint32_t size;
+    uint32_t mtime;
+    uint8_t flags;
+    uint8_t reserved;
+    uint16_t path_len;
+    uint8_t partial[DUP_HASH_SIZE];
+    uint8_t full[DUP_HASH_SIZE];
+} dup_cache_record_t;
+
+// 任务描述
+typedef struct {
+    char root[DUP_MAX_PATH];
+    char path[DUP_MAX_PATH];            // 递归时复用的路径
+    uint32_t min_size;
+    file_table_t files;                 // 本次遍历到的文件
+    file_table_t cache;                 // 上次保存的哈希
+    uint32_t* order;                    // 排序后的文件下标
+    uint8_t* buffer;
+    size_t buffer_size;
+    uint32_t bytes_since_yield;
+} dup_job_t;
+
+// 全局状态
+static struct {
+    SemaphoreHandle_t lock;             // 保护progress和results
+    dup_finder_progress_t progress;
+    bool has_progress;
+    int64_t start_time;
+    file_listing_t* results;
+    volatile bool busy;
+    volatile bool cancel_requested;
+} g_dup = {0};
+
+// qsort比较函数使用的文件表
+static const file_table_t* s_sort_table = NULL;
+
+/* -------------------------------------------------------------------------- */
+/*                                 File Table                                 */
+/* -------------------------------------------------------------------------- */
+
+static void* dup_realloc(void* ptr, size_t size) {
+    void* new_ptr = heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM);
+    if (!new_ptr) {
+        new_ptr = heap_caps_realloc(ptr, size, MALLOC_CAP_DEFAULT);
+    }
+    return new_ptr;
+}
+
+static void table_free(file_table_t* table) {
+    heap_caps_free(table->files);
+    heap_caps_free(table->paths);
+    heap_caps_free(table->index);
+    memset(table, 0, sizeof(file_table_t));
+}
+
+static dup_file_t* table_add(file_table_t* table, const char* path, size_t path_len, uint32_t size, uint32_t mtime) {
+    if (table->count == table->capacity) {
+        uint32_t capacity = table->capacity ? table->capacity * 2 : 256;
+        dup_file_t* files = dup_realloc(table->files, capacity * sizeof(dup_file_t));
+        if (!files) {
+            return NULL;
+        }
+        table->files = files;
+        table->capacity = capacity;
+    }
+    if (table->paths_used + path_len + 1 > table->paths_capacity) {
+        uint32_t capacity = table->paths_capacity ? table->paths_capacity : 16384;
+        while (capacity < table->paths_used + path_len + 1) {
+            capacity *= 2;
+        }
+        char* paths = dup_realloc(table->paths, capacity);
+        if (!paths) {
+            return NULL;
+        }
+        table->paths = paths;
+        table->paths_capacity = capacity;
+    }
+
+    dup_file_t* file = &table->files[table->count++];
+    memset(file, 0, sizeof(dup_file_t));
+    file->path_offset = table->paths_used;
+    file->size = size;
+    file->mtime = mtime;
+    memcpy(table->paths + table->paths_used, path, path_len);
+    table->paths[table->paths_used + path_len] = '\0';
+    table->paths_used += (uint32_t)path_len + 1;
+    return file;
+}
+
+static inline const char* table_path(const file_table_t* table, const dup_file_t* file) {
+    return table->paths + file->path_offset;
+}
+
+static uint32_t hash_path(const char* path) {
+    uint32_t hash = 2166136261u;
+    while (*path) {
+        hash = (hash ^ (uint8_t)*path++) * 16777619u;
+    }
+    return hash;
+}
+
+static bool table_build_index(file_table_t* table) {
+    uint32_t size = 64;
+    while (size < table->count * 2) {
+        size *= 2;
+    }
+    table->index = dup_realloc(NULL, size * sizeof(int32_t));
+    if (!table->index) {
+        return false;
+    }
+    memset(table->index, 0xFF, size * sizeof(int32_t));
+    table->index_size = size;
+
+    uint32_t mask = size - 1;
+    for (uint32_t i = 0; i < table->count; i++) {
+        uint32_t slot = hash_path(table_path(table, &table->files[i])) & mask;
+        while (table->index[slot] >= 0) {
+            slot = (slot + 1) & mask;
+        }
+        table->index[slot] = (int32_t)i;
+    }
+    return true;
+}
+
+static dup_file_t* table_find(const file_table_t* table, const char* path) {
+    if (!table->index) {
+        return NULL;
+    }
+    uint32_t mask = table->index_size - 1;
+    for (uint32_t slot = hash_path(path) & mask; table->index[slot] >= 0; slot = (slot + 1) & mask) {
+        dup_file_t* file = &table->files[table->index[slot]];
+        if (strcmp(table_path(table, file), path) == 0) {
+            return file;
+        }
+    }
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                Persistence                                 */
+/* -------------------------------------------------------------------------- */
+
+static bool build_cache_path(char* buffer, size_t size, const char* file_name) {
+    const char* mount_point = hal_sdcard_get_mount_point();
+    int len = snprintf(buffer, size, "%s/%s/%s", mount_point, DUP_CACHE_DIR, file_name);
+    return len > 0 && (size_t)len < size;
+}
+
+static void load_cache(file_table_t* cache) {
+    char cache_path[128];
+    if (!build_cache_path(cache_path, sizeof(cache_path), DUP_CACHE_FILE)) {
+        return;
+    }
+
+    FILE* fp = fopen(cache_path, "rb");
+    if (!fp) {
+        return;
+    }
+    setvbuf(fp, NULL, _IOFBF, 8192);
+
+    dup_cache_header_t header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        header.magic != DUP_CACHE_MAGIC || header.version != DUP_CACHE_VERSION) {
+        printf("Dup finder cache invalid, ignoring\n");
+        fclose(fp);
+        return;
+    }
+
+    char path[DUP_MAX_PATH];
+    for (uint32_t i = 0; i < header.count; i++) {
+        dup_cache_record_t disk;
+        if (fread(&disk, sizeof(disk), 1, fp) != 1 || disk.path_len >= sizeof(path) ||
+            fread(path, 1, disk.path_len, fp) != disk.path_len) {
+            break;
+        }
+        dup_file_t* file = table_add(cache, path, disk.path_len, disk.size, disk.mtime);
+        if (!file) {
+            break;
+        }
+        file->flags = disk.flags & (FILE_FLAG_PARTIAL | FILE_FLAG_FULL);
+        memcpy(file->partial, disk.partial, DUP_HASH_SIZE);
+        memcpy(file->full, disk.full, DUP_HASH_SIZE);
+    }
+    fclose(fp);
+
+    if (!table_build_index(cache)) {
+        table_free(cache);
+    }
+}
+
+static bool path_in_root(const char* path, const char* root, size_t root_len) {
+    return strncmp(path, root, root_len) == 0 && (path[root_len] == '/' || path[root_len] == '\0');
+}
+
+// 查找目录内是否有缓存记录对应的文件已删除
+static bool has_stale_records(const dup_job_t* job) {
+    size_t root_len = strlen(job->root);
+    for (uint32_t i = 0; i < job->cache.count; i++) {
+        const dup_file_t* file = &job->cache.files[i];
+        if (!(file->flags & FILE_FLAG_SEEN) && path_in_root(table_path(&job->cache, file), job->root, root_len)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool append_record(uint8_t** blob, size_t* size, size_t* capacity, const file_table_t* table, const dup_file_t* file) {
+    const char* path = table_path(table, file);
+    dup_cache_record_t disk = {
+        .size = file->size,
+        .mtime = file->mtime,
+        .flags = (uint8_t)(file->flags & (FILE_FLAG_PARTIAL | FILE_FLAG_FULL)),
+        .path_len = (uint16_t)strlen(path),
+    };
+    memcpy(disk.partial, file->partial, DUP_HASH_SIZE);
+    memcpy(disk.full, file->full, DUP_HASH_SIZE);
+
+    size_t needed = *size + sizeof(disk) + disk.path_len;
+    if (needed > *capacity) {
+        size_t new_capacity = *capacity * 2;
+        while (new_capacity < needed) {
+            new_capacity *= 2;
+        }
+        uint8_t* new_blob = dup_realloc(*blob, new_capacity);
+        if (!new_blob) {
+            return false;
+        }
+        *blob = new_blob;
+        *capacity = new_capacity;
+    }
+    memcpy(*blob + *size, &disk, sizeof(disk));
+    memcpy(*blob + *size + sizeof(disk), path, disk.path_len);
+    *size = needed;
+    return true;
+}
+
+// 保存：本次遍历到且有哈希的文件 + 查找目录之外的旧记录（目录内未遍历到的已删除）
+static void save_cache(dup_job_t* job) {
+    char cache_path[128], tmp_path[128], dir_path[128];
+    if (!build_cache_path(cache_path, sizeof(cache_path), DUP_CACHE_FILE) ||
+        !build_cache_path(tmp_path, sizeof(tmp_path), DUP_CACHE_TMP)) {
+        return;
+    }
+    snprintf(dir_path, sizeof(dir_path), "%s/%s", hal_sdcard_get_mount_point(), DUP_CACHE_DIR);
+    if (mkdir(dir_path, 0777) != 0 && errno != EEXIST) {
+        return;
+    }
+
+    size_t capacity = 16384;
+    size_t size = sizeof(dup_cache_header_t);
+    uint8_t* blob = dup_realloc(NULL, capacity);
+    dup_cache_header_t header = { DUP_CACHE_MAGIC, DUP_CACHE_VERSION, 0 };
+    bool ok = blob != NULL;
+
+    size_t root_len = strlen(job->root);
+    for (uint32_t i = 0; ok && i < job->cache.count; i++) {
+        const dup_file_t* file = &job->cache.files[i];
+        if (!(file->flags & FILE_FLAG_SEEN) && !path_in_root(table_path(&job->cache, file), job->root, root_len)) {
+            ok = append_record(&blob, &size, &capacity, &job->cache, file);
+            header.count++;
+        }
+    }
+    for (uint32_t i = 0; ok && i < job->files.count; i++) {
+        const dup_file_t* file = &job->files.files[i];
+        if ((file->flags & (FILE_FLAG_PARTIAL | FILE_FLAG_FULL)) && !(file->flags & FILE_FLAG_ERROR)) {
+            ok = append_record(&blob, &size, &capacity, &job->files, file);
+            header.count++;
+        }
+    }
+    if (!ok) {
+        heap_caps_free(blob);
+        return;
+    }
+    memcpy(blob, &header, sizeof(header));
+
+    // 先写临时文件再替换，避免掉电时留下损坏的缓存
+    FILE* fp = fopen(tmp_path, "wb");
+    ok = false;
+    if (fp) {
+        ok = fwrite(blob, 1, size, fp) == size;
+        ok = (fclose(fp) == 0) && ok;
+    }
+    heap_caps_free(blob);
+
+    if (ok) {
+        unlink(cache_path);
+        ok = rename(tmp_path, cache_path) == 0;
+    }
+    printf("Dup finder cache %s: %lu records, %zu bytes\n", ok ? "saved" : "save failed",
+           (unsigned long)header.count, size);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Progress                                  */
+/* -------------------------------------------------------------------------- */
+
+static void progress_lock(void) {
+    xSemaphoreTake(g_dup.lock, portMAX_DELAY);
+}
+
+static void progress_unlock(void) {
+    xSemaphoreGive(g_dup.lock);
+}
+
+static void progress_set_current(const char* path) {
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    progress_lock();
+    strncpy(g_dup.progress.current, name, sizeof(g_dup.progress.current) - 1);
+    g_dup.progress.current[sizeof(g_dup.progress.current) - 1] = '\0';
+    progress_unlock();
+}
+
+static void progress_set_error(const char* what, const char* path) {
+    printf("Dup finder error: %s %s (errno %d)\n", what, path, errno);
+
+    progress_lock();
+    if (g_dup.progress.error[0] == '\0') {
+        const char* name = strrchr(path, '/');
+        snprintf(g_dup.progress.error, sizeof(g_dup.progress.error), "%s: %s",
+                 what, name ? name + 1 : path);
+    }
+    progress_unlock();
+}
+
+static void progress_set_stage(dup_finder_stage_t stage) {
+    progress_lock();
+    g_dup.progress.stage = stage;
+    progress_unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    Scan                                    */
+/* -------------------------------------------------------------------------- */
+
+typedef struct {
+    file_listing_t* listing;
+    bool failed;
+} collect_ctx_t;
+
+static bool collect_entry_cb(const hal_sdcard_entry_t* entry, void* user_data) {
+    collect_ctx_t* ctx = (collect_ctx_t*)user_data;
+    if (!file_listing_add(ctx->listing, entry->name,
+                          entry->is_dir ? FILE_TYPE_DIRECTORY : FILE_TYPE_FILE,
+                          (uint32_t)entry->size, entry->mtime)) {
+        ctx->failed = true;
+        return false;
+    }
+    return true;
+}
+
+// 记录文件；路径、大小和修改时间与缓存一致时直接沿用缓存的哈希
+static bool add_file(dup_job_t* job, uint32_t size, uint32_t mtime) {
+    dup_file_t* file = table_add(&job->files, job->path, strlen(job->path), size, mtime);
+    if (!file) {
+        progress_set_error("内存不足", job->path);
+        return false;
+    }
+
+    dup_file_t* cached = table_find(&job->cache, job->path);
+    if (cached) {
+        cached->flags |= FILE_FLAG_SEEN;
+        if (cached->size == size && cached->mtime == mtime) {
+            file->flags = cached->flags & (FILE_FLAG_PARTIAL | FILE_FLAG_FULL);
+            memcpy(file->partial, cached->partial, DUP_HASH_SIZE);
+            memcpy(file->full, cached->full, DUP_HASH_SIZE);
+        }
+    }
+
+    progress_lock();
+    if (file->flags) {
+        g_dup.progress.cache_hits++;
+    }
+    g_dup.progress.files_scanned++;
+    g_dup.progress.bytes_total += size;
+    progress_unlock();
+    return true;
+}
+
+// 递归遍历job->path
+static bool scan_dir(dup_job_t* job) {
+    collect_ctx_t ctx = { .listing = file_listing_create(job->path), .failed = false };
+    if (!ctx.listing) {
+        return false;
+    }
+    if (hal_sdcard_list_dir(job->path, NULL, HAL_SDCARD_LIST_SKIP_HIDDEN, collect_entry_cb, &ctx) < 0 || ctx.failed) {
+        progress_set_error("无法读取目录", job->path);
+        file_listing_free(ctx.listing);
+        return true;
+    }
+    progress_set_current(job->path);
+
+    bool ok = true;
+    size_t len = strlen(job->path);
+    for (uint32_t i = 0; ok && i < ctx.listing->count && !g_dup.cancel_requested; i++) {
+        const file_entry_t* entry = &ctx.listing->entries[i];
+        const char* name = file_listing_name(ctx.listing, i);
+        if (len + 1 + strlen(name) >= sizeof(job->path)) {
+            continue;
+        }
+        job->path[len] = '/';
+        strcpy(job->path + len + 1, name);
+
+        if (entry->type == FILE_TYPE_DIRECTORY) {
+            ok = scan_dir(job);
+        } else if (entry->size > 0 && entry->size >= job->min_size) {
+            ok = add_file(job, entry->size, entry->modified_time);
+        }
+        job->path[len] = '\0';
+    }
+
+    file_listing_free(ctx.listing);
+    return ok && !g_dup.cancel_requested;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Hashing                                  */
+/* -------------------------------------------------------------------------- */
+
+// 读取[offset, offset + len)并加入哈希
+static bool hash_range(dup_job_t* job, int fd, mbedtls_sha256_context* sha, uint32_t offset, uint32_t len) {
+    while (len > 0 && !g_dup.cancel_requested) {
+        size_t chunk = len < job->buffer_size ? len : job->buffer_size;
+        ssize_t n = io_sched_read(fd, offset, job->buffer, chunk, IO_CLASS_BACKGROUND);
+        if (n <= 0) {
+            return false;
+        }
+        mbedtls_sha256_update(sha, job->buffer, (size_t)n);
+        offset += (uint32_t)n;
+        len -= (uint32_t)n;
+
+        progress_lock();
+        g_dup.progress.bytes_read += (size_t)n;
+        progress_unlock();
+
+        // 定期让出，音频等任务可以及时取得SD卡
+        job->bytes_since_yield += (uint32_t)n;
+        if (job->bytes_since_yield >= DUP_YIELD_BYTES) {
+            job->bytes_since_yield = 0;
+            vTaskDelay(1);
+        }
+    }
+    return len == 0;
+}
+
+// 计算首尾块哈希（full为false）或全文哈希；不超过两个数据块的文件直接计算全文哈希
+static void hash_file(dup_job_t* job, dup_file_t* file, bool full) {
+    const char* path = table_path(&job->files, file);
+    progress_set_current(path);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        progress_set_error("无法打开", path);
+        file->flags |= FILE_FLAG_ERROR;
+        return;
+    }
+
+    bool whole = full || file->size <= 2 * DUP_PARTIAL_BLOCK;
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+
+    bool ok;
+    if (whole) {
+        ok = hash_range(job, fd, &sha, 0, file->size);
+    } else {
+        ok = hash_range(job, fd, &sha, 0, DUP_PARTIAL_BLOCK) &&
+             hash_range(job, fd, &sha, file->size - DUP_PARTIAL_BLOCK, DUP_PARTIAL_BLOCK);
+    }
+    close(fd);
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&sha, digest);
+    mbedtls_sha256_free(&sha);
+
+    if (!ok) {
+        if (!g_dup.cancel_requested) {
+            progress_set_error("读取失败", path);
+            file->flags |= FILE_FLAG_ERROR;
+        }
+        return;
+    }
+
+    if (whole) {
+        memcpy(file->full, digest, DUP_HASH_SIZE);
+        memcpy(file->partial, digest, DUP_HASH_SIZE);
+        file->flags |= FILE_FLAG_FULL | FILE_FLAG_PARTIAL;
+    } else {
+        memcpy(file->partial, digest, DUP_HASH_SIZE);
+        file->flags |= FILE_FLAG_PARTIAL;
+    }
+
+    progress_lock();
+    g_dup.progress.files_hashed++;
+    progress_unlock();
+}
+
+// 确保文件具有所需的哈希，已有（含缓存）时不读卡
+static void ensure_hash(dup_job_t* job, dup_file_t* file, bool full) {
+    uint8_t needed = full ? FILE_FLAG_FULL : FILE_FLAG_PARTIAL;
+    if (!(file->flags & (needed | FILE_FLAG_ERROR))) {
+        hash_file(job, file, full);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Grouping                                  */
+/* -------------------------------------------------------------------------- */
+
+static int compare_size(const void* a, const void* b) {
+    const dup_file_t* fa = &s_sort_table->files[*(const uint32_t*)a];
+    const dup_file_t* fb = &s_sort_table->files[*(const uint32_t*)b];
+    if (fa->size != fb->size) {
+        return fa->size < fb->size ? -1 : 1;
+    }
+    return strcmp(s_sort_table->paths + fa->path_offset, s_sort_table->paths + fb->path_offset);
+}
+
+// 出错和缺少哈希的文件排在最后
+static int compare_hash(const dup_file_t* fa, const dup_file_t* fb, uint8_t flag, size_t offset) {
+    bool va = (fa->flags & flag) && !(fa->flags & FILE_FLAG_ERROR);
+    bool vb = (fb->flags & flag) && !(fb->flags & FILE_FLAG_ERROR);
+    if (va != vb) {
+        return va ? -1 : 1;
+    }
+    int result = va ? memcmp((const uint8_t*)fa + offset, (const uint8_t*)fb + offset, DUP_HASH_SIZE) : 0;
+    if (result != 0) {
+        return result;
+    }
+    return strcmp(s_sort_table->paths + fa->path_offset, s_sort_table->paths + fb->path_offset);
+}
+
+static int compare_partial(const void* a, const void* b) {
+    return compare_hash(&s_sort_table->files[*(const uint32_t*)a], &s_sort_table->files[*(const uint32_t*)b],
+                        FILE_FLAG_PARTIAL, offsetof(dup_file_t, partial));
+}
+
+static int compare_full(const void* a, const void* b) {
+    return compare_hash(&s_sort_table->files[*(const uint32_t*)a], &s_sort_table->files[*(const uint32_t*)b],
+                        FILE_FLAG_FULL, offsetof(dup_file_t, full));
+}
+
+// order[start, end)中哈希相同的连续区间长度
+static uint32_t run_length(const dup_job_t* job, uint32_t start, uint32_t end, bool full) {
+    const dup_file_t* first = &job->files.files[job->order[start]];
+    uint8_t flag = full ? FILE_FLAG_FULL : FILE_FLAG_PARTIAL;
+    if (!(first->flags & flag) || (first->flags & FILE_FLAG_ERROR)) {
+        return 1;
+    }
+
+    const uint8_t* hash = full ? first->full : first->partial;
+    uint32_t i = start + 1;
+    while (i < end) {
+        const dup_file_t* file = &job->files.files[job->order[i]];
+        if (!(file->flags & flag) || (file->flags & FILE_FLAG_ERROR) ||
+            memcmp(hash, full ? file->full : file->partial, DUP_HASH_SIZE) != 0) {
+            break;
+        }
+        i++;
+    }
+    return i - start;
+}
+
+static uint32_t size_group_end(const dup_job_t* job, uint32_t start) {
+    uint32_t size = job->files.files[job->order[start]].size;
+    uint32_t end = start + 1;
+    while (end < job->files.count && job->files.files[job->order[end]].size == size) {
+        end++;
+    }
+    return end;
+}
+
+// 重复组
+typedef struct {
+    uint32_t start;                     // order中的起始位置
+    uint32_t count;
+    uint64_t wasted;
+} dup_group_t;
+
+static int compare_group(const void* a, const void* b) {
+    uint64_t wa = ((const dup_group_t*)a)->wasted;
+    uint64_t wb = ((const dup_group_t*)b)->wasted;
+    return (wa < wb) - (wa > wb);
+}
+
+// 分阶段比较：大小 -> 首尾块哈希 -> 全文哈希
+static bool find_duplicates(dup_job_t* job) {
+    uint32_t count = job->files.count;
+    job->order = dup_realloc(NULL, (count ? count : 1) * sizeof(uint32_t));
+    if (!job->order) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        job->order[i] = i;
+    }
+    s_sort_table = &job->files;
+    qsort(job->order, count, sizeof(uint32_t), compare_size);
+
+    // 大小相同的文件：哈希首尾块
+    progress_set_stage(DUP_FINDER_STAGE_PARTIAL);
+    for (uint32_t start = 0; start < count && !g_dup.cancel_requested; ) {
+        uint32_t end = size_group_end(job, start);
+        if (end - start > 1) {
+            progress_lock();
+            g_dup.progress.candidates += end - start;
+            progress_unlock();
+            for (uint32_t i = start; i < end && !g_dup.cancel_requested; i++) {
+                ensure_hash(job, &job->files.files[job->order[i]], false);
+            }
+        }
+        start = end;
+    }
+
+    // 首尾块也相同的文件：哈希全部内容
+    progress_set_stage(DUP_FINDER_STAGE_FULL);
+    for (uint32_t start = 0; start < count && !g_dup.cancel_requested; ) {
+        uint32_t end = size_group_end(job, start);
+        if (end - start > 1) {
+            qsort(job->order + start, end - start, sizeof(uint32_t), compare_partial);
+            for (uint32_t i = start; i < end && !g_dup.cancel_requested; ) {
+                uint32_t run = run_length(job, i, end, false);
+                for (uint32_t j = i; run > 1 && j < i + run && !g_dup.cancel_requested; j++) {
+                    ensure_hash(job, &job->files.files[job->order[j]], true);
+                }
+                i += run;
+            }
+        }
+        start = end;
+    }
+    if (g_dup.cancel_requested) {
+        return true;
+    }
+
+    // 全文哈希相同的文件分组
+    dup_group_t* groups = NULL;
+    uint32_t group_count = 0, group_capacity = 0;
+    uint32_t duplicate_files = 0;
+    uint64_t wasted_bytes = 0;
+    bool ok = true;
+    for (uint32_t start = 0; ok && start < count; ) {
+        uint32_t end = size_group_end(job, start);
+        if (end - start > 1) {
+            qsort(job->order + start, end - start, sizeof(uint32_t), compare_full);
+            for (uint32_t i = start; ok && i < end; ) {
+                uint32_t run = run_length(job, i, end, true);
+                if (run > 1) {
+                    if (group_count == group_capacity) {
+                        group_capacity = group_capacity ? group_capacity * 2 : 32;
+                        dup_group_t* new_groups = dup_realloc(groups, group_capacity * sizeof(dup_group_t));
+                        if (!new_groups) {
+                            ok = false;
+                            break;
+                        }
+                        groups = new_groups;
+                    }
+                    uint64_t wasted = (uint64_t)job->files.files[job->order[i]].size * (run - 1);
+                    groups[group_count++] = (dup_group_t){ i, run, wasted };
+                    duplicate_files += run - 1;
+                    wasted_bytes += wasted;
+                }
+                i += run;
+            }
+        }
+        start = end;
+    }
+
+    // 结果：占用最多的组在前
+    file_listing_t* results = ok ? file_listing_create(job->root) : NULL;
+    if (results) {
+        qsort(groups, group_count, sizeof(dup_group_t), compare_group);
+        for (uint32_t g = 0; ok && g < group_count; g++) {
+            for (uint32_t i = 0; ok && i < groups[g].count; i++) {
+                const dup_file_t* file = &job->files.files[job->order[groups[g].start + i]];
+                ok = file_listing_add(results, table_path(&job->files, file), FILE_TYPE_FILE, file->size, g);
+            }
+        }
+    }
+    heap_caps_free(groups);
+    if (!ok || !results) {
+        if (results) {
+            file_listing_free(results);
+        }
+        progress_set_error("内存不足", job->root);
+        return false;
+    }
+
+    progress_lock();
+    g_dup.progress.groups = group_count;
+    g_dup.progress.duplicate_files = duplicate_files;
+    g_dup.progress.wasted_bytes = wasted_bytes;
+    if (g_dup.results) {
+        file_listing_free(g_dup.results);
+    }
+    g_dup.results = results;
+    progress_unlock();
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    Task                                    */
+/* -------------------------------------------------------------------------- */
+
+static void free_job(dup_job_t* job) {
+    table_free(&job->files);
+    table_free(&job->cache);
+    heap_caps_free(job->order);
+    if (job->buffer) {
+        heap_caps_free(job->buffer);
+    }
+    heap_caps_free(job);
+}
+
+static void dup_task(void* arg) {
+    dup_job_t* job = (dup_job_t*)arg;
+
+    load_cache(&job->cache);
+
+    struct stat st;
+    bool ok = stat(job->root, &st) == 0 && S_ISDIR(st.st_mode);
+    if (!ok) {
+        progress_set_error("路径不存在", job->root);
+    } else {
+        strcpy(job->path, job->root);
+        ok = scan_dir(job) || g_dup.cancel_requested;
+    }
+    ok = ok && !g_dup.cancel_requested && find_duplicates(job);
+
+    // 取消时已计算的哈希同样有效
+    uint32_t files_hashed;
+    progress_lock();
+    files_hashed = g_dup.progress.files_hashed;
+    progress_unlock();
+    if (files_hashed > 0 || (ok && has_stale_records(job))) {
+        save_cache(job);
+    }
+
+    progress_lock();
+    g_dup.progress.elapsed_ms = (uint32_t)((esp_timer_get_time() - g_dup.start_time) / 1000);
+    if (g_dup.progress.elapsed_ms > 0) {
+        g_dup.progress.mb_per_sec = (float)g_dup.progress.bytes_read / 1048576.0f /
+                                    ((float)g_dup.progress.elapsed_ms / 1000.0f);
+    }
+    if (g_dup.cancel_requested) {
+        g_dup.progress.state = DUP_FINDER_STATE_CANCELLED;
+    } else {
+        g_dup.progress.state = ok ? DUP_FINDER_STATE_DONE : DUP_FINDER_STATE_FAILED;
+    }
+    printf("Dup finder finished: state %d, %lu files, %lu groups, read %llu of %llu bytes "
+           "(%lu hashed, %lu cached) in %lu ms\n",
+           g_dup.progress.state,
+           (unsigned long)g_dup.progress.files_scanned,
+           (unsigned long)g_dup.progress.groups,
+           (unsigned long long)g_dup.progress.bytes_read,
+           (unsigned long long)g_dup.progress.bytes_total,
+           (unsigned long)g_dup.progress.files_hashed,
+           (unsigned long)g_dup.progress.cache_hits,
+           (unsigned long)g_dup.progress.elapsed_ms);
+    progress_unlock();
+
+    free_job(job);
+    g_dup.busy = false;
+    vTaskDelete(NULL);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Public API                                 */
+/* -------------------------------------------------------------------------- */
+
+// 分配缓存行对齐的内部RAM DMA缓冲区，内存不足时减小块大小
+static bool alloc_buffer(dup_job_t* job) {
+    for (size_t size = DUP_BUFFER_SIZE; size >= DUP_BUFFER_MIN; size /= 2) {
+        job->buffer = heap_caps_aligned_alloc(DUP_BUFFER_ALIGN, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+        if (job->buffer) {
+            job->buffer_size = size;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool dup_finder_start(const char* root, uint32_t min_size) {
+    if (!root || strlen(root) >= DUP_MAX_PATH) {
+        return false;
+    }
+    if (!hal_sdcard_is_mounted()) {
+        printf("Dup finder: SD card not mounted\n");
+        return false;
+    }
+
+    if (!g_dup.lock) {
+        g_dup.lock = xSemaphoreCreateMutex();
+        if (!g_dup.lock) {
+            return false;
+        }
+    }
+    if (g_dup.busy) {
+        printf("Dup finder: already running\n");
+        return false;
+    }
+
+    dup_job_t* job = dup_realloc(NULL, sizeof(dup_job_t));
+    if (!job) {
+        return false;
+    }
+    memset(job, 0, sizeof(dup_job_t));
+    strcpy(job->root, root);
+    job->min_size = min_size;
+
+    // 去掉末尾的'/'
+    size_t root_len = strlen(job->root);
+    while (root_len > 1 && job->root[root_len - 1] == '/') {
+        job->root[--root_len] = '\0';
+    }
+
+    if (!alloc_buffer(job)) {
+        printf("Dup finder: failed to allocate buffer\n");
+        free_job(job);
+        return false;
+    }
+
+    progress_lock();
+    memset(&g_dup.progress, 0, sizeof(g_dup.progress));
+    g_dup.progress.state = DUP_FINDER_STATE_RUNNING;
+    g_dup.progress.stage = DUP_FINDER_STAGE_SCAN;
+    g_dup.has_progress = true;
+    g_dup.start_time = esp_timer_get_time();
+    if (g_dup.results) {
+        file_listing_free(g_dup.results);
+        g_dup.results = NULL;
+    }
+    progress_unlock();
+
+    g_dup.cancel_requested = false;
+    g_dup.busy = true;
+
+    if (xTaskCreate(dup_task, "dup_finder", DUP_TASK_STACK, job, DUP_TASK_PRIORITY, NULL) != pdPASS) {
+        printf("Dup finder: failed to create task\n");
+        progress_lock();
+        g_dup.progress.state = DUP_FINDER_STATE_FAILED;
+        progress_unlock();
+        free_job(job);
+        g_dup.busy = false;
+        return false;
+    }
+
+    // 任务持有并释放job，这里只用调用者的参数
+    printf("Dup finder started: %s (min size %lu)\n", root, (unsigned long)min_size);
+    return true;
+}
+
+void dup_finder_cancel(void) {
+    if (g_dup.busy) {
+        g_dup.cancel_requested = true;
+    }
+}
+
+bool dup_finder_is_busy(void) {
+    return g_dup.busy;
+}
+
+bool dup_finder_get_progress(dup_finder_progress_t* progress) {
+    if (!progress || !g_dup.lock) {
+        return false;
+    }
+
+    progress_lock();
+    bool has_progress = g_dup.has_progress;
+    if (has_progress) {
+        *progress = g_dup.progress;
+        if (progress->state == DUP_FINDER_STATE_RUNNING) {
+            progress->elapsed_ms = (uint32_t)((esp_timer_get_time() - g_dup.start_time) / 1000);
+            if (progress->elapsed_ms > 0) {
+                progress->mb_per_sec = (float)progress->bytes_read / 1048576.0f /
+                                       ((float)progress->elapsed_ms / 1000.0f);
+            }
+        }
+    }
+    progress_unlock();
+    return has_progress;
+}
+
+file_listing_t* dup_finder_take_results(void) {
+    if (!g_dup.lock) {
+        return NULL;
+    }
+
+    progress_lock();
+    file_listing_t* results = g_dup.results;
+    g_dup.results = NULL;
+    progress_unlock();
+    return results;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Self Test                                  */
+/* -------------------------------------------------------------------------- */
+
+// 测试文件：由种子决定的测试数据，flip_at处的字节取反
+static bool write_test_file(const char* path, uint32_t size, uint8_t seed, int64_t flip_at) {
+    return sd_selftest_write_pattern(path, size, seed) &&
+           (flip_at < 0 || sd_selftest_flip_byte(path, (uint32_t)flip_at));
+}
+
+static bool run_and_wait(const char* root, dup_finder_progress_t* progress) {
+    if (!dup_finder_start(root, 1)) {
+        return false;
+    }
+    while (dup_finder_is_busy()) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    return dup_finder_get_progress(progress) && progress->state == DUP_FINDER_STATE_DONE;
+}
+
+static void print_run(const char* label, const dup_finder_progress_t* progress) {
+    printf("%s: %lu groups, %lu duplicates, read %llu of %llu bytes (%.1f%%), %lu hashed, %lu cached, %lu ms\n",
+           label, (unsigned long)progress->groups, (unsigned long)progress->duplicate_files,
+           (unsigned long long)progress->bytes_read, (unsigned long long)progress->bytes_total,
+           progress->bytes_total > 0 ? (double)progress->bytes_read * 100.0 / (double)progress->bytes_total : 0.0,
+           (unsigned long)progress->files_hashed, (unsigned long)progress->cache_hits,
+           (unsigned long)progress->elapsed_ms);
+}
+
+bool dup_finder_self_test(const char* work_dir, uint32_t file_kb) {
+    if (!work_dir) {
+        return false;
+    }
+    if (file_kb < 16) {
+        file_kb = 16;
+    }
+
+    uint32_t size = file_kb * 1024;
+    const uint32_t small = 1000;
+    printf("Dup finder self test in %s (%lu KB files)\n", work_dir, (unsigned long)file_kb);
+
+    // 期望：a三份为一组，small两份为一组；mid只在中间不同（需全文哈希才能排除），
+    // head开头不同（首尾块哈希即可排除），other大小不同（不读取）
+    struct {
+        const char* name;
+        uint32_t size;
+        uint8_t seed;
+        int64_t flip_at;
+    } files[] = {
+        { "a.bin",          size,     1, -1 },
+        { "a_copy.bin",     size,     1, -1 },
+        { "sub/a_copy.bin", size,     1, -1 },
+        { "mid.bin",        size,     1, size / 2 },
+        { "head.bin",       size,     1, 0 },
+        { "other.bin",      size + 1, 1, -1 },
+        { "small1.txt",     small,    2, -1 },
+        { "sub/small2.txt", small,    2, -1 },
+        { "small3.txt",     small,    3, -1 },
+    };
+    const int file_count = sizeof(files) / sizeof(files[0]);
+
+    char path[DUP_MAX_PATH];
+    snprintf(path, sizeof(path), "%s/sub", work_dir);
+    bool ok = sd_selftest_mkdir(work_dir) && sd_selftest_mkdir(path);
+    for (int i = 0; ok && i < file_count; i++) {
+        snprintf(path, sizeof(path), "%s/%s", work_dir, files[i].name);
+        ok = write_test_file(path, files[i].size, files[i].seed, files[i].flip_at);
+    }
+    if (!ok) {
+        printf("Self test: failed to create files\n");
+    }
+
+    // 首次查找：只读取候选文件的首尾块和最终候选的全文
+    dup_finder_progress_t first, second;
+    ok = ok && run_and_wait(work_dir, &first);
+    file_listing_t* results = ok ? dup_finder_take_results() : NULL;
+    if (ok) {
+        print_run("First run", &first);
+        uint64_t expected_read = 5 * 2 * DUP_PARTIAL_BLOCK + 4 * (uint64_t)size + 3 * small;
+        ok = first.groups == 2 && first.duplicate_files == 3 &&
+             first.wasted_bytes == 2 * (uint64_t)size + small &&
+             first.bytes_read == expected_read &&
+             results && results->count == 5 && results->entries[0].modified_time == 0 &&
+             results->entries[3].modified_time == 1;
+        printf("  naive full hashing would read %llu bytes, staged read %llu (%s)\n",
+               (unsigned long long)first.bytes_total, (unsigned long long)first.bytes_read, ok ? "OK" : "MISMATCH");
+    }
+    if (results) {
+        file_listing_free(results);
+    }
+
+    // 再次查找：文件未变化，全部使用缓存
+    ok = ok && run_and_wait(work_dir, &second);
+    if (ok) {
+        print_run("Cached run", &second);
+        ok = second.groups == 2 && second.bytes_read == 0 && second.files_hashed == 0;
+        printf("  cached rerun: %s\n", ok ? "OK" : "MISMATCH");
+    }
+    results = dup_finder_take_results();
+    if (results) {
+        file_listing_free(results);
+    }
+
+    for (int i = 0; i < file_count; i++) {
+        snprintf(path, sizeof(path), "%s/%s", work_dir, files[i].name);
+        unlink(path);
+    }
+    snprintf(path, sizeof(path), "%s/sub", work_dir);
+    rmdir(path);
+
+    // 目录已清空：再查找一次，从缓存中去掉测试文件的记录
+    dup_finder_progress_t cleanup;
+    run_and_wait(work_dir, &cleanup);
+    results = dup_finder_take_results();
+    if (results) {
+        file_listing_free(results);
+    }
+    rmdir(work_dir);
+    return ok;
+}
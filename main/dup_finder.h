@@ -0,0 +1,101 @@
+#ifndef DUP_FINDER_H
+#define DUP_FINDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "file_listing.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 查重任务状态
+typedef enum {
+    DUP_FINDER_STATE_IDLE,
+    DUP_FINDER_STATE_RUNNING,
+    DUP_FINDER_STATE_DONE,
+    DUP_FINDER_STATE_CANCELLED,
+    DUP_FINDER_STATE_FAILED
+} dup_finder_state_t;
+
+// 查重阶段
+typedef enum {
+    DUP_FINDER_STAGE_SCAN,          // 遍历目录，按大小分组
+    DUP_FINDER_STAGE_PARTIAL,       // 大小相同的文件：哈希首尾数据块
+    DUP_FINDER_STAGE_FULL           // 首尾相同的文件：哈希全部内容
+} dup_finder_stage_t;
+
+// 进度快照
+typedef struct {
+    dup_finder_state_t state;
+    dup_finder_stage_t stage;
+    uint32_t files_scanned;         // 遍历到的文件数
+    uint32_t candidates;            // 与其他文件大小相同的文件数
+    uint32_t files_hashed;          // 读取文件内容计算哈希的次数
+    uint32_t cache_hits;            // 沿用缓存哈希的文件数
+    uint32_t groups;                // 重复文件组数
+    uint32_t duplicate_files;       // 可删除的重复文件数（每组保留一份）
+    uint64_t bytes_total;           // 遍历到的文件总大小
+    uint64_t bytes_read;            // 实际读取的字节数
+    uint64_t wasted_bytes;          // 重复文件占用的空间
+    uint32_t elapsed_ms;            // 已用时间
+    float mb_per_sec;               // 平均读取吞吐量 (MB/s)
+    char current[128];              // 当前文件名
+    char error[128];                // 失败原因
+} dup_finder_progress_t;
+
+/**
+ * @brief 在后台查找目录下的重复文件
+ *
+ * 先按大小分组，只对大小相同的文件哈希首尾数据块，首尾仍相同的再哈希全部内容。
+ * 哈希结果按路径、大小和修改时间缓存到SD卡，再次查找时只读取变化的文件。
+ * 同一时间只允许一个任务。
+ *
+ * @param root 查找目录
+ * @param min_size 忽略小于该大小的文件（空文件总是忽略）
+ * @return 启动成功返回true
+ */
+bool dup_finder_start(const char* root, uint32_t min_size);
+
+/**
+ * @brief 请求取消查找（在下一个数据块边界生效）
+ */
+void dup_finder_cancel(void);
+
+/**
+ * @brief 是否有查找任务正在运行
+ */
+bool dup_finder_is_busy(void);
+
+/**
+ * @brief 获取当前（或最近一次）查找的进度快照，可从任意任务调用
+ *
+ * @return 从未启动过查找时返回false
+ */
+bool dup_finder_get_progress(dup_finder_progress_t* progress);
+
+/**
+ * @brief 取走最近一次完成的查找结果
+ *
+ * 条目名称为完整路径，size为文件大小，modified_time为组号（从0开始）。
+ * 按组排列，占用空间最多的组在前。调用方负责file_listing_free。
+ *
+ * @return 没有结果时返回NULL
+ */
+file_listing_t* dup_finder_take_results(void);
+
+/**
+ * @brief 生成测试文件（完全相同、仅中间不同、仅开头不同、不同大小），
+ *        校验分组结果，并对比首次查找与使用缓存再次查找的读取量
+ *
+ * @param work_dir 临时工作目录（结束时删除）
+ * @param file_kb 测试文件大小（KB）
+ * @return 结果正确返回true
+ */
+bool dup_finder_self_test(const char* work_dir, uint32_t file_kb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DUP_FINDER_H
@@ -0,0 +1,740 @@
+#include "file_grep.h"
+#include "io_sched.h"
+#include "file_listing.h"
+#include "hal_sdcard.h"
+#include "sd_selftest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+// 配置
+#define GREP_MAX_PATH           512
+#define GREP_PATTERN_MAX        64
+#define GREP_BUFFER_SIZE        (32 * 1024)     // 大块读取，FatFS可直接按扇区DMA读
+#define GREP_BUFFER_MIN         (8 * 1024)      // 内存不足时的最小块
+#define GREP_BUFFER_ALIGN       64              // 缓存行对齐，避免SDMMC驱动使用中转缓冲
+#define GREP_YIELD_BYTES        (128 * 1024)    // 每读取128KB让出一次SD卡
+#define GREP_TASK_STACK         6144
+#define GREP_TASK_PRIORITY      (tskIDLE_PRIORITY + 1)  // 低于音频和LVGL任务
+#define GREP_QUEUE_SIZE         64              // 待界面取走的匹配数
+#define GREP_MAX_MATCHES        1000            // 超过后停止搜索
+#define GREP_CONTEXT_BEFORE     32              // 匹配前保留的上下文字节数
+
+// Horspool匹配器
+typedef struct {
+    uint8_t pattern[GREP_PATTERN_MAX];  // 忽略大小写时已转为小写
+    size_t len;
+    bool ignore_case;
+    uint8_t skip[256];                  // 按窗口最后一个字节跳跃的距离
+} grep_matcher_t;
+
+// 任务描述
+typedef struct {
+    grep_matcher_t matcher;
+    char path[GREP_MAX_PATH];           // 递归时复用的路径
+    uint8_t* buffer;
+    size_t buffer_size;
+    uint32_t bytes_since_yield;
+} grep_job_t;
+
+// 全局状态
+static struct {
+    SemaphoreHandle_t lock;             // 保护progress和匹配队列
+    file_grep_progress_t progress;
+    bool has_progress;
+    int64_t start_time;
+    file_grep_match_t* queue;           // 环形队列（PSRAM）
+    uint32_t queue_head;
+    uint32_t queue_count;
+    volatile bool busy;
+    volatile bool cancel_requested;
+} g_grep = {0};
+
+/* -------------------------------------------------------------------------- */
+/*                                  Matcher                                   */
+/* -------------------------------------------------------------------------- */
+
+static inline uint8_t fold(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? (uint8_t)(c + ('a' - 'A')) : c;
+}
+
+static void matcher_init(grep_matcher_t* m, const char* pattern, bool ignore_case) {
+    m->len = strlen(pattern);
+    m->ignore_case = ignore_case;
+    for (size_t i = 0; i < m->len; i++) {
+        m->pattern[i] = ignore_case ? fold((uint8_t)pattern[i]) : (uint8_t)pattern[i];
+    }
+
+    memset(m->skip, (int)m->len, sizeof(m->skip));
+    for (size_t i = 0; i + 1 < m->len; i++) {
+        uint8_t c = m->pattern[i];
+        m->skip[c] = (uint8_t)(m->len - 1 - i);
+        if (ignore_case && c >= 'a' && c <= 'z') {
+            m->skip[c - ('a' - 'A')] = (uint8_t)(m->len - 1 - i);
+        }
+    }
+}
+
+static bool equal_fold(const uint8_t* text, const uint8_t* pattern, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (fold(text[i]) != pattern[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 在text[start, len)中查找，返回匹配起始位置，没有匹配返回SIZE_MAX
+static size_t matcher_find(const grep_matcher_t* m, const uint8_t* text, size_t start, size_t len) {
+    const size_t n = m->len;
+    const uint8_t last = m->pattern[n - 1];
+
+    if (n == 1 && !m->ignore_case) {
+        const uint8_t* hit = memchr(text + start, last, len - start);
+        return hit ? (size_t)(hit - text) : SIZE_MAX;
+    }
+
+    // 比较窗口最后一个字节，不匹配时按跳跃表一次移动多个字节
+    size_t i = start;
+    if (m->ignore_case) {
+        while (i + n <= len) {
+            uint8_t c = text[i + n - 1];
+            if (fold(c) == last && equal_fold(text + i, m->pattern, n - 1)) {
+                return i;
+            }
+            i += m->skip[c];
+        }
+    } else {
+        while (i + n <= len) {
+            uint8_t c = text[i + n - 1];
+            if (c == last && memcmp(text + i, m->pattern, n - 1) == 0) {
+                return i;
+            }
+            i += m->skip[c];
+        }
+    }
+    return SIZE_MAX;
+}
+
+static uint32_t count_newlines(const uint8_t* data, size_t len) {
+    uint32_t count = 0;
+    const uint8_t* end = data + len;
+    while (data < end && (data = memchr(data, '\n', (size_t)(end - data))) != NULL) {
+        count++;
+        data++;
+    }
+    return count;
+}
+
+// 提取匹配所在行的片段（不跨行，首尾对齐到UTF-8字符边界）
+static void extract_context(const uint8_t* buf, size_t len, size_t pos, char* out, size_t out_size) {
+    size_t begin = pos;
+    while (begin > 0 && pos - begin < GREP_CONTEXT_BEFORE && buf[begin - 1] != '\n') {
+        begin--;
+    }
+    while (begin < pos && (buf[begin] & 0xC0) == 0x80) {
+        begin++;
+    }
+
+    size_t end = begin;
+    while (end < len && end - begin < out_size - 1 && buf[end] != '\n') {
+        end++;
+    }
+    // 去掉被截断的多字节字符
+    if (end < len && buf[end] != '\n') {
+        while (end > begin && (buf[end] & 0xC0) == 0x80) {
+            end--;
+        }
+    }
+
+    size_t n = 0;
+    for (size_t i = begin; i < end; i++) {
+        out[n++] = buf[i] < 0x20 ? ' ' : (char)buf[i];
+    }
+    out[n] = '\0';
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Progress                                   */
+/* -------------------------------------------------------------------------- */
+
+static void progress_lock(void) {
+    xSemaphoreTake(g_grep.lock, portMAX_DELAY);
+}
+
+static void progress_unlock(void) {
+    xSemaphoreGive(g_grep.lock);
+}
+
+static void progress_set_current(const char* path) {
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    progress_lock();
+    strncpy(g_grep.progress.current, name, sizeof(g_grep.progress.current) - 1);
+    g_grep.progress.current[sizeof(g_grep.progress.current) - 1] = '\0';
+    progress_unlock();
+}
+
+static void progress_set_error(const char* what, const char* path) {
+    printf("File grep error: %s %s (errno %d)\n", what, path, errno);
+
+    progress_lock();
+    if (g_grep.progress.error[0] == '\0') {
+        const char* name = strrchr(path, '/');
+        snprintf(g_grep.progress.error, sizeof(g_grep.progress.error), "%s: %s",
+                 what, name ? name + 1 : path);
+    }
+    progress_unlock();
+}
+
+// 加入待取队列；队列满时等待界面取走，取消或达到上限时返回false
+static bool push_match(const file_grep_match_t* match) {
+    while (!g_grep.cancel_requested) {
+        progress_lock();
+        if (g_grep.progress.match_count >= GREP_MAX_MATCHES) {
+            g_grep.progress.truncated = true;
+            progress_unlock();
+            return false;
+        }
+        if (g_grep.queue_count < GREP_QUEUE_SIZE) {
+            uint32_t slot = (g_grep.queue_head + g_grep.queue_count) % GREP_QUEUE_SIZE;
+            g_grep.queue[slot] = *match;
+            g_grep.queue_count++;
+            g_grep.progress.match_count++;
+            progress_unlock();
+            return true;
+        }
+        progress_unlock();
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    return false;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Search                                   */
+/* -------------------------------------------------------------------------- */
+
+// 搜索单个文件；返回false表示需要停止整个任务
+static bool grep_file(grep_job_t* job) {
+    progress_set_current(job->path);
+
+    int fd = open(job->path, O_RDONLY);
+    if (fd < 0) {
+        progress_set_error("无法打开", job->path);
+        return true;
+    }
+
+    const grep_matcher_t* m = &job->matcher;
+    uint8_t* buf = job->buffer;
+    size_t carry = 0;           // 上一块末尾保留的字节（匹配可能跨块）
+    uint32_t base = 0;          // buf[0]在文件中的偏移
+    uint32_t line = 1;          // buf[counted]所在行号
+    size_t counted = 0;
+    uint32_t last_line = 0;     // 上次报告的行
+    bool first_block = true;
+    bool matched = false;
+    bool keep_going = true;
+
+    while (keep_going && !g_grep.cancel_requested) {
+        ssize_t n = io_sched_read(fd, IO_SCHED_CURRENT, buf + carry, job->buffer_size - carry, IO_CLASS_BACKGROUND);
+        if (n < 0) {
+            progress_set_error("读取失败", job->path);
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+
+        // 首块含NUL视为二进制文件
+        if (first_block) {
+            first_block = false;
+            if (memchr(buf, 0, (size_t)n)) {
+                progress_lock();
+                g_grep.progress.files_skipped++;
+                g_grep.progress.bytes_scanned += (size_t)n;
+                progress_unlock();
+                close(fd);
+                return true;
+            }
+        }
+
+        size_t len = carry + (size_t)n;
+        size_t pos = 0;
+        while (keep_going && (pos = matcher_find(m, buf, pos, len)) != SIZE_MAX) {
+            line += count_newlines(buf + counted, pos - counted);
+            counted = pos;
+
+            // 同一行只报告一次
+            if (line != last_line) {
+                file_grep_match_t match;
+                strncpy(match.path, job->path, sizeof(match.path) - 1);
+                match.path[sizeof(match.path) - 1] = '\0';
+                match.line = line;
+                match.offset = base + (uint32_t)pos;
+                extract_context(buf, len, pos, match.context, sizeof(match.context));
+
+                keep_going = push_match(&match);
+                last_line = line;
+                matched = true;
+            }
+            pos += m->len;
+        }
+
+        progress_lock();
+        g_grep.progress.bytes_scanned += (size_t)n;
+        progress_unlock();
+
+        // 保留末尾len-1字节与下一块拼接
+        size_t keep = (len < m->len - 1) ? len : m->len - 1;
+        size_t shift = len - keep;
+        if (counted < shift) {
+            line += count_newlines(buf + counted, shift - counted);
+            counted = 0;
+        } else {
+            counted -= shift;
+        }
+        memmove(buf, buf + shift, keep);
+        base += (uint32_t)shift;
+        carry = keep;
+
+        // 定期让出，音频等任务可以及时取得SD卡
+        job->bytes_since_yield += (uint32_t)n;
+        if (job->bytes_since_yield >= GREP_YIELD_BYTES) {
+            job->bytes_since_yield = 0;
+            vTaskDelay(1);
+        }
+    }
+    close(fd);
+
+    progress_lock();
+    g_grep.progress.files_scanned++;
+    if (matched) {
+        g_grep.progress.files_matched++;
+    }
+    progress_unlock();
+
+    return keep_going && !g_grep.cancel_requested;
+}
+
+// 子目录列表收集
+typedef struct {
+    file_listing_t* listing;
+    bool failed;
+} collect_ctx_t;
+
+static bool collect_entry_cb(const hal_sdcard_entry_t* entry, void* user_data) {
+    collect_ctx_t* ctx = (collect_ctx_t*)user_data;
+    if (!file_listing_add(ctx->listing, entry->name,
+                          entry->is_dir ? FILE_TYPE_DIRECTORY : FILE_TYPE_FILE,
+                          (uint32_t)entry->size, entry->mtime)) {
+        ctx->failed = true;
+        return false;
+    }
+    return true;
+}
+
+// 递归搜索job->path
+static bool grep_dir(grep_job_t* job) {
+    collect_ctx_t ctx = { .listing = file_listing_create(job->path), .failed = false };
+    if (!ctx.listing) {
+        return false;
+    }
+    if (hal_sdcard_list_dir(job->path, NULL, HAL_SDCARD_LIST_SKIP_HIDDEN, collect_entry_cb, &ctx) < 0 || ctx.failed) {
+        progress_set_error("无法读取目录", job->path);
+        file_listing_free(ctx.listing);
+        return true;
+    }
+
+    bool ok = true;
+    size_t len = strlen(job->path);
+    for (uint32_t i = 0; ok && i < ctx.listing->count; i++) {
+        const char* name = file_listing_name(ctx.listing, i);
+        if (len + 1 + strlen(name) >= sizeof(job->path)) {
+            continue;
+        }
+        job->path[len] = '/';
+        strcpy(job->path + len + 1, name);
+
+        if (ctx.listing->entries[i].type == FILE_TYPE_DIRECTORY) {
+            ok = grep_dir(job);
+        } else if (ctx.listing->entries[i].size > 0) {
+            ok = grep_file(job);
+        }
+        job->path[len] = '\0';
+    }
+
+    file_listing_free(ctx.listing);
+    return ok && !g_grep.cancel_requested;
+}
+
+static void free_job(grep_job_t* job) {
+    if (job->buffer) {
+        heap_caps_free(job->buffer);
+    }
+    heap_caps_free(job);
+}
+
+static void grep_task(void* arg) {
+    grep_job_t* job = (grep_job_t*)arg;
+
+    struct stat st;
+    if (stat(job->path, &st) != 0) {
+        progress_set_error("路径不存在", job->path);
+    } else if (S_ISDIR(st.st_mode)) {
+        grep_dir(job);
+    } else {
+        grep_file(job);
+    }
+
+    progress_lock();
+    g_grep.progress.elapsed_ms = (uint32_t)((esp_timer_get_time() - g_grep.start_time) / 1000);
+    if (g_grep.progress.elapsed_ms > 0) {
+        g_grep.progress.mb_per_sec = (float)g_grep.progress.bytes_scanned / 1048576.0f /
+                                     ((float)g_grep.progress.elapsed_ms / 1000.0f);
+    }
+    if (g_grep.cancel_requested) {
+        g_grep.progress.state = FILE_GREP_STATE_CANCELLED;
+    } else if (g_grep.progress.files_scanned == 0 && g_grep.progress.error[0] != '\0') {
+        g_grep.progress.state = FILE_GREP_STATE_FAILED;
+    } else {
+        g_grep.progress.state = FILE_GREP_STATE_DONE;
+    }
+    printf("File grep finished: state %d, %lu files, %lu matches, %llu bytes in %lu ms (%.2f MB/s)\n",
+           g_grep.progress.state,
+           (unsigned long)g_grep.progress.files_scanned,
+           (unsigned long)g_grep.progress.match_count,
+           (unsigned long long)g_grep.progress.bytes_scanned,
+           (unsigned long)g_grep.progress.elapsed_ms,
+           g_grep.progress.mb_per_sec);
+    progress_unlock();
+
+    free_job(job);
+    g_grep.busy = false;
+    vTaskDelete(NULL);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Public API                                 */
+/* -------------------------------------------------------------------------- */
+
+// 分配缓存行对齐的内部RAM DMA缓冲区，内存不足时减小块大小
+static bool alloc_buffer(grep_job_t* job) {
+    for (size_t size = GREP_BUFFER_SIZE; size >= GREP_BUFFER_MIN; size /= 2) {
+        job->buffer = heap_caps_aligned_alloc(GREP_BUFFER_ALIGN, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+        if (job->buffer) {
+            job->buffer_size = size;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool file_grep_start(const char* root, const char* pattern, bool ignore_case) {
+    if (!root || !pattern || strlen(root) >= GREP_MAX_PATH) {
+        return false;
+    }
+    size_t pattern_len = strlen(pattern);
+    if (pattern_len == 0 || pattern_len > GREP_PATTERN_MAX) {
+        return false;
+    }
+    if (!hal_sdcard_is_mounted()) {
+        printf("File grep: SD card not mounted\n");
+        return false;
+    }
+
+    if (!g_grep.lock) {
+        g_grep.lock = xSemaphoreCreateMutex();
+        if (!g_grep.lock) {
+            return false;
+        }
+    }
+    if (!g_grep.queue) {
+        g_grep.queue = heap_caps_malloc(GREP_QUEUE_SIZE * sizeof(file_grep_match_t), MALLOC_CAP_SPIRAM);
+        if (!g_grep.queue) {
+            g_grep.queue = malloc(GREP_QUEUE_SIZE * sizeof(file_grep_match_t));
+        }
+        if (!g_grep.queue) {
+            return false;
+        }
+    }
+    if (g_grep.busy) {
+        printf("File grep: another search is running\n");
+        return false;
+    }
+
+    grep_job_t* job = heap_caps_malloc(sizeof(grep_job_t), MALLOC_CAP_SPIRAM);
+    if (!job) {
+        job = malloc(sizeof(grep_job_t));
+    }
+    if (!job) {
+        return false;
+    }
+    memset(job, 0, sizeof(grep_job_t));
+    strcpy(job->path, root);
+    matcher_init(&job->matcher, pattern, ignore_case);
+
+    if (!alloc_buffer(job)) {
+        printf("File grep: failed to allocate buffer\n");
+        free_job(job);
+        return false;
+    }
+
+    progress_lock();
+    memset(&g_grep.progress, 0, sizeof(g_grep.progress));
+    g_grep.progress.state = FILE_GREP_STATE_RUNNING;
+    g_grep.has_progress = true;
+    g_grep.queue_head = 0;
+    g_grep.queue_count = 0;
+    g_grep.start_time = esp_timer_get_time();
+    progress_unlock();
+
+    g_grep.cancel_requested = false;
+    g_grep.busy = true;
+
+    // 任务结束时释放job，创建后不能再访问
+    size_t buffer_size = job->buffer_size;
+    if (xTaskCreate(grep_task, "file_grep", GREP_TASK_STACK, job, GREP_TASK_PRIORITY, NULL) != pdPASS) {
+        printf("File grep: failed to create task\n");
+        progress_lock();
+        g_grep.progress.state = FILE_GREP_STATE_FAILED;
+        progress_unlock();
+        free_job(job);
+        g_grep.busy = false;
+        return false;
+    }
+
+    printf("File grep started: \"%s\" in %s (%zu KB buffer)\n", pattern, root, buffer_size / 1024);
+    return true;
+}
+
+void file_grep_cancel(void) {
+    if (g_grep.busy) {
+        g_grep.cancel_requested = true;
+    }
+}
+
+bool file_grep_is_busy(void) {
+    return g_grep.busy;
+}
+
+bool file_grep_get_progress(file_grep_progress_t* progress) {
+    if (!progress || !g_grep.lock) {
+        return false;
+    }
+
+    progress_lock();
+    bool has_progress = g_grep.has_progress;
+    if (has_progress) {
+        *progress = g_grep.progress;
+        if (progress->state == FILE_GREP_STATE_RUNNING) {
+            progress->elapsed_ms = (uint32_t)((esp_timer_get_time() - g_grep.start_time) / 1000);
+            if (progress->elapsed_ms > 0) {
+                progress->mb_per_sec = (float)progress->bytes_scanned / 1048576.0f /
+                                       ((float)progress->elapsed_ms / 1000.0f);
+            }
+        }
+    }
+    progress_unlock();
+    return has_progress;
+}
+
+uint32_t file_grep_fetch_matches(file_grep_match_t* matches, uint32_t max) {
+    if (!matches || !g_grep.lock || !g_grep.queue) {
+        return 0;
+    }
+
+    progress_lock();
+    uint32_t count = 0;
+    while (count < max && g_grep.queue_count > 0) {
+        matches[count++] = g_grep.queue[g_grep.queue_head];
+        g_grep.queue_head = (g_grep.queue_head + 1) % GREP_QUEUE_SIZE;
+        g_grep.queue_count--;
+    }
+    progress_unlock();
+    return count;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Self Test                                  */
+/* -------------------------------------------------------------------------- */
+
+#define SELF_TEST_NEEDLE        "NEEDLE_42"
+#define SELF_TEST_FILES         4
+
+// 生成语料：普通文本行，每500行插入一次搜索串（交替大小写），
+// 并在首个数据块边界处放一个跨块的搜索串
+static bool write_corpus_file(const char* path, uint32_t size, uint32_t* exact, uint32_t* folded) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        return false;
+    }
+    setvbuf(fp, NULL, _IOFBF, 8 * 1024);
+
+    static const char* words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit"};
+    uint32_t written = 0;
+    uint32_t line = 0;
+    bool boundary_done = false;
+    bool ok = true;
+
+    while (written < size && ok) {
+        char text[160];
+        int len;
+        size_t needle_len = strlen(SELF_TEST_NEEDLE);
+
+        if (!boundary_done && written + 80 >= GREP_BUFFER_SIZE) {
+            // 填充到块边界前4字节，搜索串跨越边界
+            len = (int)(GREP_BUFFER_SIZE - 4 - written);
+            memset(text, 'x', len);
+            memcpy(text + len, SELF_TEST_NEEDLE "\n", needle_len + 1);
+            len += (int)needle_len + 1;
+            (*exact)++;
+            (*folded)++;
+            boundary_done = true;
+        } else if (line % 500 == 250) {
+            bool lower = (line / 500) % 2 == 1;
+            len = snprintf(text, sizeof(text), "%05lu %s %s tail\n", (unsigned long)line,
+                           words[line % 8], lower ? "needle_42" : SELF_TEST_NEEDLE);
+            if (!lower) {
+                (*exact)++;
+            }
+            (*folded)++;
+        } else {
+            len = snprintf(text, sizeof(text), "%05lu %s %s %s %s\n", (unsigned long)line,
+                           words[line % 8], words[(line / 8) % 8], words[(line / 64) % 8], words[(line * 7) % 8]);
+        }
+
+        ok = fwrite(text, 1, len, fp) == (size_t)len;
+        written += (uint32_t)len;
+        line++;
+    }
+
+    ok = (fclose(fp) == 0) && ok;
+    return ok;
+}
+
+// 搜索并取走全部匹配，返回匹配数
+static int run_and_drain(const char* root, const char* pattern, bool ignore_case, file_grep_progress_t* progress) {
+    if (!file_grep_start(root, pattern, ignore_case)) {
+        return -1;
+    }
+
+    file_grep_match_t matches[8];
+    int total = 0;
+    uint32_t n;
+    do {
+        while ((n = file_grep_fetch_matches(matches, 8)) > 0) {
+            total += (int)n;
+        }
+        vTaskDelay(pdMS_TO_TICKS(20));
+    } while (file_grep_is_busy());
+    while ((n = file_grep_fetch_matches(matches, 8)) > 0) {
+        total += (int)n;
+    }
+
+    file_grep_get_progress(progress);
+    return total;
+}
+
+// 内存中对比Horspool与逐字节比较
+static void benchmark_matcher(uint32_t size) {
+    uint8_t* text = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (!text) {
+        return;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        text[i] = (i % 61 == 60) ? '\n' : (uint8_t)('a' + (i * 7) % 26);
+    }
+
+    grep_matcher_t m;
+    matcher_init(&m, SELF_TEST_NEEDLE, false);
+
+    int64_t start = esp_timer_get_time();
+    size_t found = matcher_find(&m, text, 0, size);
+    int64_t horspool_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    size_t naive = SIZE_MAX;
+    for (size_t i = 0; i + m.len <= size; i++) {
+        if (memcmp(text + i, m.pattern, m.len) == 0) {
+            naive = i;
+            break;
+        }
+    }
+    int64_t naive_us = esp_timer_get_time() - start;
+
+    matcher_init(&m, SELF_TEST_NEEDLE, true);
+    start = esp_timer_get_time();
+    matcher_find(&m, text, 0, size);
+    int64_t folded_us = esp_timer_get_time() - start;
+
+    printf("Matcher (%lu KB in PSRAM): horspool %.1f MB/s, ignore-case %.1f MB/s, naive %.1f MB/s%s\n",
+           (unsigned long)(size / 1024),
+           horspool_us > 0 ? (float)size / (float)horspool_us : 0.0f,
+           folded_us > 0 ? (float)size / (float)folded_us : 0.0f,
+           naive_us > 0 ? (float)size / (float)naive_us : 0.0f,
+           found == naive ? "" : " (MISMATCH)");
+    heap_caps_free(text);
+}
+
+bool file_grep_self_test(const char* work_dir, uint32_t corpus_kb) {
+    if (!work_dir || corpus_kb == 0) {
+        return false;
+    }
+
+    printf("File grep self test in %s (%lu KB)\n", work_dir, (unsigned long)corpus_kb);
+    benchmark_matcher(1024 * 1024);
+
+    char path[GREP_MAX_PATH];
+    uint32_t exact = 0, folded = 0;
+    bool ok = sd_selftest_mkdir(work_dir);
+    for (int i = 0; ok && i < SELF_TEST_FILES; i++) {
+        snprintf(path, sizeof(path), "%s/corpus_%d.txt", work_dir, i);
+        ok = write_corpus_file(path, corpus_kb * 1024 / SELF_TEST_FILES, &exact, &folded);
+    }
+
+    // 含搜索串的二进制文件应被跳过
+    snprintf(path, sizeof(path), "%s/binary.bin", work_dir);
+    FILE* fp = ok ? fopen(path, "wb") : NULL;
+    if (fp) {
+        static const char binary[] = "\0\1\2" SELF_TEST_NEEDLE "\0";
+        fwrite(binary, 1, sizeof(binary), fp);
+        fclose(fp);
+    }
+    if (!ok || !fp) {
+        printf("Self test: failed to create corpus\n");
+        return false;
+    }
+
+    file_grep_progress_t progress;
+    int found = run_and_drain(work_dir, SELF_TEST_NEEDLE, false, &progress);
+    bool exact_ok = found == (int)exact && progress.files_skipped == 1;
+    printf("Self test exact: %d/%lu matches, %lu files, %lu skipped, %.2f MB/s %s\n",
+           found, (unsigned long)exact, (unsigned long)progress.files_scanned,
+           (unsigned long)progress.files_skipped, progress.mb_per_sec, exact_ok ? "OK" : "FAILED");
+
+    found = run_and_drain(work_dir, SELF_TEST_NEEDLE, true, &progress);
+    bool folded_ok = found == (int)folded;
+    printf("Self test ignore-case: %d/%lu matches, %.2f MB/s %s\n",
+           found, (unsigned long)folded, progress.mb_per_sec, folded_ok ? "OK" : "FAILED");
+
+    // 清理
+    for (int i = 0; i < SELF_TEST_FILES; i++) {
+        snprintf(path, sizeof(path), "%s/corpus_%d.txt", work_dir, i);
+        unlink(path);
+    }
+    snprintf(path, sizeof(path), "%s/binary.bin", work_dir);
+    unlink(path);
+    rmdir(work_dir);
+
+    return exact_ok && folded_ok;
+}
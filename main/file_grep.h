@@ -0,0 +1,98 @@
+#ifndef FILE_GREP_H
+#define FILE_GREP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 搜索任务状态
+typedef enum {
+    FILE_GREP_STATE_IDLE,
+    FILE_GREP_STATE_RUNNING,
+    FILE_GREP_STATE_DONE,
+    FILE_GREP_STATE_CANCELLED,
+    FILE_GREP_STATE_FAILED
+} file_grep_state_t;
+
+// 一条匹配（同一行只报告第一次出现）
+typedef struct {
+    char path[256];             // 文件完整路径
+    uint32_t line;              // 行号（从1开始）
+    uint32_t offset;            // 匹配在文件中的字节偏移
+    char context[96];           // 匹配所在行的片段（UTF-8，控制字符替换为空格）
+} file_grep_match_t;
+
+// 进度快照
+typedef struct {
+    file_grep_state_t state;
+    uint32_t files_scanned;     // 已搜索的文件数
+    uint32_t files_skipped;     // 跳过的二进制文件数
+    uint32_t files_matched;     // 包含匹配的文件数
+    uint32_t match_count;       // 匹配总数
+    uint64_t bytes_scanned;     // 已读取字节数
+    uint32_t elapsed_ms;        // 已用时间
+    float mb_per_sec;           // 平均吞吐量 (MB/s)
+    bool truncated;             // 匹配数达到上限后停止
+    char current[128];          // 当前文件名
+    char error[128];            // 失败原因
+} file_grep_progress_t;
+
+/**
+ * @brief 在后台递归搜索目录下所有文本文件的内容
+ *
+ * 以大块读取文件，使用Horspool跳跃匹配；含NUL字节的文件视为二进制并跳过。
+ * 任务优先级低于音频播放，每个数据块之间让出CPU。同一时间只允许一个任务。
+ *
+ * @param root 搜索目录（或单个文件）
+ * @param pattern 搜索串（1~64字节）
+ * @param ignore_case 忽略ASCII大小写
+ * @return 启动成功返回true
+ */
+bool file_grep_start(const char* root, const char* pattern, bool ignore_case);
+
+/**
+ * @brief 请求取消搜索（在下一个数据块边界生效）
+ */
+void file_grep_cancel(void);
+
+/**
+ * @brief 是否有搜索正在运行
+ */
+bool file_grep_is_busy(void);
+
+/**
+ * @brief 获取当前（或最近一次）搜索的进度快照，可从任意任务调用
+ *
+ * @return 从未启动过搜索时返回false
+ */
+bool file_grep_get_progress(file_grep_progress_t* progress);
+
+/**
+ * @brief 取出已找到但尚未取走的匹配（按找到的顺序）
+ *
+ * 待取队列满时搜索任务会等待，界面需定期调用。
+ *
+ * @param matches 输出数组
+ * @param max 最多取出的条数
+ * @return 取出的条数
+ */
+uint32_t file_grep_fetch_matches(file_grep_match_t* matches, uint32_t max);
+
+/**
+ * @brief 生成测试语料并搜索，校验匹配数（包括跨数据块的匹配）并打印MB/s，
+ *        同时在内存中对比Horspool与逐字节匹配的速度
+ *
+ * @param work_dir 临时工作目录（结束时删除）
+ * @param corpus_kb 语料总大小（KB）
+ * @return 匹配数正确返回true
+ */
+bool file_grep_self_test(const char* work_dir, uint32_t corpus_kb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FILE_GREP_H
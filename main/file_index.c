@@ -0,0 +1,929 @@
+#include "file_index.h"
+#include "hal_sdcard.h"
+#include "fs_watch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+// 配置
+#define FIDX_MAX_PATH          512
+#define FIDX_TASK_STACK        6144
+#define FIDX_TASK_PRIORITY     (tskIDLE_PRIORITY + 1)
+#define FIDX_DEBOUNCE_MS       1000        // 合并1秒内的多次重建请求
+#define FIDX_MAX_DIRTY         32          // 超出时退化为全量重建
+#define FIDX_YIELD_EVERY       32          // 每读取32个目录让出一次CPU
+#define FIDX_MAX_QUERY         128
+
+// 持久化文件（位于SD卡隐藏目录）
+#define FIDX_CACHE_DIR         ".imos"
+#define FIDX_CACHE_FILE        "fileindex.bin"
+#define FIDX_CACHE_TMP         "fileindex.tmp"
+#define FIDX_MAGIC             0x31584946  // "FIX1"
+#define FIDX_VERSION           1
+
+#define FIDX_NONE              UINT32_MAX
+
+// 索引条目（名称以'\0'结尾保存在名称池中）
+typedef struct {
+    uint32_t name_offset;
+    uint32_t dir;               // 所在目录
+    uint32_t size;
+    uint32_t mtime;
+    uint16_t name_len;
+    uint8_t is_dir;
+    uint8_t reserved;
+} fidx_entry_t;
+
+// 目录（子条目在entries中连续存放）
+typedef struct {
+    uint32_t path_offset;       // 完整路径在路径池中的偏移
+    uint32_t mtime;
+    uint32_t first_entry;
+    uint32_t entry_count;
+} fidx_dir_t;
+
+typedef struct {
+    fidx_entry_t* entries;
+    uint32_t entry_count;
+    uint32_t entry_capacity;
+    fidx_dir_t* dirs;
+    uint32_t dir_count;
+    uint32_t dir_capacity;
+    char* names;
+    uint32_t names_used;
+    uint32_t names_capacity;
+    char* paths;
+    uint32_t paths_used;
+    uint32_t paths_capacity;
+    uint32_t* sorted;           // 按名称（忽略大小写）排序的条目下标
+    int32_t* dir_hash;          // 路径 -> 目录下标，开放寻址
+    uint32_t dir_hash_size;
+} fidx_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t dir_count;
+    uint32_t names_used;
+    uint32_t paths_used;
+    uint32_t build_ms;
+} fidx_file_header_t;
+
+// 全局状态
+static struct {
+    SemaphoreHandle_t lock;             // 保护current和dirty
+    SemaphoreHandle_t wake;             // 唤醒构建任务
+    fidx_t* current;
+    char* dirty[FIDX_MAX_DIRTY];        // 待重新读取的目录
+    uint32_t dirty_count;
+    bool dirty_overflow;
+    volatile bool rebuild_requested;
+    volatile bool force_requested;
+    volatile bool reload_requested;     // SD卡插拔后丢弃索引并从卡上重新加载
+    volatile bool building;
+    volatile uint32_t build_generation;
+    char path[FIDX_MAX_PATH];           // 构建时复用的路径
+    uint32_t dirs_listed;
+    uint32_t dirs_reused;
+    uint32_t build_ms;
+    uint32_t last_query_us;
+} g_fidx = {0};
+
+/* -------------------------------------------------------------------------- */
+/*                                  Storage                                   */
+/* -------------------------------------------------------------------------- */
+
+static void* fidx_realloc(void* ptr, size_t size) {
+    void* new_ptr = heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM);
+    if (!new_ptr) {
+        new_ptr = heap_caps_realloc(ptr, size, MALLOC_CAP_DEFAULT);
+    }
+    return new_ptr;
+}
+
+// 容量不足时按倍数增长
+static bool fidx_reserve(void** ptr, uint32_t* capacity, uint32_t needed, size_t elem_size, uint32_t initial) {
+    if (needed <= *capacity) {
+        return true;
+    }
+
+    uint32_t new_capacity = *capacity ? *capacity : initial;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    void* new_ptr = fidx_realloc(*ptr, (size_t)new_capacity * elem_size);
+    if (!new_ptr) {
+        return false;
+    }
+    *ptr = new_ptr;
+    *capacity = new_capacity;
+    return true;
+}
+
+static void fidx_free(fidx_t* idx) {
+    if (!idx) {
+        return;
+    }
+    heap_caps_free(idx->entries);
+    heap_caps_free(idx->dirs);
+    heap_caps_free(idx->names);
+    heap_caps_free(idx->paths);
+    heap_caps_free(idx->sorted);
+    heap_caps_free(idx->dir_hash);
+    heap_caps_free(idx);
+}
+
+static size_t fidx_memory_usage(const fidx_t* idx) {
+    if (!idx) {
+        return 0;
+    }
+    return sizeof(fidx_t) +
+           (size_t)idx->entry_capacity * sizeof(fidx_entry_t) +
+           (size_t)idx->dir_capacity * sizeof(fidx_dir_t) +
+           idx->names_capacity + idx->paths_capacity +
+           (size_t)idx->entry_count * sizeof(uint32_t) +
+           (size_t)idx->dir_hash_size * sizeof(int32_t);
+}
+
+static uint32_t fidx_add_string(char** arena, uint32_t* used, uint32_t* capacity, const char* str, size_t len) {
+    if (!fidx_reserve((void**)arena, capacity, *used + (uint32_t)len + 1, 1, 64 * 1024)) {
+        return FIDX_NONE;
+    }
+    uint32_t offset = *used;
+    memcpy(*arena + offset, str, len);
+    (*arena)[offset + len] = '\0';
+    *used += (uint32_t)len + 1;
+    return offset;
+}
+
+static bool fidx_add_entry(fidx_t* idx, uint32_t dir, const char* name, size_t name_len,
+                           bool is_dir, uint32_t size, uint32_t mtime) {
+    if (name_len > UINT16_MAX ||
+        !fidx_reserve((void**)&idx->entries, &idx->entry_capacity, idx->entry_count + 1,
+                      sizeof(fidx_entry_t), 1024)) {
+        return false;
+    }
+
+    uint32_t offset = fidx_add_string(&idx->names, &idx->names_used, &idx->names_capacity, name, name_len);
+    if (offset == FIDX_NONE) {
+        return false;
+    }
+
+    fidx_entry_t* entry = &idx->entries[idx->entry_count++];
+    entry->name_offset = offset;
+    entry->dir = dir;
+    entry->size = size;
+    entry->mtime = mtime;
+    entry->name_len = (uint16_t)name_len;
+    entry->is_dir = is_dir ? 1 : 0;
+    entry->reserved = 0;
+    return true;
+}
+
+static uint32_t fidx_add_dir(fidx_t* idx, const char* path, uint32_t mtime) {
+    if (!fidx_reserve((void**)&idx->dirs, &idx->dir_capacity, idx->dir_count + 1, sizeof(fidx_dir_t), 256)) {
+        return FIDX_NONE;
+    }
+
+    uint32_t offset = fidx_add_string(&idx->paths, &idx->paths_used, &idx->paths_capacity, path, strlen(path));
+    if (offset == FIDX_NONE) {
+        return FIDX_NONE;
+    }
+
+    fidx_dir_t* dir = &idx->dirs[idx->dir_count];
+    dir->path_offset = offset;
+    dir->mtime = mtime;
+    dir->first_entry = idx->entry_count;
+    dir->entry_count = 0;
+    return idx->dir_count++;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                             Lookup Structures                              */
+/* -------------------------------------------------------------------------- */
+
+static uint32_t hash_path(const char* path) {
+    uint32_t hash = 2166136261u;
+    while (*path) {
+        hash ^= (uint8_t)*path++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool fidx_build_dir_hash(fidx_t* idx) {
+    uint32_t size = 64;
+    while (size < idx->dir_count * 2) {
+        size *= 2;
+    }
+
+    int32_t* table = fidx_realloc(NULL, size * sizeof(int32_t));
+    if (!table) {
+        return false;
+    }
+    memset(table, 0xFF, size * sizeof(int32_t));
+
+    for (uint32_t i = 0; i < idx->dir_count; i++) {
+        uint32_t slot = hash_path(idx->paths + idx->dirs[i].path_offset) & (size - 1);
+        while (table[slot] >= 0) {
+            slot = (slot + 1) & (size - 1);
+        }
+        table[slot] = (int32_t)i;
+    }
+
+    heap_caps_free(idx->dir_hash);
+    idx->dir_hash = table;
+    idx->dir_hash_size = size;
+    return true;
+}
+
+static uint32_t fidx_find_dir(const fidx_t* idx, const char* path) {
+    if (!idx || !idx->dir_hash) {
+        return FIDX_NONE;
+    }
+
+    uint32_t mask = idx->dir_hash_size - 1;
+    for (uint32_t slot = hash_path(path) & mask; ; slot = (slot + 1) & mask) {
+        int32_t i = idx->dir_hash[slot];
+        if (i < 0) {
+            return FIDX_NONE;
+        }
+        if (strcmp(idx->paths + idx->dirs[i].path_offset, path) == 0) {
+            return (uint32_t)i;
+        }
+    }
+}
+
+static inline uint8_t fold(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? (uint8_t)(c + ('a' - 'A')) : c;
+}
+
+static int fold_compare(const char* a, const char* b) {
+    while (*a && fold((uint8_t)*a) == fold((uint8_t)*b)) {
+        a++;
+        b++;
+    }
+    return (int)fold((uint8_t)*a) - (int)fold((uint8_t)*b);
+}
+
+static const fidx_t* g_sort_index;
+
+static int sort_compare(const void* a, const void* b) {
+    const fidx_entry_t* ea = &g_sort_index->entries[*(const uint32_t*)a];
+    const fidx_entry_t* eb = &g_sort_index->entries[*(const uint32_t*)b];
+    return fold_compare(g_sort_index->names + ea->name_offset, g_sort_index->names + eb->name_offset);
+}
+
+static bool fidx_build_sorted(fidx_t* idx) {
+    heap_caps_free(idx->sorted);
+    idx->sorted = fidx_realloc(NULL, (idx->entry_count ? idx->entry_count : 1) * sizeof(uint32_t));
+    if (!idx->sorted) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < idx->entry_count; i++) {
+        idx->sorted[i] = i;
+    }
+    g_sort_index = idx;
+    qsort(idx->sorted, idx->entry_count, sizeof(uint32_t), sort_compare);
+    g_sort_index = NULL;
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Build                                    */
+/* -------------------------------------------------------------------------- */
+
+typedef struct {
+    fidx_t* idx;
+    uint32_t dir;
+    bool failed;
+} list_ctx_t;
+
+static bool list_entry_cb(const hal_sdcard_entry_t* entry, void* user_data) {
+    list_ctx_t* ctx = (list_ctx_t*)user_data;
+    if (!fidx_add_entry(ctx->idx, ctx->dir, entry->name, strlen(entry->name),
+                        entry->is_dir, (uint32_t)entry->size, entry->mtime)) {
+        ctx->failed = true;
+        return false;
+    }
+    return true;
+}
+
+static bool is_dirty(char** dirty, uint32_t dirty_count, const char* path) {
+    for (uint32_t i = 0; i < dirty_count; i++) {
+        if (strcmp(dirty[i], path) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 递归构建g_fidx.path：修改时间未变且未标记失效的目录直接复用旧索引，不访问SD卡
+static bool build_dir(fidx_t* idx, const fidx_t* old, uint32_t mtime, bool force,
+                      char** dirty, uint32_t dirty_count) {
+    uint32_t dir_id = fidx_add_dir(idx, g_fidx.path, mtime);
+    if (dir_id == FIDX_NONE) {
+        return false;
+    }
+
+    uint32_t old_dir = force ? FIDX_NONE : fidx_find_dir(old, g_fidx.path);
+    if (old_dir != FIDX_NONE && old->dirs[old_dir].mtime == mtime &&
+        !is_dirty(dirty, dirty_count, g_fidx.path)) {
+        const fidx_dir_t* src = &old->dirs[old_dir];
+        for (uint32_t i = src->first_entry; i < src->first_entry + src->entry_count; i++) {
+            const fidx_entry_t* e = &old->entries[i];
+            if (!fidx_add_entry(idx, dir_id, old->names + e->name_offset, e->name_len,
+                                e->is_dir, e->size, e->mtime)) {
+                return false;
+            }
+        }
+        g_fidx.dirs_reused++;
+    } else {
+        list_ctx_t ctx = { .idx = idx, .dir = dir_id, .failed = false };
+        int listed = hal_sdcard_list_dir(g_fidx.path, NULL, HAL_SDCARD_LIST_SKIP_HIDDEN, list_entry_cb, &ctx);
+        // 卸载中途开始时放弃本次构建，不保存不完整的索引
+        if (ctx.failed || (listed < 0 && !hal_sdcard_is_mounted())) {
+            return false;
+        }
+        if (++g_fidx.dirs_listed % FIDX_YIELD_EVERY == 0) {
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+
+    uint32_t first = idx->dirs[dir_id].first_entry;
+    uint32_t count = idx->entry_count - first;
+    idx->dirs[dir_id].entry_count = count;
+
+    // 递归子目录（entries可能在递归中重新分配，每次按下标访问）
+    for (uint32_t i = first; i < first + count; i++) {
+        if (!idx->entries[i].is_dir) {
+            continue;
+        }
+
+        size_t len = strlen(g_fidx.path);
+        uint16_t name_len = idx->entries[i].name_len;
+        if (len + 1 + name_len >= sizeof(g_fidx.path)) {
+            continue;
+        }
+        g_fidx.path[len] = '/';
+        memcpy(g_fidx.path + len + 1, idx->names + idx->entries[i].name_offset, name_len + 1);
+
+        bool ok = build_dir(idx, old, idx->entries[i].mtime, force, dirty, dirty_count);
+        g_fidx.path[len] = '\0';
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t get_dir_mtime(const char* path) {
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        return (uint32_t)st.st_mtime;
+    }
+    return 0;
+}
+
+static fidx_t* build_index(const fidx_t* old, bool force, char** dirty, uint32_t dirty_count) {
+    fidx_t* idx = fidx_realloc(NULL, sizeof(fidx_t));
+    if (!idx) {
+        return NULL;
+    }
+    memset(idx, 0, sizeof(fidx_t));
+
+    const char* root = hal_sdcard_get_mount_point();
+    if (strlen(root) >= sizeof(g_fidx.path)) {
+        fidx_free(idx);
+        return NULL;
+    }
+    strcpy(g_fidx.path, root);
+
+    if (!build_dir(idx, old, get_dir_mtime(root), force, dirty, dirty_count) ||
+        !fidx_build_dir_hash(idx) || !fidx_build_sorted(idx)) {
+        printf("File index build failed (out of memory or card unmounting)\n");
+        fidx_free(idx);
+        return NULL;
+    }
+    return idx;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                Persistence                                 */
+/* -------------------------------------------------------------------------- */
+
+static bool build_cache_path(char* buffer, size_t size, const char* file_name) {
+    int len = snprintf(buffer, size, "%s/%s/%s", hal_sdcard_get_mount_point(), FIDX_CACHE_DIR, file_name);
+    return len > 0 && (size_t)len < size;
+}
+
+static void save_index(const fidx_t* idx) {
+    char cache_path[128], tmp_path[128], dir_path[128];
+    if (!build_cache_path(cache_path, sizeof(cache_path), FIDX_CACHE_FILE) ||
+        !build_cache_path(tmp_path, sizeof(tmp_path), FIDX_CACHE_TMP)) {
+        return;
+    }
+    snprintf(dir_path, sizeof(dir_path), "%s/%s", hal_sdcard_get_mount_point(), FIDX_CACHE_DIR);
+    if (mkdir(dir_path, 0777) != 0 && errno != EEXIST) {
+        return;
+    }
+
+    int64_t start = esp_timer_get_time();
+    FILE* fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        return;
+    }
+    setvbuf(fp, NULL, _IOFBF, 16 * 1024);
+
+    fidx_file_header_t header = {
+        .magic = FIDX_MAGIC,
+        .version = FIDX_VERSION,
+        .entry_count = idx->entry_count,
+        .dir_count = idx->dir_count,
+        .names_used = idx->names_used,
+        .paths_used = idx->paths_used,
+        .build_ms = g_fidx.build_ms,
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(idx->entries, sizeof(fidx_entry_t), idx->entry_count, fp) == idx->entry_count &&
+              fwrite(idx->dirs, sizeof(fidx_dir_t), idx->dir_count, fp) == idx->dir_count &&
+              fwrite(idx->names, 1, idx->names_used, fp) == idx->names_used &&
+              fwrite(idx->paths, 1, idx->paths_used, fp) == idx->paths_used &&
+              fwrite(idx->sorted, sizeof(uint32_t), idx->entry_count, fp) == idx->entry_count;
+    ok = (fclose(fp) == 0) && ok;
+
+    if (ok) {
+        unlink(cache_path);
+        ok = rename(tmp_path, cache_path) == 0;
+    }
+    printf("File index %s (%lld ms)\n", ok ? "saved" : "save failed",
+           (long long)((esp_timer_get_time() - start) / 1000));
+}
+
+static fidx_t* load_index(void) {
+    char cache_path[128];
+    if (!build_cache_path(cache_path, sizeof(cache_path), FIDX_CACHE_FILE)) {
+        return NULL;
+    }
+
+    FILE* fp = fopen(cache_path, "rb");
+    if (!fp) {
+        return NULL;
+    }
+    setvbuf(fp, NULL, _IOFBF, 16 * 1024);
+
+    int64_t start = esp_timer_get_time();
+    fidx_file_header_t header;
+    fidx_t* idx = NULL;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+              header.magic == FIDX_MAGIC && header.version == FIDX_VERSION;
+
+    if (ok) {
+        idx = fidx_realloc(NULL, sizeof(fidx_t));
+        ok = idx != NULL;
+    }
+    if (ok) {
+        memset(idx, 0, sizeof(fidx_t));
+        ok = fidx_reserve((void**)&idx->entries, &idx->entry_capacity, header.entry_count + 1, sizeof(fidx_entry_t), 1024) &&
+             fidx_reserve((void**)&idx->dirs, &idx->dir_capacity, header.dir_count + 1, sizeof(fidx_dir_t), 256) &&
+             fidx_reserve((void**)&idx->names, &idx->names_capacity, header.names_used + 1, 1, 64 * 1024) &&
+             fidx_reserve((void**)&idx->paths, &idx->paths_capacity, header.paths_used + 1, 1, 64 * 1024) &&
+             (idx->sorted = fidx_realloc(NULL, (header.entry_count + 1) * sizeof(uint32_t))) != NULL;
+    }
+    if (ok) {
+        ok = fread(idx->entries, sizeof(fidx_entry_t), header.entry_count, fp) == header.entry_count &&
+             fread(idx->dirs, sizeof(fidx_dir_t), header.dir_count, fp) == header.dir_count &&
+             fread(idx->names, 1, header.names_used, fp) == header.names_used &&
+             fread(idx->paths, 1, header.paths_used, fp) == header.paths_used &&
+             fread(idx->sorted, sizeof(uint32_t), header.entry_count, fp) == header.entry_count;
+    }
+    fclose(fp);
+
+    if (ok) {
+        idx->entry_count = header.entry_count;
+        idx->dir_count = header.dir_count;
+        idx->names_used = header.names_used;
+        idx->paths_used = header.paths_used;
+        ok = fidx_build_dir_hash(idx);
+    }
+    if (!ok) {
+        printf("File index cache invalid, ignoring\n");
+        fidx_free(idx);
+        return NULL;
+    }
+
+    g_fidx.build_ms = header.build_ms;
+    printf("File index loaded: %lu entries, %lu dirs in %lld ms\n",
+           (unsigned long)idx->entry_count, (unsigned long)idx->dir_count,
+           (long long)((esp_timer_get_time() - start) / 1000));
+    return idx;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                Build Task                                  */
+/* -------------------------------------------------------------------------- */
+
+static void file_index_task(void* arg) {
+    (void)arg;
+
+    if (hal_sdcard_io_begin()) {
+        fidx_t* loaded = load_index();
+        hal_sdcard_io_end();
+        if (loaded) {
+            xSemaphoreTake(g_fidx.lock, portMAX_DELAY);
+            g_fidx.current = loaded;
+            g_fidx.build_generation++;
+            xSemaphoreGive(g_fidx.lock);
+        }
+    }
+
+    // 保存的索引只用于立即查询：卡可能在电脑上被修改过，而FAT不会因目录内容变化
+    // 更新目录修改时间，挂载后的第一次构建必须重新读取所有目录
+    g_fidx.force_requested = true;
+    g_fidx.rebuild_requested = true;
+
+    while (true) {
+        if (!g_fidx.rebuild_requested) {
+            xSemaphoreTake(g_fidx.wake, portMAX_DELAY);
+        }
+        vTaskDelay(pdMS_TO_TICKS(FIDX_DEBOUNCE_MS));
+
+        // 取出本次构建的请求，构建期间到达的新请求留给下一轮
+        xSemaphoreTake(g_fidx.lock, portMAX_DELAY);
+        char* dirty[FIDX_MAX_DIRTY];
+        uint32_t dirty_count = g_fidx.dirty_count;
+        memcpy(dirty, g_fidx.dirty, sizeof(dirty));
+        g_fidx.dirty_count = 0;
+        bool force = g_fidx.force_requested || g_fidx.dirty_overflow;
+        g_fidx.force_requested = false;
+        g_fidx.dirty_overflow = false;
+        g_fidx.rebuild_requested = false;
+        bool reload = g_fidx.reload_requested;
+        g_fidx.reload_requested = false;
+        xSemaphoreGive(g_fidx.lock);
+
+        // 卡已更换或拔出：旧索引描述的是另一张卡，不能用于增量比较
+        if (reload) {
+            xSemaphoreTake(g_fidx.lock, portMAX_DELAY);
+            fidx_t* old = g_fidx.current;
+            g_fidx.current = NULL;
+            g_fidx.build_generation++;
+            xSemaphoreGive(g_fidx.lock);
+            fidx_free(old);
+
+            fidx_t* loaded = NULL;
+            if (hal_sdcard_io_begin()) {
+                loaded = load_index();
+                hal_sdcard_io_end();
+            }
+            if (loaded) {
+                xSemaphoreTake(g_fidx.lock, portMAX_DELAY);
+                g_fidx.current = loaded;
+                g_fidx.build_generation++;
+                xSemaphoreGive(g_fidx.lock);
+            }
+        }
+
+        // 构建期间占用SD卡，卸载时等待构建结束（卸载开始后list_dir立即失败）
+        if (hal_sdcard_io_begin()) {
+            g_fidx.building = true;
+            g_fidx.dirs_listed = 0;
+            g_fidx.dirs_reused = 0;
+            int64_t start = esp_timer_get_time();
+
+            // 只有本任务替换current，读取旧索引不需要加锁
+            fidx_t* idx = build_index(g_fidx.current, force, dirty, dirty_count);
+            if (idx) {
+                g_fidx.build_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+
+                xSemaphoreTake(g_fidx.lock, portMAX_DELAY);
+                fidx_t* old = g_fidx.current;
+                g_fidx.current = idx;
+                xSemaphoreGive(g_fidx.lock);
+                fidx_free(old);
+
+                printf("File index built: %lu entries, %lu dirs (%lu listed, %lu reused) in %lu ms, %zu bytes\n",
+                       (unsigned long)idx->entry_count, (unsigned long)idx->dir_count,
+                       (unsigned long)g_fidx.dirs_listed, (unsigned long)g_fidx.dirs_reused,
+                       (unsigned long)g_fidx.build_ms, fidx_memory_usage(idx));
+
+                // 没有目录需要读取时索引内容不变，不必重写
+                if (g_fidx.dirs_listed > 0) {
+                    save_index(idx);
+                }
+            }
+            hal_sdcard_io_end();
+            g_fidx.building = false;
+            g_fidx.build_generation++;
+        }
+
+        for (uint32_t i = 0; i < dirty_count; i++) {
+            heap_caps_free(dirty[i]);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Public API                                 */
+/* -------------------------------------------------------------------------- */
+
+// SD卡挂载状态变化（在监视任务中调用，只设置标志）
+static void sdcard_event_cb(hal_sdcard_event_t event, uint32_t generation, void* user_data) {
+    (void)generation;
+    (void)user_data;
+    // 卸载开始时构建会自行失败，卸载完成后再重新加载
+    if (event == HAL_SDCARD_EVENT_UNMOUNTING) {
+        return;
+    }
+
+    xSemaphoreTake(g_fidx.lock, portMAX_DELAY);
+    g_fidx.reload_requested = true;
+    g_fidx.force_requested = true;
+    g_fidx.rebuild_requested = true;
+    xSemaphoreGive(g_fidx.lock);
+    xSemaphoreGive(g_fidx.wake);
+}
+
+// 目录内容变化（在变化监视任务中调用）
+static void fs_watch_event_cb(const char* dir_path, bool recursive, void* user_data) {
+    (void)user_data;
+    if (recursive) {
+        file_index_rebuild(true);
+    } else {
+        file_index_invalidate(dir_path);
+    }
+}
+
+bool file_index_init(void) {
+    if (g_fidx.lock) {
+        return true;
+    }
+
+    g_fidx.lock = xSemaphoreCreateMutex();
+    g_fidx.wake = xSemaphoreCreateBinary();
+    if (!g_fidx.lock || !g_fidx.wake) {
+        printf("Failed to create file index semaphores\n");
+        return false;
+    }
+
+    if (xTaskCreate(file_index_task, "file_index", FIDX_TASK_STACK, NULL,
+                    FIDX_TASK_PRIORITY, NULL) != pdPASS) {
+        printf("Failed to create file index task\n");
+        return false;
+    }
+
+    hal_sdcard_add_listener(sdcard_event_cb, NULL);
+    fs_watch_subscribe(fs_watch_event_cb, NULL);
+    printf("File index initialized\n");
+    return true;
+}
+
+void file_index_rebuild(bool force) {
+    if (!g_fidx.lock) {
+        return;
+    }
+
+    xSemaphoreTake(g_fidx.lock, portMAX_DELAY);
+    if (force) {
+        g_fidx.force_requested = true;
+    }
+    g_fidx.rebuild_requested = true;
+    xSemaphoreGive(g_fidx.lock);
+    xSemaphoreGive(g_fidx.wake);
+}
+
+void file_index_invalidate(const char* dir_path) {
+    if (!g_fidx.lock || !dir_path) {
+        return;
+    }
+
+    xSemaphoreTake(g_fidx.lock, portMAX_DELAY);
+    if (!is_dirty(g_fidx.dirty, g_fidx.dirty_count, dir_path)) {
+        char* copy = NULL;
+        if (g_fidx.dirty_count < FIDX_MAX_DIRTY) {
+            size_t len = strlen(dir_path);
+            copy = fidx_realloc(NULL, len + 1);
+            if (copy) {
+                memcpy(copy, dir_path, len + 1);
+            }
+        }
+        if (copy) {
+            g_fidx.dirty[g_fidx.dirty_count++] = copy;
+        } else {
+            g_fidx.dirty_overflow = true;
+        }
+    }
+    g_fidx.rebuild_requested = true;
+    xSemaphoreGive(g_fidx.lock);
+    xSemaphoreGive(g_fidx.wake);
+}
+
+static bool match_prefix(const char* name, const char* query, size_t query_len) {
+    for (size_t i = 0; i < query_len; i++) {
+        if (fold((uint8_t)name[i]) != (uint8_t)query[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool match_substring(const char* name, uint32_t name_len, const char* query, size_t query_len) {
+    if (query_len > name_len) {
+        return false;
+    }
+
+    uint8_t first = (uint8_t)query[0];
+    for (uint32_t i = 0; i + query_len <= name_len; i++) {
+        if (fold((uint8_t)name[i]) == first && match_prefix(name + i + 1, query + 1, query_len - 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int file_index_query(const char* query, file_index_match_t mode, uint32_t max_results,
+                     file_index_result_cb_t cb, void* user_data) {
+    if (!g_fidx.lock || !query || !cb) {
+        return -1;
+    }
+
+    // 查询串转为小写
+    char folded[FIDX_MAX_QUERY];
+    size_t query_len = strlen(query);
+    if (query_len == 0 || query_len >= sizeof(folded)) {
+        return 0;
+    }
+    for (size_t i = 0; i <= query_len; i++) {
+        folded[i] = (char)fold((uint8_t)query[i]);
+    }
+
+    xSemaphoreTake(g_fidx.lock, portMAX_DELAY);
+    const fidx_t* idx = g_fidx.current;
+    if (!idx) {
+        xSemaphoreGive(g_fidx.lock);
+        return -1;
+    }
+
+    int64_t start = esp_timer_get_time();
+    uint32_t results = 0;
+    uint32_t first = 0;
+
+    // 前缀查询：二分查找第一个不小于查询串的名称
+    if (mode == FILE_INDEX_MATCH_PREFIX) {
+        uint32_t lo = 0, hi = idx->entry_count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (fold_compare(idx->names + idx->entries[idx->sorted[mid]].name_offset, folded) < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        first = lo;
+    }
+
+    for (uint32_t i = first; i < idx->entry_count && results < max_results; i++) {
+        const fidx_entry_t* e = &idx->entries[idx->sorted[i]];
+        const char* name = idx->names + e->name_offset;
+
+        if (mode == FILE_INDEX_MATCH_PREFIX) {
+            if (e->name_len < query_len || !match_prefix(name, folded, query_len)) {
+                break;
+            }
+        } else if (!match_substring(name, e->name_len, folded, query_len)) {
+            continue;
+        }
+
+        results++;
+        if (!cb(idx->paths + idx->dirs[e->dir].path_offset, name, e->is_dir, e->size, user_data)) {
+            break;
+        }
+    }
+
+    g_fidx.last_query_us = (uint32_t)(esp_timer_get_time() - start);
+    xSemaphoreGive(g_fidx.lock);
+    return (int)results;
+}
+
+void file_index_get_stats(file_index_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(file_index_stats_t));
+    if (!g_fidx.lock) {
+        return;
+    }
+
+    xSemaphoreTake(g_fidx.lock, portMAX_DELAY);
+    if (g_fidx.current) {
+        stats->entry_count = g_fidx.current->entry_count;
+        stats->dir_count = g_fidx.current->dir_count;
+        stats->memory_bytes = fidx_memory_usage(g_fidx.current);
+        stats->ready = true;
+    }
+    stats->dirs_listed = g_fidx.dirs_listed;
+    stats->dirs_reused = g_fidx.dirs_reused;
+    stats->build_ms = g_fidx.build_ms;
+    stats->last_query_us = g_fidx.last_query_us;
+    stats->generation = g_fidx.build_generation;
+    stats->building = g_fidx.building || g_fidx.rebuild_requested;
+    xSemaphoreGive(g_fidx.lock);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Benchmark                                  */
+/* -------------------------------------------------------------------------- */
+
+static bool count_result_cb(const char* dir_path, const char* name, bool is_dir, uint32_t size, void* user_data) {
+    (void)dir_path;
+    (void)name;
+    (void)is_dir;
+    (void)size;
+    (void)user_data;
+    return true;
+}
+
+static void wait_for_build(void) {
+    uint32_t generation = g_fidx.build_generation;
+    while (g_fidx.build_generation == generation) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+}
+
+bool file_index_benchmark(const char* path, uint32_t create_count) {
+    if (!path || !hal_sdcard_is_mounted() || !file_index_init()) {
+        printf("File index benchmark: SD card not ready\n");
+        return false;
+    }
+
+    char file_path[FIDX_MAX_PATH];
+
+    if (create_count > 0) {
+        printf("File index benchmark: creating %lu files in %s\n", (unsigned long)create_count, path);
+        mkdir(path, 0777);
+        int64_t start = esp_timer_get_time();
+        for (uint32_t i = 0; i < create_count; i++) {
+            if (i % 500 == 0) {
+                snprintf(file_path, sizeof(file_path), "%s/d%03lu", path, (unsigned long)(i / 500));
+                mkdir(file_path, 0777);
+            }
+            snprintf(file_path, sizeof(file_path), "%s/d%03lu/file_%05lu.txt",
+                     path, (unsigned long)(i / 500), (unsigned long)i);
+            FILE* fp = fopen(file_path, "wb");
+            if (fp) {
+                fclose(fp);
+            }
+            if ((i + 1) % 5000 == 0) {
+                printf("  created %lu files\n", (unsigned long)(i + 1));
+            }
+        }
+        printf("Created %lu files in %lld ms\n", (unsigned long)create_count,
+               (long long)((esp_timer_get_time() - start) / 1000));
+    }
+
+    file_index_stats_t stats;
+
+    // 全量构建
+    file_index_rebuild(true);
+    wait_for_build();
+    file_index_get_stats(&stats);
+    printf("Full build:        %lu entries, %lu dirs listed, %lu ms (debounce %d ms excluded), %zu bytes\n",
+           (unsigned long)stats.entry_count, (unsigned long)stats.dirs_listed,
+           (unsigned long)stats.build_ms, FIDX_DEBOUNCE_MS, stats.memory_bytes);
+
+    // 无变化的增量构建
+    file_index_rebuild(false);
+    wait_for_build();
+    file_index_get_stats(&stats);
+    printf("Incremental build: %lu dirs listed, %lu reused, %lu ms\n",
+           (unsigned long)stats.dirs_listed, (unsigned long)stats.dirs_reused, (unsigned long)stats.build_ms);
+
+    // 查询延迟
+    static const char* queries[] = {"file_0", "12345", "d01", ".txt", "zzzz"};
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        for (int mode = FILE_INDEX_MATCH_SUBSTRING; mode <= FILE_INDEX_MATCH_PREFIX; mode++) {
+            uint64_t total_us = 0;
+            int results = 0;
+            for (int run = 0; run < 10; run++) {
+                results = file_index_query(queries[q], (file_index_match_t)mode, UINT32_MAX, count_result_cb, NULL);
+                file_index_get_stats(&stats);
+                total_us += stats.last_query_us;
+            }
+            printf("Query %-8s %-9s: %6d results, avg %6lu us\n", queries[q],
+                   mode == FILE_INDEX_MATCH_PREFIX ? "prefix" : "substring",
+                   results, (unsigned long)(total_us / 10));
+        }
+    }
+    return true;
+}
@@ -0,0 +1,95 @@
+#ifndef FILE_INDEX_H
+#define FILE_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 匹配方式（均不区分ASCII大小写）
+typedef enum {
+    FILE_INDEX_MATCH_SUBSTRING,   // 名称包含查询串
+    FILE_INDEX_MATCH_PREFIX       // 名称以查询串开头（有序数组二分查找）
+} file_index_match_t;
+
+/**
+ * @brief 查询结果回调（结果按名称排序）
+ *
+ * @return 返回false停止查询
+ */
+typedef bool (*file_index_result_cb_t)(const char* dir_path, const char* name, bool is_dir,
+                                       uint32_t size, void* user_data);
+
+// 索引统计
+typedef struct {
+    uint32_t entry_count;       // 索引的文件和目录数
+    uint32_t dir_count;         // 目录数
+    uint32_t dirs_listed;       // 上次构建时实际读取的目录数
+    uint32_t dirs_reused;       // 上次构建时复用旧索引的目录数
+    uint32_t build_ms;          // 上次构建耗时
+    uint32_t last_query_us;     // 上次查询耗时
+    uint32_t generation;        // 每次构建完成后递增
+    size_t memory_bytes;        // 索引占用内存
+    bool ready;                 // 索引可用
+    bool building;              // 正在后台构建
+} file_index_stats_t;
+
+/**
+ * @brief 初始化文件名索引：加载SD卡上保存的索引，并在后台重新构建
+ *
+ * 保存的索引在构建完成前用于查询。每次挂载后的第一次构建读取所有目录，
+ * 之后只重新读取变化监视报告过的目录。
+ *
+ * 可重复调用，已初始化时直接返回true。
+ */
+bool file_index_init(void);
+
+/**
+ * @brief 请求后台重建索引
+ *
+ * @param force 为true时忽略目录修改时间，重新读取所有目录
+ */
+void file_index_rebuild(bool force);
+
+/**
+ * @brief 目录内容变化后调用，下次构建时重新读取该目录
+ *
+ * FAT在目录内容变化时通常不会更新目录自身的修改时间，本机修改文件后需显式调用。
+ */
+void file_index_invalidate(const char* dir_path);
+
+/**
+ * @brief 查询索引（不访问SD卡）
+ *
+ * @param query 查询串
+ * @param mode 匹配方式
+ * @param max_results 最多返回的结果数
+ * @param cb 结果回调
+ * @param user_data 回调参数
+ * @return 返回的结果数，索引不可用时返回-1
+ */
+int file_index_query(const char* query, file_index_match_t mode, uint32_t max_results,
+                     file_index_result_cb_t cb, void* user_data);
+
+/**
+ * @brief 获取索引统计
+ */
+void file_index_get_stats(file_index_stats_t* stats);
+
+/**
+ * @brief 测试索引构建时间和查询延迟
+ *
+ * @param path 测试目录
+ * @param create_count 先在测试目录下创建的文件数（每个子目录500个，0表示不创建）
+ * @return 索引不可用时返回false
+ */
+bool file_index_benchmark(const char* path, uint32_t create_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FILE_INDEX_H
@@ -0,0 +1,362 @@
+#include "file_listing.h"
+#include "hal_sdcard.h"
+#include "fs_watch.h"
+#include "mem_pressure.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+
+// 增长块大小
+#define ENTRY_CHUNK       256           // 每次增加256个条目
+#define NAMES_CHUNK       (8 * 1024)    // 名称池每次增加8KB
+
+// 缓存配置
+#define CACHE_MAX_SLOTS       16                // 最多缓存16个目录
+#define CACHE_DEFAULT_BUDGET  (512 * 1024)      // 默认内存预算512KB
+#define CACHE_TRIM_DIVISOR    4                 // 内存偏低时只保留预算的1/4
+
+// 缓存槽
+typedef struct {
+    file_listing_t* listing;    // 缓存的列表（NULL表示空槽）
+    int32_t scroll_y;           // 离开时的滚动位置
+    uint32_t last_used;         // LRU序号
+    size_t bytes;               // 占用内存
+} listing_cache_slot_t;
+
+// 缓存状态（仅在LVGL线程访问）
+static struct {
+    listing_cache_slot_t slots[CACHE_MAX_SLOTS];
+    size_t budget;
+    size_t bytes_used;
+    uint32_t use_counter;
+    uint32_t hits;
+    uint32_t misses;
+    bool pressure_registered;
+} g_listing_cache = {
+    .budget = CACHE_DEFAULT_BUDGET,
+};
+
+// 重新分配内存 - 优先使用PSRAM
+static void* listing_realloc(void* ptr, size_t size) {
+    void* new_ptr = heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM);
+    if (!new_ptr) {
+        new_ptr = realloc(ptr, size);
+    }
+    return new_ptr;
+}
+
+file_listing_t* file_listing_create(const char* dir_path) {
+    if (!dir_path) {
+        return NULL;
+    }
+    
+    file_listing_t* listing = (file_listing_t*)listing_realloc(NULL, sizeof(file_listing_t));
+    if (!listing) {
+        printf("Failed to allocate file listing\n");
+        return NULL;
+    }
+    memset(listing, 0, sizeof(file_listing_t));
+    
+    size_t path_len = strlen(dir_path);
+    listing->dir_path = (char*)listing_realloc(NULL, path_len + 1);
+    if (!listing->dir_path) {
+        printf("Failed to allocate listing path\n");
+        free(listing);
+        return NULL;
+    }
+    memcpy(listing->dir_path, dir_path, path_len + 1);
+    
+    return listing;
+}
+
+void file_listing_free(file_listing_t* listing) {
+    if (!listing) {
+        return;
+    }
+    
+    free(listing->entries);
+    free(listing->names);
+    free(listing->dir_path);
+    free(listing);
+}
+
+bool file_listing_add(file_listing_t* listing, const char* name, file_type_t type,
+                      uint32_t size, uint32_t modified_time) {
+    if (!listing || !name) {
+        return false;
+    }
+    
+    size_t name_len = strlen(name);
+    if (name_len > UINT16_MAX) {
+        return false;
+    }
+    
+    // 条目数组按块增长
+    if (listing->count >= listing->capacity) {
+        uint32_t new_capacity = listing->capacity + ENTRY_CHUNK;
+        file_entry_t* entries = (file_entry_t*)listing_realloc(listing->entries,
+                                                               new_capacity * sizeof(file_entry_t));
+        if (!entries) {
+            printf("Failed to grow file listing to %lu entries\n", (unsigned long)new_capacity);
+            return false;
+        }
+        listing->entries = entries;
+        listing->capacity = new_capacity;
+    }
+    
+    // 名称池按块增长
+    if (listing->names_used + name_len + 1 > listing->names_capacity) {
+        uint32_t new_capacity = listing->names_capacity + NAMES_CHUNK;
+        while (listing->names_used + name_len + 1 > new_capacity) {
+            new_capacity += NAMES_CHUNK;
+        }
+        char* names = (char*)listing_realloc(listing->names, new_capacity);
+        if (!names) {
+            printf("Failed to grow name arena to %lu bytes\n", (unsigned long)new_capacity);
+            return false;
+        }
+        listing->names = names;
+        listing->names_capacity = new_capacity;
+    }
+    
+    file_entry_t* entry = &listing->entries[listing->count];
+    entry->name_offset = listing->names_used;
+    entry->name_len = (uint16_t)name_len;
+    entry->size = size;
+    entry->modified_time = modified_time;
+    entry->type = (uint8_t)type;
+    entry->flags = 0;
+    
+    memcpy(listing->names + listing->names_used, name, name_len + 1);
+    listing->names_used += name_len + 1;
+    listing->count++;
+    
+    return true;
+}
+
+// 扫描回调
+static bool scan_entry_cb(const hal_sdcard_entry_t* entry, void* user_data) {
+    file_listing_t* listing = (file_listing_t*)user_data;
+    return file_listing_add(listing, entry->name,
+                            entry->is_dir ? FILE_TYPE_DIRECTORY : FILE_TYPE_FILE,
+                            (uint32_t)entry->size, entry->mtime);
+}
+
+file_listing_t* file_listing_scan(const char* path, bool add_parent) {
+    file_listing_t* listing = file_listing_create(path);
+    if (!listing) {
+        return NULL;
+    }
+    
+    // 扫描前取版本号，扫描期间发生的变化会让下次校验失败
+    listing->generation = fs_watch_get_generation(path);
+    listing->has_parent = add_parent;
+    if (add_parent) {
+        file_listing_add(listing, "..", FILE_TYPE_PARENT, 0, 0);
+    }
+    
+    if (hal_sdcard_list_dir(path, NULL, HAL_SDCARD_LIST_SKIP_HIDDEN, scan_entry_cb, listing) < 0) {
+        file_listing_free(listing);
+        return NULL;
+    }
+    
+    return listing;
+}
+
+const char* file_listing_name(const file_listing_t* listing, uint32_t index) {
+    if (!listing || index >= listing->count) {
+        return NULL;
+    }
+    return listing->names + listing->entries[index].name_offset;
+}
+
+bool file_listing_full_path(const file_listing_t* listing, uint32_t index, char* buffer, size_t buffer_size) {
+    if (!listing || index >= listing->count || !buffer || buffer_size == 0) {
+        return false;
+    }
+    
+    int len = snprintf(buffer, buffer_size, "%s/%s", listing->dir_path, file_listing_name(listing, index));
+    return len > 0 && (size_t)len < buffer_size;
+}
+
+size_t file_listing_memory_usage(const file_listing_t* listing) {
+    if (!listing) {
+        return 0;
+    }
+    
+    return sizeof(file_listing_t) + strlen(listing->dir_path) + 1 +
+           listing->capacity * sizeof(file_entry_t) + listing->names_capacity;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Listing Cache                                 */
+/* -------------------------------------------------------------------------- */
+
+// 移除缓存槽（可选择释放列表）
+static file_listing_t* cache_take_slot(listing_cache_slot_t* slot) {
+    file_listing_t* listing = slot->listing;
+    g_listing_cache.bytes_used -= slot->bytes;
+    memset(slot, 0, sizeof(listing_cache_slot_t));
+    return listing;
+}
+
+static listing_cache_slot_t* cache_find(const char* path) {
+    for (int i = 0; i < CACHE_MAX_SLOTS; i++) {
+        listing_cache_slot_t* slot = &g_listing_cache.slots[i];
+        if (slot->listing && strcmp(slot->listing->dir_path, path) == 0) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static listing_cache_slot_t* cache_find_lru(void) {
+    listing_cache_slot_t* lru = NULL;
+    for (int i = 0; i < CACHE_MAX_SLOTS; i++) {
+        listing_cache_slot_t* slot = &g_listing_cache.slots[i];
+        if (slot->listing && (!lru || slot->last_used < lru->last_used)) {
+            lru = slot;
+        }
+    }
+    return lru;
+}
+
+// 淘汰最久未使用的列表直到满足预算
+static void cache_enforce_budget(size_t incoming_bytes) {
+    while (g_listing_cache.bytes_used + incoming_bytes > g_listing_cache.budget) {
+        listing_cache_slot_t* lru = cache_find_lru();
+        if (!lru) {
+            break;
+        }
+        printf("Listing cache: evicting %s (%zu bytes)\n", lru->listing->dir_path, lru->bytes);
+        file_listing_free(cache_take_slot(lru));
+    }
+}
+
+// 低内存：偏低时缩减到预算的一部分，更严重时清空
+static void cache_pressure_cb(mem_pressure_level_t level, void* user_data) {
+    (void)user_data;
+    if (level >= MEM_PRESSURE_HIDDEN_UI) {
+        file_listing_cache_clear();
+    } else if (level == MEM_PRESSURE_TRIM) {
+        size_t keep = g_listing_cache.budget / CACHE_TRIM_DIVISOR;
+        cache_enforce_budget(g_listing_cache.budget - keep);
+    }
+}
+
+file_listing_t* file_listing_cache_acquire(const char* path, bool add_parent, int32_t* scroll_y) {
+    if (scroll_y) {
+        *scroll_y = 0;
+    }
+    if (!path) {
+        return NULL;
+    }
+    
+    listing_cache_slot_t* slot = cache_find(path);
+    if (slot) {
+        // 只比较fs_watch版本号：FAT增删条目时不更新目录的修改时间，不能用来判断
+        if (slot->listing->has_parent == add_parent &&
+            slot->listing->generation == fs_watch_get_generation(path)) {
+            if (scroll_y) {
+                *scroll_y = slot->scroll_y;
+            }
+            g_listing_cache.hits++;
+            printf("Listing cache hit: %s (%lu entries)\n", path, (unsigned long)slot->listing->count);
+            return cache_take_slot(slot);
+        }
+        
+        printf("Listing cache stale: %s\n", path);
+        file_listing_free(cache_take_slot(slot));
+    }
+    
+    g_listing_cache.misses++;
+    return file_listing_scan(path, add_parent);
+}
+
+void file_listing_cache_release(file_listing_t* listing, int32_t scroll_y) {
+    if (!listing) {
+        return;
+    }
+    
+    size_t bytes = file_listing_memory_usage(listing);
+    if (bytes > g_listing_cache.budget) {
+        // 单个列表超过预算，直接释放
+        file_listing_free(listing);
+        return;
+    }
+    
+    // 第一次缓存时注册低内存回调
+    if (!g_listing_cache.pressure_registered) {
+        g_listing_cache.pressure_registered =
+            mem_pressure_register(cache_pressure_cb, NULL, MEM_PRESSURE_PRIO_CACHE);
+    }
+    
+    // 同一路径只保留一份
+    listing_cache_slot_t* existing = cache_find(listing->dir_path);
+    if (existing) {
+        file_listing_free(cache_take_slot(existing));
+    }
+    
+    cache_enforce_budget(bytes);
+    
+    // 查找空槽，没有空槽时淘汰最久未使用的
+    listing_cache_slot_t* slot = NULL;
+    for (int i = 0; i < CACHE_MAX_SLOTS; i++) {
+        if (!g_listing_cache.slots[i].listing) {
+            slot = &g_listing_cache.slots[i];
+            break;
+        }
+    }
+    if (!slot) {
+        slot = cache_find_lru();
+        file_listing_free(cache_take_slot(slot));
+    }
+    
+    // 清除选中状态
+    for (uint32_t i = 0; i < listing->count; i++) {
+        listing->entries[i].flags &= ~FILE_ENTRY_FLAG_SELECTED;
+    }
+    
+    slot->listing = listing;
+    slot->scroll_y = scroll_y;
+    slot->last_used = ++g_listing_cache.use_counter;
+    slot->bytes = bytes;
+    g_listing_cache.bytes_used += bytes;
+}
+
+void file_listing_cache_invalidate(const char* path) {
+    if (!path) {
+        return;
+    }
+    
+    listing_cache_slot_t* slot = cache_find(path);
+    if (slot) {
+        file_listing_free(cache_take_slot(slot));
+    }
+}
+
+void file_listing_cache_clear(void) {
+    for (int i = 0; i < CACHE_MAX_SLOTS; i++) {
+        if (g_listing_cache.slots[i].listing) {
+            file_listing_free(cache_take_slot(&g_listing_cache.slots[i]));
+        }
+    }
+}
+
+void file_listing_cache_set_budget(size_t budget_bytes) {
+    g_listing_cache.budget = budget_bytes;
+    cache_enforce_budget(0);
+}
+
+void file_listing_cache_get_stats(uint32_t* hits, uint32_t* misses, size_t* bytes_used) {
+    if (hits) {
+        *hits = g_listing_cache.hits;
+    }
+    if (misses) {
+        *misses = g_listing_cache.misses;
+    }
+    if (bytes_used) {
+        *bytes_used = g_listing_cache.bytes_used;
+    }
+}
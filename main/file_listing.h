@@ -0,0 +1,145 @@
+#ifndef FILE_LISTING_H
+#define FILE_LISTING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 文件项类型
+typedef enum {
+    FILE_TYPE_DIRECTORY,
+    FILE_TYPE_FILE,
+    FILE_TYPE_PARENT
+} file_type_t;
+
+// 条目标志
+#define FILE_ENTRY_FLAG_SELECTED  (1 << 0)
+
+// 紧凑文件条目（名称保存在名称池中，不保存完整路径）
+typedef struct {
+    uint32_t name_offset;     // 名称在名称池中的偏移
+    uint32_t size;            // 文件大小（字节，FAT32单文件上限4GB）
+    uint32_t modified_time;   // 修改时间
+    uint16_t name_len;        // 名称长度（不含结尾'\0'）
+    uint8_t type;             // file_type_t
+    uint8_t flags;            // FILE_ENTRY_FLAG_*
+} file_entry_t;
+
+// 目录列表：目录路径只保存一次，条目和名称池按块增长
+typedef struct {
+    char* dir_path;           // 目录路径
+    file_entry_t* entries;    // 条目数组
+    uint32_t count;           // 条目数量
+    uint32_t capacity;        // 条目容量
+    char* names;              // 名称池
+    uint32_t names_used;      // 名称池已用字节
+    uint32_t names_capacity;  // 名称池容量
+    uint32_t generation;      // 扫描前目录的fs_watch版本号（用于缓存校验）
+    bool has_parent;          // 是否包含".."项
+} file_listing_t;
+
+/**
+ * @brief 创建空的目录列表
+ * 
+ * @param dir_path 目录路径
+ * @return 目录列表，失败返回NULL
+ */
+file_listing_t* file_listing_create(const char* dir_path);
+
+/**
+ * @brief 释放目录列表
+ */
+void file_listing_free(file_listing_t* listing);
+
+/**
+ * @brief 添加条目（条目数组和名称池按块增长）
+ * 
+ * @return true if added
+ */
+bool file_listing_add(file_listing_t* listing, const char* name, file_type_t type,
+                      uint32_t size, uint32_t modified_time);
+
+/**
+ * @brief 扫描目录生成列表（单次遍历，无计数预扫描）
+ * 
+ * @param path 目录路径
+ * @param add_parent 是否在开头添加".."项
+ * @return 目录列表，失败返回NULL
+ */
+file_listing_t* file_listing_scan(const char* path, bool add_parent);
+
+/**
+ * @brief 获取条目名称
+ */
+const char* file_listing_name(const file_listing_t* listing, uint32_t index);
+
+/**
+ * @brief 按需构建条目完整路径到调用者提供的缓冲区
+ * 
+ * @return true if the path fit into the buffer
+ */
+bool file_listing_full_path(const file_listing_t* listing, uint32_t index, char* buffer, size_t buffer_size);
+
+/**
+ * @brief 获取列表占用的内存（字节）
+ */
+size_t file_listing_memory_usage(const file_listing_t* listing);
+
+/* -------------------------------------------------------------------------- */
+/*                              Listing Cache                                 */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 从缓存获取目录列表，未命中或目录的fs_watch版本号已变化时重新扫描
+ * 
+ * 缓存不读取SD卡校验内容（FAT不更新目录的修改时间，比较条目指纹又和重新扫描一样慢），
+ * 因此修改目录内容的代码必须调用fs_watch_path_changed()/fs_watch_dir_changed()
+ * 或file_listing_cache_invalidate()。SD卡插拔后全部失效；其他途径的修改
+ * 只有在目录被fs_watch_add_dir()监视时才能发现。
+ * 
+ * 返回的列表归调用者所有，离开目录时通过file_listing_cache_release()归还。
+ * 
+ * @param path 目录路径
+ * @param add_parent 是否在开头添加".."项
+ * @param scroll_y 输出：上次离开该目录时的滚动位置（未命中时为0），可为NULL
+ * @return 目录列表，失败返回NULL
+ */
+file_listing_t* file_listing_cache_acquire(const char* path, bool add_parent, int32_t* scroll_y);
+
+/**
+ * @brief 将目录列表归还缓存（作为最近使用项），超出内存预算时淘汰最久未使用的列表
+ * 
+ * @param listing 目录列表（所有权转移给缓存）
+ * @param scroll_y 当前滚动位置
+ */
+void file_listing_cache_release(file_listing_t* listing, int32_t scroll_y);
+
+/**
+ * @brief 使指定目录的缓存失效（本机修改目录内容后调用）
+ */
+void file_listing_cache_invalidate(const char* path);
+
+/**
+ * @brief 清空缓存
+ */
+void file_listing_cache_clear(void);
+
+/**
+ * @brief 设置缓存内存预算（字节）
+ */
+void file_listing_cache_set_budget(size_t budget_bytes);
+
+/**
+ * @brief 获取缓存统计信息
+ */
+void file_listing_cache_get_stats(uint32_t* hits, uint32_t* misses, size_t* bytes_used);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FILE_LISTING_H
@@ -0,0 +1,929 @@
+#include "file_ops.h"
+#include "io_sched.h"
+#include "fs_watch.h"
+#include "hal_sdcard.h"
+#include "sd_selftest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+// 引擎配置
+#define FILE_OPS_MAX_PATH       512
+#define FILE_OPS_BUFFER_COUNT   2               // 双缓冲：读取一块的同时写入另一块
+#define FILE_OPS_BUFFER_SIZE    (64 * 1024)     // 大块传输，FatFS可直接按扇区DMA读写
+#define FILE_OPS_BUFFER_MIN     (16 * 1024)     // 内存不足时的最小块
+#define FILE_OPS_BUFFER_ALIGN   64              // 缓存行对齐，避免SDMMC驱动使用中转缓冲
+#define FILE_OPS_TASK_STACK     8192
+#define FILE_OPS_TASK_PRIORITY  3               // 低于LVGL任务，避免界面卡顿
+
+// 顶层条目已处理（同目录内rename成功）
+#define ITEM_FLAG_DONE          (1 << 7)
+
+// 读取任务传给写入任务的数据块
+typedef struct {
+    uint8_t* data;      // 缓冲区（结束块为NULL）
+    size_t len;         // 有效数据长度
+    int fd;             // 目标文件（<0表示写入任务退出）
+    bool last;          // 文件结束：写入后关闭并通知
+} copy_chunk_t;
+
+// 任务描述
+typedef struct {
+    file_op_type_t type;
+    file_listing_t* items;                  // 顶层条目（dir_path为源目录）
+    char dest_dir[FILE_OPS_MAX_PATH];
+    char src_path[FILE_OPS_MAX_PATH];       // 递归时复用的源路径
+    char dst_path[FILE_OPS_MAX_PATH];       // 递归时复用的目标路径
+    uint8_t* buffers[FILE_OPS_BUFFER_COUNT];
+    size_t buffer_size;
+    QueueHandle_t free_queue;               // 空闲缓冲区
+    QueueHandle_t full_queue;               // 待写入数据块
+    SemaphoreHandle_t file_done;            // 写入任务关闭文件后释放
+    volatile bool write_error;
+} file_op_job_t;
+
+// 全局状态
+static struct {
+    SemaphoreHandle_t lock;                 // 保护progress
+    file_op_progress_t progress;
+    bool has_progress;
+    int64_t start_time;
+    volatile bool busy;
+    volatile bool cancel_requested;
+} g_file_ops = {0};
+
+/* -------------------------------------------------------------------------- */
+/*                                 Progress                                   */
+/* -------------------------------------------------------------------------- */
+
+static void progress_lock(void) {
+    xSemaphoreTake(g_file_ops.lock, portMAX_DELAY);
+}
+
+static void progress_unlock(void) {
+    xSemaphoreGive(g_file_ops.lock);
+}
+
+static void progress_add_bytes(size_t bytes) {
+    progress_lock();
+    g_file_ops.progress.bytes_done += bytes;
+    progress_unlock();
+}
+
+static void progress_file_done(void) {
+    progress_lock();
+    g_file_ops.progress.files_done++;
+    progress_unlock();
+}
+
+static void progress_set_current(const char* path) {
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    progress_lock();
+    strncpy(g_file_ops.progress.current, name, sizeof(g_file_ops.progress.current) - 1);
+    g_file_ops.progress.current[sizeof(g_file_ops.progress.current) - 1] = '\0';
+    progress_unlock();
+}
+
+static void progress_set_error(const char* what, const char* path) {
+    printf("File ops error: %s %s (errno %d)\n", what, path, errno);
+
+    progress_lock();
+    if (g_file_ops.progress.error[0] == '\0') {
+        const char* name = strrchr(path, '/');
+        snprintf(g_file_ops.progress.error, sizeof(g_file_ops.progress.error), "%s: %s",
+                 what, name ? name + 1 : path);
+    }
+    progress_unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Helpers                                   */
+/* -------------------------------------------------------------------------- */
+
+// 在路径末尾追加名称，saved_len用于恢复
+static bool path_push(char* path, const char* name, size_t* saved_len) {
+    size_t len = strlen(path);
+    size_t name_len = strlen(name);
+    if (len + 1 + name_len >= FILE_OPS_MAX_PATH) {
+        return false;
+    }
+
+    path[len] = '/';
+    memcpy(path + len + 1, name, name_len + 1);
+    *saved_len = len;
+    return true;
+}
+
+static void path_pop(char* path, size_t saved_len) {
+    path[saved_len] = '\0';
+}
+
+static bool path_exists(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+// 子目录列表收集
+typedef struct {
+    file_listing_t* listing;
+    bool failed;
+} collect_ctx_t;
+
+static bool collect_entry_cb(const hal_sdcard_entry_t* entry, void* user_data) {
+    collect_ctx_t* ctx = (collect_ctx_t*)user_data;
+    if (!file_listing_add(ctx->listing, entry->name,
+                          entry->is_dir ? FILE_TYPE_DIRECTORY : FILE_TYPE_FILE,
+                          (uint32_t)entry->size, entry->mtime)) {
+        ctx->failed = true;
+        return false;
+    }
+    return true;
+}
+
+// 列出目录全部条目（包括隐藏文件）
+static file_listing_t* list_children(const char* path) {
+    collect_ctx_t ctx = { .listing = file_listing_create(path), .failed = false };
+    if (!ctx.listing) {
+        return NULL;
+    }
+
+    if (hal_sdcard_list_dir(path, NULL, 0, collect_entry_cb, &ctx) < 0 || ctx.failed) {
+        file_listing_free(ctx.listing);
+        return NULL;
+    }
+    return ctx.listing;
+}
+
+// 目标已存在时生成"名称 (n).扩展名"
+static bool make_unique_dest(file_op_job_t* job, const char* name) {
+    int len = snprintf(job->dst_path, sizeof(job->dst_path), "%s/%s", job->dest_dir, name);
+    if (len <= 0 || (size_t)len >= sizeof(job->dst_path)) {
+        return false;
+    }
+    if (!path_exists(job->dst_path)) {
+        return true;
+    }
+
+    const char* dot = strrchr(name, '.');
+    int base_len = (dot && dot != name) ? (int)(dot - name) : (int)strlen(name);
+    const char* ext = (dot && dot != name) ? dot : "";
+
+    for (int n = 1; n < 1000; n++) {
+        len = snprintf(job->dst_path, sizeof(job->dst_path), "%s/%.*s (%d)%s",
+                       job->dest_dir, base_len, name, n, ext);
+        if (len <= 0 || (size_t)len >= sizeof(job->dst_path)) {
+            return false;
+        }
+        if (!path_exists(job->dst_path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Measure                                   */
+/* -------------------------------------------------------------------------- */
+
+// 统计src_path下的文件数和字节数（用于进度显示）
+static void measure_entry(file_op_job_t* job, uint8_t type, uint32_t size,
+                          uint32_t* files, uint64_t* bytes) {
+    if (type != FILE_TYPE_DIRECTORY) {
+        (*files)++;
+        *bytes += size;
+        return;
+    }
+
+    file_listing_t* children = list_children(job->src_path);
+    if (!children) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < children->count && !g_file_ops.cancel_requested; i++) {
+        size_t saved_len;
+        if (path_push(job->src_path, file_listing_name(children, i), &saved_len)) {
+            measure_entry(job, children->entries[i].type, children->entries[i].size, files, bytes);
+            path_pop(job->src_path, saved_len);
+        }
+    }
+    file_listing_free(children);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               Copy Pipeline                                */
+/* -------------------------------------------------------------------------- */
+
+static bool write_all(int fd, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = io_sched_write(fd, data, len, IO_CLASS_BACKGROUND);
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        len -= (size_t)written;
+    }
+    return true;
+}
+
+// 写入任务：从full_queue取数据块写入目标文件，缓冲区归还free_queue
+static void writer_task(void* arg) {
+    file_op_job_t* job = (file_op_job_t*)arg;
+    copy_chunk_t chunk;
+
+    while (xQueueReceive(job->full_queue, &chunk, portMAX_DELAY) == pdTRUE) {
+        if (chunk.fd < 0) {
+            break;
+        }
+
+        if (chunk.len > 0 && !job->write_error && !g_file_ops.cancel_requested) {
+            if (write_all(chunk.fd, chunk.data, chunk.len)) {
+                progress_add_bytes(chunk.len);
+            } else {
+                progress_set_error(errno == ENOSPC ? "存储空间不足" : "写入失败", job->dst_path);
+                job->write_error = true;
+            }
+        }
+
+        if (chunk.data) {
+            xQueueSend(job->free_queue, &chunk.data, portMAX_DELAY);
+        }
+
+        if (chunk.last) {
+            if (close(chunk.fd) != 0 && !job->write_error) {
+                progress_set_error("写入失败", job->dst_path);
+                job->write_error = true;
+            }
+            xSemaphoreGive(job->file_done);
+        }
+    }
+
+    xSemaphoreGive(job->file_done);
+    vTaskDelete(NULL);
+}
+
+// 复制src_path到dst_path：本任务读取，写入任务同时写出上一块
+static bool copy_file(file_op_job_t* job) {
+    progress_set_current(job->src_path);
+
+    int src = open(job->src_path, O_RDONLY);
+    if (src < 0) {
+        progress_set_error("无法打开", job->src_path);
+        return false;
+    }
+
+    int dst = open(job->dst_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (dst < 0) {
+        progress_set_error("无法创建", job->dst_path);
+        close(src);
+        return false;
+    }
+
+    job->write_error = false;
+    bool ok = true;
+
+    while (true) {
+        if (g_file_ops.cancel_requested || job->write_error) {
+            ok = false;
+            break;
+        }
+
+        uint8_t* buffer = NULL;
+        xQueueReceive(job->free_queue, &buffer, portMAX_DELAY);
+
+        ssize_t n = io_sched_read(src, IO_SCHED_CURRENT, buffer, job->buffer_size, IO_CLASS_BACKGROUND);
+        if (n <= 0) {
+            if (n < 0) {
+                progress_set_error("读取失败", job->src_path);
+                ok = false;
+            }
+            xQueueSend(job->free_queue, &buffer, portMAX_DELAY);
+            break;
+        }
+
+        copy_chunk_t chunk = { .data = buffer, .len = (size_t)n, .fd = dst, .last = false };
+        xQueueSend(job->full_queue, &chunk, portMAX_DELAY);
+    }
+    close(src);
+
+    // 结束块：写入任务写完之前的数据后关闭目标文件
+    copy_chunk_t end = { .data = NULL, .len = 0, .fd = dst, .last = true };
+    xQueueSend(job->full_queue, &end, portMAX_DELAY);
+    xSemaphoreTake(job->file_done, portMAX_DELAY);
+    fs_watch_path_changed(job->dst_path);
+
+    if (job->write_error) {
+        ok = false;
+    }
+    if (!ok) {
+        unlink(job->dst_path);
+        return false;
+    }
+
+    progress_file_done();
+    return true;
+}
+
+// 递归复制src_path到dst_path
+static bool copy_entry(file_op_job_t* job, uint8_t type) {
+    if (type != FILE_TYPE_DIRECTORY) {
+        return copy_file(job);
+    }
+
+    if (mkdir(job->dst_path, 0777) == 0) {
+        fs_watch_path_changed(job->dst_path);
+    } else if (errno != EEXIST) {
+        progress_set_error("无法创建目录", job->dst_path);
+        return false;
+    }
+
+    file_listing_t* children = list_children(job->src_path);
+    if (!children) {
+        progress_set_error("无法读取目录", job->src_path);
+        return false;
+    }
+
+    bool ok = true;
+    for (uint32_t i = 0; i < children->count && ok; i++) {
+        if (g_file_ops.cancel_requested) {
+            ok = false;
+            break;
+        }
+
+        const char* name = file_listing_name(children, i);
+        size_t src_len, dst_len;
+        if (!path_push(job->src_path, name, &src_len)) {
+            progress_set_error("路径过长", name);
+            ok = false;
+            break;
+        }
+        if (!path_push(job->dst_path, name, &dst_len)) {
+            path_pop(job->src_path, src_len);
+            progress_set_error("路径过长", name);
+            ok = false;
+            break;
+        }
+
+        ok = copy_entry(job, children->entries[i].type);
+
+        path_pop(job->dst_path, dst_len);
+        path_pop(job->src_path, src_len);
+    }
+
+    file_listing_free(children);
+    return ok;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Delete                                    */
+/* -------------------------------------------------------------------------- */
+
+// 递归删除src_path
+static bool delete_entry(file_op_job_t* job, uint8_t type, bool count_progress) {
+    if (type != FILE_TYPE_DIRECTORY) {
+        if (count_progress) {
+            progress_set_current(job->src_path);
+        }
+        if (unlink(job->src_path) != 0) {
+            progress_set_error("无法删除", job->src_path);
+            return false;
+        }
+        fs_watch_path_changed(job->src_path);
+        if (count_progress) {
+            progress_file_done();
+        }
+        return true;
+    }
+
+    file_listing_t* children = list_children(job->src_path);
+    if (!children) {
+        progress_set_error("无法读取目录", job->src_path);
+        return false;
+    }
+
+    bool ok = true;
+    for (uint32_t i = 0; i < children->count && ok; i++) {
+        if (g_file_ops.cancel_requested) {
+            ok = false;
+            break;
+        }
+
+        size_t saved_len;
+        if (!path_push(job->src_path, file_listing_name(children, i), &saved_len)) {
+            progress_set_error("路径过长", file_listing_name(children, i));
+            ok = false;
+            break;
+        }
+        ok = delete_entry(job, children->entries[i].type, count_progress);
+        path_pop(job->src_path, saved_len);
+    }
+    file_listing_free(children);
+
+    if (ok && rmdir(job->src_path) != 0) {
+        progress_set_error("无法删除目录", job->src_path);
+        ok = false;
+    }
+    if (ok) {
+        fs_watch_path_changed(job->src_path);
+    }
+    return ok;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Engine                                   */
+/* -------------------------------------------------------------------------- */
+
+// path是否为dir本身或位于dir之下
+static bool is_inside(const char* path, const char* dir) {
+    size_t len = strlen(dir);
+    return strncmp(path, dir, len) == 0 && (path[len] == '/' || path[len] == '\0');
+}
+
+// 设置src_path为顶层条目i
+static bool set_item_source(file_op_job_t* job, uint32_t i) {
+    int len = snprintf(job->src_path, sizeof(job->src_path), "%s/%s",
+                       job->items->dir_path, file_listing_name(job->items, i));
+    return len > 0 && (size_t)len < sizeof(job->src_path);
+}
+
+static bool run_job(file_op_job_t* job) {
+    file_listing_t* items = job->items;
+
+    // 同一卷内移动优先使用rename，无需复制数据
+    if (job->type == FILE_OP_MOVE) {
+        for (uint32_t i = 0; i < items->count; i++) {
+            if (items->entries[i].type == FILE_TYPE_PARENT) {
+                continue;
+            }
+            if (strcmp(items->dir_path, job->dest_dir) == 0) {
+                items->entries[i].flags |= ITEM_FLAG_DONE;
+                continue;
+            }
+            if (!set_item_source(job, i)) {
+                continue;
+            }
+            // 必须在rename之前检查：把目录移动到自身内部会使其脱离目录树
+            if (items->entries[i].type == FILE_TYPE_DIRECTORY && is_inside(job->dest_dir, job->src_path)) {
+                progress_set_error("不能移动到自身内部", job->src_path);
+                return false;
+            }
+            if (!make_unique_dest(job, file_listing_name(items, i))) {
+                continue;
+            }
+            if (rename(job->src_path, job->dst_path) == 0) {
+                fs_watch_path_changed(job->src_path);
+                fs_watch_path_changed(job->dst_path);
+                items->entries[i].flags |= ITEM_FLAG_DONE;
+                progress_file_done();
+            }
+        }
+    }
+
+    // 统计剩余条目的工作量
+    uint32_t files_total = 0;
+    uint64_t bytes_total = 0;
+    for (uint32_t i = 0; i < items->count; i++) {
+        if (items->entries[i].type == FILE_TYPE_PARENT || (items->entries[i].flags & ITEM_FLAG_DONE)) {
+            continue;
+        }
+        if (set_item_source(job, i)) {
+            measure_entry(job, items->entries[i].type, items->entries[i].size, &files_total, &bytes_total);
+        }
+    }
+
+    progress_lock();
+    g_file_ops.progress.files_total = g_file_ops.progress.files_done + files_total;
+    g_file_ops.progress.bytes_total = (job->type == FILE_OP_DELETE) ? 0 : bytes_total;
+    progress_unlock();
+
+    for (uint32_t i = 0; i < items->count; i++) {
+        if (g_file_ops.cancel_requested) {
+            return false;
+        }
+        if (items->entries[i].type == FILE_TYPE_PARENT || (items->entries[i].flags & ITEM_FLAG_DONE)) {
+            continue;
+        }
+
+        const char* name = file_listing_name(items, i);
+        if (!set_item_source(job, i)) {
+            progress_set_error("路径过长", name);
+            return false;
+        }
+
+        if (job->type == FILE_OP_DELETE) {
+            if (!delete_entry(job, items->entries[i].type, true)) {
+                return false;
+            }
+            continue;
+        }
+
+        // 禁止把目录复制到自身内部
+        if (items->entries[i].type == FILE_TYPE_DIRECTORY && is_inside(job->dest_dir, job->src_path)) {
+            progress_set_error(job->type == FILE_OP_MOVE ? "不能移动到自身内部" : "不能复制到自身内部", job->src_path);
+            return false;
+        }
+
+        if (!make_unique_dest(job, name)) {
+            progress_set_error("路径过长", name);
+            return false;
+        }
+
+        if (!copy_entry(job, items->entries[i].type)) {
+            return false;
+        }
+
+        // 跨卷移动：复制成功后删除源文件
+        if (job->type == FILE_OP_MOVE && !delete_entry(job, items->entries[i].type, false)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void free_job(file_op_job_t* job) {
+    if (!job) {
+        return;
+    }
+
+    for (int i = 0; i < FILE_OPS_BUFFER_COUNT; i++) {
+        if (job->buffers[i]) {
+            heap_caps_free(job->buffers[i]);
+        }
+    }
+    if (job->free_queue) {
+        vQueueDelete(job->free_queue);
+    }
+    if (job->full_queue) {
+        vQueueDelete(job->full_queue);
+    }
+    if (job->file_done) {
+        vSemaphoreDelete(job->file_done);
+    }
+    file_listing_free(job->items);
+    heap_caps_free(job);
+}
+
+static void file_ops_task(void* arg) {
+    file_op_job_t* job = (file_op_job_t*)arg;
+
+    // 任务期间占用SD卡：卸载时先取消任务，等打开的文件都关闭后才释放驱动
+    bool in_io = hal_sdcard_io_begin();
+    bool ok = in_io && run_job(job);
+
+    // 停止写入任务
+    copy_chunk_t quit = { .data = NULL, .len = 0, .fd = -1, .last = false };
+    xQueueSend(job->full_queue, &quit, portMAX_DELAY);
+    xSemaphoreTake(job->file_done, portMAX_DELAY);
+    if (in_io) {
+        hal_sdcard_io_end();
+    }
+
+    progress_lock();
+    g_file_ops.progress.elapsed_ms = (uint32_t)((esp_timer_get_time() - g_file_ops.start_time) / 1000);
+    if (g_file_ops.progress.elapsed_ms > 0) {
+        g_file_ops.progress.mb_per_sec = (float)g_file_ops.progress.bytes_done /
+                                         (1024.0f * 1024.0f) /
+                                         ((float)g_file_ops.progress.elapsed_ms / 1000.0f);
+    }
+    if (g_file_ops.cancel_requested) {
+        g_file_ops.progress.state = FILE_OP_STATE_CANCELLED;
+    } else {
+        g_file_ops.progress.state = ok ? FILE_OP_STATE_DONE : FILE_OP_STATE_FAILED;
+    }
+    printf("File ops finished: state=%d, %lu/%lu files, %llu bytes in %lu ms (%.2f MB/s)\n",
+           g_file_ops.progress.state,
+           (unsigned long)g_file_ops.progress.files_done,
+           (unsigned long)g_file_ops.progress.files_total,
+           (unsigned long long)g_file_ops.progress.bytes_done,
+           (unsigned long)g_file_ops.progress.elapsed_ms,
+           g_file_ops.progress.mb_per_sec);
+    progress_unlock();
+
+    free_job(job);
+    g_file_ops.busy = false;
+    vTaskDelete(NULL);
+}
+
+// 分配缓存行对齐的内部RAM DMA缓冲区，内存不足时减小块大小
+static bool alloc_buffers(file_op_job_t* job) {
+    for (size_t size = FILE_OPS_BUFFER_SIZE; size >= FILE_OPS_BUFFER_MIN; size /= 2) {
+        bool ok = true;
+        for (int i = 0; i < FILE_OPS_BUFFER_COUNT; i++) {
+            job->buffers[i] = heap_caps_aligned_alloc(FILE_OPS_BUFFER_ALIGN, size,
+                                                      MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+            if (!job->buffers[i]) {
+                ok = false;
+                break;
+            }
+        }
+
+        if (ok) {
+            job->buffer_size = size;
+            return true;
+        }
+
+        for (int i = 0; i < FILE_OPS_BUFFER_COUNT; i++) {
+            if (job->buffers[i]) {
+                heap_caps_free(job->buffers[i]);
+                job->buffers[i] = NULL;
+            }
+        }
+    }
+    return false;
+}
+
+// SD卡即将卸载：取消正在进行的任务（在监视任务中调用）
+static void sdcard_event_cb(hal_sdcard_event_t event, uint32_t generation, void* user_data) {
+    (void)generation;
+    (void)user_data;
+    if (event == HAL_SDCARD_EVENT_UNMOUNTING) {
+        file_ops_cancel();
+    }
+}
+
+bool file_ops_start(file_op_type_t type, const file_listing_t* items, const char* dest_dir) {
+    if (!items || items->count == 0) {
+        return false;
+    }
+    if (type != FILE_OP_DELETE && (!dest_dir || strlen(dest_dir) >= FILE_OPS_MAX_PATH)) {
+        return false;
+    }
+    if (!hal_sdcard_is_mounted()) {
+        printf("File ops: SD card not mounted\n");
+        return false;
+    }
+
+    if (!g_file_ops.lock) {
+        g_file_ops.lock = xSemaphoreCreateMutex();
+        if (!g_file_ops.lock) {
+            return false;
+        }
+        hal_sdcard_add_listener(sdcard_event_cb, NULL);
+    }
+    if (g_file_ops.busy) {
+        printf("File ops: another operation is running\n");
+        return false;
+    }
+
+    file_op_job_t* job = heap_caps_calloc(1, sizeof(file_op_job_t), MALLOC_CAP_SPIRAM);
+    if (!job) {
+        job = calloc(1, sizeof(file_op_job_t));
+    }
+    if (!job) {
+        return false;
+    }
+
+    job->type = type;
+    if (dest_dir) {
+        strcpy(job->dest_dir, dest_dir);
+    }
+
+    // 复制条目列表（任务期间调用者可能释放原列表）
+    job->items = file_listing_create(items->dir_path);
+    bool ok = job->items != NULL;
+    for (uint32_t i = 0; ok && i < items->count; i++) {
+        const file_entry_t* entry = &items->entries[i];
+        ok = file_listing_add(job->items, file_listing_name(items, i), (file_type_t)entry->type,
+                              entry->size, entry->modified_time);
+    }
+
+    if (ok && type != FILE_OP_DELETE) {
+        ok = alloc_buffers(job);
+        if (!ok) {
+            printf("File ops: failed to allocate DMA buffers\n");
+        }
+    }
+    if (ok) {
+        job->free_queue = xQueueCreate(FILE_OPS_BUFFER_COUNT, sizeof(uint8_t*));
+        job->full_queue = xQueueCreate(FILE_OPS_BUFFER_COUNT + 1, sizeof(copy_chunk_t));
+        job->file_done = xSemaphoreCreateBinary();
+        ok = job->free_queue && job->full_queue && job->file_done;
+    }
+    if (ok) {
+        for (int i = 0; i < FILE_OPS_BUFFER_COUNT; i++) {
+            if (job->buffers[i]) {
+                xQueueSend(job->free_queue, &job->buffers[i], 0);
+            }
+        }
+    }
+    if (!ok) {
+        free_job(job);
+        return false;
+    }
+
+    progress_lock();
+    memset(&g_file_ops.progress, 0, sizeof(g_file_ops.progress));
+    g_file_ops.progress.type = type;
+    g_file_ops.progress.state = FILE_OP_STATE_RUNNING;
+    g_file_ops.has_progress = true;
+    g_file_ops.start_time = esp_timer_get_time();
+    progress_unlock();
+
+    g_file_ops.cancel_requested = false;
+    g_file_ops.busy = true;
+
+    if (xTaskCreate(writer_task, "file_ops_wr", 4096, job, FILE_OPS_TASK_PRIORITY, NULL) != pdPASS) {
+        g_file_ops.busy = false;
+        free_job(job);
+        return false;
+    }
+    // 任务结束时释放job，创建后不能再访问
+    size_t buffer_size = job->buffer_size;
+    if (xTaskCreate(file_ops_task, "file_ops", FILE_OPS_TASK_STACK, job, FILE_OPS_TASK_PRIORITY, NULL) != pdPASS) {
+        // 让写入任务退出后再释放
+        copy_chunk_t quit = { .data = NULL, .len = 0, .fd = -1, .last = false };
+        xQueueSend(job->full_queue, &quit, portMAX_DELAY);
+        xSemaphoreTake(job->file_done, portMAX_DELAY);
+        g_file_ops.busy = false;
+        free_job(job);
+        return false;
+    }
+
+    printf("File ops started: type=%d, %lu items from %s (buffers %u x %u bytes)\n",
+           type, (unsigned long)items->count, items->dir_path,
+           FILE_OPS_BUFFER_COUNT, (unsigned)buffer_size);
+    return true;
+}
+
+void file_ops_cancel(void) {
+    if (g_file_ops.busy) {
+        printf("File ops: cancel requested\n");
+        g_file_ops.cancel_requested = true;
+    }
+}
+
+bool file_ops_is_busy(void) {
+    return g_file_ops.busy;
+}
+
+bool file_ops_get_progress(file_op_progress_t* progress) {
+    if (!progress || !g_file_ops.lock) {
+        return false;
+    }
+
+    progress_lock();
+    if (!g_file_ops.has_progress) {
+        progress_unlock();
+        return false;
+    }
+
+    *progress = g_file_ops.progress;
+    if (progress->state == FILE_OP_STATE_RUNNING) {
+        progress->elapsed_ms = (uint32_t)((esp_timer_get_time() - g_file_ops.start_time) / 1000);
+        if (progress->elapsed_ms > 0) {
+            progress->mb_per_sec = (float)progress->bytes_done / (1024.0f * 1024.0f) /
+                                   ((float)progress->elapsed_ms / 1000.0f);
+        }
+    }
+    progress_unlock();
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Self Test                                  */
+/* -------------------------------------------------------------------------- */
+
+// 对照组：stdio默认小缓冲逐块复制
+static float stdio_copy(const char* src, const char* dst) {
+    FILE* in = fopen(src, "rb");
+    FILE* out = fopen(dst, "wb");
+    if (!in || !out) {
+        if (in) fclose(in);
+        if (out) fclose(out);
+        return 0.0f;
+    }
+
+    char buffer[512];
+    uint64_t total = 0;
+    int64_t start = esp_timer_get_time();
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        fwrite(buffer, 1, n, out);
+        total += n;
+    }
+    fclose(in);
+    fclose(out);
+
+    float seconds = (float)(esp_timer_get_time() - start) / 1000000.0f;
+    return seconds > 0 ? (float)total / (1024.0f * 1024.0f) / seconds : 0.0f;
+}
+
+static bool wait_for_completion(file_op_progress_t* progress) {
+    while (file_ops_is_busy()) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    return file_ops_get_progress(progress) && progress->state == FILE_OP_STATE_DONE;
+}
+
+// 测试目录路径的最大长度，留出拼接"/sub/small_00.bin"等文件名的空间
+#define SELF_TEST_DIR_MAX  (FILE_OPS_MAX_PATH - 32)
+
+bool file_ops_self_test(const char* work_dir, uint32_t file_size_kb) {
+    if (!work_dir || file_size_kb == 0) {
+        return false;
+    }
+
+    char src_dir[SELF_TEST_DIR_MAX], dst_dir[SELF_TEST_DIR_MAX], path[FILE_OPS_MAX_PATH], path2[FILE_OPS_MAX_PATH];
+    if (snprintf(src_dir, sizeof(src_dir), "%s/src", work_dir) >= (int)sizeof(src_dir) ||
+        snprintf(dst_dir, sizeof(dst_dir), "%s/dst", work_dir) >= (int)sizeof(dst_dir)) {
+        printf("Self test: work dir path too long\n");
+        return false;
+    }
+
+    printf("File ops self test in %s (%lu KB)\n", work_dir, (unsigned long)file_size_kb);
+
+    // 准备测试数据：一个大文件 + 子目录中的小文件
+    bool ok = sd_selftest_mkdir(work_dir) && sd_selftest_mkdir(src_dir) && sd_selftest_mkdir(dst_dir);
+    snprintf(path, sizeof(path), "%s/big.bin", src_dir);
+    ok = ok && sd_selftest_write_pattern(path, file_size_kb * 1024, 0x5A);
+    snprintf(path, sizeof(path), "%s/sub", src_dir);
+    ok = ok && sd_selftest_mkdir(path);
+    for (int i = 0; ok && i < 16; i++) {
+        snprintf(path, sizeof(path), "%s/sub/small_%02d.bin", src_dir, i);
+        ok = sd_selftest_write_pattern(path, 4096 + i * 100, (uint8_t)i);
+    }
+    if (!ok) {
+        printf("Self test: failed to create test files\n");
+        return false;
+    }
+
+    // 对照组
+    snprintf(path, sizeof(path), "%s/big.bin", src_dir);
+    snprintf(path2, sizeof(path2), "%s/stdio.bin", work_dir);
+    float stdio_mbps = stdio_copy(path, path2);
+    unlink(path2);
+
+    file_op_progress_t progress;
+    file_listing_t* items = file_listing_create(src_dir);
+    ok = items &&
+         file_listing_add(items, "big.bin", FILE_TYPE_FILE, file_size_kb * 1024, 0) &&
+         file_listing_add(items, "sub", FILE_TYPE_DIRECTORY, 0, 0);
+
+    // 复制并校验
+    ok = ok && file_ops_start(FILE_OP_COPY, items, dst_dir) && wait_for_completion(&progress);
+    if (ok) {
+        printf("Self test copy: %lu files, %.2f MB/s (stdio 512B: %.2f MB/s)\n",
+               (unsigned long)progress.files_done, progress.mb_per_sec, stdio_mbps);
+        snprintf(path2, sizeof(path2), "%s/big.bin", dst_dir);
+        ok = sd_selftest_files_equal(path, path2);
+        for (int i = 0; ok && i < 16; i++) {
+            snprintf(path, sizeof(path), "%s/sub/small_%02d.bin", src_dir, i);
+            snprintf(path2, sizeof(path2), "%s/sub/small_%02d.bin", dst_dir, i);
+            ok = sd_selftest_files_equal(path, path2);
+        }
+        printf("Self test verify: %s\n", ok ? "OK" : "MISMATCH");
+    }
+    file_listing_free(items);
+
+    // 移动到自身的子目录：必须失败，并且源目录保持原样
+    items = file_listing_create(dst_dir);
+    snprintf(path, sizeof(path), "%s/sub/inner", dst_dir);
+    ok = ok && items && file_listing_add(items, "sub", FILE_TYPE_DIRECTORY, 0, 0) && sd_selftest_mkdir(path);
+    if (ok && file_ops_start(FILE_OP_MOVE, items, path)) {
+        wait_for_completion(&progress);
+        snprintf(path2, sizeof(path2), "%s/sub/small_00.bin", dst_dir);
+        ok = progress.state == FILE_OP_STATE_FAILED && path_exists(path2);
+        rmdir(path);
+        printf("Self test move into itself: %s\n", ok ? "rejected" : "NOT REJECTED");
+    } else {
+        ok = false;
+    }
+    file_listing_free(items);
+
+    // 移动（同卷rename）
+    items = file_listing_create(dst_dir);
+    ok = ok && items && file_listing_add(items, "sub", FILE_TYPE_DIRECTORY, 0, 0);
+    ok = ok && file_ops_start(FILE_OP_MOVE, items, work_dir) && wait_for_completion(&progress);
+    if (ok) {
+        snprintf(path, sizeof(path), "%s/sub/small_00.bin", work_dir);
+        ok = path_exists(path);
+        printf("Self test move: %s (%lu ms)\n", ok ? "OK" : "FAILED", (unsigned long)progress.elapsed_ms);
+    }
+    file_listing_free(items);
+
+    // 删除全部测试数据
+    items = file_listing_create(work_dir);
+    bool cleaned = items &&
+                   file_listing_add(items, "src", FILE_TYPE_DIRECTORY, 0, 0) &&
+                   file_listing_add(items, "dst", FILE_TYPE_DIRECTORY, 0, 0) &&
+                   file_listing_add(items, "sub", FILE_TYPE_DIRECTORY, 0, 0);
+    cleaned = cleaned && file_ops_start(FILE_OP_DELETE, items, NULL) && wait_for_completion(&progress);
+    file_listing_free(items);
+    cleaned = cleaned && rmdir(work_dir) == 0;
+    printf("Self test delete: %s (%lu files)\n", cleaned ? "OK" : "FAILED",
+           (unsigned long)progress.files_done);
+
+    return ok && cleaned;
+}
@@ -0,0 +1,86 @@
+#ifndef FILE_OPS_H
+#define FILE_OPS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "file_listing.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 文件操作类型
+typedef enum {
+    FILE_OP_COPY,
+    FILE_OP_MOVE,
+    FILE_OP_DELETE
+} file_op_type_t;
+
+// 文件操作状态
+typedef enum {
+    FILE_OP_STATE_IDLE,
+    FILE_OP_STATE_RUNNING,
+    FILE_OP_STATE_DONE,
+    FILE_OP_STATE_CANCELLED,
+    FILE_OP_STATE_FAILED
+} file_op_state_t;
+
+// 进度快照
+typedef struct {
+    file_op_type_t type;
+    file_op_state_t state;
+    uint32_t files_done;        // 已完成文件数
+    uint32_t files_total;       // 文件总数
+    uint64_t bytes_done;        // 已写入字节数
+    uint64_t bytes_total;       // 需要复制的总字节数
+    uint32_t elapsed_ms;        // 已用时间
+    float mb_per_sec;           // 平均吞吐量 (MB/s)
+    char current[128];          // 当前处理的文件名
+    char error[128];            // 失败原因
+} file_op_progress_t;
+
+/**
+ * @brief 在后台启动复制/移动/删除任务
+ *
+ * 源目录为items->dir_path，处理items中的全部条目（".."项被忽略），
+ * 目录递归处理。同一时间只允许一个任务运行。
+ *
+ * @param type 操作类型
+ * @param items 要处理的条目（内部会复制一份，调用后即可释放）
+ * @param dest_dir 目标目录（删除时忽略，可为NULL）
+ * @return 启动成功返回true
+ */
+bool file_ops_start(file_op_type_t type, const file_listing_t* items, const char* dest_dir);
+
+/**
+ * @brief 请求取消当前任务（在下一个数据块边界生效，未完成的目标文件会被删除）
+ */
+void file_ops_cancel(void);
+
+/**
+ * @brief 是否有任务正在运行
+ */
+bool file_ops_is_busy(void);
+
+/**
+ * @brief 获取当前（或最近一次）任务的进度快照，可从任意任务调用
+ *
+ * @return 从未启动过任务时返回false
+ */
+bool file_ops_get_progress(file_op_progress_t* progress);
+
+/**
+ * @brief 在指定目录下生成测试文件，分别用stdio小缓冲和复制引擎复制，
+ *        校验内容后执行移动和删除并打印MB/s
+ *
+ * @param work_dir 临时工作目录（结束时删除）
+ * @param file_size_kb 大文件尺寸（KB）
+ * @return 全部步骤成功返回true
+ */
+bool file_ops_self_test(const char* work_dir, uint32_t file_size_kb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FILE_OPS_H
@@ -0,0 +1,372 @@
+#include "file_types.h"
+#include "lvgl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+// 配置
+#define TYPES_MAX_EXTENSION     8               // 扩展名打包为64位整数比较
+#define TYPES_HASH_SLOTS        128             // 2的幂，至少为扩展名数量的2倍
+#define TYPES_SNIFF_BYTES       264             // 覆盖TAR的"ustar"标记（偏移257）
+#define TYPES_SNIFF_CACHE       64              // 文件头识别结果缓存（直接映射）
+
+// 类型下标（与k_types顺序一致）
+enum {
+    TYPE_UNKNOWN,
+    TYPE_MP3,
+    TYPE_WAV,
+    TYPE_FLAC,
+    TYPE_AAC,
+    TYPE_OGG,
+    TYPE_JPEG,
+    TYPE_PNG,
+    TYPE_BMP,
+    TYPE_GIF,
+    TYPE_TEXT,
+    TYPE_PDF,
+    TYPE_ZIP,
+    TYPE_TAR,
+    TYPE_COUNT
+};
+
+static const file_type_info_t k_types[TYPE_COUNT] = {
+    [TYPE_UNKNOWN] = { "文件", "",     FILE_KIND_UNKNOWN,  FILE_HANDLER_NONE,         NULL,         LV_SYMBOL_FILE,     0 },
+    [TYPE_MP3]     = { "MP3",  "mp3",  FILE_KIND_AUDIO,    FILE_HANDLER_MUSIC_PLAYER, "音乐播放器", LV_SYMBOL_AUDIO,    FILE_CAP_PLAY },
+    [TYPE_WAV]     = { "WAV",  "wav",  FILE_KIND_AUDIO,    FILE_HANDLER_NONE,         NULL,         LV_SYMBOL_AUDIO,    0 },
+    [TYPE_FLAC]    = { "FLAC", "flac", FILE_KIND_AUDIO,    FILE_HANDLER_NONE,         NULL,         LV_SYMBOL_AUDIO,    0 },
+    [TYPE_AAC]     = { "AAC",  "aac",  FILE_KIND_AUDIO,    FILE_HANDLER_NONE,         NULL,         LV_SYMBOL_AUDIO,    0 },
+    [TYPE_OGG]     = { "OGG",  "ogg",  FILE_KIND_AUDIO,    FILE_HANDLER_NONE,         NULL,         LV_SYMBOL_AUDIO,    0 },
+    [TYPE_JPEG]    = { "JPEG", "jpg",  FILE_KIND_IMAGE,    FILE_HANDLER_NONE,         NULL,         LV_SYMBOL_IMAGE,    FILE_CAP_DECODE_IMAGE },
+    [TYPE_PNG]     = { "PNG",  "png",  FILE_KIND_IMAGE,    FILE_HANDLER_NONE,         NULL,         LV_SYMBOL_IMAGE,    FILE_CAP_DECODE_IMAGE },
+    [TYPE_BMP]     = { "BMP",  "bmp",  FILE_KIND_IMAGE,    FILE_HANDLER_NONE,         NULL,         LV_SYMBOL_IMAGE,    FILE_CAP_DECODE_IMAGE },
+    [TYPE_GIF]     = { "GIF",  "gif",  FILE_KIND_IMAGE,    FILE_HANDLER_NONE,         NULL,         LV_SYMBOL_IMAGE,    FILE_CAP_DECODE_IMAGE },
+    [TYPE_TEXT]    = { "文本", "txt",  FILE_KIND_TEXT,     FILE_HANDLER_TEXT_VIEWER,  "文件管理器", LV_SYMBOL_EDIT,     FILE_CAP_VIEW_TEXT | FILE_CAP_SEARCH_TEXT },
+    [TYPE_PDF]     = { "PDF",  "pdf",  FILE_KIND_DOCUMENT, FILE_HANDLER_NONE,         NULL,         LV_SYMBOL_DOWNLOAD, 0 },
+    [TYPE_ZIP]     = { "ZIP",  "zip",  FILE_KIND_ARCHIVE,  FILE_HANDLER_ARCHIVE,      "文件管理器", LV_SYMBOL_DRIVE,    FILE_CAP_EXTRACT },
+    [TYPE_TAR]     = { "TAR",  "tar",  FILE_KIND_ARCHIVE,  FILE_HANDLER_ARCHIVE,      "文件管理器", LV_SYMBOL_DRIVE,    FILE_CAP_EXTRACT },
+};
+
+// 扩展名（小写）到类型的映射，包括别名
+static const struct {
+    const char* extension;
+    uint8_t type;
+} k_extensions[] = {
+    { "mp3",  TYPE_MP3 },
+    { "wav",  TYPE_WAV },
+    { "flac", TYPE_FLAC },
+    { "aac",  TYPE_AAC },
+    { "m4a",  TYPE_AAC },
+    { "ogg",  TYPE_OGG },
+    { "jpg",  TYPE_JPEG },
+    { "jpeg", TYPE_JPEG },
+    { "png",  TYPE_PNG },
+    { "bmp",  TYPE_BMP },
+    { "gif",  TYPE_GIF },
+    { "txt",  TYPE_TEXT },
+    { "log",  TYPE_TEXT },
+    { "md",   TYPE_TEXT },
+    { "csv",  TYPE_TEXT },
+    { "json", TYPE_TEXT },
+    { "ini",  TYPE_TEXT },
+    { "cfg",  TYPE_TEXT },
+    { "xml",  TYPE_TEXT },
+    { "pdf",  TYPE_PDF },
+    { "zip",  TYPE_ZIP },
+    { "tar",  TYPE_TAR },
+};
+
+// 文件头特征
+static const struct {
+    uint16_t offset;
+    uint8_t len;
+    uint8_t type;
+    const char* magic;
+} k_magic[] = {
+    { 0,   3, TYPE_MP3,  "ID3" },
+    { 0,   4, TYPE_FLAC, "fLaC" },
+    { 0,   4, TYPE_OGG,  "OggS" },
+    { 0,   4, TYPE_PNG,  "\x89PNG" },
+    { 0,   3, TYPE_JPEG, "\xFF\xD8\xFF" },
+    { 0,   4, TYPE_GIF,  "GIF8" },
+    { 0,   2, TYPE_BMP,  "BM" },
+    { 0,   4, TYPE_PDF,  "%PDF" },
+    { 0,   4, TYPE_ZIP,  "PK\x03\x04" },
+    { 0,   4, TYPE_ZIP,  "PK\x05\x06" },      // 空ZIP
+    { 257, 5, TYPE_TAR,  "ustar" },
+};
+
+// 文件头识别缓存
+typedef struct {
+    uint32_t path_hash;
+    uint32_t size;
+    uint32_t mtime;
+    uint8_t type;
+    bool valid;
+} sniff_entry_t;
+
+static struct {
+    bool initialized;
+    uint64_t keys[TYPES_HASH_SLOTS];    // 打包后的扩展名，0为空槽
+    uint8_t types[TYPES_HASH_SLOTS];
+    SemaphoreHandle_t lock;             // 保护sniff缓存
+    sniff_entry_t sniff[TYPES_SNIFF_CACHE];
+    uint32_t sniff_hits;
+    uint32_t sniff_reads;
+} g_types = {0};
+
+/* -------------------------------------------------------------------------- */
+/*                                 Extension                                  */
+/* -------------------------------------------------------------------------- */
+
+// 把扩展名转为小写并打包为整数；过长或为空时返回0
+static uint64_t pack_extension(const char* ext) {
+    uint64_t key = 0;
+    int i = 0;
+    for (; ext[i]; i++) {
+        if (i == TYPES_MAX_EXTENSION) {
+            return 0;
+        }
+        uint8_t c = (uint8_t)ext[i];
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        key |= (uint64_t)c << (i * 8);
+    }
+    return key;
+}
+
+static inline uint32_t key_slot(uint64_t key) {
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 57) & (TYPES_HASH_SLOTS - 1);
+}
+
+void file_types_init(void) {
+    if (g_types.initialized) {
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(k_extensions) / sizeof(k_extensions[0]); i++) {
+        uint64_t key = pack_extension(k_extensions[i].extension);
+        uint32_t slot = key_slot(key);
+        while (g_types.keys[slot] != 0) {
+            slot = (slot + 1) & (TYPES_HASH_SLOTS - 1);
+        }
+        g_types.keys[slot] = key;
+        g_types.types[slot] = k_extensions[i].type;
+    }
+    g_types.lock = xSemaphoreCreateMutex();
+    g_types.initialized = true;
+}
+
+static uint8_t lookup_type(const char* filename) {
+    if (!filename) {
+        return TYPE_UNKNOWN;
+    }
+    const char* base = strrchr(filename, '/');
+    const char* dot = strrchr(base ? base : filename, '.');
+    if (!dot) {
+        return TYPE_UNKNOWN;
+    }
+    if (!g_types.initialized) {
+        file_types_init();
+    }
+
+    uint64_t key = pack_extension(dot + 1);
+    if (key == 0) {
+        return TYPE_UNKNOWN;
+    }
+    for (uint32_t slot = key_slot(key); g_types.keys[slot] != 0; slot = (slot + 1) & (TYPES_HASH_SLOTS - 1)) {
+        if (g_types.keys[slot] == key) {
+            return g_types.types[slot];
+        }
+    }
+    return TYPE_UNKNOWN;
+}
+
+const file_type_info_t* file_types_lookup(const char* filename) {
+    return &k_types[lookup_type(filename)];
+}
+
+bool file_types_has_cap(const char* filename, uint32_t cap) {
+    return (k_types[lookup_type(filename)].caps & cap) != 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Sniff                                    */
+/* -------------------------------------------------------------------------- */
+
+// MP3帧同步（无ID3标签的文件）
+static bool is_mpeg_audio(const uint8_t* header, size_t len) {
+    return len >= 2 && header[0] == 0xFF && (header[1] & 0xE6) == 0xE2;
+}
+
+// 不含NUL且控制字符很少视为文本
+static bool is_text_like(const uint8_t* header, size_t len) {
+    size_t control = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (header[i] == 0) {
+            return false;
+        }
+        if (header[i] < 0x09 || (header[i] > 0x0D && header[i] < 0x20 && header[i] != 0x1B)) {
+            control++;
+        }
+    }
+    return len > 0 && control * 32 <= len;
+}
+
+static uint8_t classify_header(const uint8_t* header, size_t len, uint8_t by_extension) {
+    for (size_t i = 0; i < sizeof(k_magic) / sizeof(k_magic[0]); i++) {
+        if (k_magic[i].offset + k_magic[i].len <= len &&
+            memcmp(header + k_magic[i].offset, k_magic[i].magic, k_magic[i].len) == 0) {
+            return k_magic[i].type;
+        }
+    }
+    if (len >= 12 && memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0) {
+        return TYPE_WAV;
+    }
+    if (is_mpeg_audio(header, len)) {
+        return TYPE_MP3;
+    }
+    // 没有特征的格式以扩展名为准；未知扩展名的纯文本可用文本查看器打开
+    if (by_extension == TYPE_UNKNOWN && is_text_like(header, len)) {
+        return TYPE_TEXT;
+    }
+    return by_extension;
+}
+
+static uint32_t hash_path(const char* path) {
+    uint32_t hash = 2166136261u;
+    while (*path) {
+        hash = (hash ^ (uint8_t)*path++) * 16777619u;
+    }
+    return hash;
+}
+
+const file_type_info_t* file_types_sniff(const char* path, uint32_t size, uint32_t mtime) {
+    file_types_init();
+    uint8_t by_extension = lookup_type(path);
+    if (!path || size == 0 || !g_types.lock) {
+        return &k_types[by_extension];
+    }
+
+    uint32_t path_hash = hash_path(path);
+    sniff_entry_t* entry = &g_types.sniff[path_hash % TYPES_SNIFF_CACHE];
+
+    xSemaphoreTake(g_types.lock, portMAX_DELAY);
+    if (entry->valid && entry->path_hash == path_hash && entry->size == size && entry->mtime == mtime) {
+        uint8_t type = entry->type;
+        g_types.sniff_hits++;
+        xSemaphoreGive(g_types.lock);
+        return &k_types[type];
+    }
+    xSemaphoreGive(g_types.lock);
+
+    // 只读一个扇区
+    uint8_t header[TYPES_SNIFF_BYTES];
+    ssize_t len = -1;
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        len = read(fd, header, sizeof(header));
+        close(fd);
+    }
+    if (len <= 0) {
+        return &k_types[by_extension];
+    }
+
+    uint8_t type = classify_header(header, (size_t)len, by_extension);
+    if (type != by_extension) {
+        printf("File type: %s sniffed as %s\n", path, k_types[type].name);
+    }
+
+    xSemaphoreTake(g_types.lock, portMAX_DELAY);
+    *entry = (sniff_entry_t){ path_hash, size, mtime, type, true };
+    g_types.sniff_reads++;
+    xSemaphoreGive(g_types.lock);
+    return &k_types[type];
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Benchmark                                  */
+/* -------------------------------------------------------------------------- */
+
+// 原文件管理器的分类方式：复制扩展名转小写后逐个strcmp
+static const char* legacy_icon(const char* filename) {
+    const char* ext = strrchr(filename, '.');
+    if (!ext) {
+        return LV_SYMBOL_FILE;
+    }
+    char ext_lower[16];
+    strncpy(ext_lower, ext + 1, sizeof(ext_lower) - 1);
+    ext_lower[sizeof(ext_lower) - 1] = '\0';
+    for (int i = 0; ext_lower[i]; i++) {
+        if (ext_lower[i] >= 'A' && ext_lower[i] <= 'Z') {
+            ext_lower[i] = ext_lower[i] - 'A' + 'a';
+        }
+    }
+    if (strcmp(ext_lower, "mp3") == 0 || strcmp(ext_lower, "wav") == 0) {
+        return LV_SYMBOL_AUDIO;
+    } else if (strcmp(ext_lower, "jpg") == 0 || strcmp(ext_lower, "png") == 0 ||
+               strcmp(ext_lower, "bmp") == 0 || strcmp(ext_lower, "gif") == 0) {
+        return LV_SYMBOL_IMAGE;
+    } else if (strcmp(ext_lower, "txt") == 0 || strcmp(ext_lower, "log") == 0) {
+        return LV_SYMBOL_EDIT;
+    } else if (strcmp(ext_lower, "pdf") == 0) {
+        return LV_SYMBOL_DOWNLOAD;
+    }
+    return LV_SYMBOL_FILE;
+}
+
+bool file_types_benchmark(uint32_t entries) {
+    static const char* extensions[] = {"MP3", "jpg", "txt", "json", "zip", "dat", "PNG", "log", "bin", "md"};
+    const uint32_t name_size = 32;
+
+    file_types_init();
+    char* names = heap_caps_malloc(entries * name_size, MALLOC_CAP_SPIRAM);
+    if (!names) {
+        return false;
+    }
+    for (uint32_t i = 0; i < entries; i++) {
+        snprintf(names + i * name_size, name_size, "IMG_%05lu.%s", (unsigned long)i,
+                 extensions[i % (sizeof(extensions) / sizeof(extensions[0]))]);
+    }
+
+    // 两种方式得到的图标必须一致（新增类型除外）
+    uint32_t mismatches = 0;
+    volatile uintptr_t sink = 0;
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < entries; i++) {
+        sink += (uintptr_t)legacy_icon(names + i * name_size);
+    }
+    int64_t legacy_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (uint32_t i = 0; i < entries; i++) {
+        sink += (uintptr_t)file_types_lookup(names + i * name_size)->icon;
+    }
+    int64_t registry_us = esp_timer_get_time() - start;
+
+    for (uint32_t i = 0; i < entries; i++) {
+        const char* name = names + i * name_size;
+        const file_type_info_t* type = file_types_lookup(name);
+        const char* legacy = legacy_icon(name);
+        if (strcmp(type->icon, legacy) != 0 && strcmp(legacy, LV_SYMBOL_FILE) != 0) {
+            mismatches++;
+        }
+    }
+    (void)sink;
+
+    printf("File type benchmark (%lu names): strcmp chain %lld us (%lld ns/entry), registry %lld us (%lld ns/entry), %lu mismatches\n",
+           (unsigned long)entries,
+           (long long)legacy_us, (long long)(legacy_us * 1000 / (entries ? entries : 1)),
+           (long long)registry_us, (long long)(registry_us * 1000 / (entries ? entries : 1)),
+           (unsigned long)mismatches);
+    printf("File type sniff cache: %lu hits, %lu header reads\n",
+           (unsigned long)g_types.sniff_hits, (unsigned long)g_types.sniff_reads);
+    heap_caps_free(names);
+    return mismatches == 0;
+}
@@ -0,0 +1,88 @@
+#ifndef FILE_TYPES_H
+#define FILE_TYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 文件大类
+typedef enum {
+    FILE_KIND_UNKNOWN,
+    FILE_KIND_AUDIO,
+    FILE_KIND_IMAGE,
+    FILE_KIND_TEXT,
+    FILE_KIND_DOCUMENT,
+    FILE_KIND_ARCHIVE
+} file_kind_t;
+
+// 处理该类型的模块
+typedef enum {
+    FILE_HANDLER_NONE,
+    FILE_HANDLER_MUSIC_PLAYER,      // 音乐播放器
+    FILE_HANDLER_TEXT_VIEWER,       // 文件管理器内的文本查看器
+    FILE_HANDLER_ARCHIVE            // 文件管理器内的压缩包浏览
+} file_handler_t;
+
+// 能力标志
+#define FILE_CAP_PLAY           (1 << 0)    // 可由音频HAL解码播放
+#define FILE_CAP_VIEW_TEXT      (1 << 1)    // 可按文本分页查看
+#define FILE_CAP_SEARCH_TEXT    (1 << 2)    // 内容搜索时有意义
+#define FILE_CAP_EXTRACT        (1 << 3)    // 可浏览和解压
+#define FILE_CAP_DECODE_IMAGE   (1 << 4)    // 图片（目前只显示图标）
+
+// 类型描述（注册表中的静态条目，指针长期有效）
+typedef struct {
+    const char* name;               // 类型名（如"MP3"）
+    const char* extension;          // 主扩展名（小写，不含'.'）
+    file_kind_t kind;
+    file_handler_t handler;
+    const char* handler_app;        // 打开该类型的App名称，没有时为NULL
+    const char* icon;               // LV_SYMBOL_*
+    uint32_t caps;                  // FILE_CAP_*
+} file_type_info_t;
+
+/**
+ * @brief 建立扩展名哈希表（可重复调用；首次查询时也会自动建立）
+ */
+void file_types_init(void);
+
+/**
+ * @brief 按扩展名查询类型（不区分大小写，不访问SD卡）
+ *
+ * @return 类型描述，未知类型返回通用条目（不会返回NULL）
+ */
+const file_type_info_t* file_types_lookup(const char* filename);
+
+/**
+ * @brief 读取文件头确认类型，结果按路径、大小和修改时间缓存
+ *
+ * 文件头与已知格式匹配时以文件头为准（例如扩展名为.jpg的PNG），
+ * 否则返回按扩展名查询的结果。
+ *
+ * @param path 文件完整路径
+ * @param size 文件大小（来自目录列表，用于判断缓存是否有效）
+ * @param mtime 修改时间（同上）
+ */
+const file_type_info_t* file_types_sniff(const char* path, uint32_t size, uint32_t mtime);
+
+/**
+ * @brief 按扩展名判断文件是否具有某项能力
+ */
+bool file_types_has_cap(const char* filename, uint32_t cap);
+
+/**
+ * @brief 对比注册表查询与逐个strcmp的分类耗时，打印每个条目的平均耗时
+ *
+ * @param entries 生成的文件名数量
+ * @return 两种方式的分类结果一致返回true
+ */
+bool file_types_benchmark(uint32_t entries);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FILE_TYPES_H
@@ -0,0 +1,476 @@
+#include "fs_watch.h"
+#include "hal_sdcard.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+// 配置
+#define FS_WATCH_MAX_DIRS           64      // 记录版本号的目录数
+#define FS_WATCH_MAX_SUBSCRIBERS    8
+#define FS_WATCH_MAX_PATH           512
+#define FS_WATCH_COALESCE_MS        300     // 收到报告后等待合并的时间
+#define FS_WATCH_SCAN_INTERVAL_MS   10000   // 后台检查监视目录的间隔
+#define FS_WATCH_TASK_STACK         4096
+#define FS_WATCH_TASK_PRIORITY      2
+
+// 目录记录
+typedef struct {
+    char* path;                 // NULL为空槽
+    uint32_t generation;
+    uint32_t fingerprint;       // 上次后台检查时的条目指纹
+    uint32_t last_used;
+    uint16_t watch_refs;        // fs_watch_add_dir引用计数
+    bool fingerprint_valid;
+    bool pending;               // 等待通知
+} watch_dir_t;
+
+typedef struct {
+    fs_watch_cb_t cb;
+    void* user_data;
+} watch_subscriber_t;
+
+// 全局状态
+static struct {
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t wake;
+    TaskHandle_t task;
+    watch_dir_t dirs[FS_WATCH_MAX_DIRS];
+    watch_subscriber_t subscribers[FS_WATCH_MAX_SUBSCRIBERS];
+    uint32_t counter;           // 全局变化计数，目录版本号取自它
+    uint32_t base_generation;   // 没有记录的目录的版本号
+    uint32_t use_clock;
+    bool overflow;              // 记录表已满，通知整张卡
+    uint32_t reports;           // 本批收到的报告数
+} g_watch = {0};
+
+/* -------------------------------------------------------------------------- */
+/*                                 Dir Table                                  */
+/* -------------------------------------------------------------------------- */
+
+static char* fw_strdup(const char* str) {
+    size_t len = strlen(str);
+    char* copy = heap_caps_malloc(len + 1, MALLOC_CAP_SPIRAM);
+    if (!copy) {
+        copy = malloc(len + 1);
+    }
+    if (copy) {
+        memcpy(copy, str, len + 1);
+    }
+    return copy;
+}
+
+static void fw_free(void* ptr) {
+    heap_caps_free(ptr);
+}
+
+// 去掉末尾的'/'，保证同一目录只有一种写法
+static bool normalize_path(const char* path, char* out, size_t size) {
+    size_t len = path ? strlen(path) : 0;
+    while (len > 1 && path[len - 1] == '/') {
+        len--;
+    }
+    if (len == 0 || len >= size) {
+        return false;
+    }
+    memcpy(out, path, len);
+    out[len] = '\0';
+    return true;
+}
+
+// 查找目录记录（调用者持有锁）
+static watch_dir_t* dir_find(const char* path) {
+    for (int i = 0; i < FS_WATCH_MAX_DIRS; i++) {
+        watch_dir_t* dir = &g_watch.dirs[i];
+        if (dir->path && strcmp(dir->path, path) == 0) {
+            dir->last_used = ++g_watch.use_clock;
+            return dir;
+        }
+    }
+    return NULL;
+}
+
+// 丢弃记录后该目录回到基础版本号，基础版本号必须前进，
+// 否则之前缓存了基础版本号的调用者会错过被丢弃的变化
+static void dir_evict(watch_dir_t* dir) {
+    fw_free(dir->path);
+    memset(dir, 0, sizeof(watch_dir_t));
+    g_watch.base_generation = ++g_watch.counter;
+}
+
+// 查找或创建目录记录，表满时淘汰最久未用的非监视记录（调用者持有锁）
+static watch_dir_t* dir_get(const char* path) {
+    watch_dir_t* dir = dir_find(path);
+    if (dir) {
+        return dir;
+    }
+
+    watch_dir_t* slot = NULL;
+    for (int i = 0; i < FS_WATCH_MAX_DIRS && !slot; i++) {
+        if (!g_watch.dirs[i].path) {
+            slot = &g_watch.dirs[i];
+        }
+    }
+    for (int i = 0; i < FS_WATCH_MAX_DIRS && !slot; i++) {
+        watch_dir_t* candidate = &g_watch.dirs[i];
+        if (candidate->watch_refs == 0 && !candidate->pending) {
+            slot = candidate;
+        }
+    }
+    if (!slot) {
+        return NULL;
+    }
+    for (int i = 0; i < FS_WATCH_MAX_DIRS; i++) {
+        watch_dir_t* candidate = &g_watch.dirs[i];
+        if (slot->path && candidate->watch_refs == 0 && !candidate->pending &&
+            candidate->last_used < slot->last_used) {
+            slot = candidate;
+        }
+    }
+    if (slot->path) {
+        dir_evict(slot);
+    }
+
+    slot->path = fw_strdup(path);
+    if (!slot->path) {
+        return NULL;
+    }
+    slot->generation = g_watch.base_generation;
+    slot->last_used = ++g_watch.use_clock;
+    return slot;
+}
+
+// 记录变化（调用者持有锁）
+static void mark_changed(const char* path) {
+    g_watch.reports++;
+    watch_dir_t* dir = dir_get(path);
+    if (dir) {
+        dir->generation = ++g_watch.counter;
+        dir->pending = true;
+        dir->fingerprint_valid = false;
+        return;
+    }
+
+    // 无法单独记录：所有目录都视为已变化
+    g_watch.overflow = true;
+    g_watch.base_generation = ++g_watch.counter;
+    for (int i = 0; i < FS_WATCH_MAX_DIRS; i++) {
+        if (g_watch.dirs[i].path) {
+            g_watch.dirs[i].generation = ++g_watch.counter;
+        }
+    }
+}
+
+static bool ensure_locks(void) {
+    if (!g_watch.lock) {
+        g_watch.lock = xSemaphoreCreateMutex();
+    }
+    if (!g_watch.wake) {
+        g_watch.wake = xSemaphoreCreateBinary();
+    }
+    return g_watch.lock && g_watch.wake;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               Watch Task                                   */
+/* -------------------------------------------------------------------------- */
+
+// 目录条目指纹（FNV-1a，覆盖名称、类型、大小和修改时间）
+static bool fingerprint_cb(const hal_sdcard_entry_t* entry, void* user_data) {
+    uint32_t* hash = (uint32_t*)user_data;
+    for (const char* p = entry->name; *p; p++) {
+        *hash = (*hash ^ (uint8_t)*p) * 16777619u;
+    }
+    uint32_t fields[3] = { entry->is_dir, (uint32_t)entry->size, entry->mtime };
+    for (int i = 0; i < 3; i++) {
+        *hash = (*hash ^ fields[i]) * 16777619u;
+    }
+    return true;
+}
+
+static uint32_t compute_fingerprint(const char* path) {
+    uint32_t hash = 2166136261u;
+    int count = hal_sdcard_list_dir(path, NULL, 0, fingerprint_cb, &hash);
+    // 目录不存在（被外部删除）时也得到确定的值
+    return count < 0 ? 0 : (hash ^ (uint32_t)count);
+}
+
+// 检查监视目录的外部修改（读目录时不持有锁）
+static void scan_watched(void) {
+    if (!hal_sdcard_is_mounted()) {
+        return;
+    }
+
+    char* paths[FS_WATCH_MAX_DIRS];
+    uint32_t generations[FS_WATCH_MAX_DIRS];
+    int count = 0;
+    xSemaphoreTake(g_watch.lock, portMAX_DELAY);
+    for (int i = 0; i < FS_WATCH_MAX_DIRS; i++) {
+        watch_dir_t* dir = &g_watch.dirs[i];
+        if (dir->path && dir->watch_refs > 0) {
+            paths[count] = fw_strdup(dir->path);
+            if (paths[count]) {
+                generations[count] = dir->generation;
+                count++;
+            }
+        }
+    }
+    xSemaphoreGive(g_watch.lock);
+
+    for (int i = 0; i < count; i++) {
+        uint32_t fingerprint = compute_fingerprint(paths[i]);
+
+        xSemaphoreTake(g_watch.lock, portMAX_DELAY);
+        watch_dir_t* dir = dir_find(paths[i]);
+        // 检查期间通过fs_watch报告过的变化已经通知，只更新指纹
+        if (dir && dir->generation == generations[i]) {
+            if (dir->fingerprint_valid && dir->fingerprint != fingerprint) {
+                printf("FS watch: external change in %s\n", paths[i]);
+                dir->generation = ++g_watch.counter;
+                dir->pending = true;
+                g_watch.reports++;
+            }
+            dir->fingerprint = fingerprint;
+            dir->fingerprint_valid = true;
+        }
+        xSemaphoreGive(g_watch.lock);
+        fw_free(paths[i]);
+    }
+}
+
+// 把合并后的变化通知订阅者（回调时不持有锁）
+static void deliver_pending(void) {
+    char* paths[FS_WATCH_MAX_DIRS];
+    int count = 0;
+    watch_subscriber_t subscribers[FS_WATCH_MAX_SUBSCRIBERS];
+
+    xSemaphoreTake(g_watch.lock, portMAX_DELAY);
+    bool overflow = g_watch.overflow;
+    uint32_t reports = g_watch.reports;
+    g_watch.overflow = false;
+    g_watch.reports = 0;
+    for (int i = 0; i < FS_WATCH_MAX_DIRS; i++) {
+        watch_dir_t* dir = &g_watch.dirs[i];
+        if (dir->pending) {
+            dir->pending = false;
+            if (!overflow) {
+                paths[count] = fw_strdup(dir->path);
+                if (paths[count]) {
+                    count++;
+                } else {
+                    overflow = true;
+                }
+            }
+        }
+    }
+    memcpy(subscribers, g_watch.subscribers, sizeof(subscribers));
+    xSemaphoreGive(g_watch.lock);
+
+    if (!overflow && count == 0) {
+        return;
+    }
+
+    // 整张卡已变化时逐个目录的通知没有意义
+    if (overflow) {
+        for (int i = 0; i < count; i++) {
+            fw_free(paths[i]);
+        }
+        count = 0;
+        printf("FS watch: too many changes (%lu reports), notifying whole card\n", (unsigned long)reports);
+    } else {
+        printf("FS watch: %d dirs changed (%lu reports)\n", count, (unsigned long)reports);
+    }
+
+    for (int s = 0; s < FS_WATCH_MAX_SUBSCRIBERS; s++) {
+        if (!subscribers[s].cb) {
+            continue;
+        }
+        if (overflow) {
+            subscribers[s].cb(hal_sdcard_get_mount_point(), true, subscribers[s].user_data);
+        }
+        for (int i = 0; i < count; i++) {
+            subscribers[s].cb(paths[i], false, subscribers[s].user_data);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        fw_free(paths[i]);
+    }
+}
+
+static void fs_watch_task(void* arg) {
+    (void)arg;
+
+    while (true) {
+        if (xSemaphoreTake(g_watch.wake, pdMS_TO_TICKS(FS_WATCH_SCAN_INTERVAL_MS)) == pdTRUE) {
+            // 连续的写入（复制、解压）在等待期间合并为一次通知
+            vTaskDelay(pdMS_TO_TICKS(FS_WATCH_COALESCE_MS));
+        } else {
+            scan_watched();
+        }
+        deliver_pending();
+    }
+}
+
+// SD卡插拔：所有目录的版本号都前进，订阅者各自处理挂载事件
+static void sdcard_event_cb(hal_sdcard_event_t event, uint32_t generation, void* user_data) {
+    (void)generation;
+    (void)user_data;
+    if (event == HAL_SDCARD_EVENT_UNMOUNTING) {
+        return;
+    }
+
+    xSemaphoreTake(g_watch.lock, portMAX_DELAY);
+    for (int i = 0; i < FS_WATCH_MAX_DIRS; i++) {
+        watch_dir_t* dir = &g_watch.dirs[i];
+        if (!dir->path) {
+            continue;
+        }
+        if (dir->watch_refs == 0) {
+            fw_free(dir->path);
+            memset(dir, 0, sizeof(watch_dir_t));
+            continue;
+        }
+        dir->generation = ++g_watch.counter;
+        dir->fingerprint_valid = false;
+        dir->pending = false;
+    }
+    g_watch.base_generation = ++g_watch.counter;
+    g_watch.overflow = false;
+    xSemaphoreGive(g_watch.lock);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Public API                                 */
+/* -------------------------------------------------------------------------- */
+
+bool fs_watch_init(void) {
+    if (g_watch.task) {
+        return true;
+    }
+    if (!ensure_locks()) {
+        printf("Failed to create FS watch semaphores\n");
+        return false;
+    }
+
+    if (xTaskCreate(fs_watch_task, "fs_watch", FS_WATCH_TASK_STACK, NULL,
+                    FS_WATCH_TASK_PRIORITY, &g_watch.task) != pdPASS) {
+        printf("Failed to create FS watch task\n");
+        g_watch.task = NULL;
+        return false;
+    }
+
+    hal_sdcard_add_listener(sdcard_event_cb, NULL);
+    printf("FS watch initialized\n");
+    return true;
+}
+
+void fs_watch_dir_changed(const char* dir_path) {
+    char path[FS_WATCH_MAX_PATH];
+    if (!g_watch.lock || !normalize_path(dir_path, path, sizeof(path))) {
+        return;
+    }
+
+    xSemaphoreTake(g_watch.lock, portMAX_DELAY);
+    mark_changed(path);
+    xSemaphoreGive(g_watch.lock);
+    xSemaphoreGive(g_watch.wake);
+}
+
+void fs_watch_path_changed(const char* path) {
+    char parent[FS_WATCH_MAX_PATH];
+    if (!g_watch.lock || !normalize_path(path, parent, sizeof(parent))) {
+        return;
+    }
+
+    // 上级目录；挂载点本身的变化记在挂载点上
+    char* slash = strrchr(parent, '/');
+    size_t mount_len = strlen(hal_sdcard_get_mount_point());
+    if (slash && (size_t)(slash - parent) >= mount_len) {
+        *slash = '\0';
+    }
+    fs_watch_dir_changed(parent);
+}
+
+uint32_t fs_watch_get_generation(const char* dir_path) {
+    char path[FS_WATCH_MAX_PATH];
+    if (!g_watch.lock || !normalize_path(dir_path, path, sizeof(path))) {
+        return hal_sdcard_get_generation();
+    }
+
+    xSemaphoreTake(g_watch.lock, portMAX_DELAY);
+    watch_dir_t* dir = dir_find(path);
+    uint32_t generation = dir ? dir->generation : g_watch.base_generation;
+    xSemaphoreGive(g_watch.lock);
+    return generation;
+}
+
+bool fs_watch_add_dir(const char* dir_path) {
+    char path[FS_WATCH_MAX_PATH];
+    if (!ensure_locks() || !normalize_path(dir_path, path, sizeof(path))) {
+        return false;
+    }
+
+    xSemaphoreTake(g_watch.lock, portMAX_DELAY);
+    watch_dir_t* dir = dir_get(path);
+    if (dir) {
+        dir->watch_refs++;
+    }
+    xSemaphoreGive(g_watch.lock);
+    return dir != NULL;
+}
+
+void fs_watch_remove_dir(const char* dir_path) {
+    char path[FS_WATCH_MAX_PATH];
+    if (!g_watch.lock || !normalize_path(dir_path, path, sizeof(path))) {
+        return;
+    }
+
+    xSemaphoreTake(g_watch.lock, portMAX_DELAY);
+    watch_dir_t* dir = dir_find(path);
+    if (dir && dir->watch_refs > 0) {
+        dir->watch_refs--;
+    }
+    xSemaphoreGive(g_watch.lock);
+}
+
+bool fs_watch_subscribe(fs_watch_cb_t cb, void* user_data) {
+    if (!cb || !ensure_locks()) {
+        return false;
+    }
+
+    bool added = false;
+    xSemaphoreTake(g_watch.lock, portMAX_DELAY);
+    for (int i = 0; i < FS_WATCH_MAX_SUBSCRIBERS && !added; i++) {
+        if (!g_watch.subscribers[i].cb) {
+            g_watch.subscribers[i].cb = cb;
+            g_watch.subscribers[i].user_data = user_data;
+            added = true;
+        }
+    }
+    xSemaphoreGive(g_watch.lock);
+
+    if (!added) {
+        printf("FS watch subscriber table full\n");
+    }
+    return added;
+}
+
+void fs_watch_unsubscribe(fs_watch_cb_t cb, void* user_data) {
+    if (!cb || !g_watch.lock) {
+        return;
+    }
+
+    xSemaphoreTake(g_watch.lock, portMAX_DELAY);
+    for (int i = 0; i < FS_WATCH_MAX_SUBSCRIBERS; i++) {
+        if (g_watch.subscribers[i].cb == cb && g_watch.subscribers[i].user_data == user_data) {
+            g_watch.subscribers[i].cb = NULL;
+            g_watch.subscribers[i].user_data = NULL;
+        }
+    }
+    xSemaphoreGive(g_watch.lock);
+}
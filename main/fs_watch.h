@@ -0,0 +1,75 @@
+#ifndef FS_WATCH_H
+#define FS_WATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 目录变化通知
+ *
+ * 在监视任务中调用（不是LVGL任务），不能阻塞，也不能操作LVGL对象。
+ *
+ * @param dir_path 内容发生变化的目录
+ * @param recursive true表示目录下任意位置都可能变化（变化过多无法逐个记录时）
+ */
+typedef void (*fs_watch_cb_t)(const char* dir_path, bool recursive, void* user_data);
+
+/**
+ * @brief 初始化变化监视（启动后台任务，可重复调用）
+ */
+bool fs_watch_init(void);
+
+/**
+ * @brief 报告目录内容已改变（创建、删除、重命名或写入了其中的条目）
+ *
+ * 立即增加目录的版本号；短时间内的多次报告合并为一次通知。
+ */
+void fs_watch_dir_changed(const char* dir_path);
+
+/**
+ * @brief 报告文件或目录已改变，等同于对其上级目录调用fs_watch_dir_changed
+ */
+void fs_watch_path_changed(const char* path);
+
+/**
+ * @brief 获取目录的版本号
+ *
+ * 目录内容改变或SD卡插拔后版本号变化。缓存保存扫描前取得的版本号，
+ * 使用前比较即可判断是否需要重新扫描。
+ */
+uint32_t fs_watch_get_generation(const char* dir_path);
+
+/**
+ * @brief 后台定期检查目录（发现外部修改），引用计数
+ *
+ * FAT不会在目录内容变化时更新目录的修改时间，
+ * 因此比较的是目录条目（名称、大小、修改时间）的指纹。
+ */
+bool fs_watch_add_dir(const char* dir_path);
+
+/**
+ * @brief 取消fs_watch_add_dir
+ */
+void fs_watch_remove_dir(const char* dir_path);
+
+/**
+ * @brief 订阅目录变化通知
+ *
+ * @return 订阅表已满返回false
+ */
+bool fs_watch_subscribe(fs_watch_cb_t cb, void* user_data);
+
+/**
+ * @brief 取消订阅
+ */
+void fs_watch_unsubscribe(fs_watch_cb_t cb, void* user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FS_WATCH_H
@@ -1,13 +1,8 @@
 #include "gui.h"
 #include "app_manager.h"
 #include "overlay_drawer.h"
-#include "app_launcher.h"
-#include "app_settings.h"
-#include "app_music_player.h"
-#include "app_file_manager.h"
-#include "app_pwm_servo.h"
-#include "app_photo.h"  // 添加照片应用头文件
 #include "gesture_handler.h"
+#include "file_types.h"
 //#include "app_test.h"
 
 // 包含自定义字体（只包含一次）
@@ -15,20 +10,15 @@
 
 void gui_init(lv_disp_t *disp) 
 {
-    // 初始化应用管理器
+    // 初始化应用管理器（应用由各自的APP_DEFINE描述，在此收集）
     app_manager_init();
     
+    // 建立文件类型注册表（文件管理器、音乐播放器共用）
+    file_types_init();
+    
     // 注册Overlay（按z_index顺序）
     register_drawer_overlay();      // z_index=50
     
-    // 注册应用
-    register_launcher_app();  
-    register_file_manager_app();
-    register_pwm_servo_app();
-    register_photo_app();
-    register_settings_app();
-    register_music_player_app();
-    
     // 启动所有auto_start的Overlay
     overlay_t* overlay = app_manager_get_overlay_list();
     while (overlay) {
@@ -44,6 +34,11 @@ void gui_init(lv_disp_t *disp)
     // 启动启动器应用
     app_manager_go_to_launcher();
     
+#ifdef CONFIG_IMOS_APP_LEAK_CHECK
+    // 反复启动关闭各应用，检查定时器和内存是否回到原值
+    app_manager_start_leak_check(CONFIG_IMOS_APP_LEAK_CHECK_LAUNCHES);
+#endif
+    
     // 运行系统测试（可选，调试时使用）
     // #ifdef DEBUG_SYSTEM_TESTS
     // run_system_tests();
@@ -1,4 +1,6 @@
 #include "hal.h"
+#include "io_sched.h"
+#include "fs_watch.h"
 //#include "system_test.h"
 #include <stdio.h>
 #include <freertos/FreeRTOS.h>
@@ -47,8 +49,12 @@ void hal_init(void)
     // Initialize touchpad
     hal_touchpad_init();
 
-    // Initialize SD card
+    // Initialize SD card and the I/O scheduler that arbitrates access to it.
+    // The scheduler also starts without a card so a later hot-plug can use it.
     hal_sdcard_init();
+    io_sched_init();
+    fs_watch_init();
+    hal_sdcard_start_monitor();
 
     g_hal_initialized = true;
     printf("HAL initialized successfully\n");
@@ -8,6 +8,7 @@
 #include "hal_audio.h"
 #include "hal_display.h"
 #include "hal_sdcard.h"
+#include "hal_event.h"
 
 #ifdef __cplusplus
 extern "C" {
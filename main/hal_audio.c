@@ -1,4 +1,6 @@
 #include "hal_audio.h"
+#include "media_stream.h"
+#include "hal_event.h"
 #include <bsp/esp-bsp.h>
 #include <stdio.h>
 #include <string.h>
@@ -7,6 +9,7 @@
 #include <freertos/semphr.h>
 #include <audio_player.h>
 #include <esp_err.h>
+#include <esp_timer.h>
 #include <driver/i2c_master.h>
 
 // PI4IOE5V寄存器定义 (与参考代码保持一致)
@@ -193,8 +196,11 @@ typedef struct {
     bool is_playing;
     bool is_initialized;
     uint32_t start_time;
+    int64_t start_us;
     uint32_t duration;
+    uint32_t finished_count;            // Tracks that played to the end
     char current_file[256];
+    esp_timer_handle_t position_timer;  // Publishes HAL_EVENT_PLAYBACK_POSITION once a second
     SemaphoreHandle_t mp3_mutex;
 } mp3_state_t;
 
@@ -212,8 +218,11 @@ static mp3_state_t g_mp3_state = {
     .is_playing = false,
     .is_initialized = false,
     .start_time = 0,
+    .start_us = 0,
     .duration = 0,
+    .finished_count = 0,
     .current_file = {0},
+    .position_timer = NULL,
     .mp3_mutex = NULL
 };
 
@@ -287,6 +296,7 @@ void hal_set_speaker_volume(uint8_t volume)
         
         printf("Set speaker volume: %d%%\n", g_audio_state.current_volume);
         xSemaphoreGive(g_audio_state.audio_mutex);
+        hal_event_publish(HAL_EVENT_VOLUME, g_audio_state.current_volume);
     }
 }
 
@@ -434,6 +444,38 @@ size_t hal_audio_record(int16_t* buffer, size_t buffer_size, uint32_t duration_m
 // Forward declaration for audio reconfiguration
 static esp_err_t hal_audio_force_reconfig(uint32_t sample_rate, uint32_t bits_per_sample, i2s_slot_mode_t slot_mode);
 
+// Publish the playback position; started at playback start so ticks land on whole seconds
+static void mp3_position_timer_cb(void* arg)
+{
+    (void)arg;
+    int64_t elapsed_us = esp_timer_get_time() - g_mp3_state.start_us;
+    hal_event_publish(HAL_EVENT_PLAYBACK_POSITION, (uint32_t)(elapsed_us / 1000000));
+}
+
+static void mp3_position_timer_start(void)
+{
+    if (g_mp3_state.position_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = mp3_position_timer_cb,
+            .name = "mp3_pos",
+        };
+        if (esp_timer_create(&args, &g_mp3_state.position_timer) != ESP_OK) {
+            printf("Failed to create MP3 position timer\n");
+            g_mp3_state.position_timer = NULL;
+            return;
+        }
+    }
+    esp_timer_stop(g_mp3_state.position_timer);
+    esp_timer_start_periodic(g_mp3_state.position_timer, 1000000);
+}
+
+static void mp3_position_timer_stop(void)
+{
+    if (g_mp3_state.position_timer) {
+        esp_timer_stop(g_mp3_state.position_timer);
+    }
+}
+
 // Audio player callback for MP3 playback
 static void mp3_audio_player_callback(audio_player_cb_ctx_t* ctx)
 {
@@ -444,11 +486,23 @@ static void mp3_audio_player_callback(audio_player_cb_ctx_t* ctx)
     
     if (state == AUDIO_PLAYER_STATE_IDLE) {
         if (xSemaphoreTake(g_mp3_state.mp3_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            // hal_audio_stop_mp3() clears is_playing first, so this is a natural end
+            bool finished = g_mp3_state.is_playing;
             g_mp3_state.is_playing = false;
             // Reset override flag when playback finishes
             g_override_audio_player_config = false;
+            mp3_position_timer_stop();
+            if (finished) {
+                g_mp3_state.finished_count++;
+            }
+            uint32_t finished_count = g_mp3_state.finished_count;
             printf("MP3 playback finished\n");
             xSemaphoreGive(g_mp3_state.mp3_mutex);
+            
+            hal_event_publish(HAL_EVENT_PLAYBACK_STATE, 0);
+            if (finished) {
+                hal_event_publish(HAL_EVENT_PLAYBACK_FINISHED, finished_count);
+            }
         }
     }
 }
@@ -644,8 +698,8 @@ bool hal_audio_play_mp3_file(const char* file_path)
         // Register callback
         audio_player_callback_register(mp3_audio_player_callback, NULL);
         
-        // Open and play MP3 file
-        FILE* fp = fopen(file_path, "rb");
+        // Open and play MP3 file (large read-ahead, scheduled ahead of bulk card jobs)
+        FILE* fp = media_stream_fopen(file_path, NULL);
         if (!fp) {
             printf("Failed to open MP3 file: %s\n", file_path);
             audio_player_delete();
@@ -678,15 +732,20 @@ bool hal_audio_play_mp3_file(const char* file_path)
         // Update state
         g_mp3_state.is_playing = true;
         g_mp3_state.is_initialized = true;
-        g_mp3_state.start_time = (uint32_t)(esp_timer_get_time() / 1000000);
+        g_mp3_state.start_us = esp_timer_get_time();
+        g_mp3_state.start_time = (uint32_t)(g_mp3_state.start_us / 1000000);
         g_mp3_state.duration = 0; // Duration not available from audio_player
         strncpy(g_mp3_state.current_file, file_path, sizeof(g_mp3_state.current_file) - 1);
         g_mp3_state.current_file[sizeof(g_mp3_state.current_file) - 1] = '\0';
+        mp3_position_timer_start();
         
         printf("Started MP3 playback: %s at %lu Hz (override active: %s)\n", 
                file_path, (unsigned long)detected_sample_rate, 
                g_override_audio_player_config ? "yes" : "no");
         xSemaphoreGive(g_mp3_state.mp3_mutex);
+        
+        hal_event_publish(HAL_EVENT_PLAYBACK_STATE, 1);
+        hal_event_publish(HAL_EVENT_PLAYBACK_POSITION, 0);
         return true;
     }
     
@@ -701,26 +760,35 @@ void hal_audio_stop_mp3(void)
     }
     
     if (xSemaphoreTake(g_mp3_state.mp3_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
+        bool stopped = false;
         if (g_mp3_state.is_playing) {
             printf("Stopping MP3 playback\n");
             
-            // Reset override flag
+            // Reset override flag; clear is_playing first so the IDLE callback
+            // does not report the stop as a finished track
             g_override_audio_player_config = false;
+            g_mp3_state.is_playing = false;
+            mp3_position_timer_stop();
             
             esp_err_t ret = audio_player_delete();
             if (ret != ESP_OK) {
                 printf("Failed to delete audio player: %s\n", esp_err_to_name(ret));
             }
             
-            g_mp3_state.is_playing = false;
             g_mp3_state.is_initialized = false;
             g_mp3_state.start_time = 0;
+            g_mp3_state.start_us = 0;
             g_mp3_state.duration = 0;
             g_mp3_state.current_file[0] = '\0';
+            stopped = true;
             
             printf("MP3 playback stopped\n");
         }
         xSemaphoreGive(g_mp3_state.mp3_mutex);
+        
+        if (stopped) {
+            hal_event_publish(HAL_EVENT_PLAYBACK_STATE, 0);
+        }
     }
 }
 
@@ -748,8 +816,7 @@ uint32_t hal_audio_get_mp3_position(void)
     uint32_t position = 0;
     if (xSemaphoreTake(g_mp3_state.mp3_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
         if (g_mp3_state.is_playing) {
-            uint32_t current_time = (uint32_t)(esp_timer_get_time() / 1000000);
-            position = current_time - g_mp3_state.start_time;
+            position = (uint32_t)((esp_timer_get_time() - g_mp3_state.start_us) / 1000000);
         }
         xSemaphoreGive(g_mp3_state.mp3_mutex);
     }
@@ -789,6 +856,7 @@ void hal_set_speaker_enable(bool enable)
         }
         
         xSemaphoreGive(g_audio_state.audio_mutex);
+        hal_event_publish(HAL_EVENT_SPEAKER, enable ? 1 : 0);
     }
 }
 
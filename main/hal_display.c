@@ -1,4 +1,5 @@
 #include "hal_display.h"
+#include "hal_event.h"
 #include <bsp/esp-bsp.h>
 #include <stdio.h>
 #include <freertos/FreeRTOS.h>
@@ -148,6 +149,7 @@ void hal_set_display_brightness(uint8_t brightness)
     bsp_display_brightness_set(g_display_state.current_brightness);
     
     printf("Set display brightness: %d%%\n", g_display_state.current_brightness);
+    hal_event_publish(HAL_EVENT_BRIGHTNESS, g_display_state.current_brightness);
 }
 
 uint8_t hal_get_display_brightness(void)
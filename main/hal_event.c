@@ -0,0 +1,141 @@
+#include "hal_event.h"
+#include "lvgl.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define HAL_EVENT_MAX_SUBSCRIBERS 24
+#define HAL_EVENT_POLL_MS 10            // Delivery delay after a publish, well below one frame (33 ms)
+
+typedef struct {
+    hal_event_type_t type;
+    hal_event_cb_t cb;                  // NULL for a free slot
+    void* user_data;
+} hal_event_subscriber_t;
+
+// Latest value per type; a set bit in pending means the value has not been delivered yet
+static struct {
+    atomic_uint values[HAL_EVENT_TYPE_COUNT];
+    atomic_uint published;              // Bit per type that has ever been published
+    atomic_uint pending;
+    lv_timer_t* _Atomic timer;          // Set once by hal_event_init(); publishers only resume it
+    // LVGL task only from here on
+    hal_event_subscriber_t subscribers[HAL_EVENT_MAX_SUBSCRIBERS];
+} g_hal_event;
+
+// 在LVGL任务中分发待处理的事件
+static void hal_event_timer_cb(lv_timer_t* timer)
+{
+    uint32_t pending = atomic_exchange(&g_hal_event.pending, 0);
+    if (pending == 0) {
+        // 没有事件时暂停，由hal_event_publish恢复。先暂停再检查：
+        // 检查之后才置位的发布者看到的旧值为0，会在暂停之后恢复定时器
+        lv_timer_pause(timer);
+        if (atomic_load(&g_hal_event.pending) != 0) {
+            lv_timer_resume(timer);
+        }
+        return;
+    }
+
+    for (int type = 0; type < HAL_EVENT_TYPE_COUNT; type++) {
+        if (!(pending & (1u << type))) {
+            continue;
+        }
+
+        hal_event_t event = {
+            .type = (hal_event_type_t)type,
+            .value = atomic_load(&g_hal_event.values[type]),
+        };
+
+        // 回调中取消订阅只清空槽位，不移动表项
+        for (int i = 0; i < HAL_EVENT_MAX_SUBSCRIBERS; i++) {
+            hal_event_subscriber_t* sub = &g_hal_event.subscribers[i];
+            if (sub->cb && sub->type == event.type) {
+                sub->cb(&event, sub->user_data);
+            }
+        }
+    }
+}
+
+void hal_event_init(void)
+{
+    if (g_hal_event.timer) {
+        return;
+    }
+
+    g_hal_event.timer = lv_timer_create(hal_event_timer_cb, HAL_EVENT_POLL_MS, NULL);
+    if (!g_hal_event.timer) {
+        printf("Failed to create HAL event timer\n");
+        return;
+    }
+    printf("HAL event bus initialized\n");
+}
+
+void hal_event_publish(hal_event_type_t type, uint32_t value)
+{
+    if ((unsigned)type >= HAL_EVENT_TYPE_COUNT) {
+        return;
+    }
+
+    // 先写值再置位，分发时读到的值不会比标志旧
+    atomic_store(&g_hal_event.values[type], value);
+    atomic_fetch_or(&g_hal_event.published, 1u << type);
+
+    // 只有从无到有时才需要唤醒分发定时器
+    uint32_t was_pending = atomic_fetch_or(&g_hal_event.pending, 1u << type);
+    lv_timer_t* timer = atomic_load(&g_hal_event.timer);
+    if (was_pending == 0 && timer) {
+        lv_timer_resume(timer);
+    }
+}
+
+bool hal_event_get_last(hal_event_type_t type, uint32_t* value)
+{
+    if ((unsigned)type >= HAL_EVENT_TYPE_COUNT ||
+        !(atomic_load(&g_hal_event.published) & (1u << type))) {
+        return false;
+    }
+    if (value) {
+        *value = atomic_load(&g_hal_event.values[type]);
+    }
+    return true;
+}
+
+bool hal_event_subscribe(hal_event_type_t type, hal_event_cb_t cb, void* user_data)
+{
+    if (!cb || (unsigned)type >= HAL_EVENT_TYPE_COUNT) {
+        return false;
+    }
+    hal_event_init();
+
+    hal_event_subscriber_t* free_slot = NULL;
+    for (int i = 0; i < HAL_EVENT_MAX_SUBSCRIBERS; i++) {
+        hal_event_subscriber_t* sub = &g_hal_event.subscribers[i];
+        if (sub->cb == cb && sub->type == type && sub->user_data == user_data) {
+            return true;
+        }
+        if (!sub->cb && !free_slot) {
+            free_slot = sub;
+        }
+    }
+
+    if (!free_slot) {
+        printf("HAL event subscriber table full\n");
+        return false;
+    }
+    free_slot->type = type;
+    free_slot->user_data = user_data;
+    free_slot->cb = cb;
+    return true;
+}
+
+void hal_event_unsubscribe(hal_event_type_t type, hal_event_cb_t cb, void* user_data)
+{
+    for (int i = 0; i < HAL_EVENT_MAX_SUBSCRIBERS; i++) {
+        hal_event_subscriber_t* sub = &g_hal_event.subscribers[i];
+        if (sub->cb == cb && sub->type == type && sub->user_data == user_data) {
+            memset(sub, 0, sizeof(hal_event_subscriber_t));
+            return;
+        }
+    }
+}
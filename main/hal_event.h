@@ -0,0 +1,96 @@
+#ifndef HAL_EVENT_H
+#define HAL_EVENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief HAL state change types
+ *
+ * Each event carries the new value of one piece of HAL state. Events of the
+ * same type published before the LVGL task runs are coalesced, so subscribers
+ * always see the latest value rather than every intermediate one.
+ */
+typedef enum {
+    HAL_EVENT_PLAYBACK_STATE = 0,   ///< value: 1 while an MP3 is playing, 0 otherwise
+    HAL_EVENT_PLAYBACK_FINISHED,    ///< value: number of tracks that reached their end
+    HAL_EVENT_PLAYBACK_POSITION,    ///< value: playback position in seconds (published once a second)
+    HAL_EVENT_VOLUME,               ///< value: speaker volume 0-100
+    HAL_EVENT_BRIGHTNESS,           ///< value: display brightness 0-100
+    HAL_EVENT_SPEAKER,              ///< value: 1 if the speaker amplifier is enabled
+    HAL_EVENT_SDCARD,               ///< value: mount generation, see hal_sdcard_is_mounted() for the state
+    HAL_EVENT_TYPE_COUNT
+} hal_event_type_t;
+
+/**
+ * @brief Event delivered to subscribers
+ */
+typedef struct {
+    hal_event_type_t type;
+    uint32_t value;
+} hal_event_t;
+
+/**
+ * @brief Event subscriber
+ *
+ * Always called from the LVGL task, so subscribers may update LVGL objects
+ * directly. They must not block.
+ */
+typedef void (*hal_event_cb_t)(const hal_event_t* event, void* user_data);
+
+/**
+ * @brief Initialize the event bus
+ *
+ * Publishing works before initialization; delivery starts once the bus has
+ * been initialized from the LVGL task (the first subscription does this).
+ */
+void hal_event_init(void);
+
+/**
+ * @brief Publish a state change
+ *
+ * Lock-free and safe to call from any task (not from an ISR: it may resume
+ * the LVGL dispatch timer). The value is stored and delivered to the
+ * subscribers of the type on the next LVGL timer run. The dispatch timer is
+ * paused while nothing is pending, so an idle bus causes no wakeups.
+ *
+ * @param type Event type
+ * @param value New value
+ */
+void hal_event_publish(hal_event_type_t type, uint32_t value);
+
+/**
+ * @brief Get the last value published for a type
+ *
+ * @param type Event type
+ * @param value Output for the value
+ * @return false if nothing has been published for the type yet
+ */
+bool hal_event_get_last(hal_event_type_t type, uint32_t* value);
+
+/**
+ * @brief Subscribe to one event type (LVGL task only)
+ *
+ * @param type Event type
+ * @param cb Subscriber callback
+ * @param user_data User pointer passed to the callback
+ * @return true on success, false if the subscriber table is full
+ */
+bool hal_event_subscribe(hal_event_type_t type, hal_event_cb_t cb, void* user_data);
+
+/**
+ * @brief Remove a subscription made with hal_event_subscribe() (LVGL task only)
+ *
+ * Safe to call from inside a subscriber callback.
+ */
+void hal_event_unsubscribe(hal_event_type_t type, hal_event_cb_t cb, void* user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HAL_EVENT_H
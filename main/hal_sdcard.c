@@ -1,69 +1,183 @@
 #include "hal_sdcard.h"
+#include "hal_event.h"
 #include <bsp/esp-bsp.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/semphr.h>
 #include <esp_vfs_fat.h>
 #include <sdmmc_cmd.h>
+#include <esp_timer.h>
+#include <ff.h>
+#include <diskio.h>
+#include <esp_heap_caps.h>
+#include <stdatomic.h>
 
 // SD card mount point
 #define SD_MOUNT_POINT "/sdcard"
 #define SD_MAX_FILES 10
 
+// FatFS logical drive of the SD card (the only FAT volume on this board)
+#define SD_FATFS_DRIVE "0:"
+#define SD_FATFS_PDRV 0
+
+// Hot-plug monitor
+#define SD_MONITOR_STACK_SIZE 4096
+#define SD_MONITOR_PRIORITY 2
+#define SD_PROBE_INTERVAL_MS 1000       // Probe period while mounted
+#define SD_PROBE_FAILURES 2             // Consecutive failed probes before unmounting
+#define SD_RETRY_MIN_MS 2000            // Mount retry back-off while unmounted
+#define SD_RETRY_MAX_MS 10000
+#define SD_MAX_LISTENERS 8
+#define SD_DRAIN_TIMEOUT_MS 3000        // Max wait for in-flight I/O before unmounting
+#define SD_DRAIN_POLL_MS 10
+
+typedef struct {
+    hal_sdcard_event_cb_t cb;
+    void* user_data;
+} sdcard_listener_t;
+
 // SD card state
 typedef struct {
-    bool is_mounted;
-    SemaphoreHandle_t mutex;
+    atomic_bool is_mounted;         // Read lock-free by hal_sdcard_is_mounted()
+    atomic_bool unmounting;         // Set while draining I/O before deinit
+    atomic_uint io_in_flight;       // Open hal_sdcard_io_begin() sections
+    atomic_uint generation;         // Bumped on every mount/unmount
+    SemaphoreHandle_t mutex;        // Serializes mount/unmount
+    SemaphoreHandle_t listener_lock;
+    sdcard_listener_t listeners[SD_MAX_LISTENERS];
+    TaskHandle_t monitor_task;
     char mount_point[32];
 } sdcard_state_t;
 
 // Global SD card state
 static sdcard_state_t g_sdcard_state = {
     .is_mounted = false,
+    .unmounting = false,
+    .io_in_flight = 0,
+    .generation = 0,
     .mutex = NULL,
+    .listener_lock = NULL,
+    .monitor_task = NULL,
     .mount_point = SD_MOUNT_POINT
 };
 
-bool hal_sdcard_init(void)
+static bool ensure_locks(void)
 {
-    // Create mutex if not already created
     if (g_sdcard_state.mutex == NULL) {
         g_sdcard_state.mutex = xSemaphoreCreateMutex();
-        if (g_sdcard_state.mutex == NULL) {
-            printf("Failed to create SD card mutex\n");
-            return false;
+    }
+    if (g_sdcard_state.listener_lock == NULL) {
+        g_sdcard_state.listener_lock = xSemaphoreCreateMutex();
+    }
+    if (g_sdcard_state.mutex == NULL || g_sdcard_state.listener_lock == NULL) {
+        printf("Failed to create SD card mutex\n");
+        return false;
+    }
+    return true;
+}
+
+// 通知监听者（在锁外调用回调，回调中可以注册/注销监听者）
+static void notify_listeners(hal_sdcard_event_t event, uint32_t generation)
+{
+    sdcard_listener_t listeners[SD_MAX_LISTENERS];
+    xSemaphoreTake(g_sdcard_state.listener_lock, portMAX_DELAY);
+    memcpy(listeners, g_sdcard_state.listeners, sizeof(listeners));
+    xSemaphoreGive(g_sdcard_state.listener_lock);
+
+    for (int i = 0; i < SD_MAX_LISTENERS; i++) {
+        if (listeners[i].cb) {
+            listeners[i].cb(event, generation, listeners[i].user_data);
+        }
+    }
+}
+
+// 等待进行中的读写结束（超时后照常卸载，残留的读写会返回错误）
+static void drain_io(void)
+{
+    int64_t start = esp_timer_get_time();
+    while (atomic_load(&g_sdcard_state.io_in_flight) > 0) {
+        if (esp_timer_get_time() - start > (int64_t)SD_DRAIN_TIMEOUT_MS * 1000) {
+            printf("SD card: %u I/O sections still active, unmounting anyway\n",
+                   (unsigned)atomic_load(&g_sdcard_state.io_in_flight));
+            return;
         }
+        vTaskDelay(pdMS_TO_TICKS(SD_DRAIN_POLL_MS));
     }
+}
 
-    if (xSemaphoreTake(g_sdcard_state.mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        // Check if already mounted
-        if (g_sdcard_state.is_mounted) {
+// 挂载或卸载并广播事件；quiet用于监视任务的重试，避免无卡时反复打印
+static bool set_mounted(bool mount, bool quiet)
+{
+    if (!ensure_locks()) {
+        return false;
+    }
+    if (xSemaphoreTake(g_sdcard_state.mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        printf("Failed to acquire SD card mutex\n");
+        return false;
+    }
+
+    bool mounted = atomic_load(&g_sdcard_state.is_mounted);
+    if (mounted == mount) {
+        xSemaphoreGive(g_sdcard_state.mutex);
+        if (mount && !quiet) {
             printf("SD card already mounted\n");
-            xSemaphoreGive(g_sdcard_state.mutex);
-            return true;
         }
+        return true;
+    }
 
-        printf("Mounting SD card...\n");
-        
+    esp_err_t ret;
+    if (mount) {
+        if (!quiet) {
+            printf("Mounting SD card...\n");
+        }
         // Initialize SD card using BSP function
-        esp_err_t ret = bsp_sdcard_init(g_sdcard_state.mount_point, SD_MAX_FILES);
-        if (ret == ESP_OK) {
-            g_sdcard_state.is_mounted = true;
-            printf("SD card mounted successfully at %s\n", g_sdcard_state.mount_point);
-            xSemaphoreGive(g_sdcard_state.mutex);
-            return true;
-        } else {
-            printf("Failed to mount SD card: %s\n", esp_err_to_name(ret));
-            g_sdcard_state.is_mounted = false;
+        ret = bsp_sdcard_init(g_sdcard_state.mount_point, SD_MAX_FILES);
+        if (ret != ESP_OK) {
+            if (!quiet) {
+                printf("Failed to mount SD card: %s\n", esp_err_to_name(ret));
+            }
             xSemaphoreGive(g_sdcard_state.mutex);
             return false;
         }
+        printf("SD card mounted successfully at %s\n", g_sdcard_state.mount_point);
     } else {
-        printf("Failed to acquire SD card mutex\n");
-        return false;
+        printf("Unmounting SD card...\n");
+        // 先让使用者停止读写并等待进行中的读写结束，再释放驱动
+        atomic_store(&g_sdcard_state.unmounting, true);
+        notify_listeners(HAL_SDCARD_EVENT_UNMOUNTING, atomic_load(&g_sdcard_state.generation));
+        drain_io();
+
+        // Deinitialize SD card using BSP function
+        ret = bsp_sdcard_deinit(g_sdcard_state.mount_point);
+        if (ret != ESP_OK) {
+            // 驱动仍然持有卡：保持挂载状态，监视任务下次探测失败时重试
+            printf("Failed to unmount SD card: %s\n", esp_err_to_name(ret));
+            atomic_store(&g_sdcard_state.unmounting, false);
+            xSemaphoreGive(g_sdcard_state.mutex);
+            return false;
+        }
+        printf("SD card unmounted successfully\n");
     }
+
+    atomic_store(&g_sdcard_state.is_mounted, mount);
+    atomic_store(&g_sdcard_state.unmounting, false);
+    uint32_t generation = atomic_fetch_add(&g_sdcard_state.generation, 1) + 1;
+    xSemaphoreGive(g_sdcard_state.mutex);
+
+    notify_listeners(mount ? HAL_SDCARD_EVENT_MOUNTED : HAL_SDCARD_EVENT_UNMOUNTED, generation);
+    hal_event_publish(HAL_EVENT_SDCARD, generation);
+    return true;
+}
+
+bool hal_sdcard_init(void)
+{
+    return set_mounted(true, false);
 }
 
 void hal_sdcard_deinit(void)
@@ -71,42 +185,422 @@ void hal_sdcard_deinit(void)
     if (g_sdcard_state.mutex == NULL) {
         return;
     }
+    set_mounted(false, false);
+}
+
+bool hal_sdcard_is_mounted(void)
+{
+    return atomic_load(&g_sdcard_state.is_mounted) && !atomic_load(&g_sdcard_state.unmounting);
+}
+
+bool hal_sdcard_io_begin(void)
+{
+    atomic_fetch_add(&g_sdcard_state.io_in_flight, 1);
+    // 先计数再检查：卸载方设置unmounting后看到的计数一定包含本次
+    if (!hal_sdcard_is_mounted()) {
+        atomic_fetch_sub(&g_sdcard_state.io_in_flight, 1);
+        return false;
+    }
+    return true;
+}
+
+void hal_sdcard_io_end(void)
+{
+    atomic_fetch_sub(&g_sdcard_state.io_in_flight, 1);
+}
+
+uint32_t hal_sdcard_get_generation(void)
+{
+    return atomic_load(&g_sdcard_state.generation);
+}
+
+bool hal_sdcard_add_listener(hal_sdcard_event_cb_t cb, void* user_data)
+{
+    if (!cb || !ensure_locks()) {
+        return false;
+    }
+
+    bool added = false;
+    xSemaphoreTake(g_sdcard_state.listener_lock, portMAX_DELAY);
+    for (int i = 0; i < SD_MAX_LISTENERS; i++) {
+        if (g_sdcard_state.listeners[i].cb == NULL) {
+            g_sdcard_state.listeners[i].cb = cb;
+            g_sdcard_state.listeners[i].user_data = user_data;
+            added = true;
+            break;
+        }
+    }
+    xSemaphoreGive(g_sdcard_state.listener_lock);
+
+    if (!added) {
+        printf("SD card listener table full\n");
+    }
+    return added;
+}
+
+void hal_sdcard_remove_listener(hal_sdcard_event_cb_t cb, void* user_data)
+{
+    if (!cb || g_sdcard_state.listener_lock == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(g_sdcard_state.listener_lock, portMAX_DELAY);
+    for (int i = 0; i < SD_MAX_LISTENERS; i++) {
+        if (g_sdcard_state.listeners[i].cb == cb && g_sdcard_state.listeners[i].user_data == user_data) {
+            g_sdcard_state.listeners[i].cb = NULL;
+            g_sdcard_state.listeners[i].user_data = NULL;
+        }
+    }
+    xSemaphoreGive(g_sdcard_state.listener_lock);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Hot-plug Monitor                              */
+/* -------------------------------------------------------------------------- */
+
+// 读取0号扇区确认卡仍然在位。单扇区读是一次SDMMC事务，
+// 与其他任务的文件访问由驱动的事务锁串行化，不需要FatFS卷锁
+static bool probe_card(uint8_t* sector)
+{
+    return disk_read(SD_FATFS_PDRV, sector, 0, 1) == RES_OK;
+}
 
-    if (xSemaphoreTake(g_sdcard_state.mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (g_sdcard_state.is_mounted) {
-            printf("Unmounting SD card...\n");
-            
-            // Deinitialize SD card using BSP function
-            esp_err_t ret = bsp_sdcard_deinit(g_sdcard_state.mount_point);
-            if (ret == ESP_OK) {
-                printf("SD card unmounted successfully\n");
-            } else {
-                printf("Failed to unmount SD card: %s\n", esp_err_to_name(ret));
+static void sdcard_monitor_task(void* arg)
+{
+    (void)arg;
+    uint8_t* sector = heap_caps_aligned_alloc(64, 512, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    uint32_t retry_ms = SD_RETRY_MIN_MS;
+    uint32_t failures = 0;
+
+    while (true) {
+        bool mounted = hal_sdcard_is_mounted();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(mounted ? SD_PROBE_INTERVAL_MS : retry_ms));
+
+        if (hal_sdcard_is_mounted()) {
+            retry_ms = SD_RETRY_MIN_MS;
+            if (!sector || probe_card(sector)) {
+                failures = 0;
+                continue;
             }
-            
-            g_sdcard_state.is_mounted = false;
+            if (++failures < SD_PROBE_FAILURES) {
+                continue;
+            }
+            printf("SD card removed\n");
+            failures = 0;
+            set_mounted(false, false);
+        } else if (set_mounted(true, true)) {
+            printf("SD card inserted\n");
+            retry_ms = SD_RETRY_MIN_MS;
+        } else if (retry_ms < SD_RETRY_MAX_MS) {
+            retry_ms = retry_ms * 2 > SD_RETRY_MAX_MS ? SD_RETRY_MAX_MS : retry_ms * 2;
         }
-        
-        xSemaphoreGive(g_sdcard_state.mutex);
     }
 }
 
-bool hal_sdcard_is_mounted(void)
+bool hal_sdcard_start_monitor(void)
 {
-    if (g_sdcard_state.mutex == NULL) {
+    if (g_sdcard_state.monitor_task) {
+        return true;
+    }
+    if (!ensure_locks()) {
         return false;
     }
 
-    bool mounted = false;
-    if (xSemaphoreTake(g_sdcard_state.mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        mounted = g_sdcard_state.is_mounted;
-        xSemaphoreGive(g_sdcard_state.mutex);
+    if (xTaskCreate(sdcard_monitor_task, "sd_monitor", SD_MONITOR_STACK_SIZE, NULL,
+                    SD_MONITOR_PRIORITY, &g_sdcard_state.monitor_task) != pdPASS) {
+        printf("Failed to create SD card monitor task\n");
+        g_sdcard_state.monitor_task = NULL;
+        return false;
+    }
+    printf("SD card hot-plug monitor started\n");
+    return true;
+}
+
+void hal_sdcard_check_now(void)
+{
+    if (g_sdcard_state.monitor_task) {
+        xTaskNotifyGive(g_sdcard_state.monitor_task);
     }
-    
-    return mounted;
 }
 
 const char* hal_sdcard_get_mount_point(void)
 {
     return g_sdcard_state.mount_point;
-} 
\ No newline at end of file
+}
+
+bool hal_sdcard_get_usage(uint64_t* total_bytes, uint64_t* free_bytes)
+{
+    if (!hal_sdcard_is_mounted()) {
+        return false;
+    }
+
+    uint64_t total = 0, free_space = 0;
+    esp_err_t ret = esp_vfs_fat_info(g_sdcard_state.mount_point, &total, &free_space);
+    if (ret != ESP_OK) {
+        printf("Failed to get SD card usage: %s\n", esp_err_to_name(ret));
+        return false;
+    }
+
+    if (total_bytes) {
+        *total_bytes = total;
+    }
+    if (free_bytes) {
+        *free_bytes = free_space;
+    }
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                           Directory Enumeration                            */
+/* -------------------------------------------------------------------------- */
+
+// 将VFS路径转换为FatFS路径（"/sdcard/music" -> "0:/music"）
+static bool to_fatfs_path(const char* path, char* out, size_t out_size)
+{
+    size_t mount_len = strlen(g_sdcard_state.mount_point);
+    if (strncmp(path, g_sdcard_state.mount_point, mount_len) != 0 ||
+        (path[mount_len] != '\0' && path[mount_len] != '/')) {
+        return false;
+    }
+
+    const char* rel = path + mount_len;
+    int len = snprintf(out, out_size, "%s%s", SD_FATFS_DRIVE, rel[0] ? rel : "/");
+    return len > 0 && (size_t)len < out_size;
+}
+
+// FAT日期时间转换为Unix时间戳（不依赖mktime，避免每个条目的时区计算）
+static uint32_t fat_time_to_epoch(uint16_t fdate, uint16_t ftime)
+{
+    if (fdate == 0) {
+        return 0;
+    }
+
+    int year = 1980 + ((fdate >> 9) & 0x7F);
+    int month = (fdate >> 5) & 0x0F;
+    int day = fdate & 0x1F;
+    if (month < 1 || month > 12 || day < 1) {
+        return 0;
+    }
+
+    // days_from_civil
+    year -= month <= 2;
+    int era = year / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int32_t days = era * 146097 + doe - 719468;
+
+    uint32_t seconds = ((ftime >> 11) & 0x1F) * 3600 + ((ftime >> 5) & 0x3F) * 60 + (ftime & 0x1F) * 2;
+    return (uint32_t)days * 86400u + seconds;
+}
+
+static bool match_one_pattern(const char* name, const char* pat, const char* pat_end)
+{
+    const char* star_pat = NULL;
+    const char* star_name = NULL;
+
+    while (*name) {
+        if (pat < pat_end && (*pat == '?' ||
+            (*pat != '*' && tolower((unsigned char)*pat) == tolower((unsigned char)*name)))) {
+            pat++;
+            name++;
+        } else if (pat < pat_end && *pat == '*') {
+            star_pat = ++pat;
+            star_name = name;
+        } else if (star_pat) {
+            pat = star_pat;
+            name = ++star_name;
+        } else {
+            return false;
+        }
+    }
+
+    while (pat < pat_end && *pat == '*') {
+        pat++;
+    }
+    return pat == pat_end;
+}
+
+bool hal_sdcard_match_pattern(const char* name, const char* pattern)
+{
+    if (!pattern || pattern[0] == '\0') {
+        return true;
+    }
+    if (!name) {
+        return false;
+    }
+
+    const char* start = pattern;
+    while (*start) {
+        const char* end = strchr(start, ';');
+        if (!end) {
+            end = start + strlen(start);
+        }
+        if (end > start && match_one_pattern(name, start, end)) {
+            return true;
+        }
+        start = (*end == ';') ? end + 1 : end;
+    }
+    return false;
+}
+
+int hal_sdcard_list_dir(const char* path, const char* pattern, uint32_t flags,
+                        hal_sdcard_list_cb_t cb, void* user_data)
+{
+    if (!path || !cb) {
+        return -1;
+    }
+
+    char ff_path[272];
+    if (!to_fatfs_path(path, ff_path, sizeof(ff_path))) {
+        printf("Path is not on the SD card: %s\n", path);
+        return -1;
+    }
+
+    if (!hal_sdcard_io_begin()) {
+        printf("SD card not mounted\n");
+        return -1;
+    }
+
+    // FF_DIR和FILINFO较大（长文件名缓冲），放在堆上避免占用调用者栈空间
+    FF_DIR* dir = (FF_DIR*)malloc(sizeof(FF_DIR));
+    FILINFO* info = (FILINFO*)malloc(sizeof(FILINFO));
+    if (!dir || !info) {
+        printf("Failed to allocate directory iterator\n");
+        free(dir);
+        free(info);
+        hal_sdcard_io_end();
+        return -1;
+    }
+
+    FRESULT res = f_opendir(dir, ff_path);
+    if (res != FR_OK) {
+        printf("Failed to open directory: %s (%d)\n", path, (int)res);
+        free(dir);
+        free(info);
+        hal_sdcard_io_end();
+        return -1;
+    }
+
+    int count = 0;
+    while (hal_sdcard_is_mounted()) {
+        res = f_readdir(dir, info);
+        if (res != FR_OK || info->fname[0] == '\0') {
+            break;
+        }
+
+        bool is_dir = (info->fattrib & AM_DIR) != 0;
+
+        if ((flags & HAL_SDCARD_LIST_SKIP_HIDDEN) &&
+            (info->fname[0] == '.' || (info->fattrib & (AM_HID | AM_SYS)))) {
+            continue;
+        }
+        if ((flags & HAL_SDCARD_LIST_FILES_ONLY) && is_dir) {
+            continue;
+        }
+        if ((flags & HAL_SDCARD_LIST_DIRS_ONLY) && !is_dir) {
+            continue;
+        }
+        if (!is_dir && !hal_sdcard_match_pattern(info->fname, pattern)) {
+            continue;
+        }
+
+        hal_sdcard_entry_t entry = {
+            .name = info->fname,
+            .is_dir = is_dir,
+            .size = is_dir ? 0 : (uint64_t)info->fsize,
+            .mtime = fat_time_to_epoch(info->fdate, info->ftime),
+        };
+
+        count++;
+        if (!cb(&entry, user_data)) {
+            break;
+        }
+    }
+
+    if (res != FR_OK) {
+        printf("Error reading directory %s (%d)\n", path, (int)res);
+    }
+
+    f_closedir(dir);
+    free(dir);
+    free(info);
+    hal_sdcard_io_end();
+    return count;
+}
+
+// 基准测试回调：统计条目和总字节数
+static bool benchmark_count_cb(const hal_sdcard_entry_t* entry, void* user_data)
+{
+    uint64_t* total = (uint64_t*)user_data;
+    *total += entry->size;
+    return true;
+}
+
+bool hal_sdcard_benchmark_listing(const char* path, uint32_t create_count)
+{
+    if (!path || !hal_sdcard_is_mounted()) {
+        printf("Listing benchmark: SD card not mounted\n");
+        return false;
+    }
+
+    char file_path[300];
+
+    if (create_count > 0) {
+        mkdir(path, 0775);
+        printf("Listing benchmark: creating %lu files in %s...\n", (unsigned long)create_count, path);
+        int64_t create_start = esp_timer_get_time();
+        for (uint32_t i = 0; i < create_count; i++) {
+            snprintf(file_path, sizeof(file_path), "%s/bench_%05lu.txt", path, (unsigned long)i);
+            FILE* fp = fopen(file_path, "wb");
+            if (!fp) {
+                printf("Listing benchmark: failed to create %s\n", file_path);
+                break;
+            }
+            fputs("benchmark\n", fp);
+            fclose(fp);
+        }
+        printf("Listing benchmark: created files in %lld ms\n",
+               (long long)((esp_timer_get_time() - create_start) / 1000));
+    }
+
+    // 方法一：readdir() + stat()
+    uint32_t stat_count = 0;
+    uint64_t stat_bytes = 0;
+    int64_t start = esp_timer_get_time();
+    DIR* dir = opendir(path);
+    if (!dir) {
+        printf("Listing benchmark: failed to open %s\n", path);
+        return false;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        snprintf(file_path, sizeof(file_path), "%s/%s", path, entry->d_name);
+        struct stat st;
+        if (stat(file_path, &st) == 0) {
+            stat_bytes += st.st_size;
+        }
+        stat_count++;
+    }
+    closedir(dir);
+    int64_t stat_us = esp_timer_get_time() - start;
+
+    // 方法二：FatFS目录记录单次遍历
+    uint64_t list_bytes = 0;
+    start = esp_timer_get_time();
+    int list_count = hal_sdcard_list_dir(path, NULL, 0, benchmark_count_cb, &list_bytes);
+    int64_t list_us = esp_timer_get_time() - start;
+
+    printf("=== LISTING BENCHMARK [%s] ===\n", path);
+    printf("  readdir+stat: %lu entries, %llu bytes, %lld ms (%lld us/entry)\n",
+           (unsigned long)stat_count, (unsigned long long)stat_bytes, (long long)(stat_us / 1000),
+           (long long)(stat_count ? stat_us / stat_count : 0));
+    printf("  list_dir:     %d entries, %llu bytes, %lld ms (%lld us/entry)\n",
+           list_count, (unsigned long long)list_bytes, (long long)(list_us / 1000),
+           (long long)(list_count > 0 ? list_us / list_count : 0));
+    if (list_us > 0) {
+        printf("  Speedup: %.1fx\n", (double)stat_us / (double)list_us);
+    }
+    printf("=== END LISTING BENCHMARK ===\n");
+    return list_count >= 0 && (uint32_t)list_count == stat_count;
+}
@@ -24,10 +24,97 @@ void hal_sdcard_deinit(void);
 /**
  * @brief Check if SD card is mounted
  * 
+ * Lock-free; safe to call from any task at any rate. Returns false as soon
+ * as an unmount starts, so loops that check it stop before the card goes away.
+ * 
  * @return true if SD card is mounted
  */
 bool hal_sdcard_is_mounted(void);
 
+/**
+ * @brief Get the mount generation
+ * 
+ * Incremented on every mount and unmount, so a cached value that differs
+ * from the current one means the card was removed, inserted or swapped.
+ * Lock-free.
+ * 
+ * @return Current mount generation
+ */
+uint32_t hal_sdcard_get_generation(void);
+
+/**
+ * @brief SD card mount state events
+ */
+typedef enum {
+    HAL_SDCARD_EVENT_MOUNTED,       // Card mounted (at boot, after insertion or a retry)
+    HAL_SDCARD_EVENT_UNMOUNTING,    // Unmount starting; cancel card I/O and close files
+    HAL_SDCARD_EVENT_UNMOUNTED      // Card removed or unmounted; open files are invalid
+} hal_sdcard_event_t;
+
+/**
+ * @brief Mount state listener
+ * 
+ * Called from the task that changed the mount state (usually the hot-plug
+ * monitor), never from the LVGL task. Listeners must not block and must not
+ * touch LVGL objects; set a flag or wake a worker instead.
+ * 
+ * @param event Event type
+ * @param generation Mount generation after the change
+ * @param user_data User pointer passed to hal_sdcard_add_listener()
+ */
+typedef void (*hal_sdcard_event_cb_t)(hal_sdcard_event_t event, uint32_t generation, void* user_data);
+
+/**
+ * @brief Mark the start of an I/O section on the card
+ * 
+ * Unmounting broadcasts HAL_SDCARD_EVENT_UNMOUNTING, then waits (bounded) for
+ * all sections to end before releasing the card, so a read or write is never
+ * cut off by the driver going away. Keep sections short (one read, one job)
+ * and end them promptly once the card is no longer mounted.
+ * 
+ * @return true if the section started; false while unmounting or unmounted,
+ *         in which case the card must not be touched and io_end not called
+ */
+bool hal_sdcard_io_begin(void);
+
+/**
+ * @brief End a section started with hal_sdcard_io_begin()
+ */
+void hal_sdcard_io_end(void);
+
+/**
+ * @brief Register a mount state listener
+ * 
+ * @param cb Listener callback
+ * @param user_data User pointer passed to the callback
+ * @return true on success, false if the listener table is full
+ */
+bool hal_sdcard_add_listener(hal_sdcard_event_cb_t cb, void* user_data);
+
+/**
+ * @brief Remove a listener registered with hal_sdcard_add_listener()
+ * 
+ * @param cb Listener callback
+ * @param user_data User pointer the listener was registered with
+ */
+void hal_sdcard_remove_listener(hal_sdcard_event_cb_t cb, void* user_data);
+
+/**
+ * @brief Start the background hot-plug monitor
+ * 
+ * While mounted, the card is probed periodically and unmounted when it no
+ * longer responds. While unmounted, mounting is retried with back-off.
+ * Both transitions are broadcast to the registered listeners.
+ * 
+ * @return true if the monitor is running
+ */
+bool hal_sdcard_start_monitor(void);
+
+/**
+ * @brief Ask the monitor to probe or retry mounting immediately
+ */
+void hal_sdcard_check_now(void);
+
 /**
  * @brief Get SD card mount point
  * 
@@ -35,6 +122,77 @@ bool hal_sdcard_is_mounted(void);
  */
 const char* hal_sdcard_get_mount_point(void);
 
+/**
+ * @brief Get SD card capacity and free space
+ * 
+ * @param total_bytes Output: volume size in bytes (may be NULL)
+ * @param free_bytes Output: free space in bytes (may be NULL)
+ * @return true on success
+ */
+bool hal_sdcard_get_usage(uint64_t* total_bytes, uint64_t* free_bytes);
+
+// Flags for hal_sdcard_list_dir()
+#define HAL_SDCARD_LIST_SKIP_HIDDEN  (1 << 0)   // Skip dot-files and FAT hidden/system entries
+#define HAL_SDCARD_LIST_FILES_ONLY   (1 << 1)   // Report regular files only
+#define HAL_SDCARD_LIST_DIRS_ONLY    (1 << 2)   // Report directories only
+
+/**
+ * @brief Directory entry reported by hal_sdcard_list_dir()
+ */
+typedef struct {
+    const char* name;       // Entry name (only valid during the callback)
+    bool is_dir;            // true if the entry is a directory
+    uint64_t size;          // File size in bytes (0 for directories)
+    uint32_t mtime;         // Modification time (seconds since epoch)
+} hal_sdcard_entry_t;
+
+/**
+ * @brief Callback invoked for every matching entry
+ * 
+ * @param entry Entry information
+ * @param user_data User pointer passed to hal_sdcard_list_dir()
+ * @return true to continue enumeration, false to stop
+ */
+typedef bool (*hal_sdcard_list_cb_t)(const hal_sdcard_entry_t* entry, void* user_data);
+
+/**
+ * @brief Enumerate a directory in a single pass without per-entry stat()
+ * 
+ * Reads the FatFS directory records directly, so name, type, size and
+ * modification time come from the same read that finds the entry.
+ * 
+ * @param path Directory path (VFS path under the mount point, e.g. "/sdcard/music")
+ * @param pattern Optional case-insensitive wildcard filter ("*.mp3", "*.jpg;*.png"),
+ *                applied to files only; NULL matches everything
+ * @param flags HAL_SDCARD_LIST_* flags
+ * @param cb Callback invoked for each entry
+ * @param user_data User pointer passed to the callback
+ * @return Number of entries reported, or -1 on error
+ */
+int hal_sdcard_list_dir(const char* path, const char* pattern, uint32_t flags,
+                        hal_sdcard_list_cb_t cb, void* user_data);
+
+/**
+ * @brief Check a file name against a wildcard filter
+ * 
+ * @param name File name
+ * @param pattern Case-insensitive pattern list separated by ';' ('*' and '?' supported)
+ * @return true if the name matches (or pattern is NULL/empty)
+ */
+bool hal_sdcard_match_pattern(const char* name, const char* pattern);
+
+/**
+ * @brief Compare readdir()+stat() listing against hal_sdcard_list_dir()
+ * 
+ * Prints the time taken by both approaches. If create_count is non-zero the
+ * directory is first populated with that many small files.
+ * 
+ * @param path Directory to benchmark
+ * @param create_count Number of files to create before measuring (0 to skip)
+ * @return true if both approaches ran and found the same number of entries
+ */
+bool hal_sdcard_benchmark_listing(const char* path, uint32_t create_count);
+
 #ifdef __cplusplus
 }
 #endif
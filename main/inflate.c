@@ -0,0 +1,485 @@
+#include "inflate.h"
+#include <stdio.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+
+#define WINDOW_SIZE     32768
+#define WINDOW_MASK     (WINDOW_SIZE - 1)
+#define INPUT_SIZE      (16 * 1024)   // 大块读取压缩数据
+#define MAX_BITS        15
+#define FAST_BITS       9           // 不超过9位的码字查表解码
+#define MAX_LIT_CODES   288
+#define MAX_DIST_CODES  30
+#define MAX_OVERRUN     16          // 输入结束后允许预读的填充字节数
+
+// 范式哈夫曼表
+typedef struct {
+    uint16_t fast[1 << FAST_BITS];  // (符号 << 4) | 码长，0表示需逐位解码
+    uint16_t count[MAX_BITS + 1];   // 各码长的符号数
+    uint16_t symbol[MAX_LIT_CODES]; // 按码字顺序排列的符号
+} huffman_t;
+
+struct inflate_ctx {
+    uint8_t window[WINDOW_SIZE];    // 滑动窗口，写满后整块输出
+    uint8_t input[INPUT_SIZE];
+    size_t in_pos;
+    size_t in_len;
+    bool in_eof;
+    uint32_t overrun;               // 输入结束后读取的填充字节数
+    uint32_t bitbuf;
+    uint32_t bitcnt;
+    uint32_t out_pos;               // 窗口写位置
+    uint64_t total_out;
+    bool write_failed;
+    inflate_read_cb_t read_cb;
+    inflate_write_cb_t write_cb;
+    void* user_data;
+    huffman_t lencode;
+    huffman_t distcode;
+    huffman_t fixed_lencode;
+    huffman_t fixed_distcode;
+};
+
+// 长度和距离码的基值与附加位数（RFC 1951 3.2.5）
+static const uint16_t k_len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t k_len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t k_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t k_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                   Input                                    */
+/* -------------------------------------------------------------------------- */
+
+static uint8_t next_byte(inflate_ctx_t* ctx) {
+    if (ctx->in_pos == ctx->in_len) {
+        ctx->in_pos = 0;
+        ctx->in_len = ctx->in_eof ? 0 : ctx->read_cb(ctx->input, INPUT_SIZE, ctx->user_data);
+        if (ctx->in_len == 0) {
+            // 输入结束后补0，由调用方检查overrun
+            ctx->in_eof = true;
+            ctx->overrun++;
+            return 0;
+        }
+    }
+    return ctx->input[ctx->in_pos++];
+}
+
+static inline void need_bits(inflate_ctx_t* ctx, uint32_t n) {
+    while (ctx->bitcnt < n) {
+        ctx->bitbuf |= (uint32_t)next_byte(ctx) << ctx->bitcnt;
+        ctx->bitcnt += 8;
+    }
+}
+
+static inline uint32_t get_bits(inflate_ctx_t* ctx, uint32_t n) {
+    need_bits(ctx, n);
+    uint32_t value = ctx->bitbuf & ((1u << n) - 1);
+    ctx->bitbuf >>= n;
+    ctx->bitcnt -= n;
+    return value;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Output                                   */
+/* -------------------------------------------------------------------------- */
+
+static bool flush_window(inflate_ctx_t* ctx) {
+    if (ctx->out_pos > 0 && !ctx->write_cb(ctx->window, ctx->out_pos, ctx->user_data)) {
+        ctx->write_failed = true;
+        return false;
+    }
+    ctx->out_pos = 0;
+    return true;
+}
+
+static inline bool put_byte(inflate_ctx_t* ctx, uint8_t b) {
+    ctx->window[ctx->out_pos++] = b;
+    ctx->total_out++;
+    return ctx->out_pos < WINDOW_SIZE || flush_window(ctx);
+}
+
+// 复制窗口中dist字节之前的len字节（可与目标重叠）
+static bool copy_match(inflate_ctx_t* ctx, uint32_t dist, uint32_t len) {
+    uint32_t src = (ctx->out_pos - dist) & WINDOW_MASK;
+    ctx->total_out += len;
+
+    while (len > 0) {
+        // 分段到窗口末尾；距离不小于段长时可整段复制
+        uint32_t chunk = len;
+        if (chunk > WINDOW_SIZE - ctx->out_pos) {
+            chunk = WINDOW_SIZE - ctx->out_pos;
+        }
+        if (chunk > WINDOW_SIZE - src) {
+            chunk = WINDOW_SIZE - src;
+        }
+
+        if (dist >= chunk) {
+            memmove(ctx->window + ctx->out_pos, ctx->window + src, chunk);
+        } else {
+            for (uint32_t i = 0; i < chunk; i++) {
+                ctx->window[ctx->out_pos + i] = ctx->window[src + i];
+            }
+        }
+
+        ctx->out_pos += chunk;
+        src = (src + chunk) & WINDOW_MASK;
+        len -= chunk;
+        if (ctx->out_pos == WINDOW_SIZE && !flush_window(ctx)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Huffman                                   */
+/* -------------------------------------------------------------------------- */
+
+static uint32_t reverse_bits(uint32_t code, uint32_t len) {
+    uint32_t result = 0;
+    while (len--) {
+        result = (result << 1) | (code & 1);
+        code >>= 1;
+    }
+    return result;
+}
+
+// 由码长构建范式哈夫曼表；码长超额时返回-1，不完整返回>0
+static int build_huffman(huffman_t* h, const uint8_t* lengths, uint32_t n) {
+    memset(h->count, 0, sizeof(h->count));
+    for (uint32_t sym = 0; sym < n; sym++) {
+        h->count[lengths[sym]]++;
+    }
+    h->count[0] = 0;
+
+    int left = 1;
+    for (uint32_t len = 1; len <= MAX_BITS; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0) {
+            return -1;
+        }
+    }
+
+    uint16_t offsets[MAX_BITS + 1];
+    offsets[1] = 0;
+    for (uint32_t len = 1; len < MAX_BITS; len++) {
+        offsets[len + 1] = offsets[len] + h->count[len];
+    }
+    for (uint32_t sym = 0; sym < n; sym++) {
+        if (lengths[sym] != 0) {
+            h->symbol[offsets[lengths[sym]]++] = (uint16_t)sym;
+        }
+    }
+
+    // 短码字查表：码字在比特流中低位在前，填充所有高位组合
+    memset(h->fast, 0, sizeof(h->fast));
+    uint32_t code = 0, index = 0;
+    for (uint32_t len = 1; len <= FAST_BITS; len++) {
+        for (uint32_t k = 0; k < h->count[len]; k++, index++, code++) {
+            uint16_t entry = (uint16_t)((h->symbol[index] << 4) | len);
+            for (uint32_t f = reverse_bits(code, len); f < (1u << FAST_BITS); f += 1u << len) {
+                h->fast[f] = entry;
+            }
+        }
+        code <<= 1;
+    }
+    return left;
+}
+
+static int decode_symbol(inflate_ctx_t* ctx, const huffman_t* h) {
+    need_bits(ctx, FAST_BITS);
+    uint16_t entry = h->fast[ctx->bitbuf & ((1u << FAST_BITS) - 1)];
+    if (entry) {
+        uint32_t len = entry & 15;
+        ctx->bitbuf >>= len;
+        ctx->bitcnt -= len;
+        return entry >> 4;
+    }
+
+    // 长码字逐位解码
+    int code = 0, first = 0, index = 0;
+    for (uint32_t len = 1; len <= MAX_BITS; len++) {
+        code |= (int)get_bits(ctx, 1);
+        int count = h->count[len];
+        if (code - count < first) {
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Blocks                                   */
+/* -------------------------------------------------------------------------- */
+
+static int inflate_stored(inflate_ctx_t* ctx) {
+    // 跳到字节边界
+    ctx->bitbuf >>= ctx->bitcnt & 7;
+    ctx->bitcnt -= ctx->bitcnt & 7;
+
+    uint32_t len = get_bits(ctx, 16);
+    uint32_t nlen = get_bits(ctx, 16);
+    if (len != (~nlen & 0xFFFF)) {
+        return INFLATE_ERR_DATA;
+    }
+
+    // 先取出位缓冲中剩余的整字节
+    while (len > 0 && ctx->bitcnt >= 8) {
+        if (!put_byte(ctx, (uint8_t)get_bits(ctx, 8))) {
+            return INFLATE_ERR_WRITE;
+        }
+        len--;
+    }
+
+    while (len > 0) {
+        if (ctx->in_pos == ctx->in_len) {
+            ctx->in_pos = 0;
+            ctx->in_len = ctx->in_eof ? 0 : ctx->read_cb(ctx->input, INPUT_SIZE, ctx->user_data);
+            if (ctx->in_len == 0) {
+                ctx->in_eof = true;
+                return INFLATE_ERR_TRUNCATED;
+            }
+        }
+
+        uint32_t chunk = (uint32_t)(ctx->in_len - ctx->in_pos);
+        if (chunk > len) {
+            chunk = len;
+        }
+        if (chunk > WINDOW_SIZE - ctx->out_pos) {
+            chunk = WINDOW_SIZE - ctx->out_pos;
+        }
+        memcpy(ctx->window + ctx->out_pos, ctx->input + ctx->in_pos, chunk);
+        ctx->in_pos += chunk;
+        ctx->out_pos += chunk;
+        ctx->total_out += chunk;
+        len -= chunk;
+        if (ctx->out_pos == WINDOW_SIZE && !flush_window(ctx)) {
+            return INFLATE_ERR_WRITE;
+        }
+    }
+    return INFLATE_OK;
+}
+
+static int inflate_codes(inflate_ctx_t* ctx, const huffman_t* lencode, const huffman_t* distcode) {
+    while (true) {
+        int sym = decode_symbol(ctx, lencode);
+        if (sym < 0) {
+            return INFLATE_ERR_DATA;
+        }
+
+        if (sym < 256) {
+            if (!put_byte(ctx, (uint8_t)sym)) {
+                return INFLATE_ERR_WRITE;
+            }
+        } else if (sym == 256) {
+            return INFLATE_OK;
+        } else {
+            sym -= 257;
+            if (sym >= 29) {
+                return INFLATE_ERR_DATA;
+            }
+            uint32_t len = k_len_base[sym] + get_bits(ctx, k_len_extra[sym]);
+
+            int dsym = decode_symbol(ctx, distcode);
+            if (dsym < 0 || dsym >= MAX_DIST_CODES) {
+                return INFLATE_ERR_DATA;
+            }
+            uint32_t dist = k_dist_base[dsym] + get_bits(ctx, k_dist_extra[dsym]);
+            if (dist > ctx->total_out) {
+                return INFLATE_ERR_DATA;
+            }
+            if (!copy_match(ctx, dist, len)) {
+                return INFLATE_ERR_WRITE;
+            }
+        }
+
+        if (ctx->overrun > MAX_OVERRUN) {
+            return INFLATE_ERR_TRUNCATED;
+        }
+    }
+}
+
+static int inflate_dynamic(inflate_ctx_t* ctx) {
+    static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    uint8_t lengths[MAX_LIT_CODES + MAX_DIST_CODES];
+
+    uint32_t nlen = get_bits(ctx, 5) + 257;
+    uint32_t ndist = get_bits(ctx, 5) + 1;
+    uint32_t ncode = get_bits(ctx, 4) + 4;
+    if (nlen > 286 || ndist > MAX_DIST_CODES) {
+        return INFLATE_ERR_DATA;
+    }
+
+    // 码长的码长
+    memset(lengths, 0, 19);
+    for (uint32_t i = 0; i < ncode; i++) {
+        lengths[order[i]] = (uint8_t)get_bits(ctx, 3);
+    }
+    if (build_huffman(&ctx->lencode, lengths, 19) != 0) {
+        return INFLATE_ERR_DATA;
+    }
+
+    uint32_t index = 0;
+    while (index < nlen + ndist) {
+        int sym = decode_symbol(ctx, &ctx->lencode);
+        if (sym < 0) {
+            return INFLATE_ERR_DATA;
+        }
+        if (sym < 16) {
+            lengths[index++] = (uint8_t)sym;
+            continue;
+        }
+
+        uint8_t value = 0;
+        uint32_t repeat;
+        if (sym == 16) {
+            if (index == 0) {
+                return INFLATE_ERR_DATA;
+            }
+            value = lengths[index - 1];
+            repeat = 3 + get_bits(ctx, 2);
+        } else if (sym == 17) {
+            repeat = 3 + get_bits(ctx, 3);
+        } else {
+            repeat = 11 + get_bits(ctx, 7);
+        }
+        if (index + repeat > nlen + ndist) {
+            return INFLATE_ERR_DATA;
+        }
+        while (repeat--) {
+            lengths[index++] = value;
+        }
+    }
+
+    if (lengths[256] == 0) {
+        return INFLATE_ERR_DATA;
+    }
+
+    // 字面量/长度表必须完整（只有一个码字时除外），距离表允许不完整
+    int err = build_huffman(&ctx->lencode, lengths, nlen);
+    if (err < 0 || (err > 0 && nlen - ctx->lencode.count[0] != 1)) {
+        return INFLATE_ERR_DATA;
+    }
+    err = build_huffman(&ctx->distcode, lengths + nlen, ndist);
+    if (err < 0) {
+        return INFLATE_ERR_DATA;
+    }
+
+    return inflate_codes(ctx, &ctx->lencode, &ctx->distcode);
+}
+
+static void build_fixed_tables(inflate_ctx_t* ctx) {
+    uint8_t lengths[MAX_LIT_CODES];
+    uint32_t sym = 0;
+    for (; sym < 144; sym++) lengths[sym] = 8;
+    for (; sym < 256; sym++) lengths[sym] = 9;
+    for (; sym < 280; sym++) lengths[sym] = 7;
+    for (; sym < MAX_LIT_CODES; sym++) lengths[sym] = 8;
+    build_huffman(&ctx->fixed_lencode, lengths, MAX_LIT_CODES);
+
+    for (sym = 0; sym < MAX_DIST_CODES; sym++) {
+        lengths[sym] = 5;
+    }
+    build_huffman(&ctx->fixed_distcode, lengths, MAX_DIST_CODES);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Public API                                 */
+/* -------------------------------------------------------------------------- */
+
+inflate_ctx_t* inflate_create(void) {
+    // 窗口随机访问频繁，优先使用内部RAM
+    inflate_ctx_t* ctx = heap_caps_malloc(sizeof(inflate_ctx_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!ctx) {
+        ctx = heap_caps_malloc(sizeof(inflate_ctx_t), MALLOC_CAP_SPIRAM);
+    }
+    if (!ctx) {
+        printf("Inflate: failed to allocate %zu bytes\n", sizeof(inflate_ctx_t));
+        return NULL;
+    }
+
+    build_fixed_tables(ctx);
+    return ctx;
+}
+
+void inflate_free(inflate_ctx_t* ctx) {
+    if (ctx) {
+        heap_caps_free(ctx);
+    }
+}
+
+int inflate_run(inflate_ctx_t* ctx, inflate_read_cb_t read_cb, inflate_write_cb_t write_cb, void* user_data) {
+    if (!ctx || !read_cb || !write_cb) {
+        return INFLATE_ERR_DATA;
+    }
+
+    ctx->read_cb = read_cb;
+    ctx->write_cb = write_cb;
+    ctx->user_data = user_data;
+    ctx->in_pos = 0;
+    ctx->in_len = 0;
+    ctx->in_eof = false;
+    ctx->overrun = 0;
+    ctx->bitbuf = 0;
+    ctx->bitcnt = 0;
+    ctx->out_pos = 0;
+    ctx->total_out = 0;
+    ctx->write_failed = false;
+
+    int result = INFLATE_OK;
+    bool last = false;
+    while (!last && result == INFLATE_OK) {
+        last = get_bits(ctx, 1);
+        uint32_t type = get_bits(ctx, 2);
+
+        if (type == 0) {
+            result = inflate_stored(ctx);
+        } else if (type == 1) {
+            result = inflate_codes(ctx, &ctx->fixed_lencode, &ctx->fixed_distcode);
+        } else if (type == 2) {
+            result = inflate_dynamic(ctx);
+        } else {
+            result = INFLATE_ERR_DATA;
+        }
+
+        // 超出输入末尾的位只能来自最后一个字节之后的预读
+        if (result == INFLATE_OK && ctx->overrun > 0 && ctx->overrun * 8 > ctx->bitcnt) {
+            result = INFLATE_ERR_TRUNCATED;
+        }
+    }
+
+    if (result == INFLATE_OK && !flush_window(ctx)) {
+        result = INFLATE_ERR_WRITE;
+    }
+    if (ctx->write_failed) {
+        result = INFLATE_ERR_WRITE;
+    }
+    return result;
+}
+
+uint8_t* inflate_get_buffer(inflate_ctx_t* ctx, size_t* size) {
+    if (!ctx) {
+        return NULL;
+    }
+    if (size) {
+        *size = WINDOW_SIZE;
+    }
+    return ctx->window;
+}
@@ -0,0 +1,63 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 解压结果
+#define INFLATE_OK               0
+#define INFLATE_ERR_DATA        -1      // 数据格式错误
+#define INFLATE_ERR_TRUNCATED   -2      // 输入提前结束
+#define INFLATE_ERR_WRITE       -3      // 输出回调返回false（写入失败或取消）
+
+// 解压器（不透明类型，内存固定约55KB，与数据大小无关）
+typedef struct inflate_ctx inflate_ctx_t;
+
+/**
+ * @brief 读取压缩数据的回调
+ *
+ * @return 读取的字节数，0表示输入结束
+ */
+typedef size_t (*inflate_read_cb_t)(uint8_t* buffer, size_t size, void* user_data);
+
+/**
+ * @brief 输出解压数据的回调（每次最多32KB）
+ *
+ * @return 返回false中止解压
+ */
+typedef bool (*inflate_write_cb_t)(const uint8_t* data, size_t len, void* user_data);
+
+/**
+ * @brief 创建解压器（32KB滑动窗口 + 16KB输入缓冲 + 哈夫曼表）
+ */
+inflate_ctx_t* inflate_create(void);
+
+/**
+ * @brief 释放解压器
+ */
+void inflate_free(inflate_ctx_t* ctx);
+
+/**
+ * @brief 流式解压一段raw DEFLATE数据（RFC 1951，无zlib/gzip头）
+ *
+ * 解压器可重复使用，每次调用从头开始。
+ *
+ * @return INFLATE_OK或INFLATE_ERR_*
+ */
+int inflate_run(inflate_ctx_t* ctx, inflate_read_cb_t read_cb, inflate_write_cb_t write_cb, void* user_data);
+
+/**
+ * @brief 获取解压器的窗口缓冲区，不解压时可借用作复制缓冲
+ */
+uint8_t* inflate_get_buffer(inflate_ctx_t* ctx, size_t* size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INFLATE_H
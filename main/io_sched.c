@@ -0,0 +1,548 @@
+#include "io_sched.h"
+#include "hal_sdcard.h"
+#include "sd_selftest.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+// 配置
+#define IO_SCHED_STACK_SIZE     4096
+#define IO_SCHED_PRIORITY       9               // 高于音频解码任务(8)，请求到达后立即分派
+#define IO_SCHED_CHUNK          (32 * 1024)     // 非实时请求每次最多执行的字节数
+#define IO_SCHED_MERGE_LIMIT    (128 * 1024)    // 连续执行相邻请求的最大字节数
+#define IO_SCHED_STARVATION_MS  500             // 低优先级请求等待超过该时间时插队一块
+
+// 请求（位于提交方任务的栈上，完成前提交方一直阻塞）
+typedef struct io_request {
+    struct io_request* next;
+    int fd;
+    bool write;
+    io_class_t io_class;
+    int64_t offset;             // 下一块的文件偏移，或IO_SCHED_CURRENT
+    uint8_t* buf;               // 下一块的数据位置
+    size_t remaining;
+    size_t done;
+    int64_t submit_us;
+    int64_t deadline_us;
+    int64_t waiting_since_us;   // 入队（或上一块完成）的时间，用于防饿死
+    int error;
+    bool eof;
+    SemaphoreHandle_t complete;
+} io_request_t;
+
+static struct {
+    bool running;
+    SemaphoreHandle_t lock;             // 保护队列和统计
+    SemaphoreHandle_t wake;             // 有新请求
+    io_request_t* queues[IO_CLASS_COUNT];   // 每个类别按截止时间排序
+    uint32_t deadline_ms[IO_CLASS_COUNT];
+    io_sched_class_stats_t stats[IO_CLASS_COUNT];
+} g_io = {
+    .deadline_ms = { 50, 200, 2000 },
+};
+
+static const char* k_class_names[IO_CLASS_COUNT] = { "realtime", "interactive", "background" };
+
+/* -------------------------------------------------------------------------- */
+/*                                  Execute                                   */
+/* -------------------------------------------------------------------------- */
+
+static bool request_finished(const io_request_t* req) {
+    return req->error != 0 || req->eof || req->remaining == 0;
+}
+
+// 执行请求的一块（最多max字节）
+static void execute_chunk(io_request_t* req, size_t max) {
+    size_t len = req->remaining < max ? req->remaining : max;
+
+    if (req->offset != IO_SCHED_CURRENT && lseek(req->fd, (off_t)req->offset, SEEK_SET) < 0) {
+        req->error = errno ? errno : EIO;
+        return;
+    }
+
+    ssize_t n = req->write ? write(req->fd, req->buf, len) : read(req->fd, req->buf, len);
+    if (n < 0) {
+        req->error = errno ? errno : EIO;
+        return;
+    }
+    if (n == 0) {
+        if (req->write) {
+            req->error = ENOSPC;
+        } else {
+            req->eof = true;
+        }
+        return;
+    }
+
+    req->buf += n;
+    req->remaining -= (size_t)n;
+    req->done += (size_t)n;
+    if (req->offset != IO_SCHED_CURRENT) {
+        req->offset += n;
+    }
+    // 普通文件读不满即到达末尾
+    if (!req->write && (size_t)n < len) {
+        req->eof = true;
+    }
+}
+
+static uint32_t latency_bucket(uint32_t latency_us) {
+    uint32_t bucket = 0;
+    uint32_t limit = 500;
+    while (bucket < IO_SCHED_HIST_BUCKETS - 1 && latency_us >= limit) {
+        limit *= 2;
+        bucket++;
+    }
+    return bucket;
+}
+
+// 记录统计并唤醒提交方
+static void complete_request(io_request_t* req, bool merged) {
+    int64_t now = esp_timer_get_time();
+    uint32_t latency_us = (uint32_t)(now - req->submit_us);
+
+    xSemaphoreTake(g_io.lock, portMAX_DELAY);
+    io_sched_class_stats_t* stats = &g_io.stats[req->io_class];
+    stats->requests++;
+    stats->bytes += req->done;
+    stats->total_latency_us += latency_us;
+    stats->histogram[latency_bucket(latency_us)]++;
+    if (latency_us > stats->max_latency_us) {
+        stats->max_latency_us = latency_us;
+    }
+    if (now > req->deadline_us) {
+        stats->deadline_misses++;
+    }
+    if (merged) {
+        stats->merged++;
+    }
+    xSemaphoreGive(g_io.lock);
+
+    xSemaphoreGive(req->complete);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Queues                                   */
+/* -------------------------------------------------------------------------- */
+
+// 按截止时间插入（相同截止时间保持先来先服务）；调用方持有锁
+static void queue_insert(io_request_t* req) {
+    io_request_t** link = &g_io.queues[req->io_class];
+    while (*link && (*link)->deadline_us <= req->deadline_us) {
+        link = &(*link)->next;
+    }
+    req->next = *link;
+    *link = req;
+}
+
+static void queue_remove(io_request_t* req) {
+    io_request_t** link = &g_io.queues[req->io_class];
+    while (*link && *link != req) {
+        link = &(*link)->next;
+    }
+    if (*link) {
+        *link = req->next;
+    }
+    req->next = NULL;
+}
+
+// 选择下一个请求并出队；调用方持有锁
+static io_request_t* pick_request(int64_t now) {
+    io_request_t* picked = NULL;
+
+    // 实时队列为空时，等待过久的低优先级请求先执行一块
+    if (!g_io.queues[IO_CLASS_REALTIME]) {
+        for (int c = IO_CLASS_COUNT - 1; c > IO_CLASS_REALTIME && !picked; c--) {
+            io_request_t* head = g_io.queues[c];
+            if (head && now - head->waiting_since_us > IO_SCHED_STARVATION_MS * 1000LL) {
+                picked = head;
+            }
+        }
+    }
+    for (int c = 0; c < IO_CLASS_COUNT && !picked; c++) {
+        picked = g_io.queues[c];
+    }
+
+    if (picked) {
+        queue_remove(picked);
+    }
+    return picked;
+}
+
+// 查找紧接在fd的end位置之后的同类请求并出队；调用方持有锁
+static io_request_t* take_continuation(const io_request_t* prev, int64_t end) {
+    // 有更高优先级的请求等待时不再连续执行
+    for (int c = 0; c < prev->io_class; c++) {
+        if (g_io.queues[c]) {
+            return NULL;
+        }
+    }
+    for (io_request_t* req = g_io.queues[prev->io_class]; req; req = req->next) {
+        if (req->fd == prev->fd && req->write == prev->write && req->offset == end) {
+            queue_remove(req);
+            return req;
+        }
+    }
+    return NULL;
+}
+
+static void io_sched_task(void* arg) {
+    (void)arg;
+
+    while (true) {
+        xSemaphoreTake(g_io.wake, portMAX_DELAY);
+
+        while (true) {
+            xSemaphoreTake(g_io.lock, portMAX_DELAY);
+            io_request_t* req = pick_request(esp_timer_get_time());
+            xSemaphoreGive(g_io.lock);
+            if (!req) {
+                break;
+            }
+
+            // 执行一块；同一文件后续位置的请求接着执行（FatFS只需沿簇链前移）
+            size_t run_bytes = 0;
+            bool merged = false;
+            while (req) {
+                size_t max = req->io_class == IO_CLASS_REALTIME ? req->remaining : IO_SCHED_CHUNK;
+                size_t before = req->done;
+                execute_chunk(req, max);
+                run_bytes += req->done - before;
+
+                if (!request_finished(req)) {
+                    // 大请求：放回队列，让更高优先级的请求插入
+                    xSemaphoreTake(g_io.lock, portMAX_DELAY);
+                    g_io.stats[req->io_class].chunks++;
+                    req->waiting_since_us = esp_timer_get_time();
+                    queue_insert(req);
+                    xSemaphoreGive(g_io.lock);
+                    break;
+                }
+
+                io_request_t* next = NULL;
+                if (req->offset != IO_SCHED_CURRENT && req->error == 0 && run_bytes < IO_SCHED_MERGE_LIMIT) {
+                    xSemaphoreTake(g_io.lock, portMAX_DELAY);
+                    next = take_continuation(req, req->offset);
+                    xSemaphoreGive(g_io.lock);
+                }
+                complete_request(req, merged);
+                req = next;
+                merged = true;
+            }
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Submit                                   */
+/* -------------------------------------------------------------------------- */
+
+static ssize_t submit(int fd, bool write, int64_t offset, void* buf, size_t len, io_class_t io_class) {
+    if (fd < 0 || (!buf && len > 0) || io_class >= IO_CLASS_COUNT) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    // 卸载开始后不再提交新请求，卸载等待已提交的请求完成
+    if (!hal_sdcard_io_begin()) {
+        errno = EIO;
+        return -1;
+    }
+
+    int64_t now = esp_timer_get_time();
+    io_request_t req = {
+        .fd = fd,
+        .write = write,
+        .io_class = io_class,
+        .offset = offset,
+        .buf = (uint8_t*)buf,
+        .remaining = len,
+        .submit_us = now,
+        .deadline_us = now + (int64_t)g_io.deadline_ms[io_class] * 1000,
+        .waiting_since_us = now,
+    };
+
+    if (!g_io.running) {
+        // 调度器未启动：在调用方任务中直接执行
+        while (!request_finished(&req)) {
+            execute_chunk(&req, req.remaining);
+        }
+    } else {
+        StaticSemaphore_t complete_buffer;
+        req.complete = xSemaphoreCreateBinaryStatic(&complete_buffer);
+
+        xSemaphoreTake(g_io.lock, portMAX_DELAY);
+        queue_insert(&req);
+        xSemaphoreGive(g_io.lock);
+        xSemaphoreGive(g_io.wake);
+
+        xSemaphoreTake(req.complete, portMAX_DELAY);
+        vSemaphoreDelete(req.complete);
+    }
+    hal_sdcard_io_end();
+
+    if (req.error != 0) {
+        errno = req.error;
+        return -1;
+    }
+    return (ssize_t)req.done;
+}
+
+bool io_sched_init(void) {
+    if (g_io.running) {
+        return true;
+    }
+
+    g_io.lock = xSemaphoreCreateMutex();
+    g_io.wake = xSemaphoreCreateBinary();
+    if (!g_io.lock || !g_io.wake) {
+        printf("I/O scheduler: failed to create semaphores\n");
+        return false;
+    }
+
+    g_io.running = true;
+    if (xTaskCreate(io_sched_task, "io_sched", IO_SCHED_STACK_SIZE, NULL, IO_SCHED_PRIORITY, NULL) != pdPASS) {
+        g_io.running = false;
+        printf("I/O scheduler: failed to create task\n");
+        return false;
+    }
+
+    printf("I/O scheduler started (deadlines: realtime %lu ms, interactive %lu ms, background %lu ms)\n",
+           (unsigned long)g_io.deadline_ms[IO_CLASS_REALTIME],
+           (unsigned long)g_io.deadline_ms[IO_CLASS_INTERACTIVE],
+           (unsigned long)g_io.deadline_ms[IO_CLASS_BACKGROUND]);
+    return true;
+}
+
+ssize_t io_sched_read(int fd, int64_t offset, void* buf, size_t len, io_class_t io_class) {
+    return submit(fd, false, offset, buf, len, io_class);
+}
+
+ssize_t io_sched_write(int fd, const void* buf, size_t len, io_class_t io_class) {
+    return submit(fd, true, IO_SCHED_CURRENT, (void*)buf, len, io_class);
+}
+
+void io_sched_set_deadline(io_class_t io_class, uint32_t deadline_ms) {
+    if (io_class < IO_CLASS_COUNT && deadline_ms > 0) {
+        g_io.deadline_ms[io_class] = deadline_ms;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Statistics                                 */
+/* -------------------------------------------------------------------------- */
+
+void io_sched_get_stats(io_class_t io_class, io_sched_class_stats_t* stats) {
+    if (io_class >= IO_CLASS_COUNT || !stats) {
+        return;
+    }
+    if (g_io.lock) {
+        xSemaphoreTake(g_io.lock, portMAX_DELAY);
+    }
+    *stats = g_io.stats[io_class];
+    if (g_io.lock) {
+        xSemaphoreGive(g_io.lock);
+    }
+}
+
+void io_sched_reset_stats(void) {
+    if (g_io.lock) {
+        xSemaphoreTake(g_io.lock, portMAX_DELAY);
+    }
+    memset(g_io.stats, 0, sizeof(g_io.stats));
+    if (g_io.lock) {
+        xSemaphoreGive(g_io.lock);
+    }
+}
+
+void io_sched_log_stats(void) {
+    for (int c = 0; c < IO_CLASS_COUNT; c++) {
+        io_sched_class_stats_t stats;
+        io_sched_get_stats((io_class_t)c, &stats);
+        if (stats.requests == 0) {
+            continue;
+        }
+
+        printf("I/O sched [%s]: %lu requests, %.1f KB, avg %.2f ms, max %.2f ms, %lu deadline misses (%lu ms), %lu merged, %lu chunks\n",
+               k_class_names[c], (unsigned long)stats.requests, stats.bytes / 1024.0,
+               stats.total_latency_us / 1000.0 / stats.requests, stats.max_latency_us / 1000.0,
+               (unsigned long)stats.deadline_misses, (unsigned long)g_io.deadline_ms[c],
+               (unsigned long)stats.merged, (unsigned long)stats.chunks);
+
+        char line[256];
+        int pos = 0;
+        uint32_t limit_us = 500;
+        for (int b = 0; b < IO_SCHED_HIST_BUCKETS && pos < (int)sizeof(line); b++, limit_us *= 2) {
+            if (b == IO_SCHED_HIST_BUCKETS - 1) {
+                pos += snprintf(line + pos, sizeof(line) - pos, " >=%lums:%lu",
+                                (unsigned long)(limit_us / 2000), (unsigned long)stats.histogram[b]);
+            } else if (limit_us < 1000) {
+                pos += snprintf(line + pos, sizeof(line) - pos, " <0.5ms:%lu", (unsigned long)stats.histogram[b]);
+            } else {
+                pos += snprintf(line + pos, sizeof(line) - pos, " <%lums:%lu",
+                                (unsigned long)(limit_us / 1000), (unsigned long)stats.histogram[b]);
+            }
+        }
+        printf("  latency:%s\n", line);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Self Test                                 */
+/* -------------------------------------------------------------------------- */
+
+#define SELF_TEST_AUDIO_SIZE        (1024 * 1024)
+#define SELF_TEST_BULK_SIZE         (4 * 1024 * 1024)
+#define SELF_TEST_AUDIO_BLOCK       (8 * 1024)      // 每40ms读8KB，约为320kbps MP3所需的5倍
+#define SELF_TEST_AUDIO_PERIOD_MS   40
+#define SELF_TEST_BULK_BLOCK        (64 * 1024)
+#define SELF_TEST_BULK_WORKERS      2
+
+typedef struct {
+    const char* path;
+    uint32_t file_size;
+    uint32_t block;
+    io_class_t io_class;
+    uint32_t interval_ms;       // 0表示连续读取
+    bool random;
+    volatile bool* stop;
+    SemaphoreHandle_t done;
+    uint32_t reads;
+    uint32_t errors;
+} load_worker_t;
+
+static void load_task(void* arg) {
+    load_worker_t* worker = (load_worker_t*)arg;
+    uint8_t* buffer = heap_caps_malloc(worker->block, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    int fd = open(worker->path, O_RDONLY);
+    uint32_t blocks = worker->file_size / worker->block;
+    uint32_t seed = (uint32_t)(uintptr_t)worker | 1;
+    uint32_t index = 0;
+
+    while (buffer && fd >= 0 && !*worker->stop) {
+        if (worker->random) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            index = seed % blocks;
+        } else {
+            index = (index + 1) % blocks;
+        }
+        if (io_sched_read(fd, (int64_t)index * worker->block, buffer, worker->block, worker->io_class) <= 0) {
+            worker->errors++;
+        }
+        worker->reads++;
+        vTaskDelay(worker->interval_ms ? pdMS_TO_TICKS(worker->interval_ms) : 1);
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+    heap_caps_free(buffer);
+    xSemaphoreGive(worker->done);
+    vTaskDelete(NULL);
+}
+
+bool io_sched_self_test(const char* work_dir, uint32_t seconds) {
+    if (!work_dir || seconds == 0 || !io_sched_init()) {
+        return false;
+    }
+
+    char audio_path[256];
+    char bulk_path[256];
+    snprintf(audio_path, sizeof(audio_path), "%s/io_audio.bin", work_dir);
+    snprintf(bulk_path, sizeof(bulk_path), "%s/io_bulk.bin", work_dir);
+
+    if (!sd_selftest_mkdir(work_dir) ||
+        !sd_selftest_write_pattern(audio_path, SELF_TEST_AUDIO_SIZE, 0) ||
+        !sd_selftest_write_pattern(bulk_path, SELF_TEST_BULK_SIZE, 0)) {
+        printf("I/O sched self test: failed to create test files in %s\n", work_dir);
+        unlink(audio_path);
+        unlink(bulk_path);
+        rmdir(work_dir);
+        return false;
+    }
+
+    volatile bool stop = false;
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(SELF_TEST_BULK_WORKERS + 1, 0);
+    load_worker_t workers[SELF_TEST_BULK_WORKERS + 1];
+    int started = 0;
+    for (int i = 0; done && i < SELF_TEST_BULK_WORKERS + 1; i++) {
+        bool interactive = i == SELF_TEST_BULK_WORKERS;
+        workers[i] = (load_worker_t){
+            .path = bulk_path,
+            .file_size = SELF_TEST_BULK_SIZE,
+            .block = interactive ? 4096 : SELF_TEST_BULK_BLOCK,
+            .io_class = interactive ? IO_CLASS_INTERACTIVE : IO_CLASS_BACKGROUND,
+            .interval_ms = interactive ? 100 : 0,
+            .random = interactive || i == 1,
+            .stop = &stop,
+            .done = done,
+        };
+        if (xTaskCreate(load_task, "io_load", 4096, &workers[i], 4, NULL) == pdPASS) {
+            started++;
+        }
+    }
+
+    io_sched_reset_stats();
+
+    // 按固定周期读取，模拟音频解码
+    uint8_t* audio_buffer = heap_caps_malloc(SELF_TEST_AUDIO_BLOCK, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    int fd = open(audio_path, O_RDONLY);
+    uint32_t audio_reads = 0;
+    uint32_t audio_errors = 0;
+    int64_t end_us = esp_timer_get_time() + (int64_t)seconds * 1000000;
+    uint32_t offset = 0;
+
+    while (audio_buffer && fd >= 0 && esp_timer_get_time() < end_us) {
+        int64_t period_start = esp_timer_get_time();
+        if (io_sched_read(fd, offset, audio_buffer, SELF_TEST_AUDIO_BLOCK, IO_CLASS_REALTIME) != SELF_TEST_AUDIO_BLOCK) {
+            audio_errors++;
+        }
+        audio_reads++;
+        offset = (offset + SELF_TEST_AUDIO_BLOCK) % SELF_TEST_AUDIO_SIZE;
+
+        int64_t spent_ms = (esp_timer_get_time() - period_start) / 1000;
+        if (spent_ms < SELF_TEST_AUDIO_PERIOD_MS) {
+            vTaskDelay(pdMS_TO_TICKS(SELF_TEST_AUDIO_PERIOD_MS - spent_ms));
+        }
+    }
+
+    stop = true;
+    for (int i = 0; i < started; i++) {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+    if (done) {
+        vSemaphoreDelete(done);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    heap_caps_free(audio_buffer);
+    unlink(audio_path);
+    unlink(bulk_path);
+    rmdir(work_dir);
+
+    io_sched_class_stats_t realtime;
+    io_sched_get_stats(IO_CLASS_REALTIME, &realtime);
+    uint32_t bulk_reads = 0;
+    for (int i = 0; i < started; i++) {
+        bulk_reads += workers[i].reads;
+    }
+    io_sched_log_stats();
+
+    bool ok = audio_reads > 0 && audio_errors == 0 && realtime.deadline_misses == 0;
+    printf("I/O sched self test %s: %lu audio reads (%lu errors), %lu load reads in %lu s\n",
+           ok ? "passed" : "FAILED", (unsigned long)audio_reads, (unsigned long)audio_errors,
+           (unsigned long)bulk_reads, (unsigned long)seconds);
+    return ok;
+}
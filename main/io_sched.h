@@ -0,0 +1,99 @@
+#ifndef IO_SCHED_H
+#define IO_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 优先级类别（数值越小越优先）
+typedef enum {
+    IO_CLASS_REALTIME,          // 音频流：有截止时间，不能断
+    IO_CLASS_INTERACTIVE,       // 界面直接等待的读取（文本查看器翻页等）
+    IO_CLASS_BACKGROUND,        // 复制、搜索、查重等批量任务
+    IO_CLASS_COUNT
+} io_class_t;
+
+// 读写位置：使用文件当前位置
+#define IO_SCHED_CURRENT        ((int64_t)-1)
+
+// 延迟直方图桶数：<0.5ms, <1ms, <2ms ... <512ms, >=512ms
+#define IO_SCHED_HIST_BUCKETS   12
+
+// 单个类别的统计
+typedef struct {
+    uint32_t requests;          // 完成的请求数
+    uint32_t merged;            // 与前一请求连续、省去定位的请求数
+    uint32_t chunks;            // 大请求被拆分执行的次数
+    uint32_t deadline_misses;   // 超过截止时间才完成的请求数
+    uint64_t bytes;             // 传输字节数
+    uint32_t max_latency_us;    // 最大延迟（提交到完成）
+    uint64_t total_latency_us;  // 累计延迟（用于计算平均值）
+    uint32_t histogram[IO_SCHED_HIST_BUCKETS];
+} io_sched_class_stats_t;
+
+/**
+ * @brief 启动I/O调度任务（SD卡挂载后调用，可重复调用）
+ *
+ * 未启动时所有接口直接在调用方任务中执行读写。
+ */
+bool io_sched_init(void);
+
+/**
+ * @brief 通过调度器读取，阻塞直到完成
+ *
+ * 高优先级请求先执行；同一类别内按截止时间排序。后台和交互请求按块拆分，
+ * 实时请求最多等待一个块。对同一文件连续位置的请求连在一起执行。
+ *
+ * @param fd 已打开的文件描述符
+ * @param offset 文件偏移，IO_SCHED_CURRENT表示从当前位置读取
+ * @return 读取的字节数（0表示文件末尾），失败返回-1并设置errno
+ */
+ssize_t io_sched_read(int fd, int64_t offset, void* buf, size_t len, io_class_t io_class);
+
+/**
+ * @brief 通过调度器写入全部数据（从文件当前位置），阻塞直到完成
+ *
+ * @return 写入的字节数，失败返回-1并设置errno
+ */
+ssize_t io_sched_write(int fd, const void* buf, size_t len, io_class_t io_class);
+
+/**
+ * @brief 设置类别的截止时间（毫秒，从提交算起）
+ */
+void io_sched_set_deadline(io_class_t io_class, uint32_t deadline_ms);
+
+/**
+ * @brief 获取类别的统计快照
+ */
+void io_sched_get_stats(io_class_t io_class, io_sched_class_stats_t* stats);
+
+/**
+ * @brief 清零统计
+ */
+void io_sched_reset_stats(void);
+
+/**
+ * @brief 打印各类别的统计和延迟直方图
+ */
+void io_sched_log_stats(void);
+
+/**
+ * @brief 负载测试：后台任务持续大块读取、交互任务随机读取的同时，
+ *        按音频码率读取并检查截止时间
+ *
+ * @param work_dir 临时工作目录（结束时删除测试文件）
+ * @param seconds 测试时长
+ * @return 实时读取全部满足截止时间返回true
+ */
+bool io_sched_self_test(const char* work_dir, uint32_t seconds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IO_SCHED_H
@@ -0,0 +1,531 @@
+#define _GNU_SOURCE     // fopencookie
+#include "media_stream.h"
+#include "hal_sdcard.h"
+#include "sd_selftest.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+// 配置
+#define STREAM_DEFAULT_BUFFER   (16 * 1024)
+#define STREAM_DEFAULT_COUNT    4
+#define STREAM_MIN_BUFFER       (4 * 1024)
+#define STREAM_TASK_STACK       3072
+#define STREAM_TASK_PRIORITY    7               // 低于音频解码任务(8)，高于界面和后台任务
+
+// fopencookie的定位参数类型（newlib与glibc不同）
+#if defined(__NEWLIB__) && !defined(__LARGE64_FILES)
+typedef off_t cookie_off_t;
+#elif defined(__NEWLIB__)
+typedef _off64_t cookie_off_t;
+#else
+typedef off64_t cookie_off_t;
+#endif
+
+typedef struct {
+    uint8_t* data;
+    uint32_t len;               // 0表示文件末尾
+    int64_t offset;             // 数据在文件中的偏移
+    uint32_t generation;        // 预读时的代数，定位后旧数据作废
+    bool error;
+} stream_buffer_t;
+
+typedef struct media_stream {
+    int fd;
+    uint32_t mount_generation; // 打开时的挂载代数
+    int64_t file_size;
+    media_stream_config_t config;
+
+    uint8_t* pool;
+    stream_buffer_t* buffers;
+    QueueHandle_t free_queue;   // 空闲缓冲区
+    QueueHandle_t full_queue;   // 已预读的缓冲区（按文件顺序）
+    SemaphoreHandle_t kick;     // 定位或关闭时唤醒到达末尾的预读任务
+    SemaphoreHandle_t filler_done;
+    volatile bool stop;
+
+    // 以下两项由g_media.lock保护
+    uint32_t generation;
+    int64_t fill_offset;        // 预读任务下一次读取的偏移
+
+    // 解码器一侧（只在调用fread/fseek的任务中访问）
+    stream_buffer_t* current;
+    uint32_t current_pos;
+    int64_t position;
+    bool eof;
+    bool started;
+
+    media_stream_stats_t stats; // 由g_media.lock保护
+} media_stream_t;
+
+static struct {
+    SemaphoreHandle_t lock;
+    media_stream_t* active;     // 最近打开且未关闭的流
+    media_stream_stats_t last_stats;
+    bool has_stats;
+} g_media = {0};
+
+static void media_lock(void) {
+    xSemaphoreTake(g_media.lock, portMAX_DELAY);
+}
+
+static void media_unlock(void) {
+    xSemaphoreGive(g_media.lock);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                Read-ahead                                  */
+/* -------------------------------------------------------------------------- */
+
+// 模拟慢速卡：固定延迟加带宽限制
+static void emulate_card(const media_stream_config_t* config, uint32_t len, int64_t started_us) {
+    if (config->emulate_latency_ms == 0 && config->emulate_kbps == 0) {
+        return;
+    }
+    int64_t target_us = started_us + (int64_t)config->emulate_latency_ms * 1000;
+    if (config->emulate_kbps > 0) {
+        target_us += (int64_t)len * 1000000 / ((int64_t)config->emulate_kbps * 1024);
+    }
+    int64_t wait_us = target_us - esp_timer_get_time();
+    if (wait_us > 0) {
+        vTaskDelay(pdMS_TO_TICKS((wait_us + 999) / 1000));
+    }
+}
+
+static void filler_task(void* arg) {
+    media_stream_t* s = (media_stream_t*)arg;
+    uint32_t eof_generation = UINT32_MAX;
+
+    while (!s->stop) {
+        stream_buffer_t* b = NULL;
+        if (xQueueReceive(s->free_queue, &b, pdMS_TO_TICKS(50)) != pdTRUE) {
+            continue;
+        }
+
+        media_lock();
+        uint32_t generation = s->generation;
+        int64_t offset = s->fill_offset;
+        media_unlock();
+
+        if (offset >= s->file_size) {
+            if (generation == eof_generation) {
+                // 已发送过结束标记：等待定位或关闭
+                xQueueSend(s->free_queue, &b, 0);
+                xSemaphoreTake(s->kick, pdMS_TO_TICKS(100));
+                continue;
+            }
+            eof_generation = generation;
+            *b = (stream_buffer_t){ b->data, 0, offset, generation, false };
+            xQueueSend(s->full_queue, &b, portMAX_DELAY);
+            continue;
+        }
+
+        int64_t start = esp_timer_get_time();
+        ssize_t n = io_sched_read(s->fd, offset, b->data, s->config.buffer_size, s->config.io_class);
+        emulate_card(&s->config, n > 0 ? (uint32_t)n : 0, start);
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        media_lock();
+        if (generation == s->generation && n > 0) {
+            s->fill_offset = offset + n;
+        }
+        s->stats.fills++;
+        s->stats.fill_bytes += n > 0 ? (uint64_t)n : 0;
+        s->stats.fill_us += (uint64_t)elapsed;
+        media_unlock();
+
+        *b = (stream_buffer_t){ b->data, n > 0 ? (uint32_t)n : 0, offset, generation, n < 0 };
+        if (n == 0) {
+            eof_generation = generation;
+        }
+        xQueueSend(s->full_queue, &b, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(s->filler_done);
+    vTaskDelete(NULL);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Consumer                                   */
+/* -------------------------------------------------------------------------- */
+
+// 归还当前缓冲区并取下一个有效缓冲区，记录等待时间
+static void next_buffer(media_stream_t* s) {
+    if (s->current) {
+        xQueueSend(s->free_queue, &s->current, portMAX_DELAY);
+        s->current = NULL;
+    }
+
+    while (true) {
+        stream_buffer_t* b = NULL;
+        if (xQueueReceive(s->full_queue, &b, 0) != pdTRUE) {
+            int64_t start = esp_timer_get_time();
+            xQueueReceive(s->full_queue, &b, portMAX_DELAY);
+            uint32_t waited = (uint32_t)(esp_timer_get_time() - start);
+
+            media_lock();
+            if (!s->started) {
+                s->stats.startup_us = waited;
+            } else {
+                s->stats.stalls++;
+                s->stats.stall_us += waited;
+                if (waited > s->stats.max_stall_us) {
+                    s->stats.max_stall_us = waited;
+                }
+            }
+            media_unlock();
+        }
+        s->started = true;
+
+        // 只有本任务修改generation，无需加锁读取
+        if (b->generation != s->generation) {
+            xQueueSend(s->free_queue, &b, portMAX_DELAY);
+            continue;
+        }
+        s->current = b;
+        s->current_pos = (uint32_t)(s->position - b->offset);
+        return;
+    }
+}
+
+static ssize_t stream_read(void* cookie, char* buf, size_t size) {
+    media_stream_t* s = (media_stream_t*)cookie;
+    if (s->eof || size == 0) {
+        return 0;
+    }
+
+    if (!s->current || s->current_pos >= s->current->len) {
+        next_buffer(s);
+        if (s->current->error) {
+            errno = EIO;
+            return -1;
+        }
+        if (s->current->len == 0) {
+            s->eof = true;
+            return 0;
+        }
+    }
+
+    uint32_t available = s->current->len - s->current_pos;
+    size_t n = size < available ? size : available;
+    memcpy(buf, s->current->data + s->current_pos, n);
+    s->current_pos += (uint32_t)n;
+    s->position += (int64_t)n;
+
+    media_lock();
+    s->stats.bytes_delivered += n;
+    media_unlock();
+    return (ssize_t)n;
+}
+
+static int stream_seek(void* cookie, cookie_off_t* offset, int whence) {
+    media_stream_t* s = (media_stream_t*)cookie;
+    int64_t target;
+
+    switch (whence) {
+    case SEEK_SET:
+        target = *offset;
+        break;
+    case SEEK_CUR:
+        target = s->position + *offset;
+        break;
+    case SEEK_END:
+        target = s->file_size + *offset;
+        break;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+    if (target < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    *offset = (cookie_off_t)target;
+
+    if (target == s->position) {
+        return 0;
+    }
+
+    // 目标在当前缓冲区内：只移动读取位置
+    stream_buffer_t* b = s->current;
+    if (b && b->len > 0 && target >= b->offset && target < b->offset + b->len) {
+        s->current_pos = (uint32_t)(target - b->offset);
+        s->position = target;
+        s->eof = false;
+        return 0;
+    }
+
+    // 否则作废已预读的数据，从目标位置重新预读
+    media_lock();
+    s->generation++;
+    s->fill_offset = target;
+    s->stats.seeks++;
+    media_unlock();
+
+    // 队列中的旧数据由next_buffer按代数丢弃（这里清空会误丢预读任务刚放入的新数据）
+    if (s->current) {
+        xQueueSend(s->free_queue, &s->current, portMAX_DELAY);
+        s->current = NULL;
+    }
+    s->position = target;
+    s->eof = false;
+    xSemaphoreGive(s->kick);
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               Open / Close                                 */
+/* -------------------------------------------------------------------------- */
+
+static void stream_free(media_stream_t* s) {
+    if (s->free_queue) {
+        vQueueDelete(s->free_queue);
+    }
+    if (s->full_queue) {
+        vQueueDelete(s->full_queue);
+    }
+    if (s->kick) {
+        vSemaphoreDelete(s->kick);
+    }
+    if (s->filler_done) {
+        vSemaphoreDelete(s->filler_done);
+    }
+    if (s->pool) {
+        heap_caps_free(s->pool);
+    }
+    free(s->buffers);
+    // 卡已卸载时描述符已失效，编号可能已分配给重新挂载后打开的文件，不能再关闭
+    if (s->fd >= 0 && s->mount_generation == hal_sdcard_get_generation()) {
+        close(s->fd);
+    }
+    free(s);
+}
+
+static int stream_close(void* cookie) {
+    media_stream_t* s = (media_stream_t*)cookie;
+
+    s->stop = true;
+    xSemaphoreGive(s->kick);
+    xSemaphoreTake(s->filler_done, portMAX_DELAY);
+
+    media_lock();
+    g_media.last_stats = s->stats;
+    g_media.has_stats = true;
+    if (g_media.active == s) {
+        g_media.active = NULL;
+    }
+    media_stream_stats_t stats = s->stats;
+    media_unlock();
+
+    printf("Media stream closed: %llu bytes delivered, startup %.1f ms, %lu stalls (%.1f ms total, max %.1f ms), %lu fills avg %.2f ms\n",
+           (unsigned long long)stats.bytes_delivered, stats.startup_us / 1000.0,
+           (unsigned long)stats.stalls, stats.stall_us / 1000.0, stats.max_stall_us / 1000.0,
+           (unsigned long)stats.fills, stats.fills ? stats.fill_us / 1000.0 / stats.fills : 0.0);
+
+    stream_free(s);
+    return 0;
+}
+
+// 分配缓冲池：优先可DMA的内部RAM，不足时减小缓冲区，最后退回PSRAM
+static bool allocate_pool(media_stream_t* s) {
+    uint32_t count = s->config.buffer_count;
+    for (uint32_t size = s->config.buffer_size; size >= STREAM_MIN_BUFFER; size /= 2) {
+        s->pool = heap_caps_aligned_alloc(64, (size_t)size * count, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+        if (s->pool) {
+            s->config.buffer_size = size;
+            s->stats.dma_buffers = true;
+            return true;
+        }
+    }
+    s->pool = heap_caps_aligned_alloc(64, (size_t)s->config.buffer_size * count, MALLOC_CAP_SPIRAM);
+    if (s->pool) {
+        printf("Media stream: internal RAM low, read-ahead buffers in PSRAM\n");
+    }
+    return s->pool != NULL;
+}
+
+FILE* media_stream_fopen(const char* path, const media_stream_config_t* config) {
+    if (!path) {
+        return NULL;
+    }
+    if (!g_media.lock) {
+        g_media.lock = xSemaphoreCreateMutex();
+        if (!g_media.lock) {
+            return NULL;
+        }
+    }
+
+    media_stream_t* s = calloc(1, sizeof(media_stream_t));
+    if (!s) {
+        return NULL;
+    }
+    s->mount_generation = hal_sdcard_get_generation();
+    s->fd = open(path, O_RDONLY);
+    struct stat st;
+    if (s->fd < 0 || fstat(s->fd, &st) != 0) {
+        printf("Media stream: failed to open %s\n", path);
+        stream_free(s);
+        return NULL;
+    }
+    s->file_size = st.st_size;
+
+    s->config = (media_stream_config_t){
+        .buffer_size = STREAM_DEFAULT_BUFFER,
+        .buffer_count = STREAM_DEFAULT_COUNT,
+        .io_class = IO_CLASS_REALTIME,
+    };
+    if (config) {
+        s->config = *config;
+        if (s->config.buffer_size < STREAM_MIN_BUFFER) {
+            s->config.buffer_size = STREAM_MIN_BUFFER;
+        }
+        if (s->config.buffer_count == 0) {
+            s->config.buffer_count = 1;
+        }
+    }
+
+    uint32_t count = s->config.buffer_count;
+    s->buffers = calloc(count, sizeof(stream_buffer_t));
+    s->free_queue = xQueueCreate(count, sizeof(stream_buffer_t*));
+    s->full_queue = xQueueCreate(count, sizeof(stream_buffer_t*));
+    s->kick = xSemaphoreCreateBinary();
+    s->filler_done = xSemaphoreCreateBinary();
+    if (!s->buffers || !s->free_queue || !s->full_queue || !s->kick || !s->filler_done || !allocate_pool(s)) {
+        printf("Media stream: out of memory for %lu x %lu bytes\n",
+               (unsigned long)count, (unsigned long)s->config.buffer_size);
+        stream_free(s);
+        return NULL;
+    }
+    s->stats.buffer_size = s->config.buffer_size;
+    s->stats.buffer_count = count;
+    for (uint32_t i = 0; i < count; i++) {
+        stream_buffer_t* b = &s->buffers[i];
+        b->data = s->pool + (size_t)i * s->config.buffer_size;
+        xQueueSend(s->free_queue, &b, 0);
+    }
+
+    cookie_io_functions_t functions = {
+        .read = stream_read,
+        .write = NULL,
+        .seek = stream_seek,
+        .close = stream_close,
+    };
+    FILE* fp = fopencookie(s, "rb", functions);
+    if (!fp) {
+        stream_free(s);
+        return NULL;
+    }
+
+    if (xTaskCreate(filler_task, "media_stream", STREAM_TASK_STACK, s, STREAM_TASK_PRIORITY, NULL) != pdPASS) {
+        // 没有预读任务时stream_close不能等待它
+        xSemaphoreGive(s->filler_done);
+        fclose(fp);
+        return NULL;
+    }
+
+    media_lock();
+    g_media.active = s;
+    media_unlock();
+    return fp;
+}
+
+bool media_stream_get_last_stats(media_stream_stats_t* stats) {
+    if (!stats || !g_media.lock) {
+        return false;
+    }
+    media_lock();
+    bool ok = g_media.active || g_media.has_stats;
+    *stats = g_media.active ? g_media.active->stats : g_media.last_stats;
+    media_unlock();
+    return ok;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Self Test                                  */
+/* -------------------------------------------------------------------------- */
+
+#define SELF_TEST_FILE_SIZE     (512 * 1024)
+#define SELF_TEST_READ_SIZE     2048        // 解码器每次fread的大小
+#define SELF_TEST_READ_PERIOD   5           // ms，约400KB/s，相当于10倍320kbps码率
+#define SELF_TEST_LATENCY_MS    8           // 模拟的每次读取延迟
+#define SELF_TEST_CARD_KBPS     1024        // 模拟的卡带宽
+
+// 按解码器节奏读完整个文件，中途做一次远距离定位和一次缓冲区内定位
+static bool run_decoder(const char* path, uint32_t buffer_count, media_stream_stats_t* stats) {
+    media_stream_config_t config = {
+        .buffer_size = 16 * 1024,
+        .buffer_count = buffer_count,
+        .io_class = IO_CLASS_REALTIME,
+        .emulate_latency_ms = SELF_TEST_LATENCY_MS,
+        .emulate_kbps = SELF_TEST_CARD_KBPS,
+    };
+    FILE* fp = media_stream_fopen(path, &config);
+    if (!fp) {
+        return false;
+    }
+    setvbuf(fp, NULL, _IONBF, 0);
+
+    uint8_t chunk[SELF_TEST_READ_SIZE];
+    uint32_t offset = 0;
+    bool ok = true;
+    while (ok) {
+        size_t n = fread(chunk, 1, sizeof(chunk), fp);
+        if (n == 0) {
+            break;
+        }
+        ok = sd_selftest_check_pattern(chunk, n, offset, 0);
+        offset += (uint32_t)n;
+        vTaskDelay(pdMS_TO_TICKS(SELF_TEST_READ_PERIOD));
+    }
+    ok = ok && offset == SELF_TEST_FILE_SIZE;
+
+    // 定位：文件中部（需要重新预读）、回退100字节（当前缓冲区内）、末尾
+    uint32_t middle = SELF_TEST_FILE_SIZE / 2 + 1234;
+    ok = ok && fseek(fp, middle, SEEK_SET) == 0 && fread(chunk, 1, 300, fp) == 300 && sd_selftest_check_pattern(chunk, 300, middle, 0);
+    ok = ok && fseek(fp, -100, SEEK_CUR) == 0 && fread(chunk, 1, 100, fp) == 100 && sd_selftest_check_pattern(chunk, 100, middle + 200, 0);
+    ok = ok && fseek(fp, 0, SEEK_END) == 0 && ftell(fp) == SELF_TEST_FILE_SIZE && fread(chunk, 1, 1, fp) == 0;
+
+    fclose(fp);
+    media_stream_get_last_stats(stats);
+    return ok;
+}
+
+bool media_stream_self_test(const char* work_dir) {
+    if (!work_dir) {
+        return false;
+    }
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/stream_test.bin", work_dir);
+    if (!sd_selftest_mkdir(work_dir) || !sd_selftest_write_pattern(path, SELF_TEST_FILE_SIZE, 0)) {
+        printf("Media stream self test: failed to create %s\n", path);
+        unlink(path);
+        rmdir(work_dir);
+        return false;
+    }
+
+    media_stream_stats_t single = {0};
+    media_stream_stats_t ahead = {0};
+    bool single_ok = run_decoder(path, 1, &single);
+    bool ahead_ok = run_decoder(path, STREAM_DEFAULT_COUNT, &ahead);
+    unlink(path);
+    rmdir(work_dir);
+
+    printf("Media stream self test (card %lu ms + %lu KB/s, decoder %lu KB/s):\n",
+           (unsigned long)SELF_TEST_LATENCY_MS, (unsigned long)SELF_TEST_CARD_KBPS,
+           (unsigned long)(SELF_TEST_READ_SIZE * 1000 / SELF_TEST_READ_PERIOD / 1024));
+    printf("  1 buffer:  %s, %lu stalls, %.1f ms stalled (max %.1f ms)\n", single_ok ? "ok" : "FAILED",
+           (unsigned long)single.stalls, single.stall_us / 1000.0, single.max_stall_us / 1000.0);
+    printf("  %d buffers: %s, %lu stalls, %.1f ms stalled (max %.1f ms)\n", STREAM_DEFAULT_COUNT, ahead_ok ? "ok" : "FAILED",
+           (unsigned long)ahead.stalls, ahead.stall_us / 1000.0, ahead.max_stall_us / 1000.0);
+    return single_ok && ahead_ok;
+}
@@ -0,0 +1,71 @@
+#ifndef MEDIA_STREAM_H
+#define MEDIA_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "io_sched.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 流配置（传NULL使用默认值）
+typedef struct {
+    uint32_t buffer_size;           // 每个预读缓冲区大小（默认16KB）
+    uint32_t buffer_count;          // 缓冲区数量（默认4，至少1）
+    io_class_t io_class;            // 预读请求的调度类别（默认实时）
+    uint32_t emulate_latency_ms;    // 测试用：每次预读额外等待的时间，模拟慢速卡
+    uint32_t emulate_kbps;          // 测试用：限制预读带宽 (KB/s)，0表示不限制
+} media_stream_config_t;
+
+// 流统计
+typedef struct {
+    uint64_t bytes_delivered;       // 交给解码器的字节数
+    uint32_t startup_us;            // 打开后等待首个缓冲区的时间
+    uint32_t stalls;                // 解码器等待预读的次数（不含启动）
+    uint64_t stall_us;              // 解码器累计等待时间
+    uint32_t max_stall_us;          // 单次最长等待
+    uint32_t fills;                 // 预读次数
+    uint64_t fill_bytes;            // 预读字节数
+    uint64_t fill_us;               // 预读累计耗时
+    uint32_t seeks;                 // 超出已缓冲范围、需要重新预读的定位次数
+    uint32_t buffer_size;           // 实际使用的缓冲区大小
+    uint32_t buffer_count;
+    bool dma_buffers;               // 缓冲区是否位于可DMA的内部RAM
+} media_stream_stats_t;
+
+/**
+ * @brief 打开媒体文件，返回带后台预读的只读FILE*
+ *
+ * 预读任务把文件按大块顺序读入缓冲池（优先可DMA的内部RAM），
+ * 解码器的小块fread只从缓冲区复制。支持fseek/ftell，定位到已缓冲范围外时重新预读。
+ * 用fclose关闭（同时结束预读任务）。
+ *
+ * @param path 文件路径
+ * @param config 配置，NULL使用默认值
+ * @return 失败返回NULL
+ */
+FILE* media_stream_fopen(const char* path, const media_stream_config_t* config);
+
+/**
+ * @brief 获取最近打开的流的统计（流已关闭时为关闭时的值）
+ *
+ * @return 从未打开过流时返回false
+ */
+bool media_stream_get_last_stats(media_stream_stats_t* stats);
+
+/**
+ * @brief 用限速模拟慢速SD卡，以解码器的方式读取测试文件，
+ *        对比不预读（单缓冲区）与多缓冲区预读的等待时间，并校验数据和定位
+ *
+ * @param work_dir 临时工作目录（结束时删除测试文件）
+ * @return 数据正确返回true
+ */
+bool media_stream_self_test(const char* work_dir);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEDIA_STREAM_H
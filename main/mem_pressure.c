@@ -0,0 +1,291 @@
+#include "mem_pressure.h"
+#include "lvgl.h"
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+// 配置
+#define MEM_PRESSURE_MAX_CALLBACKS      16
+#define MEM_PRESSURE_INTERVAL_MS        500     // 后台检查间隔
+#define MEM_PRESSURE_REPEAT_MS          5000    // 级别没有变化时再次执行回调的间隔
+#define MEM_PRESSURE_LOG_INTERVAL_MS    15000
+#define MEM_PRESSURE_POLL_MS            100     // LVGL任务检查新请求的间隔
+#define MEM_PRESSURE_TASK_STACK         3072
+#define MEM_PRESSURE_TASK_PRIORITY      1
+
+// 离开级别时需要超出阈值的余量，避免在阈值附近反复
+#define MEM_PRESSURE_HYST_INTERNAL      (16 * 1024)
+#define MEM_PRESSURE_HYST_PSRAM         (256 * 1024)
+
+// 各级别的阈值：内部RAM或PSRAM任一低于阈值即进入该级别
+typedef struct {
+    size_t internal;
+    size_t psram;
+} pressure_threshold_t;
+
+static const pressure_threshold_t g_thresholds[] = {
+    [MEM_PRESSURE_NONE]      = { 0, 0 },
+    [MEM_PRESSURE_TRIM]      = { 128 * 1024, 2 * 1024 * 1024 },
+    [MEM_PRESSURE_HIDDEN_UI] = { 96 * 1024, 1024 * 1024 },
+    [MEM_PRESSURE_EMERGENCY] = { 64 * 1024, 256 * 1024 },
+};
+
+static const char* const g_level_names[] = { "none", "trim", "hidden-ui", "emergency" };
+
+typedef struct {
+    mem_pressure_cb_t cb;       // NULL表示执行回调期间被取消注册
+    void* user_data;
+    uint8_t priority;
+} pressure_callback_t;
+
+// 全局状态（回调表只在LVGL任务中访问）
+static struct {
+    TaskHandle_t task;
+    lv_timer_t* poll_timer;
+    pressure_callback_t callbacks[MEM_PRESSURE_MAX_CALLBACKS];
+    uint32_t callback_count;
+    volatile mem_pressure_level_t level;            // 后台任务发布的当前级别
+    volatile mem_pressure_level_t request_level;
+    volatile uint32_t request_seq;                  // 后台任务每请求一轮加1
+    uint32_t handled_seq;
+    volatile uint32_t alloc_failures;
+    uint32_t rounds;
+    size_t last_released;
+    bool dispatching;
+} g_pressure = {0};
+
+/* -------------------------------------------------------------------------- */
+/*                                   Levels                                   */
+/* -------------------------------------------------------------------------- */
+
+static size_t free_total(void) {
+    return heap_caps_get_free_size(MALLOC_CAP_INTERNAL) + heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+}
+
+// 按剩余内存计算级别；已处于的级别需要超出余量才能离开
+static mem_pressure_level_t level_for(size_t internal, size_t psram, mem_pressure_level_t current) {
+    bool has_psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+
+    for (int level = MEM_PRESSURE_EMERGENCY; level > MEM_PRESSURE_NONE; level--) {
+        size_t internal_limit = g_thresholds[level].internal;
+        size_t psram_limit = g_thresholds[level].psram;
+        if (level <= (int)current) {
+            internal_limit += MEM_PRESSURE_HYST_INTERNAL;
+            psram_limit += MEM_PRESSURE_HYST_PSRAM;
+        }
+        if (internal < internal_limit || (has_psram && psram < psram_limit)) {
+            return (mem_pressure_level_t)level;
+        }
+    }
+    return MEM_PRESSURE_NONE;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Dispatch                                  */
+/* -------------------------------------------------------------------------- */
+
+// 按优先级调用回调；stop_when_recovered时每个回调之后检查，低于请求级别就停止
+static size_t dispatch(mem_pressure_level_t level, bool stop_when_recovered) {
+    if (level == MEM_PRESSURE_NONE || g_pressure.dispatching) {
+        return 0;
+    }
+    g_pressure.dispatching = true;
+
+    size_t before = free_total();
+    int64_t start_us = esp_timer_get_time();
+    uint32_t called = 0;
+
+    for (uint32_t i = 0; i < g_pressure.callback_count; i++) {
+        pressure_callback_t* entry = &g_pressure.callbacks[i];
+        if (!entry->cb) {
+            continue;
+        }
+        entry->cb(level, entry->user_data);
+        called++;
+        if (stop_when_recovered && mem_pressure_check() < level) {
+            break;
+        }
+    }
+
+    // 压缩执行期间取消注册的空位
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < g_pressure.callback_count; i++) {
+        if (g_pressure.callbacks[i].cb) {
+            g_pressure.callbacks[count++] = g_pressure.callbacks[i];
+        }
+    }
+    g_pressure.callback_count = count;
+
+    size_t after = free_total();
+    g_pressure.last_released = after > before ? after - before : 0;
+    g_pressure.rounds++;
+    g_pressure.dispatching = false;
+
+    printf("Memory pressure round #%lu (%s): %lu callbacks, released %zu bytes in %lld us\n",
+           (unsigned long)g_pressure.rounds, g_level_names[level], (unsigned long)called,
+           g_pressure.last_released, (long long)(esp_timer_get_time() - start_us));
+    return g_pressure.last_released;
+}
+
+// LVGL任务中检查后台任务的请求
+static void poll_timer_cb(lv_timer_t* timer) {
+    (void)timer;
+    uint32_t seq = g_pressure.request_seq;
+    if (seq == g_pressure.handled_seq) {
+        return;
+    }
+    g_pressure.handled_seq = seq;
+    dispatch(g_pressure.request_level, true);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Monitor                                   */
+/* -------------------------------------------------------------------------- */
+
+// 分配失败时立即唤醒监控任务（不能在这里打印或分配）
+static void alloc_failed_hook(size_t size, uint32_t caps, const char* function_name) {
+    (void)size;
+    (void)caps;
+    (void)function_name;
+
+    g_pressure.alloc_failures++;
+    if (!g_pressure.task) {
+        return;
+    }
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(g_pressure.task, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        xTaskNotifyGive(g_pressure.task);
+    }
+}
+
+static void mem_pressure_task(void* arg) {
+    (void)arg;
+    int64_t last_request_us = 0;
+    int64_t last_log_us = 0;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MEM_PRESSURE_INTERVAL_MS));
+
+        size_t internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        size_t psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        mem_pressure_level_t previous = g_pressure.level;
+        mem_pressure_level_t level = level_for(internal, psram, previous);
+        g_pressure.level = level;
+
+        int64_t now_us = esp_timer_get_time();
+        if (level > MEM_PRESSURE_NONE &&
+            (level > previous || now_us - last_request_us >= (int64_t)MEM_PRESSURE_REPEAT_MS * 1000)) {
+            printf("Memory pressure %s (internal %zu, PSRAM %zu)\n", g_level_names[level], internal, psram);
+            g_pressure.request_level = level;
+            g_pressure.request_seq++;
+            last_request_us = now_us;
+        } else if (level == MEM_PRESSURE_NONE && previous != MEM_PRESSURE_NONE) {
+            printf("Memory pressure cleared (internal %zu, PSRAM %zu)\n", internal, psram);
+        }
+
+        if (now_us - last_log_us >= (int64_t)MEM_PRESSURE_LOG_INTERVAL_MS * 1000) {
+            printf("Memory Monitor: Internal=%zu, PSRAM=%zu, Level=%s, Rounds=%lu\n",
+                   internal, psram, g_level_names[level], (unsigned long)g_pressure.rounds);
+            last_log_us = now_us;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Public API                                 */
+/* -------------------------------------------------------------------------- */
+
+bool mem_pressure_init(void) {
+    if (g_pressure.task) {
+        return true;
+    }
+
+    g_pressure.poll_timer = lv_timer_create(poll_timer_cb, MEM_PRESSURE_POLL_MS, NULL);
+    if (!g_pressure.poll_timer) {
+        printf("Failed to create memory pressure timer\n");
+        return false;
+    }
+
+    if (xTaskCreate(mem_pressure_task, "mem_pressure", MEM_PRESSURE_TASK_STACK, NULL,
+                    MEM_PRESSURE_TASK_PRIORITY, &g_pressure.task) != pdPASS) {
+        printf("Failed to create memory pressure task\n");
+        lv_timer_delete(g_pressure.poll_timer);
+        g_pressure.poll_timer = NULL;
+        g_pressure.task = NULL;
+        return false;
+    }
+
+    heap_caps_register_failed_alloc_callback(alloc_failed_hook);
+    printf("Memory pressure monitor started (interval: %d ms)\n", MEM_PRESSURE_INTERVAL_MS);
+    return true;
+}
+
+bool mem_pressure_register(mem_pressure_cb_t cb, void* user_data, uint8_t priority) {
+    if (!cb) {
+        return false;
+    }
+    for (uint32_t i = 0; i < g_pressure.callback_count; i++) {
+        if (g_pressure.callbacks[i].cb == cb && g_pressure.callbacks[i].user_data == user_data) {
+            return true;
+        }
+    }
+    if (g_pressure.callback_count >= MEM_PRESSURE_MAX_CALLBACKS) {
+        printf("Memory pressure callback table full\n");
+        return false;
+    }
+
+    // 按优先级插入，同优先级按注册顺序
+    uint32_t pos = g_pressure.callback_count;
+    while (pos > 0 && g_pressure.callbacks[pos - 1].priority > priority) {
+        g_pressure.callbacks[pos] = g_pressure.callbacks[pos - 1];
+        pos--;
+    }
+    g_pressure.callbacks[pos].cb = cb;
+    g_pressure.callbacks[pos].user_data = user_data;
+    g_pressure.callbacks[pos].priority = priority;
+    g_pressure.callback_count++;
+    return true;
+}
+
+void mem_pressure_unregister(mem_pressure_cb_t cb, void* user_data) {
+    for (uint32_t i = 0; i < g_pressure.callback_count; i++) {
+        pressure_callback_t* entry = &g_pressure.callbacks[i];
+        if (entry->cb != cb || entry->user_data != user_data) {
+            continue;
+        }
+        if (g_pressure.dispatching) {
+            // 执行回调期间不移动表项，结束后压缩
+            entry->cb = NULL;
+        } else {
+            memmove(entry, entry + 1, (g_pressure.callback_count - i - 1) * sizeof(pressure_callback_t));
+            g_pressure.callback_count--;
+        }
+        return;
+    }
+}
+
+mem_pressure_level_t mem_pressure_check(void) {
+    return level_for(heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                     heap_caps_get_free_size(MALLOC_CAP_SPIRAM), MEM_PRESSURE_NONE);
+}
+
+size_t mem_pressure_release(mem_pressure_level_t level) {
+    return dispatch(level, false);
+}
+
+void mem_pressure_get_stats(mem_pressure_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    stats->level = g_pressure.level;
+    stats->rounds = g_pressure.rounds;
+    stats->alloc_failures = g_pressure.alloc_failures;
+    stats->last_released = g_pressure.last_released;
+    stats->min_free_internal = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+}
@@ -0,0 +1,82 @@
+#ifndef MEM_PRESSURE_H
+#define MEM_PRESSURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 内存紧张程度（逐级加重，回调收到的级别包含较低级别的要求）
+typedef enum {
+    MEM_PRESSURE_NONE = 0,
+    MEM_PRESSURE_TRIM,          // 内存偏低：释放可以重建的缓存
+    MEM_PRESSURE_HIDDEN_UI,     // 内存不足：释放看不见的界面（挂起的应用、收起的抽屉）
+    MEM_PRESSURE_EMERGENCY,     // 内存严重不足：释放一切可以释放的
+} mem_pressure_level_t;
+
+// 回调优先级：数值小的先调用，重建代价越低越靠前
+#define MEM_PRESSURE_PRIO_CACHE     10      // 缓存
+#define MEM_PRESSURE_PRIO_APP       20      // 应用自己的可释放内存
+#define MEM_PRESSURE_PRIO_HIDDEN_UI 30      // 看不见的界面
+
+/**
+ * @brief 低内存回调
+ *
+ * 在LVGL任务中调用，可以操作LVGL对象。按级别释放内存，不能阻塞。
+ */
+typedef void (*mem_pressure_cb_t)(mem_pressure_level_t level, void* user_data);
+
+// 统计
+typedef struct {
+    mem_pressure_level_t level;     // 后台任务发布的当前级别
+    uint32_t rounds;                // 执行回调的轮数
+    uint32_t alloc_failures;        // 分配失败次数
+    size_t last_released;           // 最近一轮释放的内部RAM和PSRAM总量
+    size_t min_free_internal;       // 启动以来内部RAM的最低剩余
+} mem_pressure_stats_t;
+
+/**
+ * @brief 初始化（在LVGL任务中调用，启动后台监控任务）
+ *
+ * 后台任务以低优先级定期检查内部RAM和PSRAM的剩余量，分配失败时立即检查；
+ * 级别升高时在LVGL任务中按优先级调用回调，每个回调之后重新检查，恢复后不再继续。
+ */
+bool mem_pressure_init(void);
+
+/**
+ * @brief 注册低内存回调（在LVGL任务中调用）
+ *
+ * @return 回调表已满返回false
+ */
+bool mem_pressure_register(mem_pressure_cb_t cb, void* user_data, uint8_t priority);
+
+/**
+ * @brief 取消注册
+ */
+void mem_pressure_unregister(mem_pressure_cb_t cb, void* user_data);
+
+/**
+ * @brief 按当前剩余内存计算级别（立即检查，不经过后台任务）
+ */
+mem_pressure_level_t mem_pressure_check(void);
+
+/**
+ * @brief 立即以指定级别执行回调（在LVGL任务中调用）
+ *
+ * @return 释放的内部RAM和PSRAM总量
+ */
+size_t mem_pressure_release(mem_pressure_level_t level);
+
+/**
+ * @brief 获取统计
+ */
+void mem_pressure_get_stats(mem_pressure_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEM_PRESSURE_H
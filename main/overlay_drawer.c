@@ -1,6 +1,9 @@
 #include "overlay_drawer.h"
 #include "app_manager.h"
 #include "gesture_handler.h"
+#include "mem_pressure.h"
+#include "app_ctx.h"
+#include "ui_bind.h"
 #include "hal.h"
 #include <stdlib.h>
 #include <string.h>
@@ -62,6 +65,9 @@ typedef struct {
     lv_anim_t slide_anim;
 } drawer_state_t;
 
+static void deep_clean_drawer(drawer_state_t* state);
+static void drawer_pressure_cb(mem_pressure_level_t level, void* user_data);
+
 // 应用项点击事件
 static void app_item_event_cb(lv_event_t* e) {
     lv_event_code_t code = lv_event_get_code(e);
@@ -71,7 +77,7 @@ static void app_item_event_cb(lv_event_t* e) {
         printf("*** APP ITEM CLICKED: %s ***\n", app->name);
         
         // 启动应用
-        bool success = app_manager_launch_app(app->name);
+        bool success = app_manager_launch_app_by_id(app->id);
         printf("App launch %s: %s\n", app->name, success ? "success" : "failed");
         
         // 关闭抽屉
@@ -100,42 +106,6 @@ static void slide_anim_ready_cb(lv_anim_t* a) {
     }
 }
 
-// 音量滑块事件回调
-static void volume_slider_event_cb(lv_event_t* e) {
-    lv_event_code_t code = lv_event_get_code(e);
-    lv_obj_t* slider = lv_event_get_target(e);
-    
-    if (code == LV_EVENT_VALUE_CHANGED) {
-        drawer_state_t* state = (drawer_state_t*)lv_event_get_user_data(e);
-        if (state && state->volume_label) {
-            int32_t value = lv_slider_get_value(slider);
-            hal_set_speaker_volume((uint8_t)value);
-            
-            // 更新标签显示
-            lv_label_set_text_fmt(state->volume_label, "音量: %d%%", (int)value);
-            printf("Volume changed to: %d%%\n", (int)value);
-        }
-    }
-}
-
-// 亮度滑块事件回调
-static void brightness_slider_event_cb(lv_event_t* e) {
-    lv_event_code_t code = lv_event_get_code(e);
-    lv_obj_t* slider = lv_event_get_target(e);
-    
-    if (code == LV_EVENT_VALUE_CHANGED) {
-        drawer_state_t* state = (drawer_state_t*)lv_event_get_user_data(e);
-        if (state && state->brightness_label) {
-            int32_t value = lv_slider_get_value(slider);
-            hal_set_display_brightness((uint8_t)value);
-            
-            // 更新标签显示
-            lv_label_set_text_fmt(state->brightness_label, "亮度: %d%%", (int)value);
-            printf("Brightness changed to: %d%%\n", (int)value);
-        }
-    }
-}
-
 // 扬声器开关事件回调
 static void speaker_switch_event_cb(lv_event_t* e) {
     lv_event_code_t code = lv_event_get_code(e);
@@ -150,13 +120,8 @@ static void speaker_switch_event_cb(lv_event_t* e) {
             bool enabled = lv_obj_has_state(switch_obj, LV_STATE_CHECKED);
             printf("Switch state: %s\n", enabled ? "checked" : "unchecked");
             
-            // 调用HAL函数设置扬声器状态
-            hal_set_speaker_enable(enabled);
-            
-            printf("Speaker %s\n", enabled ? "enabled" : "disabled");
-            
-            // 强制刷新显示
-            lv_obj_invalidate(switch_obj);
+            // 写入共享状态，由ui_bind写回HAL并同步设置应用中的开关
+            ui_bind_set_int(ui_bind_speaker(), enabled ? 1 : 0);
         }
     }
 }
@@ -211,7 +176,7 @@ static void create_app_item(lv_obj_t* parent, app_t* app) {
     
     // 创建应用图标
     lv_obj_t* icon = lv_label_create(icon_container);
-    if (app->icon[0] != '\0') {
+    if (app->icon && app->icon[0] != '\0') {
         lv_label_set_text(icon, app->icon);
     } else {
         // 如果没有图标，使用应用名称的第一个字符
@@ -389,7 +354,7 @@ static void drawer_overlay_create(app_t* app) {
     
     // 音量标签
     state->volume_label = lv_label_create(volume_container);
-    lv_label_set_text_fmt(state->volume_label, "音量: %d%%", hal_get_speaker_volume());
+    lv_label_bind_text(state->volume_label, ui_bind_volume(), "音量: %d%%");
     lv_obj_set_style_text_color(state->volume_label, lv_color_hex(0xFF6600), 0);  // 橙色
     lv_obj_set_style_text_font(state->volume_label, &simhei_32, 0);  // 使用中文字体
     lv_obj_align(state->volume_label, LV_ALIGN_TOP_LEFT, 0, 0);
@@ -399,29 +364,20 @@ static void drawer_overlay_create(app_t* app) {
     lv_obj_set_size(state->volume_slider, LV_PCT(50), 18);  // 调窄到50%宽度，为开关留出更多空间
     lv_obj_align_to(state->volume_slider, state->volume_label, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 8);  // 增加间距到8像素
     lv_slider_set_range(state->volume_slider, 0, 100);
-    lv_slider_set_value(state->volume_slider, hal_get_speaker_volume(), LV_ANIM_OFF);
+    lv_slider_bind_value(state->volume_slider, ui_bind_volume());  // 双向绑定，拖动时写回HAL
     
     // 设置音量滑块样式 (橙色主题)
     lv_obj_set_style_bg_color(state->volume_slider, lv_color_hex(0xFF9966), LV_PART_MAIN);
     lv_obj_set_style_bg_color(state->volume_slider, lv_color_hex(0xFF6600), LV_PART_INDICATOR);
     lv_obj_set_style_bg_color(state->volume_slider, lv_color_hex(0xFF4400), LV_PART_KNOB);
     
-    // 添加音量滑块事件
-    lv_obj_add_event_cb(state->volume_slider, volume_slider_event_cb, LV_EVENT_VALUE_CHANGED, state);
-    
     // 扬声器开关 (移除标签，只保留开关)
     state->speaker_switch = lv_switch_create(volume_container);
     lv_obj_set_size(state->speaker_switch, 50, 25);  // 调整开关大小
     lv_obj_align_to(state->speaker_switch, state->volume_slider, LV_ALIGN_OUT_RIGHT_MID, 15, 0);  // 放在滑块右边，减少间距
     
-    // 设置开关状态
-    bool speaker_enabled = hal_get_speaker_enable();
-    printf("Initial speaker state: %s\n", speaker_enabled ? "enabled" : "disabled");
-    if (speaker_enabled) {
-        lv_obj_add_state(state->speaker_switch, LV_STATE_CHECKED);
-    } else {
-        lv_obj_clear_state(state->speaker_switch, LV_STATE_CHECKED);
-    }
+    // 开关状态跟随扬声器状态
+    lv_obj_bind_state_if_not_eq(state->speaker_switch, ui_bind_speaker(), LV_STATE_CHECKED, 0);
     
     // 设置开关样式 (绿色主题)
     lv_obj_set_style_bg_color(state->speaker_switch, lv_color_hex(0xCCCCCC), LV_PART_MAIN);
@@ -460,7 +416,7 @@ static void drawer_overlay_create(app_t* app) {
     
     // 亮度标签
     state->brightness_label = lv_label_create(brightness_container);
-    lv_label_set_text_fmt(state->brightness_label, "亮度: %d%%", hal_get_display_brightness());
+    lv_label_bind_text(state->brightness_label, ui_bind_brightness(), "亮度: %d%%");
     lv_obj_set_style_text_color(state->brightness_label, lv_color_hex(0x0066FF), 0);  // 蓝色
     lv_obj_set_style_text_font(state->brightness_label, &simhei_32, 0);  // 使用中文字体
     lv_obj_align(state->brightness_label, LV_ALIGN_TOP_LEFT, 0, 0);
@@ -470,27 +426,28 @@ static void drawer_overlay_create(app_t* app) {
     lv_obj_set_size(state->brightness_slider, LV_PCT(100), 18);  // 调整滑块高度到22像素
     lv_obj_align_to(state->brightness_slider, state->brightness_label, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 8);  // 增加间距到8像素
     lv_slider_set_range(state->brightness_slider, 20, 100);  // 最低亮度20%
-    lv_slider_set_value(state->brightness_slider, hal_get_display_brightness(), LV_ANIM_OFF);
+    lv_slider_bind_value(state->brightness_slider, ui_bind_brightness());
     
     // 设置亮度滑块样式 (蓝色主题)
     lv_obj_set_style_bg_color(state->brightness_slider, lv_color_hex(0x6699FF), LV_PART_MAIN);
     lv_obj_set_style_bg_color(state->brightness_slider, lv_color_hex(0x0066FF), LV_PART_INDICATOR);
     lv_obj_set_style_bg_color(state->brightness_slider, lv_color_hex(0x0044CC), LV_PART_KNOB);
     
-    // 添加亮度滑块事件
-    lv_obj_add_event_cb(state->brightness_slider, brightness_slider_event_cb, LV_EVENT_VALUE_CHANGED, state);
-    
     // 不在创建时刷新应用列表，延迟到第一次打开
     // refresh_app_list(state->app_list, false); // 移除这行
     
     // 保存状态到用户数据
     app->user_data = state;
+    
+    // 内存不足时立即深度清理收起的抽屉，不等空闲超时
+    mem_pressure_register(drawer_pressure_cb, state, MEM_PRESSURE_PRIO_HIDDEN_UI);
 }
 
 // 销毁应用抽屉Overlay
 static void drawer_overlay_destroy(app_t* app) {
     if (app && app->user_data) {
         drawer_state_t* state = (drawer_state_t*)app->user_data;
+        mem_pressure_unregister(drawer_pressure_cb, state);
         
         // 清理应用列表中的内存
         if (state->app_list) {
@@ -561,7 +518,7 @@ void app_drawer_open(void) {
     lv_anim_set_path_cb(&state->slide_anim, lv_anim_path_ease_out);
     lv_anim_set_ready_cb(&state->slide_anim, slide_anim_ready_cb);
     lv_anim_set_user_data(&state->slide_anim, state);
-    lv_anim_start(&state->slide_anim);
+    app_ctx_anim_start(&overlay->base, &state->slide_anim);
     
     state->is_open = true;
     
@@ -601,7 +558,7 @@ void app_drawer_close(void) {
     lv_anim_set_path_cb(&state->slide_anim, lv_anim_path_ease_in);
     lv_anim_set_ready_cb(&state->slide_anim, slide_anim_ready_cb);
     lv_anim_set_user_data(&state->slide_anim, state);
-    lv_anim_start(&state->slide_anim);
+    app_ctx_anim_start(&overlay->base, &state->slide_anim);
     
     state->is_open = false;
     
@@ -675,6 +632,13 @@ static void deep_clean_drawer(drawer_state_t* state) {
     app_manager_log_memory_usage("After drawer deep clean");
 }
 
+// 低内存：深度清理收起的抽屉（deep_clean_drawer会跳过打开的抽屉）
+static void drawer_pressure_cb(mem_pressure_level_t level, void* user_data) {
+    if (level >= MEM_PRESSURE_HIDDEN_UI) {
+        deep_clean_drawer((drawer_state_t*)user_data);
+    }
+}
+
 // 检查是否需要进行空闲清理
 static bool should_idle_cleanup(drawer_state_t* state) {
     if (!state || state->is_open || state->deep_cleaned) {
@@ -0,0 +1,632 @@
+#include "sd_bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifdef ESP_PLATFORM
+#include "hal_sdcard.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+static int64_t now_us(void) {
+    return esp_timer_get_time();
+}
+
+static void* alloc_buffer(size_t size, bool psram) {
+    return psram ? heap_caps_aligned_alloc(64, size, MALLOC_CAP_SPIRAM)
+                 : heap_caps_aligned_alloc(64, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+}
+
+static void free_buffer(void* ptr) {
+    heap_caps_free(ptr);
+}
+#else
+#include <time.h>
+
+// Linux：缓冲区位置无区别，按同样的名称输出以便对比
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void* alloc_buffer(size_t size, bool psram) {
+    (void)psram;
+    return aligned_alloc(64, size);
+}
+
+static void free_buffer(void* ptr) {
+    free(ptr);
+}
+#endif
+
+// 配置
+#define BENCH_MAX_BLOCK         (128 * 1024)
+#define BENCH_SEQ_OPS           1024            // 顺序测试最多读写的块数
+#define BENCH_RAND_READ_OPS     512
+#define BENCH_RAND_WRITE_OPS    256
+#define BENCH_FRAG_CHUNK        (32 * 1024)     // 碎片文件：两个文件交替追加的块大小
+#define BENCH_FRAG_SIZE         (2 * 1024 * 1024)
+#define BENCH_META_FILES        200
+#define BENCH_MAX_SAMPLES       2048
+
+typedef enum {
+    BENCH_SEQ_WRITE,
+    BENCH_SEQ_READ,
+    BENCH_RAND_READ,
+    BENCH_RAND_WRITE,
+    BENCH_FRAG_READ,
+    BENCH_CREATE,
+    BENCH_OPEN,
+    BENCH_STAT,
+    BENCH_READDIR,
+    BENCH_READDIR_STAT,
+    BENCH_UNLINK
+} bench_kind_t;
+
+static const char* k_kind_names[] = {
+    "seq_write", "seq_read", "rand_read", "rand_write", "frag_read",
+    "create", "fopen", "stat", "readdir", "readdir_stat", "unlink"
+};
+
+static const struct {
+    bench_kind_t kind;
+    uint32_t block;
+    bool psram;
+} k_plan[] = {
+    { BENCH_SEQ_WRITE, 512, false },
+    { BENCH_SEQ_WRITE, 4096, false },
+    { BENCH_SEQ_WRITE, 32768, false },
+    { BENCH_SEQ_WRITE, 131072, false },
+    { BENCH_SEQ_WRITE, 4096, true },
+    { BENCH_SEQ_WRITE, 32768, true },
+    { BENCH_SEQ_WRITE, 131072, true },
+    { BENCH_SEQ_READ, 512, false },
+    { BENCH_SEQ_READ, 4096, false },
+    { BENCH_SEQ_READ, 32768, false },
+    { BENCH_SEQ_READ, 131072, false },
+    { BENCH_SEQ_READ, 4096, true },
+    { BENCH_SEQ_READ, 32768, true },
+    { BENCH_SEQ_READ, 131072, true },
+    { BENCH_RAND_READ, 512, false },
+    { BENCH_RAND_READ, 4096, false },
+    { BENCH_RAND_WRITE, 4096, false },
+    { BENCH_FRAG_READ, BENCH_FRAG_CHUNK, false },
+    { BENCH_CREATE, 0, false },
+    { BENCH_OPEN, 0, false },
+    { BENCH_STAT, 0, false },
+    { BENCH_READDIR, 0, false },
+    { BENCH_READDIR_STAT, 0, false },
+    { BENCH_UNLINK, 0, false },
+};
+
+#define BENCH_PLAN_COUNT (sizeof(k_plan) / sizeof(k_plan[0]))
+
+typedef struct {
+    char data_path[256];        // 顺序读和随机读写使用的文件
+    char seq_path[256];         // 顺序写测试文件
+    char frag_path[2][256];     // 交替追加生成的碎片文件
+    char meta_dir[256];         // 小文件目录
+    uint64_t data_size;
+    uint8_t* sram;
+    uint32_t sram_size;
+    uint8_t* psram;
+    uint32_t* samples;
+    uint32_t sample_count;
+    uint32_t rng;
+    volatile bool* cancel;
+} bench_ctx_t;
+
+/* -------------------------------------------------------------------------- */
+/*                                  Helpers                                   */
+/* -------------------------------------------------------------------------- */
+
+static bool cancelled(const bench_ctx_t* ctx) {
+    return ctx->cancel && *ctx->cancel;
+}
+
+static uint32_t next_random(bench_ctx_t* ctx) {
+    ctx->rng ^= ctx->rng << 13;
+    ctx->rng ^= ctx->rng >> 17;
+    ctx->rng ^= ctx->rng << 5;
+    return ctx->rng;
+}
+
+static void record(bench_ctx_t* ctx, int64_t start) {
+    if (ctx->sample_count < BENCH_MAX_SAMPLES) {
+        ctx->samples[ctx->sample_count++] = (uint32_t)(now_us() - start);
+    }
+}
+
+// 读测试前让操作系统丢弃页缓存（FatFS没有整文件缓存，无需处理）
+static void drop_cache(int fd) {
+#if !defined(ESP_PLATFORM) && defined(POSIX_FADV_DONTNEED)
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#else
+    (void)fd;
+#endif
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void finish_result(bench_ctx_t* ctx, sd_bench_result_t* result, int64_t start) {
+    result->elapsed_us = (uint32_t)(now_us() - start);
+    if (result->bytes > 0 && result->elapsed_us > 0) {
+        result->mb_per_sec = (float)((double)result->bytes / result->elapsed_us * 1000000.0 / (1024.0 * 1024.0));
+    }
+
+    uint32_t n = ctx->sample_count;
+    if (n > 0) {
+        qsort(ctx->samples, n, sizeof(uint32_t), compare_u32);
+        result->p50_us = ctx->samples[(n - 1) * 50 / 100];
+        result->p90_us = ctx->samples[(n - 1) * 90 / 100];
+        result->p99_us = ctx->samples[(n - 1) * 99 / 100];
+        result->max_us = ctx->samples[n - 1];
+    }
+}
+
+// 用pattern填满文件（准备阶段，不计时）
+static bool write_file(bench_ctx_t* ctx, const char* path, uint64_t size) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = true;
+    for (uint64_t done = 0; ok && done < size && !cancelled(ctx); done += ctx->sram_size) {
+        size_t len = size - done < ctx->sram_size ? (size_t)(size - done) : ctx->sram_size;
+        ok = write(fd, ctx->sram, len) == (ssize_t)len;
+    }
+    return close(fd) == 0 && ok && !cancelled(ctx);
+}
+
+// 两个文件交替追加，FAT上得到互相穿插的簇链
+static bool write_fragmented(bench_ctx_t* ctx) {
+    int fds[2];
+    fds[0] = open(ctx->frag_path[0], O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    fds[1] = open(ctx->frag_path[1], O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    bool ok = fds[0] >= 0 && fds[1] >= 0;
+    for (uint32_t done = 0; ok && done < BENCH_FRAG_SIZE && !cancelled(ctx); done += BENCH_FRAG_CHUNK) {
+        for (int f = 0; f < 2 && ok; f++) {
+            ok = write(fds[f], ctx->sram, BENCH_FRAG_CHUNK) == BENCH_FRAG_CHUNK && fsync(fds[f]) == 0;
+        }
+    }
+    for (int f = 0; f < 2; f++) {
+        if (fds[f] >= 0) {
+            close(fds[f]);
+        }
+    }
+    return ok && !cancelled(ctx);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Tests                                    */
+/* -------------------------------------------------------------------------- */
+
+static bool run_transfer(bench_ctx_t* ctx, bench_kind_t kind, uint32_t block, uint8_t* buffer,
+                         sd_bench_result_t* result) {
+    const char* path = kind == BENCH_SEQ_WRITE ? ctx->seq_path
+                     : kind == BENCH_FRAG_READ ? ctx->frag_path[0]
+                     : ctx->data_path;
+    bool writing = kind == BENCH_SEQ_WRITE || kind == BENCH_RAND_WRITE;
+    int flags = kind == BENCH_SEQ_WRITE ? O_WRONLY | O_CREAT | O_TRUNC
+              : kind == BENCH_RAND_WRITE ? O_WRONLY
+              : O_RDONLY;
+
+    uint64_t file_size = kind == BENCH_FRAG_READ ? BENCH_FRAG_SIZE : ctx->data_size;
+    uint32_t ops;
+    if (kind == BENCH_RAND_READ) {
+        ops = BENCH_RAND_READ_OPS;
+    } else if (kind == BENCH_RAND_WRITE) {
+        ops = BENCH_RAND_WRITE_OPS;
+    } else {
+        ops = (uint32_t)(file_size / block);
+        if (kind != BENCH_FRAG_READ && ops > BENCH_SEQ_OPS) {
+            ops = BENCH_SEQ_OPS;
+        }
+    }
+    uint32_t blocks_in_file = (uint32_t)(ctx->data_size / block);
+
+    int fd = open(path, flags, 0666);
+    if (fd < 0) {
+        return false;
+    }
+    if (!writing) {
+        drop_cache(fd);
+    }
+
+    bool ok = true;
+    int64_t start = now_us();
+    for (uint32_t i = 0; i < ops && ok && !cancelled(ctx); i++) {
+        int64_t op_start = now_us();
+        if (kind == BENCH_RAND_READ || kind == BENCH_RAND_WRITE) {
+            off_t offset = (off_t)(next_random(ctx) % blocks_in_file) * block;
+            ok = lseek(fd, offset, SEEK_SET) == offset;
+        }
+        if (ok) {
+            ssize_t n = writing ? write(fd, buffer, block) : read(fd, buffer, block);
+            ok = n == (ssize_t)block;
+        }
+        record(ctx, op_start);
+        result->ops++;
+        result->bytes += block;
+    }
+    // 写入测试包含把数据刷到卡上的时间
+    if (writing && ok) {
+        ok = fsync(fd) == 0;
+    }
+    ok = close(fd) == 0 && ok;
+    finish_result(ctx, result, start);
+    return ok && !cancelled(ctx);
+}
+
+static void meta_path(const bench_ctx_t* ctx, uint32_t index, char* path, size_t size) {
+    snprintf(path, size, "%s/f_%03lu.txt", ctx->meta_dir, (unsigned long)index);
+}
+
+static bool run_metadata(bench_ctx_t* ctx, bench_kind_t kind, sd_bench_result_t* result) {
+    char path[520];
+    bool ok = true;
+    int64_t start = now_us();
+
+    if (kind == BENCH_READDIR || kind == BENCH_READDIR_STAT) {
+        DIR* dir = opendir(ctx->meta_dir);
+        if (!dir) {
+            return false;
+        }
+        while (!cancelled(ctx)) {
+            int64_t op_start = now_us();
+            struct dirent* entry = readdir(dir);
+            if (!entry) {
+                break;
+            }
+            if (kind == BENCH_READDIR_STAT) {
+                snprintf(path, sizeof(path), "%s/%s", ctx->meta_dir, entry->d_name);
+                struct stat st;
+                stat(path, &st);
+            }
+            record(ctx, op_start);
+            result->ops++;
+        }
+        closedir(dir);
+        finish_result(ctx, result, start);
+        return !cancelled(ctx);
+    }
+
+    for (uint32_t i = 0; i < BENCH_META_FILES && ok && !cancelled(ctx); i++) {
+        meta_path(ctx, i, path, sizeof(path));
+        int64_t op_start = now_us();
+        if (kind == BENCH_CREATE) {
+            FILE* fp = fopen(path, "wb");
+            ok = fp && fputs("sd bench\n", fp) >= 0;
+            ok = fp && fclose(fp) == 0 && ok;
+        } else if (kind == BENCH_OPEN) {
+            FILE* fp = fopen(path, "rb");
+            ok = fp && fclose(fp) == 0;
+        } else if (kind == BENCH_STAT) {
+            struct stat st;
+            ok = stat(path, &st) == 0;
+        } else if (kind == BENCH_UNLINK) {
+            ok = unlink(path) == 0;
+        }
+        record(ctx, op_start);
+        result->ops++;
+    }
+    finish_result(ctx, result, start);
+    return ok && !cancelled(ctx);
+}
+
+static bool write_csv(const char* csv_path, const sd_bench_result_t* results, uint32_t count) {
+    FILE* fp = fopen(csv_path, "w");
+    if (!fp) {
+        return false;
+    }
+    fprintf(fp, "test,block,buffer,ops,bytes,elapsed_us,mb_per_s,p50_us,p90_us,p99_us,max_us\n");
+    for (uint32_t i = 0; i < count; i++) {
+        const sd_bench_result_t* r = &results[i];
+        fprintf(fp, "%s,%lu,%s,%lu,%llu,%lu,%.2f,%lu,%lu,%lu,%lu\n",
+                r->test, (unsigned long)r->block_size, r->buffer, (unsigned long)r->ops,
+                (unsigned long long)r->bytes, (unsigned long)r->elapsed_us, r->mb_per_sec,
+                (unsigned long)r->p50_us, (unsigned long)r->p90_us,
+                (unsigned long)r->p99_us, (unsigned long)r->max_us);
+    }
+    return fclose(fp) == 0;
+}
+
+static void cleanup_files(const bench_ctx_t* ctx) {
+    char path[300];
+    for (uint32_t i = 0; i < BENCH_META_FILES; i++) {
+        meta_path(ctx, i, path, sizeof(path));
+        unlink(path);
+    }
+    rmdir(ctx->meta_dir);
+    unlink(ctx->data_path);
+    unlink(ctx->seq_path);
+    unlink(ctx->frag_path[0]);
+    unlink(ctx->frag_path[1]);
+}
+
+bool sd_bench_run(const char* dir, const char* csv_path, uint32_t file_mb,
+                  sd_bench_result_cb_t cb, void* user_data, volatile bool* cancel) {
+    if (!dir || file_mb == 0) {
+        return false;
+    }
+
+    bench_ctx_t ctx = {
+        .data_size = (uint64_t)file_mb * 1024 * 1024,
+        .sram_size = BENCH_MAX_BLOCK,
+        .rng = 0x2545F491,
+        .cancel = cancel,
+    };
+    snprintf(ctx.data_path, sizeof(ctx.data_path), "%s/bench_data.bin", dir);
+    snprintf(ctx.seq_path, sizeof(ctx.seq_path), "%s/bench_seq.bin", dir);
+    snprintf(ctx.frag_path[0], sizeof(ctx.frag_path[0]), "%s/bench_frag_a.bin", dir);
+    snprintf(ctx.frag_path[1], sizeof(ctx.frag_path[1]), "%s/bench_frag_b.bin", dir);
+    snprintf(ctx.meta_dir, sizeof(ctx.meta_dir), "%s/bench_meta", dir);
+
+    // 内部RAM不足时缩小缓冲区，超出的块大小跳过SRAM测试
+    while (!ctx.sram && ctx.sram_size >= 4096) {
+        ctx.sram = alloc_buffer(ctx.sram_size, false);
+        if (!ctx.sram) {
+            ctx.sram_size /= 2;
+        }
+    }
+    ctx.psram = alloc_buffer(BENCH_MAX_BLOCK, true);
+    ctx.samples = malloc(BENCH_MAX_SAMPLES * sizeof(uint32_t));
+    sd_bench_result_t* results = calloc(BENCH_PLAN_COUNT, sizeof(sd_bench_result_t));
+    if (!ctx.sram || !ctx.psram || !ctx.samples || !results) {
+        printf("SD bench: out of memory\n");
+        free_buffer(ctx.sram);
+        free_buffer(ctx.psram);
+        free(ctx.samples);
+        free(results);
+        return false;
+    }
+    for (uint32_t i = 0; i < ctx.sram_size; i++) {
+        ctx.sram[i] = (uint8_t)(i * 131 + 17);
+    }
+    memcpy(ctx.psram, ctx.sram, ctx.sram_size < BENCH_MAX_BLOCK ? ctx.sram_size : BENCH_MAX_BLOCK);
+
+    mkdir(dir, 0775);
+    printf("SD bench: preparing %lu MB test file in %s\n", (unsigned long)file_mb, dir);
+    bool ok = write_file(&ctx, ctx.data_path, ctx.data_size) && write_fragmented(&ctx) &&
+              (mkdir(ctx.meta_dir, 0775) == 0 || errno == EEXIST);
+    if (!ok) {
+        printf("SD bench: failed to prepare test files in %s\n", dir);
+    }
+
+    uint32_t count = 0;
+    int64_t total_start = now_us();
+    for (uint32_t i = 0; ok && i < BENCH_PLAN_COUNT; i++) {
+        bench_kind_t kind = k_plan[i].kind;
+        uint32_t block = k_plan[i].block;
+        bool psram = k_plan[i].psram;
+        if (!psram && block > ctx.sram_size) {
+            continue;
+        }
+
+        sd_bench_result_t* result = &results[count];
+        strncpy(result->test, k_kind_names[kind], sizeof(result->test) - 1);
+        result->block_size = block;
+        result->buffer = block == 0 ? "-" : psram ? "psram" : "sram";
+        ctx.sample_count = 0;
+
+        ok = kind >= BENCH_CREATE ? run_metadata(&ctx, kind, result)
+                                  : run_transfer(&ctx, kind, block, psram ? ctx.psram : ctx.sram, result);
+        if (!ok) {
+            if (!cancelled(&ctx)) {
+                printf("SD bench: %s (block %lu) failed: errno %d\n", result->test, (unsigned long)block, errno);
+            }
+            break;
+        }
+
+        printf("SD bench: %-12s %6lu %-5s %5lu ops %8.2f MB/s  p50 %lu us  p99 %lu us  max %lu us\n",
+               result->test, (unsigned long)block, result->buffer, (unsigned long)result->ops,
+               result->mb_per_sec, (unsigned long)result->p50_us, (unsigned long)result->p99_us,
+               (unsigned long)result->max_us);
+        count++;
+        if (cb) {
+            cb(result, user_data);
+        }
+    }
+
+    cleanup_files(&ctx);
+    if (ok && csv_path) {
+        if (write_csv(csv_path, results, count)) {
+            printf("SD bench: %lu results written to %s\n", (unsigned long)count, csv_path);
+        } else {
+            printf("SD bench: failed to write %s\n", csv_path);
+        }
+    }
+    printf("SD bench: %s in %lld ms\n", ok ? "finished" : (cancelled(&ctx) ? "cancelled" : "failed"),
+           (long long)((now_us() - total_start) / 1000));
+
+    free_buffer(ctx.sram);
+    free_buffer(ctx.psram);
+    free(ctx.samples);
+    free(results);
+    return ok;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              Background Task                               */
+/* -------------------------------------------------------------------------- */
+
+#ifdef ESP_PLATFORM
+
+#define BENCH_TASK_STACK        6144
+#define BENCH_TASK_PRIORITY     3
+
+// 界面摘要使用的主要结果
+typedef struct {
+    float seq_read_mb;
+    float seq_write_mb;
+    float rand_read_iops;
+    float rand_write_iops;
+    uint32_t rand_read_p99;
+    uint32_t rand_write_p99;
+    float frag_read_mb;
+    uint32_t fopen_p50;
+    uint32_t stat_p50;
+} bench_summary_t;
+
+static struct {
+    SemaphoreHandle_t lock;
+    bool busy;
+    volatile bool cancel_requested;
+    bool has_progress;
+    uint32_t file_mb;
+    bench_summary_t summary;
+    sd_bench_progress_t progress;
+} g_bench = {0};
+
+static void update_summary(const sd_bench_result_t* r) {
+    bench_summary_t* s = &g_bench.summary;
+    float iops = r->elapsed_us ? r->ops * 1000000.0f / r->elapsed_us : 0;
+
+    if (strcmp(r->test, "seq_read") == 0 && r->block_size == BENCH_MAX_BLOCK && strcmp(r->buffer, "sram") == 0) {
+        s->seq_read_mb = r->mb_per_sec;
+    } else if (strcmp(r->test, "seq_write") == 0 && r->block_size == BENCH_MAX_BLOCK && strcmp(r->buffer, "sram") == 0) {
+        s->seq_write_mb = r->mb_per_sec;
+    } else if (strcmp(r->test, "rand_read") == 0 && r->block_size == 4096) {
+        s->rand_read_iops = iops;
+        s->rand_read_p99 = r->p99_us;
+    } else if (strcmp(r->test, "rand_write") == 0) {
+        s->rand_write_iops = iops;
+        s->rand_write_p99 = r->p99_us;
+    } else if (strcmp(r->test, "frag_read") == 0) {
+        s->frag_read_mb = r->mb_per_sec;
+    } else if (strcmp(r->test, "fopen") == 0) {
+        s->fopen_p50 = r->p50_us;
+    } else if (strcmp(r->test, "stat") == 0) {
+        s->stat_p50 = r->p50_us;
+    }
+
+    snprintf(g_bench.progress.summary, sizeof(g_bench.progress.summary),
+             "顺序读 %.1f MB/s  顺序写 %.1f MB/s (128KB)\n"
+             "随机读4K %.0f IOPS  p99 %.1f ms\n"
+             "随机写4K %.0f IOPS  p99 %.1f ms\n"
+             "碎片文件读 %.1f MB/s\n"
+             "fopen %lu us  stat %lu us (p50)",
+             s->seq_read_mb, s->seq_write_mb,
+             s->rand_read_iops, s->rand_read_p99 / 1000.0f,
+             s->rand_write_iops, s->rand_write_p99 / 1000.0f,
+             s->frag_read_mb,
+             (unsigned long)s->fopen_p50, (unsigned long)s->stat_p50);
+}
+
+static void bench_result_cb(const sd_bench_result_t* result, void* user_data) {
+    (void)user_data;
+    xSemaphoreTake(g_bench.lock, portMAX_DELAY);
+    g_bench.progress.tests_done++;
+    strncpy(g_bench.progress.last_test, result->test, sizeof(g_bench.progress.last_test) - 1);
+    update_summary(result);
+    xSemaphoreGive(g_bench.lock);
+}
+
+static void bench_task(void* arg) {
+    (void)arg;
+    char dir[128];
+    snprintf(dir, sizeof(dir), "%s/.imos", hal_sdcard_get_mount_point());
+    mkdir(dir, 0775);
+    strncat(dir, "/bench", sizeof(dir) - strlen(dir) - 1);
+
+    bool ok = sd_bench_run(dir, g_bench.progress.csv_path, g_bench.file_mb,
+                           bench_result_cb, NULL, &g_bench.cancel_requested);
+
+    xSemaphoreTake(g_bench.lock, portMAX_DELAY);
+    g_bench.progress.state = ok ? SD_BENCH_STATE_DONE
+                           : g_bench.cancel_requested ? SD_BENCH_STATE_CANCELLED
+                           : SD_BENCH_STATE_FAILED;
+    g_bench.busy = false;
+    xSemaphoreGive(g_bench.lock);
+    vTaskDelete(NULL);
+}
+
+bool sd_bench_start(uint32_t file_mb) {
+    if (!hal_sdcard_is_mounted() || file_mb == 0) {
+        return false;
+    }
+    if (!g_bench.lock) {
+        g_bench.lock = xSemaphoreCreateMutex();
+        if (!g_bench.lock) {
+            return false;
+        }
+    }
+
+    xSemaphoreTake(g_bench.lock, portMAX_DELAY);
+    if (g_bench.busy) {
+        xSemaphoreGive(g_bench.lock);
+        return false;
+    }
+    g_bench.busy = true;
+    g_bench.cancel_requested = false;
+    g_bench.has_progress = true;
+    g_bench.file_mb = file_mb;
+    memset(&g_bench.summary, 0, sizeof(g_bench.summary));
+    memset(&g_bench.progress, 0, sizeof(g_bench.progress));
+    g_bench.progress.state = SD_BENCH_STATE_RUNNING;
+    g_bench.progress.tests_total = BENCH_PLAN_COUNT;
+    snprintf(g_bench.progress.csv_path, sizeof(g_bench.progress.csv_path),
+             "%s/.imos/sd_bench.csv", hal_sdcard_get_mount_point());
+    xSemaphoreGive(g_bench.lock);
+
+    if (xTaskCreate(bench_task, "sd_bench", BENCH_TASK_STACK, NULL, BENCH_TASK_PRIORITY, NULL) != pdPASS) {
+        xSemaphoreTake(g_bench.lock, portMAX_DELAY);
+        g_bench.busy = false;
+        g_bench.progress.state = SD_BENCH_STATE_FAILED;
+        xSemaphoreGive(g_bench.lock);
+        return false;
+    }
+    return true;
+}
+
+void sd_bench_cancel(void) {
+    g_bench.cancel_requested = true;
+}
+
+bool sd_bench_is_busy(void) {
+    return g_bench.busy;
+}
+
+bool sd_bench_get_progress(sd_bench_progress_t* progress) {
+    if (!progress || !g_bench.lock || !g_bench.has_progress) {
+        return false;
+    }
+    xSemaphoreTake(g_bench.lock, portMAX_DELAY);
+    *progress = g_bench.progress;
+    xSemaphoreGive(g_bench.lock);
+    return true;
+}
+
+#endif // ESP_PLATFORM
+
+/* -------------------------------------------------------------------------- */
+/*                                Host Runner                                 */
+/* -------------------------------------------------------------------------- */
+
+// 在Linux上对目录运行同一套测试：
+//   gcc -O2 -std=gnu11 -DSD_BENCH_MAIN main/sd_bench.c -o sd_bench
+//   ./sd_bench /media/sdcard/bench 64 result.csv
+#if defined(SD_BENCH_MAIN) && !defined(ESP_PLATFORM)
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <dir> [file_mb] [csv]\n", argv[0]);
+        return 2;
+    }
+    uint32_t file_mb = argc > 2 ? (uint32_t)atoi(argv[2]) : 16;
+    const char* csv = argc > 3 ? argv[3] : "sd_bench.csv";
+    return sd_bench_run(argv[1], csv, file_mb, NULL, NULL, NULL) ? 0 : 1;
+}
+#endif
@@ -0,0 +1,93 @@
+#ifndef SD_BENCH_H
+#define SD_BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 单项测试结果
+typedef struct {
+    char test[24];              // 测试名（seq_read、rand_write、stat等）
+    uint32_t block_size;        // 每次读写的字节数（元数据测试为0）
+    const char* buffer;         // 缓冲区位置："sram"、"psram"或"-"
+    uint32_t ops;               // 操作次数
+    uint64_t bytes;             // 传输字节数
+    uint32_t elapsed_us;        // 总耗时（写测试包含最后的fsync）
+    float mb_per_sec;           // 吞吐量（元数据测试为0）
+    uint32_t p50_us;            // 单次操作延迟百分位
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} sd_bench_result_t;
+
+typedef void (*sd_bench_result_cb_t)(const sd_bench_result_t* result, void* user_data);
+
+/**
+ * @brief 在目录中运行全部测试（阻塞），结果逐项回调并写入CSV
+ *
+ * 顺序读写（多种块大小，缓冲区分别位于内部RAM和PSRAM）、4KB随机读写、
+ * 碎片文件读取、创建/打开/stat/遍历/删除小文件。测试文件在结束时删除。
+ * 只依赖POSIX文件接口，也可在Linux上对任意目录编译运行（见sd_bench.c末尾）。
+ *
+ * @param dir 测试目录（不存在时创建）
+ * @param csv_path CSV输出路径，NULL表示不写
+ * @param file_mb 顺序测试的文件大小 (MB)
+ * @param cb 每项完成时回调，可为NULL
+ * @param cancel 置为true时在下一次操作前停止，可为NULL
+ * @return 全部测试完成返回true
+ */
+bool sd_bench_run(const char* dir, const char* csv_path, uint32_t file_mb,
+                  sd_bench_result_cb_t cb, void* user_data, volatile bool* cancel);
+
+// 后台测试状态
+typedef enum {
+    SD_BENCH_STATE_IDLE,
+    SD_BENCH_STATE_RUNNING,
+    SD_BENCH_STATE_DONE,
+    SD_BENCH_STATE_CANCELLED,
+    SD_BENCH_STATE_FAILED
+} sd_bench_state_t;
+
+// 进度快照
+typedef struct {
+    sd_bench_state_t state;
+    uint32_t tests_done;
+    uint32_t tests_total;
+    char last_test[24];         // 最近完成的测试
+    char summary[320];          // 主要结果（多行文本，用于界面显示）
+    char csv_path[128];         // 完整结果所在的CSV文件
+} sd_bench_progress_t;
+
+/**
+ * @brief 在后台任务中对SD卡运行测试，CSV写入<挂载点>/.imos/sd_bench.csv
+ *
+ * @param file_mb 顺序测试的文件大小 (MB)
+ * @return 启动成功返回true
+ */
+bool sd_bench_start(uint32_t file_mb);
+
+/**
+ * @brief 请求取消（当前操作完成后生效）
+ */
+void sd_bench_cancel(void);
+
+/**
+ * @brief 是否有测试正在运行
+ */
+bool sd_bench_is_busy(void);
+
+/**
+ * @brief 获取进度快照
+ *
+ * @return 从未启动过测试时返回false
+ */
+bool sd_bench_get_progress(sd_bench_progress_t* progress);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SD_BENCH_H
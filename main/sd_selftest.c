@@ -0,0 +1,311 @@
+#include "sd_selftest.h"
+#include "hal_sdcard.h"
+#include "file_ops.h"
+#include "file_grep.h"
+#include "archive.h"
+#include "dup_finder.h"
+#include "io_sched.h"
+#include "media_stream.h"
+#include "file_index.h"
+#include "file_types.h"
+#include "fs_watch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
+
+// 配置
+#define SELFTEST_TASK_STACK     8192
+#define SELFTEST_TASK_PRIORITY  3
+#define SELFTEST_CHUNK          4096
+#define SELFTEST_LISTING_FILES  1000
+#define SELFTEST_INDEX_FILES    2000
+#define SELFTEST_TYPE_NAMES     10000
+
+// 测试项：在work_dir（不存在，由测试项创建并在结束时删除）中运行
+typedef struct {
+    const char* name;
+    bool (*run)(const char* work_dir);
+} selftest_case_t;
+
+static bool run_file_ops(const char* work_dir) {
+    return file_ops_self_test(work_dir, 4096);
+}
+
+static bool run_file_grep(const char* work_dir) {
+    return file_grep_self_test(work_dir, 1024);
+}
+
+static bool run_archive(const char* work_dir) {
+    return archive_self_test(work_dir, 1024);
+}
+
+static bool run_dup_finder(const char* work_dir) {
+    return dup_finder_self_test(work_dir, 256);
+}
+
+static bool run_io_sched(const char* work_dir) {
+    return io_sched_self_test(work_dir, 10);
+}
+
+static bool run_media_stream(const char* work_dir) {
+    return media_stream_self_test(work_dir);
+}
+
+// 性能测试：结果打印到串口，创建的文件在结束时删除
+static bool run_listing_bench(const char* work_dir) {
+    bool ok = hal_sdcard_benchmark_listing(work_dir, SELFTEST_LISTING_FILES);
+    return sd_selftest_remove_tree(work_dir) && ok;
+}
+
+static bool run_index_bench(const char* work_dir) {
+    bool ok = file_index_benchmark(work_dir, SELFTEST_INDEX_FILES);
+    ok = sd_selftest_remove_tree(work_dir) && ok;
+    // 让索引丢掉测试文件
+    fs_watch_path_changed(work_dir);
+    return ok;
+}
+
+static bool run_types_bench(const char* work_dir) {
+    (void)work_dir;
+    return file_types_benchmark(SELFTEST_TYPE_NAMES);
+}
+
+static const selftest_case_t k_cases[] = {
+    { "file_ops",       run_file_ops },
+    { "file_grep",      run_file_grep },
+    { "archive",        run_archive },
+    { "dup_finder",     run_dup_finder },
+    { "io_sched",       run_io_sched },
+    { "media_stream",   run_media_stream },
+    { "listing_bench",  run_listing_bench },
+    { "index_bench",    run_index_bench },
+    { "types_bench",    run_types_bench },
+};
+
+#define SELFTEST_CASE_COUNT (sizeof(k_cases) / sizeof(k_cases[0]))
+
+static struct {
+    SemaphoreHandle_t lock;
+    bool busy;
+    volatile bool cancel_requested;
+    bool has_progress;
+    sd_selftest_progress_t progress;
+} g_selftest = {0};
+
+static void append_result(const char* name, bool ok, uint32_t elapsed_ms) {
+    sd_selftest_progress_t* p = &g_selftest.progress;
+    size_t len = strlen(p->summary);
+    snprintf(p->summary + len, sizeof(p->summary) - len, "%s%s: %s (%lu ms)",
+             len ? "\n" : "", name, ok ? "OK" : "失败", (unsigned long)elapsed_ms);
+}
+
+static void selftest_task(void* arg) {
+    (void)arg;
+    char base[128], work_dir[160];
+    snprintf(base, sizeof(base), "%s/.imos", hal_sdcard_get_mount_point());
+    mkdir(base, 0775);
+    strncat(base, "/selftest", sizeof(base) - strlen(base) - 1);
+    mkdir(base, 0775);
+
+    for (uint32_t i = 0; i < SELFTEST_CASE_COUNT && !g_selftest.cancel_requested; i++) {
+        const selftest_case_t* c = &k_cases[i];
+        xSemaphoreTake(g_selftest.lock, portMAX_DELAY);
+        strncpy(g_selftest.progress.current, c->name, sizeof(g_selftest.progress.current) - 1);
+        xSemaphoreGive(g_selftest.lock);
+
+        printf("Self test [%s] start\n", c->name);
+        snprintf(work_dir, sizeof(work_dir), "%s/%s", base, c->name);
+        int64_t start = esp_timer_get_time();
+        bool ok = hal_sdcard_is_mounted() && c->run(work_dir);
+        uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+        printf("Self test [%s] %s (%lu ms)\n", c->name, ok ? "PASSED" : "FAILED", (unsigned long)elapsed_ms);
+
+        xSemaphoreTake(g_selftest.lock, portMAX_DELAY);
+        g_selftest.progress.tests_done++;
+        if (!ok) {
+            g_selftest.progress.tests_failed++;
+        }
+        append_result(c->name, ok, elapsed_ms);
+        xSemaphoreGive(g_selftest.lock);
+    }
+    rmdir(base);
+
+    xSemaphoreTake(g_selftest.lock, portMAX_DELAY);
+    printf("Self test: %lu/%lu passed\n",
+           (unsigned long)(g_selftest.progress.tests_done - g_selftest.progress.tests_failed),
+           (unsigned long)g_selftest.progress.tests_total);
+    g_selftest.progress.current[0] = '\0';
+    g_selftest.progress.state = g_selftest.progress.tests_done < g_selftest.progress.tests_total
+                              ? SD_SELFTEST_STATE_CANCELLED : SD_SELFTEST_STATE_DONE;
+    g_selftest.busy = false;
+    xSemaphoreGive(g_selftest.lock);
+    vTaskDelete(NULL);
+}
+
+bool sd_selftest_start(void) {
+    if (!hal_sdcard_is_mounted()) {
+        return false;
+    }
+    if (!g_selftest.lock) {
+        g_selftest.lock = xSemaphoreCreateMutex();
+        if (!g_selftest.lock) {
+            return false;
+        }
+    }
+
+    xSemaphoreTake(g_selftest.lock, portMAX_DELAY);
+    if (g_selftest.busy) {
+        xSemaphoreGive(g_selftest.lock);
+        return false;
+    }
+    g_selftest.busy = true;
+    g_selftest.cancel_requested = false;
+    g_selftest.has_progress = true;
+    memset(&g_selftest.progress, 0, sizeof(g_selftest.progress));
+    g_selftest.progress.state = SD_SELFTEST_STATE_RUNNING;
+    g_selftest.progress.tests_total = SELFTEST_CASE_COUNT;
+    xSemaphoreGive(g_selftest.lock);
+
+    if (xTaskCreate(selftest_task, "sd_selftest", SELFTEST_TASK_STACK, NULL, SELFTEST_TASK_PRIORITY, NULL) != pdPASS) {
+        xSemaphoreTake(g_selftest.lock, portMAX_DELAY);
+        g_selftest.busy = false;
+        g_selftest.progress.state = SD_SELFTEST_STATE_IDLE;
+        xSemaphoreGive(g_selftest.lock);
+        return false;
+    }
+    return true;
+}
+
+void sd_selftest_cancel(void) {
+    g_selftest.cancel_requested = true;
+}
+
+bool sd_selftest_is_busy(void) {
+    return g_selftest.busy;
+}
+
+bool sd_selftest_get_progress(sd_selftest_progress_t* progress) {
+    if (!progress || !g_selftest.lock || !g_selftest.has_progress) {
+        return false;
+    }
+    xSemaphoreTake(g_selftest.lock, portMAX_DELAY);
+    *progress = g_selftest.progress;
+    xSemaphoreGive(g_selftest.lock);
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                Test fixture                                */
+/* -------------------------------------------------------------------------- */
+
+bool sd_selftest_mkdir(const char* path) {
+    return mkdir(path, 0777) == 0 || errno == EEXIST;
+}
+
+uint8_t sd_selftest_pattern_byte(uint32_t pos, uint8_t seed) {
+    return (uint8_t)((pos * 31 + 7) ^ (pos >> 9) ^ seed);
+}
+
+bool sd_selftest_write_pattern(const char* path, uint32_t size, uint8_t seed) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) {
+        return false;
+    }
+
+    uint8_t* chunk = malloc(SELFTEST_CHUNK);
+    bool ok = chunk != NULL;
+    for (uint32_t pos = 0; ok && pos < size; pos += SELFTEST_CHUNK) {
+        uint32_t n = (size - pos < SELFTEST_CHUNK) ? size - pos : SELFTEST_CHUNK;
+        for (uint32_t i = 0; i < n; i++) {
+            chunk[i] = sd_selftest_pattern_byte(pos + i, seed);
+        }
+        ok = fwrite(chunk, 1, n, fp) == n;
+    }
+
+    free(chunk);
+    ok = (fclose(fp) == 0) && ok;
+    return ok;
+}
+
+bool sd_selftest_check_pattern(const uint8_t* data, size_t len, uint32_t pos, uint8_t seed) {
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != sd_selftest_pattern_byte(pos + (uint32_t)i, seed)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sd_selftest_flip_byte(const char* path, uint32_t pos) {
+    FILE* fp = fopen(path, "r+b");
+    if (!fp) {
+        return false;
+    }
+    int c = (fseek(fp, (long)pos, SEEK_SET) == 0) ? fgetc(fp) : EOF;
+    bool ok = c != EOF && fseek(fp, (long)pos, SEEK_SET) == 0 && fputc(~c & 0xFF, fp) != EOF;
+    ok = (fclose(fp) == 0) && ok;
+    return ok;
+}
+
+bool sd_selftest_remove_tree(const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir) {
+        return errno == ENOENT || unlink(path) == 0;
+    }
+
+    char child[256];
+    bool ok = true;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        // 路径被截断时会删到别的文件，跳过并报告失败
+        int len = snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        if (len < 0 || len >= (int)sizeof(child)) {
+            printf("Self test: path too long under %s, not removed\n", path);
+            ok = false;
+            continue;
+        }
+        if (entry->d_type == DT_DIR) {
+            ok = sd_selftest_remove_tree(child) && ok;
+        } else {
+            ok = unlink(child) == 0 && ok;
+        }
+    }
+    closedir(dir);
+    return rmdir(path) == 0 && ok;
+}
+
+bool sd_selftest_files_equal(const char* a, const char* b) {
+    FILE* fa = fopen(a, "rb");
+    FILE* fb = fopen(b, "rb");
+    uint8_t* buf_a = malloc(SELFTEST_CHUNK);
+    uint8_t* buf_b = malloc(SELFTEST_CHUNK);
+    bool equal = fa && fb && buf_a && buf_b;
+
+    while (equal) {
+        size_t na = fread(buf_a, 1, SELFTEST_CHUNK, fa);
+        size_t nb = fread(buf_b, 1, SELFTEST_CHUNK, fb);
+        if (na != nb || memcmp(buf_a, buf_b, na) != 0) {
+            equal = false;
+        }
+        if (na == 0) {
+            break;
+        }
+    }
+
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    free(buf_a);
+    free(buf_b);
+    return equal;
+}
@@ -0,0 +1,83 @@
+#ifndef SD_SELFTEST_H
+#define SD_SELFTEST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 后台自检状态
+typedef enum {
+    SD_SELFTEST_STATE_IDLE,
+    SD_SELFTEST_STATE_RUNNING,
+    SD_SELFTEST_STATE_DONE,         // 全部运行完（可能有失败项，见tests_failed）
+    SD_SELFTEST_STATE_CANCELLED
+} sd_selftest_state_t;
+
+// 进度快照
+typedef struct {
+    sd_selftest_state_t state;
+    uint32_t tests_done;
+    uint32_t tests_total;
+    uint32_t tests_failed;
+    char current[24];           // 正在运行的测试
+    char summary[384];          // 各项结果（多行文本，用于界面显示）
+} sd_selftest_progress_t;
+
+/**
+ * @brief 在后台任务中依次运行各存储模块的自检和性能测试，临时文件位于<挂载点>/.imos/selftest
+ *
+ * 各项的详细输出打印到串口，结果汇总在进度快照中。
+ *
+ * @return 启动成功返回true
+ */
+bool sd_selftest_start(void);
+
+/**
+ * @brief 请求取消（当前测试项完成后生效）
+ */
+void sd_selftest_cancel(void);
+
+/**
+ * @brief 是否有自检正在运行
+ */
+bool sd_selftest_is_busy(void);
+
+/**
+ * @brief 获取进度快照
+ *
+ * @return 从未启动过自检时返回false
+ */
+bool sd_selftest_get_progress(sd_selftest_progress_t* progress);
+
+/* 以下为各模块自检共用的测试数据工具，只在自检任务中调用 */
+
+// 创建目录，已存在也返回true
+bool sd_selftest_mkdir(const char* path);
+
+// 测试数据第pos个字节，不同seed生成不同内容
+uint8_t sd_selftest_pattern_byte(uint32_t pos, uint8_t seed);
+
+// 写入size字节的测试数据
+bool sd_selftest_write_pattern(const char* path, uint32_t size, uint8_t seed);
+
+// 检查从pos开始的len字节是否为测试数据
+bool sd_selftest_check_pattern(const uint8_t* data, size_t len, uint32_t pos, uint8_t seed);
+
+// 将文件第pos个字节取反（生成只差一个字节的文件）
+bool sd_selftest_flip_byte(const char* path, uint32_t pos);
+
+// 递归删除目录（或文件），不存在也返回true
+bool sd_selftest_remove_tree(const char* path);
+
+// 比较两个文件内容是否相同
+bool sd_selftest_files_equal(const char* a, const char* b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SD_SELFTEST_H
@@ -0,0 +1,810 @@
+#include "text_viewer.h"
+#include "file_types.h"
+#include "io_sched.h"
+#include "app_ctx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+LV_FONT_DECLARE(simhei_32);
+
+// 页面缓存
+#define TV_BLOCK_SIZE          4096
+#define TV_CACHE_BLOCKS        8                // 8 x 4KB，与文件大小无关
+
+// 显示
+#define TV_LINE_MAX            256              // 单个显示行最多字节，超长行折成多行
+#define TV_MAX_PAGE_LINES      64
+
+// 稀疏行索引
+#define TV_INDEX_STRIDE        64               // 初始每64行记录一次偏移
+#define TV_INDEX_MAX_ENTRIES   4096             // 索引上限，超出时步长加倍（最多16KB）
+#define TV_INDEX_CHUNK         (32 * 1024)      // 后台索引每次读取32KB
+#define TV_TASK_STACK          4096
+#define TV_TASK_PRIORITY       (tskIDLE_PRIORITY + 1)
+
+#define TV_UNKNOWN_LINE        UINT32_MAX
+
+// 底部按钮
+typedef enum {
+    TV_ACTION_HOME,
+    TV_ACTION_PAGE_UP,
+    TV_ACTION_PAGE_DOWN,
+    TV_ACTION_END,
+    TV_ACTION_JUMP_LINE,
+    TV_ACTION_JUMP_BYTE
+} tv_action_t;
+
+// 缓存块
+typedef struct {
+    uint8_t* data;
+    uint32_t block;
+    uint32_t len;
+    uint32_t last_used;
+    bool valid;
+} tv_block_t;
+
+struct text_viewer {
+    char path[512];
+    int fd;                             // 页面缓存使用的文件描述符
+    uint32_t file_size;
+
+    // 页面缓存
+    tv_block_t blocks[TV_CACHE_BLOCKS];
+    uint8_t* block_memory;
+    uint32_t use_counter;
+
+    // 稀疏行索引（后台任务写入，index_lock保护）
+    SemaphoreHandle_t index_lock;
+    SemaphoreHandle_t index_done;
+    uint32_t* line_offsets;             // line_offsets[k] = 第k*index_stride行的起始偏移
+    uint32_t index_count;
+    uint32_t index_stride;
+    uint32_t total_lines;               // 已索引部分的换行数
+    uint32_t indexed_bytes;
+    uint32_t index_ms;
+    bool index_running;
+    volatile bool index_complete;
+    volatile bool index_cancel;
+
+    // 显示窗口
+    uint32_t top_offset;
+    uint32_t next_offset;               // 当前页之后的偏移
+    uint32_t lines_per_page;
+    char* window_text;
+
+    // UI
+    lv_obj_t* root;
+    lv_obj_t* info_label;
+    lv_obj_t* text_box;
+    lv_obj_t* text_label;
+    lv_obj_t* jump_panel;
+    lv_obj_t* jump_input;
+    bool jump_by_byte;
+    lv_timer_t* info_timer;             // 属于应用上下文
+    char message[96];                   // 临时提示（跳转失败等）
+
+    app_t* app;
+    text_viewer_close_cb_t close_cb;
+    void* user_data;
+};
+
+static void* tv_malloc(size_t size) {
+    void* ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (!ptr) {
+        ptr = malloc(size);
+    }
+    return ptr;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Page Cache                                 */
+/* -------------------------------------------------------------------------- */
+
+static const uint8_t* tv_get_block(text_viewer_t* v, uint32_t block, uint32_t* len) {
+    tv_block_t* victim = NULL;
+    for (int i = 0; i < TV_CACHE_BLOCKS; i++) {
+        tv_block_t* b = &v->blocks[i];
+        if (b->valid && b->block == block) {
+            b->last_used = ++v->use_counter;
+            *len = b->len;
+            return b->data;
+        }
+        if (!victim || (victim->valid && (!b->valid || b->last_used < victim->last_used))) {
+            victim = b;
+        }
+    }
+
+    victim->valid = false;
+    ssize_t n = io_sched_read(v->fd, (int64_t)block * TV_BLOCK_SIZE, victim->data, TV_BLOCK_SIZE, IO_CLASS_INTERACTIVE);
+    if (n <= 0) {
+        return NULL;
+    }
+
+    victim->block = block;
+    victim->len = (uint32_t)n;
+    victim->last_used = ++v->use_counter;
+    victim->valid = true;
+    *len = victim->len;
+    return victim->data;
+}
+
+static int tv_byte_at(text_viewer_t* v, uint32_t off) {
+    if (off >= v->file_size) {
+        return -1;
+    }
+
+    uint32_t len;
+    const uint8_t* data = tv_get_block(v, off / TV_BLOCK_SIZE, &len);
+    uint32_t idx = off % TV_BLOCK_SIZE;
+    if (!data || idx >= len) {
+        return -1;
+    }
+    return data[idx];
+}
+
+// 在[off, end)中查找'\n'
+static bool tv_find_newline(text_viewer_t* v, uint32_t off, uint32_t end, uint32_t* nl_pos) {
+    if (end > v->file_size) {
+        end = v->file_size;
+    }
+
+    while (off < end) {
+        uint32_t len;
+        const uint8_t* data = tv_get_block(v, off / TV_BLOCK_SIZE, &len);
+        uint32_t idx = off % TV_BLOCK_SIZE;
+        if (!data || idx >= len) {
+            return false;
+        }
+
+        uint32_t avail = len - idx;
+        if (avail > end - off) {
+            avail = end - off;
+        }
+
+        const uint8_t* p = memchr(data + idx, '\n', avail);
+        if (p) {
+            *nl_pos = off + (uint32_t)(p - (data + idx));
+            return true;
+        }
+        off += avail;
+    }
+    return false;
+}
+
+// 复制[off, end)到out，替换控制字符
+static uint32_t tv_copy_range(text_viewer_t* v, uint32_t off, uint32_t end, char* out) {
+    uint32_t used = 0;
+    while (off < end) {
+        uint32_t len;
+        const uint8_t* data = tv_get_block(v, off / TV_BLOCK_SIZE, &len);
+        uint32_t idx = off % TV_BLOCK_SIZE;
+        if (!data || idx >= len) {
+            break;
+        }
+
+        uint32_t avail = len - idx;
+        if (avail > end - off) {
+            avail = end - off;
+        }
+        for (uint32_t i = 0; i < avail; i++) {
+            uint8_t c = data[idx + i];
+            if (c == '\r') {
+                continue;
+            }
+            out[used++] = (c == '\t') ? ' ' : (c < 0x20 ? '.' : (char)c);
+        }
+        off += avail;
+    }
+    return used;
+}
+
+// 跳过UTF-8后续字节，返回字符起始位置
+static uint32_t tv_utf8_align(text_viewer_t* v, uint32_t off, uint32_t limit) {
+    while (off > limit) {
+        int c = tv_byte_at(v, off);
+        if (c < 0 || (c & 0xC0) != 0x80) {
+            break;
+        }
+        off--;
+    }
+    return off;
+}
+
+// off所在行的起始位置（最多回溯一个显示行）
+static uint32_t tv_line_start_at(text_viewer_t* v, uint32_t off) {
+    uint32_t limit = off > TV_LINE_MAX ? off - TV_LINE_MAX : 0;
+    uint32_t pos = off;
+    while (pos > limit && tv_byte_at(v, pos - 1) != '\n') {
+        pos--;
+    }
+    return pos == limit && limit > 0 ? tv_utf8_align(v, off, limit) : pos;
+}
+
+// off之前一个显示行的起始位置
+static uint32_t tv_prev_line_start(text_viewer_t* v, uint32_t off) {
+    if (off == 0) {
+        return 0;
+    }
+
+    uint32_t pos = off - 1;
+    if (tv_byte_at(v, pos) != '\n') {
+        pos = off;
+    }
+
+    uint32_t limit = pos > TV_LINE_MAX ? pos - TV_LINE_MAX : 0;
+    while (pos > limit) {
+        if (tv_byte_at(v, pos - 1) == '\n') {
+            return pos;
+        }
+        pos--;
+    }
+    return limit > 0 ? tv_utf8_align(v, limit, 0) : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Line Index                                 */
+/* -------------------------------------------------------------------------- */
+
+// 记录一行的起始偏移（调用者持有锁），索引满时丢弃一半条目并加倍步长
+static void tv_index_append(text_viewer_t* v, uint32_t line, uint32_t off) {
+    if (line % v->index_stride != 0) {
+        return;
+    }
+
+    if (v->index_count == TV_INDEX_MAX_ENTRIES) {
+        for (uint32_t i = 0; i < TV_INDEX_MAX_ENTRIES / 2; i++) {
+            v->line_offsets[i] = v->line_offsets[i * 2];
+        }
+        v->index_count = TV_INDEX_MAX_ENTRIES / 2;
+        v->index_stride *= 2;
+        if (line % v->index_stride != 0) {
+            return;
+        }
+    }
+
+    v->line_offsets[v->index_count++] = off;
+}
+
+static void tv_index_task(void* arg) {
+    text_viewer_t* v = (text_viewer_t*)arg;
+    int64_t start = esp_timer_get_time();
+
+    int fd = open(v->path, O_RDONLY);
+    uint8_t* buffer = tv_malloc(TV_INDEX_CHUNK);
+    uint32_t pos = 0;
+    uint32_t line = 0;
+    uint32_t chunks = 0;
+
+    // 关闭查看器或应用销毁时在下一个数据块边界退出
+    bool stopped = false;
+    while (fd >= 0 && buffer && !v->index_cancel && !(stopped = app_ctx_task_should_stop())) {
+        ssize_t n = io_sched_read(fd, IO_SCHED_CURRENT, buffer, TV_INDEX_CHUNK, IO_CLASS_BACKGROUND);
+        if (n <= 0) {
+            break;
+        }
+
+        xSemaphoreTake(v->index_lock, portMAX_DELAY);
+        const uint8_t* p = buffer;
+        const uint8_t* end = buffer + n;
+        while ((p = memchr(p, '\n', end - p)) != NULL) {
+            p++;
+            line++;
+            tv_index_append(v, line, pos + (uint32_t)(p - buffer));
+        }
+        pos += (uint32_t)n;
+        v->total_lines = line;
+        v->indexed_bytes = pos;
+        xSemaphoreGive(v->index_lock);
+
+        // 定期让出CPU，避免饿死空闲任务
+        if (++chunks % 8 == 0) {
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+    heap_caps_free(buffer);
+
+    v->index_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    v->index_complete = !v->index_cancel && !stopped;
+    if (v->index_complete) {
+        printf("Text viewer indexed %lu lines in %lu ms (stride %lu, %lu entries)\n",
+               (unsigned long)line, (unsigned long)v->index_ms,
+               (unsigned long)v->index_stride, (unsigned long)v->index_count);
+    }
+
+    xSemaphoreGive(v->index_done);
+}
+
+// 行号（从0开始）对应的偏移，该行尚未索引时返回false
+static bool tv_offset_for_line(text_viewer_t* v, uint32_t line, uint32_t* offset) {
+    xSemaphoreTake(v->index_lock, portMAX_DELAY);
+    if (line > v->total_lines || v->index_count == 0) {
+        xSemaphoreGive(v->index_lock);
+        return false;
+    }
+    uint32_t k = line / v->index_stride;
+    if (k >= v->index_count) {
+        k = v->index_count - 1;
+    }
+    uint32_t base_line = k * v->index_stride;
+    uint32_t off = v->line_offsets[k];
+    xSemaphoreGive(v->index_lock);
+
+    for (uint32_t l = base_line; l < line; l++) {
+        uint32_t nl;
+        if (!tv_find_newline(v, off, v->file_size, &nl)) {
+            return false;
+        }
+        off = nl + 1;
+    }
+
+    *offset = off;
+    return true;
+}
+
+// 偏移所在行号（从0开始），尚未索引时返回TV_UNKNOWN_LINE
+static uint32_t tv_line_for_offset(text_viewer_t* v, uint32_t off) {
+    xSemaphoreTake(v->index_lock, portMAX_DELAY);
+    if (v->index_count == 0 || (off > v->indexed_bytes && !v->index_complete)) {
+        xSemaphoreGive(v->index_lock);
+        return TV_UNKNOWN_LINE;
+    }
+
+    // 二分查找不大于off的最后一个索引点
+    uint32_t lo = 0, hi = v->index_count - 1;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi + 1) / 2;
+        if (v->line_offsets[mid] <= off) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    uint32_t line = lo * v->index_stride;
+    uint32_t pos = v->line_offsets[lo];
+    xSemaphoreGive(v->index_lock);
+
+    uint32_t nl;
+    while (pos < off && tv_find_newline(v, pos, off, &nl)) {
+        line++;
+        pos = nl + 1;
+    }
+    return line;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Render                                   */
+/* -------------------------------------------------------------------------- */
+
+static void tv_format_size(uint32_t size, char* buffer, size_t buffer_size) {
+    if (size < 1024) {
+        snprintf(buffer, buffer_size, "%lu B", (unsigned long)size);
+    } else if (size < 1024 * 1024) {
+        snprintf(buffer, buffer_size, "%.1f KB", (float)size / 1024);
+    } else {
+        snprintf(buffer, buffer_size, "%.1f MB", (float)size / (1024 * 1024));
+    }
+}
+
+static void tv_update_info(text_viewer_t* v) {
+    char text[192];
+    char size_text[24];
+    tv_format_size(v->file_size, size_text, sizeof(size_text));
+
+    uint32_t line = tv_line_for_offset(v, v->top_offset);
+    unsigned percent = v->file_size ? (unsigned)((uint64_t)v->top_offset * 100 / v->file_size) : 100;
+    int len;
+    if (line == TV_UNKNOWN_LINE) {
+        len = snprintf(text, sizeof(text), "行 ? | %u%% | %s", percent, size_text);
+    } else {
+        len = snprintf(text, sizeof(text), "行 %lu | %u%% | %s", (unsigned long)line + 1, percent, size_text);
+    }
+
+    if (v->index_complete) {
+        len += snprintf(text + len, sizeof(text) - len, " | 共 %lu 行", (unsigned long)v->total_lines + 1);
+    } else if (v->file_size > 0) {
+        len += snprintf(text + len, sizeof(text) - len, " | 索引中 %u%%",
+                        (unsigned)((uint64_t)v->indexed_bytes * 100 / v->file_size));
+    }
+
+    if (v->message[0] != '\0') {
+        snprintf(text + len, sizeof(text) - len, "\n%s", v->message);
+    }
+
+    lv_label_set_text(v->info_label, text);
+}
+
+// 从top_offset开始渲染一页
+static void tv_render(text_viewer_t* v) {
+    char* out = v->window_text;
+    uint32_t used = 0;
+    uint32_t off = v->top_offset;
+
+    for (uint32_t line = 0; line < v->lines_per_page && off < v->file_size; line++) {
+        uint32_t end = off + TV_LINE_MAX;
+        if (end > v->file_size) {
+            end = v->file_size;
+        }
+
+        uint32_t nl;
+        uint32_t seg_end, next;
+        if (tv_find_newline(v, off, end, &nl)) {
+            seg_end = nl;
+            next = nl + 1;
+        } else if (end < v->file_size) {
+            // 超长行折行，断点对齐到UTF-8字符边界
+            seg_end = tv_utf8_align(v, end, off + 1);
+            next = seg_end;
+        } else {
+            seg_end = end;
+            next = end;
+        }
+
+        used += tv_copy_range(v, off, seg_end, out + used);
+        out[used++] = '\n';
+        off = next;
+    }
+
+    if (used > 0) {
+        used--;
+    }
+    out[used] = '\0';
+    v->next_offset = off;
+
+    lv_label_set_text(v->text_label, out);
+    lv_obj_scroll_to_x(v->text_box, 0, LV_ANIM_OFF);
+    tv_update_info(v);
+}
+
+static void tv_page_up(text_viewer_t* v) {
+    uint32_t off = v->top_offset;
+    for (uint32_t i = 0; i < v->lines_per_page && off > 0; i++) {
+        off = tv_prev_line_start(v, off);
+    }
+    v->top_offset = off;
+}
+
+static void tv_go_end(text_viewer_t* v) {
+    v->top_offset = v->file_size;
+    tv_page_up(v);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                     UI                                     */
+/* -------------------------------------------------------------------------- */
+
+static void tv_destroy(text_viewer_t* v, bool async_delete);
+
+static void tv_close_jump_panel(text_viewer_t* v) {
+    if (v->jump_panel) {
+        lv_obj_delete_async(v->jump_panel);
+        v->jump_panel = NULL;
+        v->jump_input = NULL;
+    }
+}
+
+static void tv_jump_event_cb(lv_event_t* e) {
+    text_viewer_t* v = (text_viewer_t*)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+
+    if (code == LV_EVENT_READY && v->jump_input) {
+        unsigned long value = strtoul(lv_textarea_get_text(v->jump_input), NULL, 10);
+        v->message[0] = '\0';
+
+        if (v->jump_by_byte) {
+            uint32_t off = value < v->file_size ? (uint32_t)value : (v->file_size ? v->file_size - 1 : 0);
+            v->top_offset = tv_line_start_at(v, off);
+        } else {
+            uint32_t off;
+            uint32_t line = value > 0 ? (uint32_t)(value - 1) : 0;
+            if (tv_offset_for_line(v, line, &off)) {
+                v->top_offset = off;
+            } else {
+                snprintf(v->message, sizeof(v->message), "第 %lu 行尚未索引（已索引 %lu 行）",
+                         value, (unsigned long)v->total_lines + 1);
+            }
+        }
+        tv_render(v);
+    }
+
+    if (code == LV_EVENT_READY || code == LV_EVENT_CANCEL) {
+        tv_close_jump_panel(v);
+    }
+}
+
+static void tv_show_jump_panel(text_viewer_t* v, bool by_byte) {
+    if (v->jump_panel) {
+        return;
+    }
+    v->jump_by_byte = by_byte;
+
+    v->jump_panel = lv_obj_create(v->root);
+    lv_obj_set_size(v->jump_panel, LV_PCT(100), LV_PCT(50));
+    lv_obj_align(v->jump_panel, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_set_style_pad_all(v->jump_panel, 8, 0);
+    lv_obj_clear_flag(v->jump_panel, LV_OBJ_FLAG_SCROLLABLE);
+
+    v->jump_input = lv_textarea_create(v->jump_panel);
+    lv_textarea_set_one_line(v->jump_input, true);
+    lv_textarea_set_accepted_chars(v->jump_input, "0123456789");
+    lv_textarea_set_max_length(v->jump_input, 10);
+    lv_textarea_set_placeholder_text(v->jump_input, by_byte ? "字节偏移" : "行号");
+    lv_obj_set_style_text_font(v->jump_input, &simhei_32, 0);
+    lv_obj_set_width(v->jump_input, LV_PCT(100));
+    lv_obj_align(v->jump_input, LV_ALIGN_TOP_MID, 0, 0);
+
+    lv_obj_t* keyboard = lv_keyboard_create(v->jump_panel);
+    lv_keyboard_set_mode(keyboard, LV_KEYBOARD_MODE_NUMBER);
+    lv_keyboard_set_textarea(keyboard, v->jump_input);
+    lv_obj_set_size(keyboard, LV_PCT(100), LV_PCT(75));
+    lv_obj_align(keyboard, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_add_event_cb(keyboard, tv_jump_event_cb, LV_EVENT_READY, v);
+    lv_obj_add_event_cb(keyboard, tv_jump_event_cb, LV_EVENT_CANCEL, v);
+}
+
+static void tv_button_event_cb(lv_event_t* e) {
+    text_viewer_t* v = (text_viewer_t*)lv_event_get_user_data(e);
+    tv_action_t action = (tv_action_t)(intptr_t)lv_obj_get_user_data(lv_event_get_current_target_obj(e));
+
+    v->message[0] = '\0';
+    switch (action) {
+        case TV_ACTION_HOME:
+            v->top_offset = 0;
+            break;
+        case TV_ACTION_PAGE_UP:
+            tv_page_up(v);
+            break;
+        case TV_ACTION_PAGE_DOWN:
+            if (v->next_offset < v->file_size) {
+                v->top_offset = v->next_offset;
+            }
+            break;
+        case TV_ACTION_END:
+            tv_go_end(v);
+            break;
+        case TV_ACTION_JUMP_LINE:
+        case TV_ACTION_JUMP_BYTE:
+            tv_show_jump_panel(v, action == TV_ACTION_JUMP_BYTE);
+            return;
+    }
+    tv_render(v);
+}
+
+static void tv_close_event_cb(lv_event_t* e) {
+    text_viewer_t* v = (text_viewer_t*)lv_event_get_user_data(e);
+    if (v->close_cb) {
+        v->close_cb(v->user_data);
+    }
+    tv_destroy(v, true);
+}
+
+// 索引进行中时刷新进度
+static void tv_info_timer_cb(lv_timer_t* timer) {
+    text_viewer_t* v = (text_viewer_t*)lv_timer_get_user_data(timer);
+    tv_update_info(v);
+    if (v->index_complete) {
+        app_ctx_timer_delete(v->app, v->info_timer);
+        v->info_timer = NULL;
+    }
+}
+
+static void tv_create_ui(text_viewer_t* v, lv_obj_t* parent) {
+    v->root = lv_obj_create(parent);
+    lv_obj_set_size(v->root, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_pos(v->root, 0, 0);
+    lv_obj_set_style_bg_color(v->root, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_bg_opa(v->root, LV_OPA_COVER, 0);
+    lv_obj_set_style_pad_all(v->root, 12, 0);
+    lv_obj_clear_flag(v->root, LV_OBJ_FLAG_SCROLLABLE);
+
+    // 标题和关闭按钮
+    const char* name = strrchr(v->path, '/');
+    lv_obj_t* title = lv_label_create(v->root);
+    lv_label_set_text(title, name ? name + 1 : v->path);
+    lv_label_set_long_mode(title, LV_LABEL_LONG_DOT);
+    lv_obj_set_width(title, LV_PCT(75));
+    lv_obj_set_style_text_color(title, lv_color_hex(0x2196F3), 0);
+    lv_obj_set_style_text_font(title, &simhei_32, 0);
+    lv_obj_align(title, LV_ALIGN_TOP_LEFT, 0, 0);
+
+    lv_obj_t* close_btn = lv_btn_create(v->root);
+    lv_obj_set_size(close_btn, 100, 48);
+    lv_obj_set_style_bg_color(close_btn, lv_color_hex(0x2196F3), 0);
+    lv_obj_set_style_radius(close_btn, 8, 0);
+    lv_obj_align(close_btn, LV_ALIGN_TOP_RIGHT, 0, 0);
+    lv_obj_add_event_cb(close_btn, tv_close_event_cb, LV_EVENT_CLICKED, v);
+
+    lv_obj_t* close_label = lv_label_create(close_btn);
+    lv_label_set_text(close_label, "关闭");
+    lv_obj_set_style_text_color(close_label, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_font(close_label, &simhei_32, 0);
+    lv_obj_center(close_label);
+
+    v->info_label = lv_label_create(v->root);
+    lv_obj_set_width(v->info_label, LV_PCT(100));
+    lv_obj_set_style_text_color(v->info_label, lv_color_hex(0x666666), 0);
+    lv_obj_set_style_text_font(v->info_label, &simhei_32, 0);
+    lv_obj_align(v->info_label, LV_ALIGN_TOP_LEFT, 0, 56);
+
+    // 文本区域：固定行数，超长行可横向滚动
+    v->text_box = lv_obj_create(v->root);
+    lv_obj_set_size(v->text_box, LV_PCT(100), LV_PCT(72));
+    lv_obj_align(v->text_box, LV_ALIGN_TOP_LEFT, 0, 136);
+    lv_obj_set_style_bg_color(v->text_box, lv_color_hex(0xFAFAFA), 0);
+    lv_obj_set_style_pad_all(v->text_box, 8, 0);
+    lv_obj_set_scroll_dir(v->text_box, LV_DIR_HOR);
+
+    v->text_label = lv_label_create(v->text_box);
+    lv_obj_set_width(v->text_label, LV_SIZE_CONTENT);
+    lv_obj_set_style_text_color(v->text_label, lv_color_hex(0x333333), 0);
+    lv_obj_set_style_text_font(v->text_label, &simhei_32, 0);
+    lv_label_set_text(v->text_label, "");
+
+    // 底部按钮
+    lv_obj_t* buttons = lv_obj_create(v->root);
+    lv_obj_set_size(buttons, LV_PCT(100), 72);
+    lv_obj_align(buttons, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_set_style_bg_opa(buttons, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(buttons, 0, 0);
+    lv_obj_set_style_pad_all(buttons, 4, 0);
+    lv_obj_set_layout(buttons, LV_LAYOUT_FLEX);
+    lv_obj_set_flex_flow(buttons, LV_FLEX_FLOW_ROW);
+    lv_obj_set_flex_align(buttons, LV_FLEX_ALIGN_SPACE_EVENLY, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+    const char* button_texts[] = {"开头", "上页", "下页", "末尾", "跳行", "跳字节"};
+    for (int i = 0; i < 6; i++) {
+        lv_obj_t* button = lv_btn_create(buttons);
+        lv_obj_set_height(button, 56);
+        lv_obj_set_style_bg_color(button, lv_color_hex(0x2196F3), 0);
+        lv_obj_set_style_radius(button, 8, 0);
+        lv_obj_set_user_data(button, (void*)(intptr_t)i);
+        lv_obj_add_event_cb(button, tv_button_event_cb, LV_EVENT_CLICKED, v);
+
+        lv_obj_t* label = lv_label_create(button);
+        lv_label_set_text(label, button_texts[i]);
+        lv_obj_set_style_text_color(label, lv_color_hex(0xFFFFFF), 0);
+        lv_obj_set_style_text_font(label, &simhei_32, 0);
+        lv_obj_center(label);
+    }
+
+    // 根据文本区域高度计算每页行数
+    lv_obj_update_layout(v->root);
+    int32_t line_height = lv_font_get_line_height(&simhei_32);
+    int32_t lines = line_height > 0 ? lv_obj_get_content_height(v->text_box) / line_height : 20;
+    if (lines < 1) {
+        lines = 1;
+    } else if (lines > TV_MAX_PAGE_LINES) {
+        lines = TV_MAX_PAGE_LINES;
+    }
+    v->lines_per_page = (uint32_t)lines;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Public API                                 */
+/* -------------------------------------------------------------------------- */
+
+static void tv_destroy(text_viewer_t* v, bool async_delete) {
+    if (!v) {
+        return;
+    }
+
+    // 停止后台索引（在下一个数据块边界退出）
+    if (v->index_running) {
+        v->index_cancel = true;
+        xSemaphoreTake(v->index_done, portMAX_DELAY);
+    }
+
+    // 应用销毁时定时器已随应用上下文释放，这里不做任何事
+    if (v->info_timer) {
+        app_ctx_timer_delete(v->app, v->info_timer);
+    }
+    if (v->root) {
+        if (async_delete) {
+            lv_obj_delete_async(v->root);
+        } else {
+            lv_obj_delete(v->root);
+        }
+    }
+
+    if (v->fd >= 0) {
+        close(v->fd);
+    }
+    if (v->index_lock) {
+        vSemaphoreDelete(v->index_lock);
+    }
+    if (v->index_done) {
+        vSemaphoreDelete(v->index_done);
+    }
+    heap_caps_free(v->block_memory);
+    heap_caps_free(v->line_offsets);
+    heap_caps_free(v->window_text);
+    heap_caps_free(v);
+}
+
+text_viewer_t* text_viewer_open(app_t* app, lv_obj_t* parent, const char* path,
+                                text_viewer_close_cb_t close_cb, void* user_data) {
+    if (!app || !parent || !path || strlen(path) >= sizeof(((text_viewer_t*)0)->path)) {
+        return NULL;
+    }
+
+    int64_t start = esp_timer_get_time();
+
+    text_viewer_t* v = tv_malloc(sizeof(text_viewer_t));
+    if (!v) {
+        return NULL;
+    }
+    memset(v, 0, sizeof(text_viewer_t));
+    strcpy(v->path, path);
+    v->app = app;
+    v->close_cb = close_cb;
+    v->user_data = user_data;
+    v->index_stride = TV_INDEX_STRIDE;
+
+    v->fd = open(path, O_RDONLY);
+    struct stat st;
+    if (v->fd < 0 || fstat(v->fd, &st) != 0) {
+        printf("Text viewer: failed to open %s\n", path);
+        tv_destroy(v, false);
+        return NULL;
+    }
+    v->file_size = (uint32_t)st.st_size;
+
+    v->block_memory = tv_malloc(TV_BLOCK_SIZE * TV_CACHE_BLOCKS);
+    v->line_offsets = tv_malloc(TV_INDEX_MAX_ENTRIES * sizeof(uint32_t));
+    v->window_text = tv_malloc(TV_MAX_PAGE_LINES * (TV_LINE_MAX + 1) + 1);
+    v->index_lock = xSemaphoreCreateMutex();
+    v->index_done = xSemaphoreCreateBinary();
+    if (!v->block_memory || !v->line_offsets || !v->window_text || !v->index_lock || !v->index_done) {
+        printf("Text viewer: out of memory\n");
+        tv_destroy(v, false);
+        return NULL;
+    }
+    for (int i = 0; i < TV_CACHE_BLOCKS; i++) {
+        v->blocks[i].data = v->block_memory + i * TV_BLOCK_SIZE;
+    }
+    v->line_offsets[0] = 0;
+    v->index_count = 1;
+
+    // 先显示第一页，索引在后台建立
+    tv_create_ui(v, parent);
+    tv_render(v);
+
+    if (app_ctx_task_create(app, tv_index_task, "text_index", TV_TASK_STACK, TV_TASK_PRIORITY, v)) {
+        v->index_running = true;
+        v->info_timer = app_ctx_timer_create(app, tv_info_timer_cb, 500, v);
+    }
+
+    printf("Text viewer opened %s (%lu bytes), first page in %lld ms\n",
+           path, (unsigned long)v->file_size, (long long)((esp_timer_get_time() - start) / 1000));
+    return v;
+}
+
+void text_viewer_close(text_viewer_t* viewer) {
+    tv_destroy(viewer, false);
+}
+
+void text_viewer_goto_offset(text_viewer_t* viewer, uint32_t offset) {
+    if (!viewer || viewer->file_size == 0) {
+        return;
+    }
+    uint32_t off = offset < viewer->file_size ? offset : viewer->file_size - 1;
+    viewer->top_offset = tv_line_start_at(viewer, off);
+    viewer->message[0] = '\0';
+    tv_render(viewer);
+}
+
+bool text_viewer_is_text_file(const char* filename) {
+    return file_types_has_cap(filename, FILE_CAP_VIEW_TEXT);
+}
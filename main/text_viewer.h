@@ -0,0 +1,54 @@
+#ifndef TEXT_VIEWER_H
+#define TEXT_VIEWER_H
+
+#include "lvgl.h"
+#include "app_manager.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 文本查看器（不透明类型）
+typedef struct text_viewer text_viewer_t;
+
+// 用户点击关闭按钮后的回调（查看器随后自行释放）
+typedef void (*text_viewer_close_cb_t)(void* user_data);
+
+/**
+ * @brief 打开分页文本查看器
+ *
+ * 只读取可见窗口附近的数据，行索引在后台任务中建立，
+ * 内存占用与文件大小无关。索引任务和进度定时器属于app的应用上下文，
+ * 随应用挂起和释放。
+ *
+ * @param app 使用查看器的应用
+ * @param parent 父对象（查看器铺满父对象）
+ * @param path 文件路径
+ * @param close_cb 点击关闭按钮时的回调，可为NULL
+ * @param user_data 回调参数
+ * @return 查看器，失败返回NULL
+ */
+text_viewer_t* text_viewer_open(app_t* app, lv_obj_t* parent, const char* path,
+                                text_viewer_close_cb_t close_cb, void* user_data);
+
+/**
+ * @brief 关闭查看器并释放资源（停止后台索引任务）
+ */
+void text_viewer_close(text_viewer_t* viewer);
+
+/**
+ * @brief 跳转到字节偏移所在的行（显示在首行）
+ */
+void text_viewer_goto_offset(text_viewer_t* viewer, uint32_t offset);
+
+/**
+ * @brief 判断文件名是否为查看器支持的文本类型
+ */
+bool text_viewer_is_text_file(const char* filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEXT_VIEWER_H
@@ -0,0 +1,256 @@
+#include "ui_bind.h"
+#include "hal.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+// 配置
+#define UI_BIND_TEXT_MAX            128     // ui_bind_set_textf格式化缓冲区
+#define UI_BIND_STATS_MIN_WINDOW_MS 1000    // 重绘面积统计的最短周期
+#define UI_BIND_STATS_LOG_MS        10000   // 打印统计的周期（CONFIG_IMOS_UI_BIND_STATS_LOG）
+
+// 全局HAL状态
+static bool g_hal_subjects_ready = false;
+static lv_subject_t g_volume_subject;
+static lv_subject_t g_brightness_subject;
+static lv_subject_t g_speaker_subject;
+
+// 统计
+static uint32_t g_updates = 0;
+static uint32_t g_unchanged = 0;
+#ifdef CONFIG_IMOS_UI_BIND_STATS_LOG
+// 重绘面积统计需要在每次标记重绘时回调，只在调试选项打开时安装
+static bool g_stats_ready = false;
+static uint64_t g_invalidated_acc = 0;      // 当前周期累计的重绘面积
+static uint32_t g_invalidated_px = 0;       // 上个周期的每秒平均值
+static uint32_t g_window_start = 0;         // 当前周期开始的时刻
+#endif
+
+static void stats_init(void);
+
+/* -------------------------------------------------------------------------- */
+/*                                  Setters                                   */
+/* -------------------------------------------------------------------------- */
+
+void ui_bind_set_int(lv_subject_t* subject, int32_t value) {
+    if (!subject) {
+        return;
+    }
+    stats_init();
+
+    // lv_subject_set_int不比较新旧值，每次都会通知所有绑定的控件
+    if (lv_subject_get_int(subject) == value) {
+        g_unchanged++;
+        return;
+    }
+    g_updates++;
+    lv_subject_set_int(subject, value);
+}
+
+void ui_bind_set_text(lv_subject_t* subject, const char* text) {
+    if (!subject) {
+        return;
+    }
+    stats_init();
+
+    if (!text) {
+        text = "";
+    }
+    const char* current = lv_subject_get_string(subject);
+    if (current && strcmp(current, text) == 0) {
+        g_unchanged++;
+        return;
+    }
+    g_updates++;
+    lv_subject_copy_string(subject, text);
+}
+
+void ui_bind_set_textf(lv_subject_t* subject, const char* fmt, ...) {
+    char text[UI_BIND_TEXT_MAX];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    ui_bind_set_text(subject, text);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Binders                                   */
+/* -------------------------------------------------------------------------- */
+
+typedef struct {
+    const char* const* texts;
+    uint32_t count;
+} label_map_t;
+
+static void label_map_observer_cb(lv_observer_t* observer, lv_subject_t* subject) {
+    lv_obj_t* label = (lv_obj_t*)lv_observer_get_target(observer);
+    const label_map_t* map = (const label_map_t*)lv_observer_get_user_data(observer);
+    int32_t value = lv_subject_get_int(subject);
+
+    const char* text = (value >= 0 && (uint32_t)value < map->count && map->texts[value]) ? map->texts[value] : "";
+    // 绑定时会立即通知一次，文本相同也不重设
+    if (strcmp(lv_label_get_text(label), text) != 0) {
+        lv_label_set_text_static(label, text);
+    }
+}
+
+static void label_map_delete_cb(lv_event_t* e) {
+    lv_free(lv_event_get_user_data(e));
+}
+
+lv_observer_t* ui_bind_label_map(lv_obj_t* label, lv_subject_t* subject,
+                                 const char* const* texts, uint32_t count) {
+    if (!label || !subject || !texts) {
+        return NULL;
+    }
+
+    label_map_t* map = (label_map_t*)lv_malloc(sizeof(label_map_t));
+    if (!map) {
+        return NULL;
+    }
+    map->texts = texts;
+    map->count = count;
+    lv_obj_add_event_cb(label, label_map_delete_cb, LV_EVENT_DELETE, map);
+    return lv_subject_add_observer_obj(subject, label_map_observer_cb, label, map);
+}
+
+static void bar_value_observer_cb(lv_observer_t* observer, lv_subject_t* subject) {
+    lv_obj_t* bar = (lv_obj_t*)lv_observer_get_target(observer);
+    int32_t value = lv_subject_get_int(subject);
+    if (lv_bar_get_value(bar) != value) {
+        lv_bar_set_value(bar, value, LV_ANIM_ON);
+    }
+}
+
+lv_observer_t* ui_bind_bar_value(lv_obj_t* bar, lv_subject_t* subject) {
+    if (!bar || !subject) {
+        return NULL;
+    }
+    return lv_subject_add_observer_obj(subject, bar_value_observer_cb, bar, NULL);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              HAL state subjects                            */
+/* -------------------------------------------------------------------------- */
+
+// HAL事件 -> 状态（值相同时不通知，写回HAL后收到的事件不会再次触发）
+static void hal_subject_event_cb(const hal_event_t* event, void* user_data) {
+    ui_bind_set_int((lv_subject_t*)user_data, (int32_t)event->value);
+}
+
+// 状态 -> HAL（滑块拖动等界面修改）
+static void volume_to_hal_cb(lv_observer_t* observer, lv_subject_t* subject) {
+    (void)observer;
+    uint8_t volume = (uint8_t)lv_subject_get_int(subject);
+    if (volume != hal_get_speaker_volume()) {
+        hal_set_speaker_volume(volume);
+    }
+}
+
+static void brightness_to_hal_cb(lv_observer_t* observer, lv_subject_t* subject) {
+    (void)observer;
+    uint8_t brightness = (uint8_t)lv_subject_get_int(subject);
+    if (brightness != hal_get_display_brightness()) {
+        hal_set_display_brightness(brightness);
+    }
+}
+
+static void speaker_to_hal_cb(lv_observer_t* observer, lv_subject_t* subject) {
+    (void)observer;
+    bool enabled = lv_subject_get_int(subject) != 0;
+    if (enabled != hal_get_speaker_enable()) {
+        hal_set_speaker_enable(enabled);
+    }
+}
+
+static void hal_subjects_init(void) {
+    if (g_hal_subjects_ready) {
+        return;
+    }
+    g_hal_subjects_ready = true;
+
+    lv_subject_init_int(&g_volume_subject, hal_get_speaker_volume());
+    lv_subject_init_int(&g_brightness_subject, hal_get_display_brightness());
+    lv_subject_init_int(&g_speaker_subject, hal_get_speaker_enable() ? 1 : 0);
+
+    lv_subject_add_observer(&g_volume_subject, volume_to_hal_cb, NULL);
+    lv_subject_add_observer(&g_brightness_subject, brightness_to_hal_cb, NULL);
+    lv_subject_add_observer(&g_speaker_subject, speaker_to_hal_cb, NULL);
+
+    hal_event_subscribe(HAL_EVENT_VOLUME, hal_subject_event_cb, &g_volume_subject);
+    hal_event_subscribe(HAL_EVENT_BRIGHTNESS, hal_subject_event_cb, &g_brightness_subject);
+    hal_event_subscribe(HAL_EVENT_SPEAKER, hal_subject_event_cb, &g_speaker_subject);
+}
+
+lv_subject_t* ui_bind_volume(void) {
+    hal_subjects_init();
+    return &g_volume_subject;
+}
+
+lv_subject_t* ui_bind_brightness(void) {
+    hal_subjects_init();
+    return &g_brightness_subject;
+}
+
+lv_subject_t* ui_bind_speaker(void) {
+    hal_subjects_init();
+    return &g_speaker_subject;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Statistics                                 */
+/* -------------------------------------------------------------------------- */
+
+#ifdef CONFIG_IMOS_UI_BIND_STATS_LOG
+// 累计每次标记重绘的面积（重叠区域会重复计算，和实际刷新的像素数有出入）
+static void invalidate_area_cb(lv_event_t* e) {
+    const lv_area_t* area = (const lv_area_t*)lv_event_get_param(e);
+    if (area) {
+        g_invalidated_acc += (uint32_t)lv_area_get_size(area);
+    }
+}
+
+static void stats_timer_cb(lv_timer_t* timer) {
+    (void)timer;
+    ui_bind_stats_t stats;
+    ui_bind_get_stats(&stats);
+    printf("UI redraw: %lu px/s invalidated, bindings %lu updated / %lu unchanged\n",
+           (unsigned long)stats.invalidated_px, (unsigned long)stats.updates, (unsigned long)stats.unchanged);
+}
+#endif
+
+static void stats_init(void) {
+#ifdef CONFIG_IMOS_UI_BIND_STATS_LOG
+    if (g_stats_ready) {
+        return;
+    }
+    lv_display_t* disp = lv_display_get_default();
+    if (!disp) {
+        return;
+    }
+    g_stats_ready = true;
+    g_window_start = lv_tick_get();
+    lv_display_add_event_cb(disp, invalidate_area_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+    lv_timer_create(stats_timer_cb, UI_BIND_STATS_LOG_MS, NULL);
+#endif
+}
+
+// 不用定时器：读取时结算上次读取以来的平均值，间隔太短时沿用上个周期的值
+void ui_bind_get_stats(ui_bind_stats_t* stats) {
+    if (!stats) {
+        return;
+    }
+    stats->updates = g_updates;
+    stats->unchanged = g_unchanged;
+    stats->invalidated_px = 0;
+#ifdef CONFIG_IMOS_UI_BIND_STATS_LOG
+    uint32_t elapsed = lv_tick_elaps(g_window_start);
+    if (g_stats_ready && elapsed >= UI_BIND_STATS_MIN_WINDOW_MS) {
+        g_invalidated_px = (uint32_t)(g_invalidated_acc * 1000 / elapsed);
+        g_invalidated_acc = 0;
+        g_window_start = lv_tick_get();
+    }
+    stats->invalidated_px = g_invalidated_px;
+#endif
+}
@@ -0,0 +1,70 @@
+#ifndef UI_BIND_H
+#define UI_BIND_H
+
+#include "lvgl.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 绑定统计
+typedef struct {
+    uint32_t updates;           // 值改变、通知了绑定控件的次数
+    uint32_t unchanged;         // 值没有改变、跳过的次数
+    uint32_t invalidated_px;    // 上次读取以来每秒标记重绘的面积（像素），
+                                // 只在CONFIG_IMOS_UI_BIND_STATS_LOG打开时统计，否则为0
+} ui_bind_stats_t;
+
+/**
+ * @brief 设置整数状态，值没有改变时不通知（绑定的控件不更新也不重绘）
+ */
+void ui_bind_set_int(lv_subject_t* subject, int32_t value);
+
+/**
+ * @brief 设置字符串状态（lv_subject_init_string初始化的），内容相同时不通知
+ */
+void ui_bind_set_text(lv_subject_t* subject, const char* text);
+
+/**
+ * @brief 按格式设置字符串状态，内容相同时不通知
+ */
+void ui_bind_set_textf(lv_subject_t* subject, const char* fmt, ...);
+
+/**
+ * @brief 标签显示整数状态对应的文本：texts[value]，超出范围时显示空字符串
+ *
+ * 绑定随控件删除自动解除，texts需要一直有效。
+ */
+lv_observer_t* ui_bind_label_map(lv_obj_t* label, lv_subject_t* subject,
+                                 const char* const* texts, uint32_t count);
+
+/**
+ * @brief 进度条显示整数状态（带动画）
+ */
+lv_observer_t* ui_bind_bar_value(lv_obj_t* bar, lv_subject_t* subject);
+
+/**
+ * @brief 全局HAL状态：由HAL事件更新，修改时写回HAL
+ *
+ * 音量和亮度为0-100，扬声器为0或1。滑块用lv_slider_bind_value双向绑定，
+ * 标签用lv_label_bind_text绑定，不需要各自同步。只能在LVGL任务中使用。
+ */
+lv_subject_t* ui_bind_volume(void);
+lv_subject_t* ui_bind_brightness(void);
+lv_subject_t* ui_bind_speaker(void);
+
+/**
+ * @brief 获取统计
+ *
+ * 重绘面积在读取时按上次读取以来的时间求平均，两次读取间隔不足1秒时返回上次的值。
+ * 只能在LVGL任务中调用。
+ */
+void ui_bind_get_stats(ui_bind_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UI_BIND_H